@@ -51,3 +51,40 @@ bool WriteEntireFile(const wchar_t* FilePath, const void* Content, size_t Length
     CloseHandle(hFile);
     return true;
 }
+
+bool ReadEntireFile(const wchar_t* FilePath, std::string& Content)
+{
+    HANDLE hFile = CreateFileW(
+        FilePath,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        0,
+        nullptr);
+
+    if (hFile == INVALID_HANDLE_VALUE) {
+        fprintf(stderr, "Failed open file '%ls' (%lu)\n", FilePath, GetLastError());
+        return false;
+    }
+
+    LARGE_INTEGER FileSize;
+    if (!GetFileSizeEx(hFile, &FileSize) || FileSize.QuadPart > static_cast<DWORD>(-1)) {
+        fprintf(stderr, "Failed to get the size of file '%ls' (%lu)\n", FilePath, GetLastError());
+        CloseHandle(hFile);
+        return false;
+    }
+
+    Content.resize(static_cast<size_t>(FileSize.QuadPart));
+    DWORD BytesRead;
+    const auto dwBytesToRead = static_cast<DWORD>(Content.size());
+    if (dwBytesToRead != 0 && (!ReadFile(hFile, Content.data(), dwBytesToRead, &BytesRead, nullptr) || BytesRead != dwBytesToRead)) {
+        fprintf(stderr, "Failed to read %lu bytes from file '%ls' (%lu)\n",
+                dwBytesToRead, FilePath, GetLastError());
+        CloseHandle(hFile);
+        return false;
+    }
+
+    CloseHandle(hFile);
+    return true;
+}
@@ -1,3 +1,6 @@
 #pragma once
 
+#include <string>
+
 bool WriteEntireFile(const wchar_t* Path, const void* Content, size_t Length);
+bool ReadEntireFile(const wchar_t* Path, std::string& Content);
@@ -0,0 +1,129 @@
+// No stdafx.h: the tests project builds this file without Windows
+
+#include "BlockUpdate.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+#include <nlohmann/json.hpp>
+
+namespace BlockUpdate {
+    bool ParseManifest(const std::string& json_text, Manifest* manifest)
+    {
+        const auto json = nlohmann::json::parse(json_text, nullptr, false);
+        if (json.is_discarded() || !json.is_object()) {
+            fprintf(stderr, "Failed to parse block manifest\n");
+            return false;
+        }
+        const auto it_size = json.find("size");
+        const auto it_block_size = json.find("block_size");
+        const auto it_sha256 = json.find("sha256");
+        const auto it_blocks = json.find("blocks");
+        if (it_size == json.end() || !it_size->is_number_unsigned()
+            || it_block_size == json.end() || !it_block_size->is_number_unsigned()
+            || it_sha256 == json.end() || !it_sha256->is_string()
+            || it_blocks == json.end() || !it_blocks->is_array()) {
+            fprintf(stderr, "Block manifest is missing 'size', 'block_size', 'sha256' or 'blocks'\n");
+            return false;
+        }
+        manifest->size = it_size->get<size_t>();
+        manifest->block_size = it_block_size->get<size_t>();
+        manifest->sha256 = it_sha256->get<std::string>();
+        manifest->blocks.clear();
+        for (const auto& block : *it_blocks) {
+            if (!block.is_string()) {
+                return false;
+            }
+            manifest->blocks.push_back(block.get<std::string>());
+        }
+        if (manifest->block_size == 0 || manifest->blocks.size() != (manifest->size + manifest->block_size - 1) / manifest->block_size) {
+            fprintf(stderr, "Block manifest doesn't describe %zu bytes\n", manifest->size);
+            return false;
+        }
+        return true;
+    }
+
+    std::vector<Range> Plan(const Manifest& manifest, const std::string& local, std::string& output, const HashFn sha256)
+    {
+        std::unordered_map<std::string, size_t> local_blocks;
+        for (size_t offset = 0; offset < local.size(); offset += manifest.block_size) {
+            std::string hash;
+            if (sha256(local.data() + offset, std::min(manifest.block_size, local.size() - offset), hash)) {
+                local_blocks.emplace(std::move(hash), offset);
+            }
+        }
+
+        output.assign(manifest.size, '\0');
+        std::vector<size_t> missing;
+        for (size_t i = 0; i < manifest.blocks.size(); i++) {
+            const size_t offset = i * manifest.block_size;
+            const size_t length = std::min(manifest.block_size, manifest.size - offset);
+            const auto found = local_blocks.find(manifest.blocks[i]);
+            if (found != local_blocks.end() && local.size() - found->second >= length) {
+                memcpy(output.data() + offset, local.data() + found->second, length);
+            }
+            else {
+                missing.push_back(i);
+            }
+        }
+
+        // Runs of adjacent missing blocks, as [first, last]
+        std::vector<std::pair<size_t, size_t>> runs;
+        for (const auto block : missing) {
+            if (!runs.empty() && runs.back().second + 1 == block) {
+                runs.back().second = block;
+            }
+            else {
+                runs.emplace_back(block, block);
+            }
+        }
+        while (runs.size() > MAX_RANGES) {
+            size_t closest = 0;
+            for (size_t i = 1; i + 1 < runs.size(); i++) {
+                if (runs[i + 1].first - runs[i].second < runs[closest + 1].first - runs[closest].second) {
+                    closest = i;
+                }
+            }
+            runs[closest].second = runs[closest + 1].second;
+            runs.erase(runs.begin() + static_cast<ptrdiff_t>(closest) + 1);
+        }
+        // Split the longest runs while there are requests to spare, so big changes still download in parallel
+        while (!runs.empty() && runs.size() < MAX_RANGES) {
+            const auto longest = std::ranges::max_element(runs, {}, [](const auto& run) {
+                return run.second - run.first;
+            });
+            if (longest->first == longest->second) {
+                break;
+            }
+            const auto middle = longest->first + (longest->second - longest->first) / 2;
+            const std::pair<size_t, size_t> second_half = {middle + 1, longest->second};
+            longest->second = middle;
+            runs.insert(longest + 1, second_half);
+        }
+
+        std::vector<Range> ranges;
+        for (const auto& [first, last] : runs) {
+            const size_t offset = first * manifest.block_size;
+            ranges.push_back({offset, std::min(manifest.size, (last + 1) * manifest.block_size) - offset});
+        }
+        return ranges;
+    }
+
+    std::string RangeHeader(const Range& range)
+    {
+        char header[64];
+        snprintf(header, sizeof(header), "Range: bytes=%zu-%zu", range.offset, range.offset + range.length - 1);
+        return header;
+    }
+
+    bool Apply(const Range& range, const std::string& content, std::string& output)
+    {
+        if (content.size() != range.length || range.offset > output.size() || output.size() - range.offset < range.length) {
+            return false;
+        }
+        memcpy(output.data() + range.offset, content.data(), content.size());
+        return true;
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Updating GWToolboxdll.dll block by block: which parts of the new dll can be copied out of the local one, and which
+// ranges have to be downloaded. No networking or hashing of its own, so it can be tested outside the launcher.
+namespace BlockUpdate {
+    // Published next to the dll as GWToolboxdll.manifest.json; lets an existing install fetch only the blocks that changed
+    struct Manifest {
+        size_t size = 0;
+        size_t block_size = 0;
+        std::string sha256{};
+        std::vector<std::string> blocks{}; // sha256 of each block, the last one may be short
+    };
+
+    // A slice of the new dll to download
+    struct Range {
+        size_t offset = 0;
+        size_t length = 0;
+    };
+
+    constexpr size_t MAX_RANGES = 8;
+
+    // Lower case hex SHA-256 of size bytes at data
+    using HashFn = bool (*)(const void* data, size_t size, std::string& out);
+
+    bool ParseManifest(const std::string& json_text, Manifest* manifest);
+
+    // Fills output with every block of the new dll that can be found somewhere in the local one, and returns the ranges
+    // to download for the rest. There are at most MAX_RANGES; when there are more runs of missing blocks than that, the
+    // runs closest together are merged and the blocks between them downloaded again.
+    std::vector<Range> Plan(const Manifest& manifest, const std::string& local, std::string& output, HashFn sha256);
+
+    // "Range: bytes=first-last", last inclusive
+    std::string RangeHeader(const Range& range);
+
+    // Copies a downloaded range into output; false if it isn't the expected length
+    bool Apply(const Range& range, const std::string& content, std::string& output);
+}
@@ -1,9 +1,14 @@
 #include "stdafx.h"
 
+#include <bcrypt.h>
+#include <memory>
+#include <unordered_map>
+
 #include <File.h>
 #include <Path.h>
 
 #include <RestClient.h>
+#include "BlockUpdate.h"
 #include "Download.h"
 
 class AsyncFileDownloader : public AsyncRestClient {
@@ -48,13 +53,100 @@ bool Download(std::string& content, const char* url)
     return true;
 }
 
-void AsyncDownload(const char* url, AsyncFileDownloader* downloader)
+// A slice of the dll to download, or the whole file if it isn't a ranged request
+struct BlockRequest {
+    BlockUpdate::Range range{};
+    bool ranged = false;
+    AsyncFileDownloader downloader{};
+};
+
+bool Sha256Hex(const void* data, const size_t size, std::string& out)
+{
+    // BCryptHash and BCRYPT_SHA256_ALG_HANDLE need Windows 10; open the provider once and hash step by step instead
+    static const BCRYPT_ALG_HANDLE algorithm = [] {
+        BCRYPT_ALG_HANDLE handle = nullptr;
+        if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&handle, BCRYPT_SHA256_ALGORITHM, nullptr, 0))) {
+            fprintf(stderr, "BCryptOpenAlgorithmProvider failed\n");
+            handle = nullptr;
+        }
+        return handle;
+    }();
+    uint8_t digest[32];
+    BCRYPT_HASH_HANDLE hash = nullptr;
+    const bool hashed = algorithm
+                        && BCRYPT_SUCCESS(BCryptCreateHash(algorithm, &hash, nullptr, 0, nullptr, 0, 0))
+                        && BCRYPT_SUCCESS(BCryptHashData(hash, static_cast<PUCHAR>(const_cast<void*>(data)), static_cast<ULONG>(size), 0))
+                        && BCRYPT_SUCCESS(BCryptFinishHash(hash, digest, sizeof(digest), 0));
+    if (hash) {
+        BCryptDestroyHash(hash);
+    }
+    if (!hashed) {
+        fprintf(stderr, "Failed to hash %zu bytes\n", size);
+        return false;
+    }
+    char hex[sizeof(digest) * 2 + 1];
+    for (size_t i = 0; i < sizeof(digest); i++) {
+        snprintf(hex + i * 2, 3, "%02x", digest[i]);
+    }
+    out.assign(hex, sizeof(digest) * 2);
+    return true;
+}
+
+// Runs the requests while pumping the window's messages. Returns false if any failed or the window was closed.
+bool RunBlockRequests(DownloadWindow& window, HWND progress_bar, std::vector<std::unique_ptr<BlockRequest>>& requests, const char* url)
 {
-    downloader->SetUrl(url);
-    downloader->SetVerifyPeer(false);
-    downloader->SetFollowLocation(true);
-    downloader->SetUserAgent("curl/7.71.1");
-    downloader->ExecuteAsync();
+    size_t total = 0;
+    for (const auto& request : requests) {
+        request->downloader.SetUrl(url);
+        request->downloader.SetVerifyPeer(false);
+        request->downloader.SetFollowLocation(true);
+        request->downloader.SetUserAgent("curl/7.71.1");
+        if (request->ranged) {
+            request->downloader.SetHeader(BlockUpdate::RangeHeader(request->range).c_str());
+        }
+        request->downloader.ExecuteAsync();
+        total += request->range.length;
+    }
+
+    while (!window.ShouldClose()) {
+        window.PollMessages(16);
+
+        size_t downloaded = 0;
+        bool completed = true;
+        for (const auto& request : requests) {
+            downloaded += request->downloader.GetDownloadCount();
+            completed = completed && request->downloader.IsCompleted();
+        }
+        if (!completed) {
+            SendMessageW(progress_bar, PBM_SETPOS, total ? downloaded * 100 / total : 0, 0);
+            continue;
+        }
+
+        for (const auto& request : requests) {
+            if (!request->downloader.IsSuccessful()) {
+                fprintf(stderr, "Failed to download '%s'. (Status: %s, StatusCode: %d)\n",
+                        url, request->downloader.GetStatusStr(), request->downloader.GetStatusCode());
+                return false;
+            }
+            if (request->ranged && request->downloader.GetContent().size() != request->range.length) {
+                fprintf(stderr, "Expected %zu bytes at offset %zu of '%s', got %zu\n",
+                        request->range.length, request->range.offset, url, request->downloader.GetContent().size());
+                return false;
+            }
+        }
+        SendMessageW(progress_bar, PBM_SETPOS, 100, 0);
+        return true;
+    }
+
+    //
+    // The user could close the window, before the download is complete
+    //
+    for (const auto& request : requests) {
+        if (request->downloader.IsPending()) {
+            request->downloader.Abort();
+        }
+    }
+    return false;
 }
 
 struct Asset {
@@ -184,35 +276,30 @@ bool DownloadWindow::DownloadAllFiles()
         return false;
     }
 
-    std::filesystem::path dllpath;
-    PathGetDocumentsPath(dllpath, L"GWToolboxpp\\GWToolboxdll.dll");
-    const auto release_string = GetDllRelease(dllpath);
+    std::filesystem::path dll_path;
+    if (!PathGetDocumentsPath(dll_path, L"GWToolboxpp\\GWToolboxdll.dll")) {
+        return false;
+    }
+    const auto release_string = GetDllRelease(dll_path);
     if (!release_string.empty()) {
-        std::string release_tag = release.tag_name;
-        const auto current_version = std::regex_replace(release_tag, std::regex(R"([^0-9.])"), "");
+        std::string current_version = release.tag_name;
+        std::erase_if(current_version, [](const char c) {
+            return !(c >= '0' && c <= '9') && c != '.';
+        });
         if (release_string.starts_with(current_version)) {
             return true;
         }
     }
 
-    std::filesystem::path dll_path;
-    if (!PathGetDocumentsPath(dll_path, L"GWToolboxpp\\GWToolboxdll.dll")) {
-        return false;
-    }
-
-    char buffer[64];
-    snprintf(buffer, 64, "Downloading version '%s'", release.tag_name.c_str());
-    MessageBoxA(nullptr, buffer, "Downloading...", 0);
-
     std::string url;
-    size_t file_size = 0;
+    std::string manifest_url;
     for (auto& asset : release.assets) {
-        if (asset.name == "GWToolbox.dll" || asset.name == "GWToolboxdll.dll") {
+        if (url.empty() && (asset.name == "GWToolbox.dll" || asset.name == "GWToolboxdll.dll")) {
             fprintf(stderr, "browser_download_url: '%s'\n", asset.browser_download_url.c_str());
-            const char* purl = asset.browser_download_url.c_str();
-            file_size = asset.size;
-            url = std::string(purl, purl + asset.browser_download_url.size());
-            break;
+            url = asset.browser_download_url;
+        }
+        else if (asset.name == "GWToolboxdll.manifest.json") {
+            manifest_url = asset.browser_download_url;
         }
     }
 
@@ -221,49 +308,87 @@ bool DownloadWindow::DownloadAllFiles()
         return false;
     }
 
+    // Without a manifest, or a local dll to reuse blocks from, this falls back to downloading the whole file
+    BlockUpdate::Manifest manifest;
+    std::string manifest_content;
+    const bool has_manifest = !manifest_url.empty()
+                              && Download(manifest_content, manifest_url.c_str())
+                              && BlockUpdate::ParseManifest(manifest_content, &manifest);
+    std::string local_content;
+    if (has_manifest && std::filesystem::exists(dll_path)) {
+        ReadEntireFile(dll_path.wstring().c_str(), local_content);
+    }
+
+    char buffer[64];
+    snprintf(buffer, 64, "Downloading version '%s'", release.tag_name.c_str());
+    MessageBoxA(nullptr, buffer, "Downloading...", 0);
+
     DownloadWindow window;
     window.Create();
     window.SetChangelog(release.body.c_str(), release.body.size());
 
-    AsyncFileDownloader downloader;
-    AsyncDownload(url.c_str(), &downloader);
-
-    while (!window.ShouldClose()) {
-        window.PollMessages(16);
-
-        if (!downloader.IsCompleted()) {
-            size_t BytesDownloaded = downloader.GetDownloadCount();
-            const auto progress = BytesDownloaded * 100 / file_size;
-            SendMessageW(window.m_hProgressBar, PBM_SETPOS, progress, 0);
+    std::string file_content;
+    std::string sha256;
+    if (!local_content.empty()) {
+        std::vector<std::unique_ptr<BlockRequest>> requests;
+        for (const auto& range : BlockUpdate::Plan(manifest, local_content, file_content, &Sha256Hex)) {
+            auto request = std::make_unique<BlockRequest>();
+            request->range = range;
+            request->ranged = true;
+            requests.push_back(std::move(request));
         }
-        else {
-            if (!downloader.IsSuccessful()) {
-                fprintf(stderr, "Failed to download '%s'. (Status: %s, StatusCode: %d)\n",
-                        url.c_str(), downloader.GetStatusStr(), downloader.GetStatusCode());
+        fprintf(stderr, "Downloading %zu ranges of '%s'\n", requests.size(), url.c_str());
+        if (!requests.empty() && !RunBlockRequests(window, window.m_hProgressBar, requests, url.c_str())) {
+            if (window.ShouldClose()) {
                 return false;
             }
-
-            std::string& file_content = downloader.GetContent();
-            if (!WriteEntireFile(dll_path.wstring().c_str(), file_content.c_str(), file_content.size())) {
-                fwprintf(stderr, L"WriteEntireFile failed on '%s' with %zu bytes\n",
-                         dll_path.wstring().c_str(), file_content.size());
-                return false;
+            file_content.clear();
+        }
+        for (const auto& request : requests) {
+            if (!file_content.empty() && !BlockUpdate::Apply(request->range, request->downloader.GetContent(), file_content)) {
+                file_content.clear();
             }
+        }
+        if (!file_content.empty() && (!Sha256Hex(file_content.data(), file_content.size(), sha256) || sha256 != manifest.sha256)) {
+            fprintf(stderr, "Reassembled dll doesn't match the manifest, downloading all of it\n");
+            file_content.clear();
+        }
+    }
 
-            downloader.Clear();
-            SendMessageW(window.m_hProgressBar, PBM_SETPOS, 100, 0);
-            SendMessageW(window.m_hWnd, WM_CLOSE, 0, 0);
+    if (file_content.empty()) {
+        std::vector<std::unique_ptr<BlockRequest>> requests;
+        requests.push_back(std::make_unique<BlockRequest>());
+        if (has_manifest) {
+            requests[0]->range.length = manifest.size;
+        }
+        else {
+            const auto asset = std::ranges::find(release.assets, url, &Asset::browser_download_url);
+            requests[0]->range.length = asset->size;
+        }
+        if (!RunBlockRequests(window, window.m_hProgressBar, requests, url.c_str())) {
+            return false;
+        }
+        file_content = std::move(requests[0]->downloader.GetContent());
+        if (has_manifest && (!Sha256Hex(file_content.data(), file_content.size(), sha256) || sha256 != manifest.sha256)) {
+            fprintf(stderr, "Downloaded dll doesn't match the manifest\n");
+            return false;
         }
     }
 
-    //
-    // The user could close the window, before the download is complete
-    //
-    if (downloader.IsPending()) {
-        downloader.Abort();
+    // Write next to the dll and swap it in, so a failure never leaves a truncated dll behind
+    auto tmp_path = dll_path;
+    tmp_path += L".tmp";
+    if (!WriteEntireFile(tmp_path.wstring().c_str(), file_content.c_str(), file_content.size())) {
+        fwprintf(stderr, L"WriteEntireFile failed on '%s' with %zu bytes\n",
+                 tmp_path.wstring().c_str(), file_content.size());
+        return false;
+    }
+    if (!MoveFileExW(tmp_path.wstring().c_str(), dll_path.wstring().c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        fprintf(stderr, "MoveFileExW failed (%lu)\n", GetLastError());
         return false;
     }
 
+    SendMessageW(window.m_hWnd, WM_CLOSE, 0, 0);
     return true;
 }
 
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 
+#include <Path.h>
 #include <Str.h>
 
 #include "Inject.h"
@@ -103,16 +104,21 @@ InjectReply InjectWindow::AskInjectProcess(Process* target_process)
         return InjectReply_NoProcess;
     }
 
-    uintptr_t charname_rva;
-    const ProcessScanner scanner(processes.data());
-    if (!scanner.FindPatternRva("\x8B\xF8\x6A\x03\x68\x0F\x00\x00\xC0\x8B\xCF\xE8", "xxxxxxxxxxxx", -0x42, &charname_rva)) {
-        return InjectReply_PatternError;
+    ProcessScanner scanner(processes.data());
+    std::filesystem::path cache_path;
+    if (PathGetDocumentsPath(cache_path, L"GWToolboxpp\\pattern_cache.json")) {
+        scanner.LoadCache(cache_path);
     }
-
-    uintptr_t email_rva;
-    if (!scanner.FindPatternRva("\x33\xC0\x5D\xC2\x10\x00\xCC\x68\x80\x00\x00\x00", "xxxxxxxxxxxx", 0xE, &email_rva)) {
+    std::vector<ScanPattern> patterns = {
+        {"\x8B\xF8\x6A\x03\x68\x0F\x00\x00\xC0\x8B\xCF\xE8", "xxxxxxxxxxxx", -0x42},
+        {"\x33\xC0\x5D\xC2\x10\x00\xCC\x68\x80\x00\x00\x00", "xxxxxxxxxxxx", 0xE},
+    };
+    if (!scanner.FindPatternsRva(patterns)) {
         return InjectReply_PatternError;
     }
+    const uintptr_t charname_rva = patterns[0].rva;
+    const uintptr_t email_rva = patterns[1].rva;
+    scanner.SaveCache();
 
     std::vector<InjectProcess> inject_processes;
 
@@ -0,0 +1,279 @@
+// Built without the launcher's stdafx.h (the tests build it on Linux); the precompiled header is still forced in
+// for the launcher itself.
+
+#include "PatternScanner.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <emmintrin.h>
+#include <nlohmann/json.hpp>
+
+namespace {
+    // Index of the first byte equal to value in [from, size), or size. SSE2 is always there on the targets we build for.
+    size_t FindByte(const uint8_t* buffer, size_t from, const size_t size, const uint8_t value)
+    {
+        const __m128i needle = _mm_set1_epi8(static_cast<char>(value));
+        for (; from + 16 <= size; from += 16) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + from));
+            if (const auto bits = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)))) {
+                return from + std::countr_zero(bits);
+            }
+        }
+        for (; from < size; from++) {
+            if (buffer[from] == value) {
+                return from;
+            }
+        }
+        return size;
+    }
+
+    bool Matches(const uint8_t* at, const uint8_t* pattern, const char* mask, const size_t length)
+    {
+        for (size_t j = 0; j < length; j++) {
+            if (mask[j] == 'x' && at[j] != pattern[j]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename T>
+    T ReadAt(const uint8_t* image, const size_t offset)
+    {
+        T value;
+        memcpy(&value, image + offset, sizeof(value));
+        return value;
+    }
+
+    // Identifies one build of a module from its PE headers, which are the first bytes of the image.
+    // Offsets are those of IMAGE_DOS_HEADER and IMAGE_NT_HEADERS32.
+    std::string ModuleId(const uint8_t* image, const size_t size)
+    {
+        constexpr size_t dos_header_size = 0x40;
+        constexpr size_t nt_headers_size = 0xF8;
+        if (size < dos_header_size || ReadAt<uint16_t>(image, 0) != 0x5A4D) { // "MZ"
+            return {};
+        }
+        const auto e_lfanew = ReadAt<int32_t>(image, 0x3C);
+        if (e_lfanew < 0 || static_cast<size_t>(e_lfanew) + nt_headers_size > size) {
+            return {};
+        }
+        const auto nt = static_cast<size_t>(e_lfanew);
+        if (ReadAt<uint32_t>(image, nt) != 0x00004550) { // "PE\0\0"
+            return {};
+        }
+        const auto time_date_stamp = ReadAt<uint32_t>(image, nt + 0x08);
+        const auto size_of_image = ReadAt<uint32_t>(image, nt + 0x50);
+        const auto checksum = ReadAt<uint32_t>(image, nt + 0x58);
+        char id[32];
+        snprintf(id, sizeof(id), "%08X-%08X-%08X", time_date_stamp, size_of_image, checksum);
+        return id;
+    }
+
+    // Pattern bytes in hex, then the mask and the offset
+    std::string CacheKey(const ScanPattern& pattern)
+    {
+        const size_t length = strlen(pattern.mask);
+        std::string key;
+        key.reserve(length * 3 + 16);
+        char hex[3];
+        for (size_t i = 0; i < length; i++) {
+            snprintf(hex, sizeof(hex), "%02X", static_cast<uint8_t>(pattern.pattern[i]));
+            key += pattern.mask[i] == 'x' ? hex : "??";
+        }
+        key += ':';
+        key += pattern.mask;
+        key += ':';
+        key += std::to_string(pattern.offset);
+        return key;
+    }
+}
+
+PatternScanner::PatternScanner(std::vector<uint8_t> image)
+    : m_image(std::move(image))
+{
+    m_module_id = ModuleId(m_image.data(), m_image.size());
+}
+
+bool PatternScanner::MatchesAt(const ScanPattern& pattern, const uintptr_t rva) const
+{
+    const size_t length = strlen(pattern.mask);
+    const uintptr_t start = rva - static_cast<uintptr_t>(pattern.offset);
+    return start < m_image.size() && length <= m_image.size() - start
+           && Matches(m_image.data() + start, reinterpret_cast<const uint8_t*>(pattern.pattern), pattern.mask, length);
+}
+
+bool PatternScanner::FindPatternsRva(std::vector<ScanPattern>& patterns)
+{
+    std::vector<ScanPattern*> misses;
+    for (auto& pattern : patterns) {
+        pattern.found = false;
+        pattern.rva = 0;
+        if (!m_module_id.empty()) {
+            // A cached address only counts if the pattern still matches there
+            const auto cached = m_cache.find(CacheKey(pattern));
+            if (cached != m_cache.end() && MatchesAt(pattern, cached->second)) {
+                pattern.rva = cached->second;
+                pattern.found = true;
+                continue;
+            }
+        }
+        misses.push_back(&pattern);
+    }
+    if (misses.empty()) {
+        return true;
+    }
+
+    const bool all_found = ScanPatterns(misses);
+    if (!m_module_id.empty()) {
+        for (const auto pattern : misses) {
+            if (pattern->found) {
+                m_cache[CacheKey(*pattern)] = pattern->rva;
+                m_cache_dirty = true;
+            }
+        }
+    }
+    return all_found;
+}
+
+bool PatternScanner::LoadCache(const std::filesystem::path& path)
+{
+    m_cache_path = path;
+    m_cache.clear();
+    m_cache_dirty = false;
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    const auto json = nlohmann::json::parse(file, nullptr, false);
+    if (json.is_discarded() || !json.is_object()) {
+        fprintf(stderr, "Ignoring malformed pattern cache '%ls'\n", path.wstring().c_str());
+        return false;
+    }
+    const auto it_module = json.find("module");
+    const auto it_entries = json.find("entries");
+    if (it_module == json.end() || !it_module->is_string() || it_entries == json.end() || !it_entries->is_object()) {
+        return false;
+    }
+    if (m_module_id.empty() || it_module->get<std::string>() != m_module_id) {
+        // Different build of the game; every cached address is stale
+        m_cache_dirty = true;
+        return false;
+    }
+    for (const auto& [key, value] : it_entries->items()) {
+        if (value.is_number_unsigned()) {
+            m_cache[key] = value.get<uintptr_t>();
+        }
+    }
+    return true;
+}
+
+bool PatternScanner::SaveCache() const
+{
+    if (!m_cache_dirty || m_cache_path.empty() || m_module_id.empty()) {
+        return true;
+    }
+    nlohmann::json json;
+    json["module"] = m_module_id;
+    auto& entries = json["entries"] = nlohmann::json::object();
+    for (const auto& [key, rva] : m_cache) {
+        entries[key] = rva;
+    }
+
+    std::filesystem::path tmp_path = m_cache_path;
+    tmp_path += L".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::trunc);
+        if (!file.is_open()) {
+            fprintf(stderr, "Couldn't write pattern cache '%ls'\n", tmp_path.wstring().c_str());
+            return false;
+        }
+        file << json.dump();
+        if (!file.good()) {
+            return false;
+        }
+    }
+    // Replaces the old cache in one step (MoveFileExW with MOVEFILE_REPLACE_EXISTING on Windows)
+    std::error_code error;
+    std::filesystem::rename(tmp_path, m_cache_path, error);
+    if (error) {
+        fprintf(stderr, "Couldn't replace pattern cache '%ls' (%s)\n", m_cache_path.wstring().c_str(), error.message().c_str());
+        return false;
+    }
+    return true;
+}
+
+bool PatternScanner::ScanPatterns(const std::vector<ScanPattern*>& patterns) const
+{
+    const uint8_t* buffer = m_image.data();
+    const size_t size = m_image.size();
+
+    // Each pattern is anchored on its rarest fixed byte, and patterns sharing an anchor byte are resolved together:
+    // every occurrence of the anchor byte is a candidate for all of them, checked against their masks.
+    size_t histogram[256] = {};
+    for (size_t i = 0; i < size; i++) {
+        histogram[buffer[i]]++;
+    }
+
+    struct Anchored {
+        ScanPattern* pattern;
+        size_t length;
+        size_t anchor; // index of the anchor byte in the pattern
+    };
+    std::vector<Anchored> by_anchor[256];
+    size_t remaining = 0;
+    for (const auto pattern_ptr : patterns) {
+        auto& pattern = *pattern_ptr;
+        const size_t length = strlen(pattern.mask);
+        if (length > size) {
+            continue;
+        }
+        const auto upattern = reinterpret_cast<const uint8_t*>(pattern.pattern);
+        size_t anchor = length;
+        for (size_t j = 0; j < length; j++) {
+            if (pattern.mask[j] == 'x' && (anchor == length || histogram[upattern[j]] < histogram[upattern[anchor]])) {
+                anchor = j;
+            }
+        }
+        if (anchor == length) {
+            // Nothing fixed; matches at the start of the module
+            pattern.rva = static_cast<uintptr_t>(pattern.offset);
+            pattern.found = true;
+            continue;
+        }
+        by_anchor[upattern[anchor]].push_back({&pattern, length, anchor});
+        remaining++;
+    }
+
+    for (size_t value = 0; remaining && value < 256; value++) {
+        auto& group = by_anchor[value];
+        size_t unresolved = group.size();
+        // Occurrences come in increasing order, so each pattern's first hit is its lowest match like a linear scan would find
+        for (size_t at = FindByte(buffer, 0, size, static_cast<uint8_t>(value)); unresolved && at < size;
+             at = FindByte(buffer, at + 1, size, static_cast<uint8_t>(value))) {
+            for (auto& candidate : group) {
+                if (candidate.pattern->found || at < candidate.anchor) {
+                    continue;
+                }
+                const size_t start = at - candidate.anchor;
+                if (start + candidate.length > size) {
+                    continue;
+                }
+                if (Matches(buffer + start, reinterpret_cast<const uint8_t*>(candidate.pattern->pattern), candidate.pattern->mask, candidate.length)) {
+                    candidate.pattern->rva = start + candidate.pattern->offset;
+                    candidate.pattern->found = true;
+                    unresolved--;
+                    remaining--;
+                }
+            }
+        }
+    }
+    return std::ranges::all_of(patterns, [](const ScanPattern* pattern) {
+        return pattern->found;
+    });
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ScanPattern {
+    const char* pattern;
+    const char* mask;
+    int offset;
+
+    // Filled in by PatternScanner::FindPatternsRva
+    uintptr_t rva = 0;
+    bool found = false;
+};
+
+// Finds masked byte patterns in a copy of a module image. Kept apart from ProcessScanner, which copies the image out
+// of the game, so it builds without Windows and can be tested and benchmarked on its own.
+class PatternScanner {
+public:
+    PatternScanner() = default;
+    explicit PatternScanner(std::vector<uint8_t> image);
+    PatternScanner(PatternScanner&&) = default;
+    PatternScanner& operator=(PatternScanner&&) = default;
+
+    // Resolves every pattern to its first match in the module, sharing the scan between patterns.
+    // Patterns found in the loaded cache are only checked at their cached address. Returns true if all of them were found.
+    bool FindPatternsRva(std::vector<ScanPattern>& patterns);
+
+    // Results cached for this exact module (same PE timestamp, size and checksum) are reused by FindPatternsRva.
+    // Entries for any other build of the module are dropped.
+    bool LoadCache(const std::filesystem::path& path);
+    // Writes the cache back if FindPatternsRva had to scan for anything
+    bool SaveCache() const;
+
+    // Empty if the image doesn't start with PE headers, in which case nothing is cached
+    [[nodiscard]] const std::string& GetModuleId() const { return m_module_id; }
+
+private:
+    bool ScanPatterns(const std::vector<ScanPattern*>& patterns) const;
+    [[nodiscard]] bool MatchesAt(const ScanPattern& pattern, uintptr_t rva) const;
+
+    std::vector<uint8_t> m_image;
+
+    std::string m_module_id;
+    std::filesystem::path m_cache_path;
+    std::unordered_map<std::string, uintptr_t> m_cache;
+    bool m_cache_dirty = false;
+};
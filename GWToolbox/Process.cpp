@@ -320,17 +320,12 @@ ProcessScanner::ProcessScanner(Process* process)
     process->GetModule(&module);
 
     m_base = module.base;
-    m_size = module.size;
-    m_buffer = new uint8_t[module.size];
-    process->Read(module.base, m_buffer, m_size);
+    std::vector<uint8_t> image(module.size);
+    process->Read(module.base, image.data(), image.size());
+    m_scanner = PatternScanner(std::move(image));
 }
 
-ProcessScanner::~ProcessScanner()
-{
-    delete[] m_buffer;
-}
-
-uintptr_t ProcessScanner::FindPattern(const char* pattern, const char* mask, const int offset) const
+uintptr_t ProcessScanner::FindPattern(const char* pattern, const char* mask, const int offset)
 {
     uintptr_t rva;
     if (FindPatternRva(pattern, mask, offset, &rva)) {
@@ -339,21 +334,12 @@ uintptr_t ProcessScanner::FindPattern(const char* pattern, const char* mask, con
     return 0;
 }
 
-bool ProcessScanner::FindPatternRva(const char* pattern, const char* mask, const int offset, uintptr_t* rva) const
+bool ProcessScanner::FindPatternRva(const char* pattern, const char* mask, const int offset, uintptr_t* rva)
 {
-    const size_t length = strlen(mask);
-    const auto upattern = reinterpret_cast<const uint8_t*>(pattern);
-    for (size_t i = 0; i < m_size; i++) {
-        size_t j;
-        for (j = 0; j < length; j++) {
-            if (mask[j] == 'x' && m_buffer[i + j] != upattern[j]) {
-                break;
-            }
-        }
-        if (j == length) {
-            *rva = i + offset;
-            return true;
-        }
+    std::vector<ScanPattern> patterns = {{pattern, mask, offset}};
+    if (!FindPatternsRva(patterns)) {
+        return false;
     }
-    return false;
+    *rva = patterns[0].rva;
+    return true;
 }
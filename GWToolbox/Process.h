@@ -1,5 +1,9 @@
 #pragma once
 
+#include <filesystem>
+
+#include "PatternScanner.h"
+
 struct ProcessModule {
     uintptr_t base = 0;
     size_t size = 0;
@@ -44,13 +48,15 @@ class ProcessScanner {
 public:
     ProcessScanner(Process* process);
     ProcessScanner(const ProcessScanner&) = delete;
-    ~ProcessScanner();
 
-    uintptr_t FindPattern(const char* pattern, const char* mask, int Offset) const;
-    bool FindPatternRva(const char* pattern, const char* mask, int offset, uintptr_t* rva) const;
+    uintptr_t FindPattern(const char* pattern, const char* mask, int Offset);
+    bool FindPatternRva(const char* pattern, const char* mask, int offset, uintptr_t* rva);
+    // See PatternScanner
+    bool FindPatternsRva(std::vector<ScanPattern>& patterns) { return m_scanner.FindPatternsRva(patterns); }
+    bool LoadCache(const std::filesystem::path& path) { return m_scanner.LoadCache(path); }
+    bool SaveCache() const { return m_scanner.SaveCache(); }
 
 private:
     uintptr_t m_base = 0;
-    size_t m_size = 0;
-    uint8_t* m_buffer = nullptr;
+    PatternScanner m_scanner;
 };
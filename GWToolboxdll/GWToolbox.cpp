@@ -982,6 +982,7 @@ void GWToolbox::Draw(IDirect3DDevice9* device)
     }
     // Draw loop
     Resources::DxUpdate(device);
+    GwDatTextureModule::DxUpdate(device);
 
     if (!CanRenderToolbox())
         return;
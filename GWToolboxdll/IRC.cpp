@@ -46,22 +46,88 @@
 #endif
 
 
-IRC::IRC()
+namespace {
+    // IRCv3 allows 8191 bytes of tags on top of the 512 byte message
+    constexpr size_t max_line_length = 8191 + 512;
+
+    std::string unescape_tag_value(const std::string_view value)
+    {
+        std::string out;
+        out.reserve(value.size());
+        for (size_t i = 0; i < value.size(); i++) {
+            if (value[i] != '\\') {
+                out += value[i];
+                continue;
+            }
+            if (++i == value.size()) {
+                break; // Trailing backslash is dropped
+            }
+            switch (value[i]) {
+                case ':':
+                    out += ';';
+                    break;
+                case 's':
+                    out += ' ';
+                    break;
+                case 'r':
+                    out += '\r';
+                    break;
+                case 'n':
+                    out += '\n';
+                    break;
+                default:
+                    out += value[i];
+                    break;
+            }
+        }
+        return out;
+    }
+
+    void parse_tags(const std::string_view tags_str, irc_tags& out)
+    {
+        size_t pos = 0;
+        while (pos <= tags_str.size()) {
+            auto end = tags_str.find(';', pos);
+            if (end == std::string_view::npos) {
+                end = tags_str.size();
+            }
+            const auto tag = tags_str.substr(pos, end - pos);
+            const auto eq = tag.find('=');
+            if (!tag.empty()) {
+                if (eq == std::string_view::npos) {
+                    out[std::string(tag)] = "";
+                }
+                else {
+                    out[std::string(tag.substr(0, eq))] = unescape_tag_value(tag.substr(eq + 1));
+                }
+            }
+            pos = end + 1;
+        }
+    }
+}
+
+const char* irc_reply_data::tag(const char* name) const
 {
-    hooks = nullptr;
-    chan_users = nullptr;
-    connected = false;
-    sentnick = false;
-    sentpass = false;
-    sentuser = false;
-    pending_disconnect = false;
-    cur_nick = nullptr;
+    if (!tags) {
+        return nullptr;
+    }
+    const auto found = tags->find(name);
+    return found == tags->end() ? nullptr : found->second.c_str();
 }
 
+IRC::IRC() = default;
+
 IRC::~IRC()
 {
-    if (hooks) {
-        delete_irc_command_hook(hooks);
+    disconnect();
+    if (t.joinable()) {
+        t.join();
+    }
+    if (socket_event != WSA_INVALID_EVENT) {
+        WSACloseEvent(socket_event);
+    }
+    if (wake_event != WSA_INVALID_EVENT) {
+        WSACloseEvent(wake_event);
     }
     if (wsaData.wVersion) {
         WSACleanup();
@@ -69,46 +135,18 @@ IRC::~IRC()
     }
 }
 
-void IRC::insert_irc_command_hook(irc_command_hook* hook, const char* cmd_name, int (*function_ptr)(const char*, irc_reply_data*, void*))
+void IRC::hook_irc_command(const char* cmd_name, const irc_hook_func function_ptr)
 {
-    if (hook->function) {
-        if (!hook->next) {
-            hook->next = new irc_command_hook;
-            hook->next->function = nullptr;
-            hook->next->irc_command = nullptr;
-            hook->next->next = nullptr;
-        }
-        insert_irc_command_hook(hook->next, cmd_name, function_ptr);
-    }
-    else {
-        hook->function = function_ptr;
-        hook->irc_command = new char[strlen(cmd_name) + 1];
-        strcpy(hook->irc_command, cmd_name);
-    }
+    // First hook registered for a command wins
+    hooks.try_emplace(cmd_name, function_ptr);
 }
 
-void IRC::hook_irc_command(const char* cmd_name, int (*function_ptr)(const char*, irc_reply_data*, void*))
+void IRC::set_send_rate(const uint32_t burst, const uint32_t interval_ms)
 {
-    if (!hooks) {
-        hooks = new irc_command_hook;
-        hooks->function = nullptr;
-        hooks->irc_command = nullptr;
-        hooks->next = nullptr;
-        insert_irc_command_hook(hooks, cmd_name, function_ptr);
-    }
-    else {
-        insert_irc_command_hook(hooks, cmd_name, function_ptr);
-    }
-}
-
-void IRC::delete_irc_command_hook(const irc_command_hook* cmd_hook)
-{
-    if (cmd_hook->next) {
-        delete_irc_command_hook(cmd_hook->next);
-    }
-
-    delete cmd_hook->irc_command;
-    delete cmd_hook;
+    std::lock_guard lock(send_mutex);
+    send_burst = std::max(burst, 1u);
+    send_interval_ms = std::max(interval_ms, 1u);
+    send_tokens = std::min(send_tokens, static_cast<double>(send_burst));
 }
 
 int IRC::start(const char* server, int port, const char* nick, const char* user, const char* name, const char* pass)
@@ -118,7 +156,12 @@ int IRC::start(const char* server, int port, const char* nick, const char* user,
         printf("IRC::start called when already connected\n");
         return 1;
     }
+    // A previous connection may have been closed from its own thread
+    if (t.joinable()) {
+        t.join();
+    }
     ping_sent = 0;
+    pong_recieved = 0;
 
     //setup hints
     hints.ai_family = AF_UNSPEC;     //IPv4 or IPv6 doesnt matter
@@ -139,28 +182,58 @@ int IRC::start(const char* server, int port, const char* nick, const char* user,
     //setup socket
     if ((irc_socket = socket(servinfo->ai_family, servinfo->ai_socktype, servinfo->ai_protocol)) == INVALID_SOCKET) {
         printf("Failed to socket: %d\n", WSAGetLastError());
+        freeaddrinfo(servinfo);
         return 1;
     }
-    disconnect();
 
     //Connect
     if (connect(irc_socket, servinfo->ai_addr, servinfo->ai_addrlen) == SOCKET_ERROR) {
         printf("Failed to connect: %d\n", WSAGetLastError());
+        freeaddrinfo(servinfo);
         closesocket(irc_socket);
+        irc_socket = INVALID_SOCKET;
         return 1;
     }
 
     //We dont need this anymore
     freeaddrinfo(servinfo);
 
+    // Makes the socket non-blocking; the event is signalled when there's something to read, room to write, or the server hung up
+    if (socket_event == WSA_INVALID_EVENT) {
+        socket_event = WSACreateEvent();
+    }
+    if (wake_event == WSA_INVALID_EVENT) {
+        wake_event = WSACreateEvent();
+    }
+    WSAResetEvent(socket_event);
+    WSAResetEvent(wake_event);
+    if (socket_event == WSA_INVALID_EVENT || wake_event == WSA_INVALID_EVENT
+        || WSAEventSelect(irc_socket, socket_event, FD_READ | FD_WRITE | FD_CLOSE) == SOCKET_ERROR) {
+        printf("Failed to WSAEventSelect: %d\n", WSAGetLastError());
+        close_connection();
+        return 1;
+    }
+
+    recv_buffer.clear();
+    {
+        std::lock_guard lock(send_mutex);
+        send_queue.clear();
+        send_offset = 0;
+        send_tokens = send_burst;
+        send_refilled = clock();
+    }
+    {
+        std::lock_guard lock(nick_mutex);
+        cur_nick = nick;
+    }
+    pending_disconnect = false;
     connected = true;
-    t = std::thread([&] {
-        message_loop();
-    });
-    t.detach();
     raw("PASS %s\r\n", pass);
     raw("USER %s\r\n", user);
     raw("NICK %s\r\n", user);
+    t = std::thread([this] {
+        message_loop();
+    });
 
     return 0;
 }
@@ -170,23 +243,31 @@ void IRC::disconnect()
     if (!connected) {
         return;
     }
-    if (dataout) {
-        fclose(dataout);
-    }
-    printf("Disconnected from server.\n");
-    connected = false;
     quit("Leaving");
-#ifdef WIN32
-    shutdown(irc_socket, 2);
-#endif
-    closesocket(irc_socket);
-    // Destroy thread.
     pending_disconnect = true;
+    WSASetEvent(wake_event);
+    // Hooks run on the message loop thread and may disconnect; the loop cleans up after itself
+    if (std::this_thread::get_id() == t.get_id()) {
+        return;
+    }
     if (t.joinable()) {
         t.join();
     }
-    pending_disconnect = false;
-    t.~thread();
+    printf("Disconnected from server.\n");
+}
+
+void IRC::close_connection()
+{
+    if (irc_socket != INVALID_SOCKET) {
+        shutdown(irc_socket, SD_BOTH);
+        closesocket(irc_socket);
+        irc_socket = INVALID_SOCKET;
+    }
+    {
+        std::lock_guard lock(users_mutex);
+        channel_users.clear();
+    }
+    connected = false;
 }
 
 void IRC::error(const int err)
@@ -207,22 +288,25 @@ int IRC::message_fetch()
     if (!connected) {
         return 1;
     }
-    message_buffer[0] = '\0';
-    const auto ret_len = recv(irc_socket, message_buffer, 1023, 0);
-    if (ret_len == SOCKET_ERROR) {
-        printf("IRC::message_fetch recv failed, %d\n", WSAGetLastError());
-        connected = false;
-        closesocket(irc_socket);
-        return 1;
-    }
-    if (!message_buffer[0]) {
-        printf("IRC::message_fetch message empty; graceful close?\n");
-        connected = false;
-        closesocket(irc_socket);
+    char chunk[4096];
+    while (true) {
+        const auto ret_len = recv(irc_socket, chunk, sizeof(chunk), 0);
+        if (ret_len > 0) {
+            recv_buffer.append(chunk, static_cast<size_t>(ret_len));
+            continue;
+        }
+        if (ret_len == 0) {
+            printf("IRC::message_fetch connection closed by server\n");
+            return 1;
+        }
+        const auto err = WSAGetLastError();
+        if (err == WSAEWOULDBLOCK) {
+            break;
+        }
+        printf("IRC::message_fetch recv failed, %d\n", err);
         return 1;
     }
-    message_buffer[ret_len] = '\0';
-    split_to_replies(message_buffer);
+    split_to_replies();
     return 0;
 }
 
@@ -243,9 +327,9 @@ int IRC::ping()
     }
     if (ping_sent && now - ping_sent > timeout) {
         printf("IRC::ping failed to get pong response after timeout; graceful close?\n");
-        connected = false;
         ping_sent = 0;
-        closesocket(irc_socket);
+        pending_disconnect = true;
+        WSASetEvent(wake_event);
         return 1;
     }
     return 0;
@@ -258,74 +342,121 @@ bool IRC::is_connected() const
 
 int IRC::message_loop()
 {
-    while (true) {
+    const WSAEVENT events[] = {socket_event, wake_event};
+    int result = 0;
+    while (!pending_disconnect) {
+        const DWORD timeout = flush_send_queue();
         if (!connected) {
+            result = 1;
+            break;
+        }
+        const DWORD signalled = WSAWaitForMultipleEvents(_countof(events), events, FALSE, timeout, FALSE);
+        if (signalled == WSA_WAIT_FAILED) {
+            error(WSAGetLastError());
+            result = 1;
+            break;
+        }
+        if (signalled == WSA_WAIT_EVENT_0 + 1) {
+            WSAResetEvent(wake_event);
             continue;
         }
-        if (pending_disconnect) {
-            return 0;
+        if (signalled != WSA_WAIT_EVENT_0) {
+            continue; // Timed out waiting for the rate limit
         }
-        if (message_fetch() != 0) {
-            return 1;
+        WSANETWORKEVENTS network_events{};
+        if (WSAEnumNetworkEvents(irc_socket, socket_event, &network_events) == SOCKET_ERROR) {
+            error(WSAGetLastError());
+            result = 1;
+            break;
+        }
+        if (network_events.lNetworkEvents & (FD_READ | FD_CLOSE)) {
+            if (message_fetch() != 0) {
+                result = 1;
+                break;
+            }
+        }
+        if (network_events.lNetworkEvents & FD_CLOSE) {
+            result = 1;
+            break;
         }
     }
+    // Best effort to get QUIT out before closing
+    flush_send_queue();
+    close_connection();
+    return result;
 }
 
-void IRC::split_to_replies(const char* data)
+void IRC::split_to_replies()
 {
-    const char* p;
-    while (p = strstr(data, "\r\n")) {
-        *const_cast<char*>(p) = '\0';
-        parse_irc_reply(data);
-        data = p + 2;
+    size_t start = 0;
+    size_t newline;
+    while ((newline = recv_buffer.find('\n', start)) != std::string::npos) {
+        size_t end = newline;
+        if (end > start && recv_buffer[end - 1] == '\r') {
+            end--;
+        }
+        recv_buffer[end] = '\0';
+        if (end > start) {
+            parse_irc_reply(&recv_buffer[start]);
+        }
+        start = newline + 1;
+    }
+    recv_buffer.erase(0, start);
+    if (recv_buffer.size() > max_line_length) {
+        printf("IRC::split_to_replies discarding %zu bytes without a line ending\n", recv_buffer.size());
+        recv_buffer.clear();
     }
 }
 
-int IRC::is_op(const char* channel, const char* nick) const
+char IRC::channel_user_flags(const char* channel, const char* nick) const
 {
-    const channel_user* cup = chan_users;
-
-    while (cup) {
-        if (!strcmp(cup->channel, channel) && !strcmp(cup->nick, nick)) {
-            return cup->flags & IRC_USER_OP;
-        }
-        cup = cup->next;
+    std::lock_guard lock(users_mutex);
+    const auto found_channel = channel_users.find(channel);
+    if (found_channel == channel_users.end()) {
+        return 0;
     }
+    const auto found_user = found_channel->second.find(nick);
+    return found_user == found_channel->second.end() ? 0 : found_user->second;
+}
 
-    return 0;
+int IRC::is_op(const char* channel, const char* nick) const
+{
+    return channel_user_flags(channel, nick) & IRC_USER_OP;
 }
 
 int IRC::is_voice(const char* channel, const char* nick) const
 {
-    const channel_user* cup = chan_users;
-
-    while (cup) {
-        if (!strcmp(cup->channel, channel) && !strcmp(cup->nick, nick)) {
-            return cup->flags & IRC_USER_VOICE;
-        }
-        cup = cup->next;
-    }
-
-    return 0;
+    return channel_user_flags(channel, nick) & IRC_USER_VOICE;
 }
 
-void IRC::parse_irc_reply(const char* data)
+void IRC::parse_irc_reply(char* data)
 {
     char* hostd;
     char* cmd;
     char* params;
-    //char buffer[514];
     irc_reply_data hostd_tmp{};
-    channel_user* cup;
-    char* p;
-    char* chan_temp;
-
-    hostd_tmp.target = nullptr;
+    irc_tags tags;
 
+#if __IRC_DEBUG__
     printf("%s\n", data);
+#endif
+
+    if (data[0] == '@') {
+        char* tags_end = strchr(data, ' ');
+        if (!tags_end) {
+            return;
+        }
+        *tags_end = '\0';
+        parse_tags(&data[1], tags);
+        hostd_tmp.tags = &tags;
+        data = tags_end + 1;
+        while (*data == ' ') {
+            data++;
+        }
+    }
 
     if (data[0] == ':') {
-        hostd = const_cast<char*>(&data[1]);
+        hostd = &data[1];
         cmd = strchr(hostd, ' ');
         if (!cmd) {
             return;
@@ -348,295 +479,129 @@ void IRC::parse_irc_reply(const char* data)
                 hostd_tmp.host++;
             }
         }
+        if (!params) {
+            params = const_cast<char*>("");
+        }
 
         if (!strcmp(cmd, "JOIN")) {
-            cup = chan_users;
-            if (cup) {
-                while (cup->nick) {
-                    if (!cup->next) {
-                        cup->next = new channel_user;
-                        cup->next->channel = nullptr;
-                        cup->next->flags = 0;
-                        cup->next->next = nullptr;
-                        cup->next->nick = nullptr;
-                    }
-                    cup = cup->next;
-                }
-                cup->channel = new char[strlen(params) + 1];
-                strcpy(cup->channel, params);
-                cup->nick = new char[strlen(hostd_tmp.nick) + 1];
-                strcpy(cup->nick, hostd_tmp.nick);
-            }
+            const char* chan = params[0] == ':' ? &params[1] : params;
+            std::lock_guard lock(users_mutex);
+            channel_users[chan].try_emplace(hostd_tmp.nick, static_cast<char>(0));
         }
         else if (!strcmp(cmd, "PART")) {
-            channel_user* d;
-            channel_user* prev;
-
-            d = nullptr;
-            prev = nullptr;
-            cup = chan_users;
-            while (cup) {
-                if (!strcmp(cup->channel, params) && !strcmp(cup->nick, hostd_tmp.nick)) {
-                    d = cup;
-                    break;
-                }
-                prev = cup;
-                cup = cup->next;
-            }
-            if (d) {
-                if (d == chan_users) {
-                    chan_users = d->next;
-
-                    delete [] d->channel;
-
-                    delete [] d->nick;
-                    delete d;
-                }
-                else {
-                    if (prev) {
-                        prev->next = d->next;
-                    }
-                    chan_users = d->next;
-
-                    delete [] d->channel;
-
-                    delete [] d->nick;
-                    delete d;
-                }
+            std::string chan = params;
+            chan.erase(std::min(chan.find(' '), chan.size()));
+            std::lock_guard lock(users_mutex);
+            const auto found = channel_users.find(chan);
+            if (found != channel_users.end()) {
+                found->second.erase(hostd_tmp.nick);
             }
         }
         else if (!strcmp(cmd, "QUIT")) {
-            channel_user* d;
-            channel_user* prev;
-
-            d = nullptr;
-            prev = nullptr;
-            cup = chan_users;
-            while (cup) {
-                if (!strcmp(cup->nick, hostd_tmp.nick)) {
-                    d = cup;
-                    if (d == chan_users) {
-                        chan_users = d->next;
-
-                        delete [] d->channel;
-
-                        delete [] d->nick;
-                        delete d;
-                    }
-                    else {
-                        if (prev) {
-                            prev->next = d->next;
-                        }
-
-                        delete [] d->channel;
-
-                        delete [] d->nick;
-                        delete d;
-                    }
-                    break;
-                }
-                prev = cup;
-                cup = cup->next;
+            std::lock_guard lock(users_mutex);
+            for (auto& users : channel_users | std::views::values) {
+                users.erase(hostd_tmp.nick);
             }
         }
         else if (!strcmp(cmd, "MODE")) {
-            char* chan;
-            char* changevars;
-            channel_user* cup;
-            channel_user* d;
-            char* tmp;
-            int i;
-            bool plus;
-
-            chan = params;
-            params = strchr(chan, ' ');
-            *params = '\0';
-            params++;
-            changevars = params;
-            params = strchr(changevars, ' ');
-            if (!params) {
+            // MODE #channel +ov-v nick1 nick2 nick3
+            char* chan = params;
+            char* changevars = strchr(chan, ' ');
+            if (!changevars || chan[0] != '#') {
                 return;
             }
-            if (chan[0] != '#') {
+            *changevars++ = '\0';
+            char* targets = strchr(changevars, ' ');
+            if (!targets) {
                 return;
             }
-            *params = '\0';
-            params++;
-
-            plus = false;
-            for (i = 0; i < static_cast<signed>(strlen(changevars)); i++) {
-                switch (changevars[i]) {
+            *targets++ = '\0';
+
+            std::lock_guard lock(users_mutex);
+            auto& users = channel_users[chan];
+            bool plus = false;
+            for (const char* c = changevars; *c; c++) {
+                char flag = 0;
+                switch (*c) {
                     case '+':
                         plus = true;
-                        break;
+                        continue;
                     case '-':
                         plus = false;
-                        break;
+                        continue;
                     case 'o':
-                        tmp = strchr(params, ' ');
-                        if (tmp) {
-                            *tmp = '\0';
-                            tmp++;
-                        }
-                        tmp = params;
-                        if (plus) {
-                            // user has been opped (chan, params)
-                            cup = chan_users;
-                            d = nullptr;
-                            while (cup) {
-                                if (cup->next && cup->channel) {
-                                    if (!strcmp(cup->channel, chan) && !strcmp(cup->nick, tmp)) {
-                                        d = cup;
-                                        break;
-                                    }
-                                }
-                                cup = cup->next;
-                            }
-                            if (d) {
-                                d->flags = d->flags | IRC_USER_OP;
-                            }
-                        }
-                        else {
-                            // user has been deopped (chan, params)
-                            cup = chan_users;
-                            d = nullptr;
-                            while (cup) {
-                                if (!strcmp(cup->channel, chan) && !strcmp(cup->nick, tmp)) {
-                                    d = cup;
-                                    break;
-                                }
-                                cup = cup->next;
-                            }
-                            if (d) {
-                                d->flags = d->flags ^ IRC_USER_OP;
-                            }
-                        }
-                        params = tmp;
+                        flag = IRC_USER_OP;
+                        break;
+                    case 'h':
+                        flag = IRC_USER_HALFOP;
                         break;
                     case 'v':
-                        tmp = strchr(params, ' ');
-                        if (tmp) {
-                            *tmp = '\0';
-                            tmp++;
-                        }
-                        if (plus) {
-                            // user has been voiced
-                            cup = chan_users;
-                            d = nullptr;
-                            while (cup) {
-                                if (!strcmp(cup->channel, params) && !strcmp(cup->nick, hostd_tmp.nick)) {
-                                    d = cup;
-                                    break;
-                                }
-                                cup = cup->next;
-                            }
-                            if (d) {
-                                d->flags = d->flags | IRC_USER_VOICE;
-                            }
-                        }
-                        else {
-                            // user has been devoiced
-                            cup = chan_users;
-                            d = nullptr;
-                            while (cup) {
-                                if (!strcmp(cup->channel, params) && !strcmp(cup->nick, hostd_tmp.nick)) {
-                                    d = cup;
-                                    break;
-                                }
-                                cup = cup->next;
-                            }
-                            if (d) {
-                                d->flags = d->flags ^ IRC_USER_VOICE;
-                            }
-                        }
-                        params = tmp;
+                        flag = IRC_USER_VOICE;
                         break;
                     default:
-                        return;
+                        continue;
+                }
+                if (!*targets) {
+                    break;
+                }
+                char* target = targets;
+                targets = strchr(targets, ' ');
+                if (targets) {
+                    *targets++ = '\0';
+                }
+                else {
+                    targets = const_cast<char*>("");
                 }
-                // ------------ END OF MODE ---------------
+                auto& user_flags = users[target];
+                user_flags = plus ? static_cast<char>(user_flags | flag) : static_cast<char>(user_flags & ~flag);
             }
+            // ------------ END OF MODE ---------------
         }
         else if (!strcmp(cmd, "353")) {
-            // receiving channel names list
-            if (!chan_users) {
-                chan_users = new channel_user;
-                chan_users->next = nullptr;
-                chan_users->nick = nullptr;
-                chan_users->flags = 0;
-                chan_users->channel = nullptr;
-            }
-            cup = chan_users;
-            chan_temp = strchr(params, '#');
-            if (chan_temp) {
-                //chan_temp+=3;
-                p = strstr(chan_temp, " :");
-                if (p) {
-                    *p = '\0';
-                    p += 2;
-                    while (strchr(p, ' ')) {
-                        char* tmp;
-
-                        tmp = strchr(p, ' ');
-                        *tmp = '\0';
-                        tmp++;
-                        while (cup->nick) {
-                            if (!cup->next) {
-                                cup->next = new channel_user;
-                                cup->next->channel = nullptr;
-                                cup->next->flags = 0;
-                                cup->next->next = nullptr;
-                                cup->next->nick = nullptr;
-                            }
-                            cup = cup->next;
-                        }
-                        if (p[0] == '@') {
-                            cup->flags = cup->flags | IRC_USER_OP;
-                            p++;
-                        }
-                        else if (p[0] == '+') {
-                            cup->flags = cup->flags | IRC_USER_VOICE;
-                            p++;
-                        }
-                        cup->nick = new char[strlen(p) + 1];
-                        strcpy(cup->nick, p);
-                        cup->channel = new char[strlen(chan_temp) + 1];
-                        strcpy(cup->channel, chan_temp);
-                        p = tmp;
-                    }
-                    while (cup->nick) {
-                        if (!cup->next) {
-                            cup->next = new channel_user;
-                            cup->next->channel = nullptr;
-                            cup->next->flags = 0;
-                            cup->next->next = nullptr;
-                            cup->next->nick = nullptr;
-                        }
-                        cup = cup->next;
+            // receiving channel names list: "<me> = #channel :@op +voiced user"
+            char* chan_temp = strchr(params, '#');
+            char* p = chan_temp ? strstr(chan_temp, " :") : nullptr;
+            if (p) {
+                *p = '\0';
+                p += 2;
+                std::lock_guard lock(users_mutex);
+                auto& users = channel_users[chan_temp];
+                while (*p) {
+                    char* next = strchr(p, ' ');
+                    if (next) {
+                        *next++ = '\0';
                     }
+                    char flags = 0;
                     if (p[0] == '@') {
-                        cup->flags = cup->flags | IRC_USER_OP;
+                        flags = IRC_USER_OP;
+                        p++;
+                    }
+                    else if (p[0] == '%') {
+                        flags = IRC_USER_HALFOP;
                         p++;
                     }
                     else if (p[0] == '+') {
-                        cup->flags = cup->flags | IRC_USER_VOICE;
+                        flags = IRC_USER_VOICE;
                         p++;
                     }
-                    cup->nick = new char[strlen(p) + 1];
-                    strcpy(cup->nick, p);
-                    cup->channel = new char[strlen(chan_temp) + 1];
-                    strcpy(cup->channel, chan_temp);
+                    if (*p) {
+                        users[p] = static_cast<char>(users[p] | flags);
+                    }
+                    if (!next) {
+                        break;
+                    }
+                    p = next;
                 }
             }
         }
         else if (!strcmp(cmd, "NOTICE")) {
             hostd_tmp.target = params;
             params = strchr(hostd_tmp.target, ' ');
-            if (params) {
-                *params = '\0';
+            if (!params) {
+                return;
             }
-            params++;
-#ifdef __IRC_DEBUG__
+            *params++ = '\0';
+#if __IRC_DEBUG__
             printf("%s >-%s- %s\n", hostd_tmp.nick, hostd_tmp.target, &params[1]);
 #endif
         }
@@ -647,52 +612,41 @@ void IRC::parse_irc_reply(const char* data)
                 return;
             }
             *params++ = '\0';
-#ifdef __IRC_DEBUG__
+#if __IRC_DEBUG__
             printf("%s: <%s> %s\n", hostd_tmp.target, hostd_tmp.nick, &params[1]);
 #endif
         }
         else if (!strcmp(cmd, "NICK")) {
-            if (!strcmp(hostd_tmp.nick, cur_nick)) {
-                delete [] cur_nick;
-                cur_nick = new char[strlen(params) + 1];
-                strcpy(cur_nick, params);
+            std::lock_guard lock(nick_mutex);
+            if (cur_nick == hostd_tmp.nick) {
+                cur_nick = params[0] == ':' ? &params[1] : params;
             }
         }
-        /* else if (!strcmp(cmd, ""))
-        {
-            #ifdef __IRC_DEBUG__
-            #endif
-        } */
+        else if (!strcmp(cmd, "001")) {
+            // Welcome; the first param is the nick the server gave us
+            std::lock_guard lock(nick_mutex);
+            cur_nick.assign(params, strcspn(params, " "));
+        }
         call_hook(cmd, params, &hostd_tmp);
     }
     else {
-        cmd = const_cast<char*>(data);
-        data = strchr(cmd, ' ');
-        if (!data) {
+        cmd = data;
+        params = strchr(cmd, ' ');
+        if (!params) {
             return;
         }
-        *const_cast<char*>(data) = '\0';
-        params = const_cast<char*>(data + 1);
+        *params++ = '\0';
 
         if (!strcmp(cmd, "PING")) {
-            if (!params) {
-                return;
-            }
-            raw("PONG %s\r\n", &params[1]);
-#ifdef __IRC_DEBUG__
+            queue_line(std::format("PONG {}\r\n", params[0] == ':' ? &params[1] : params), true);
+#if __IRC_DEBUG__
             printf("Ping received, pong sent.\n");
 #endif
-            fflush(dataout);
         }
         else if (!strcmp(cmd, "PONG")) {
             pong_recieved = clock();
-            fflush(dataout);
         }
         else {
-            hostd_tmp.host = nullptr;
-            hostd_tmp.ident = nullptr;
-            hostd_tmp.nick = nullptr;
-            hostd_tmp.target = nullptr;
             call_hook(cmd, params, &hostd_tmp);
         }
     }
@@ -700,45 +654,27 @@ void IRC::parse_irc_reply(const char* data)
 
 void IRC::call_hook(const char* irc_command, const char* params, irc_reply_data* hostd)
 {
-    if (!hooks) {
-        return;
-    }
-
-    const irc_command_hook* p = hooks;
-    while (p) {
-        if (!strcmp(p->irc_command, irc_command)) {
-            (*p->function)(params, hostd, this);
-            p = nullptr;
-        }
-        else {
-            p = p->next;
-        }
+    const auto found = hooks.find(irc_command);
+    if (found != hooks.end()) {
+        found->second(params, hostd, this);
     }
 }
 
 int IRC::notice(const char* target, const char* message) const
 {
-    if (!connected) {
-        return 1;
-    }
-    fprintf(dataout, "NOTICE %s :%s\r\n", target, message);
-    return fflush(dataout);
+    return raw("NOTICE %s :%s\r\n", target, message);
 }
 
 int IRC::notice(const char* fmt, ...) const
 {
+    // fmt is the target, followed by the format string for the message
     va_list argp;
-    //char* target;
-
-    if (!connected) {
-        return 1;
-    }
     va_start(argp, fmt);
-    fprintf(dataout, "NOTICE %s :", fmt);
-    vfprintf(dataout, va_arg(argp, char*), argp);
+    const char* message_fmt = va_arg(argp, char*);
+    char message[512];
+    vsnprintf(message, sizeof(message), message_fmt, argp);
     va_end(argp);
-    fprintf(dataout, "\r\n");
-    return fflush(dataout);
+    return notice(fmt, static_cast<const char*>(message));
 }
 
 int IRC::privmsg(const char* target, const char* message) const
@@ -748,15 +684,14 @@ int IRC::privmsg(const char* target, const char* message) const
 
 int IRC::privmsg(const char* fmt, ...) const
 {
-    if (!connected) {
-        return 1;
-    }
+    // fmt is the target, followed by the format string for the message
     va_list args;
     va_start(args, fmt);
-    raw("PRIVMSG %s :", fmt);
-    const auto ok = raw(va_arg(args, char*), args);
+    const char* message_fmt = va_arg(args, char*);
+    char message[512];
+    vsnprintf(message, sizeof(message), message_fmt, args);
     va_end(args);
-    return ok;
+    return privmsg(fmt, static_cast<const char*>(message));
 }
 
 int IRC::part(const char* channel) const
@@ -783,28 +718,78 @@ int IRC::raw(const char* fmt, ...) const
     char buffer[600];
     va_list args;
     va_start(args, fmt);
-    const auto len = vsnprintf(buffer, 599, fmt, args) + 1;
+    const auto len = vsnprintf(buffer, sizeof(buffer) - 2, fmt, args);
     va_end(args);
     if (len < 1) {
         printf("IRC::raw, no message bytes or failure\n");
         return 1;
     }
+    std::string line(buffer, std::min(static_cast<size_t>(len), sizeof(buffer) - 3));
     // Add new line at the end if missing
-    if (len < 3 || buffer[len - 3] != '\r\n') {
-        buffer[len] = '\r';
-        buffer[len + 1] = '\n';
-        buffer[len + 2] = '\0';
-    }
-    printf("IRC::raw sending %s\n", buffer);
-    const auto sent_bytes = send(irc_socket, buffer, static_cast<int>(strlen(buffer)), NULL);
-    if (sent_bytes == SOCKET_ERROR) {
-        printf("IRC::raw send() failed, %d\n", WSAGetLastError());
-        return 1;
+    if (!line.ends_with("\r\n")) {
+        line += "\r\n";
+    }
+    return queue_line(std::move(line), false);
+}
+
+int IRC::queue_line(std::string line, const bool priority) const
+{
+    {
+        std::lock_guard lock(send_mutex);
+        if (priority) {
+            // Don't jump in front of a line that is half sent
+            const auto pos = send_offset ? std::next(send_queue.begin()) : send_queue.begin();
+            send_queue.insert(pos, {std::move(line), true});
+        }
+        else {
+            send_queue.push_back({std::move(line), false});
+        }
     }
-    printf("IRC::raw send() %d bytes sent\n", sent_bytes);
+    WSASetEvent(wake_event);
     return 0;
 }
 
+DWORD IRC::flush_send_queue()
+{
+    std::lock_guard lock(send_mutex);
+    const clock_t now = clock();
+    const double elapsed_ms = static_cast<double>(now - send_refilled) * 1000.0 / CLOCKS_PER_SEC;
+    send_tokens = std::min(static_cast<double>(send_burst), send_tokens + elapsed_ms * send_burst / send_interval_ms);
+    send_refilled = now;
+
+    while (!send_queue.empty()) {
+        const auto& line = send_queue.front();
+        if (!send_offset && !line.priority) {
+            if (send_tokens < 1.0) {
+                // Wake up again when the next token is available
+                return static_cast<DWORD>((1.0 - send_tokens) * send_interval_ms / send_burst) + 1;
+            }
+        }
+        const auto sent = send(irc_socket, line.data.data() + send_offset, static_cast<int>(line.data.size() - send_offset), 0);
+        if (sent == SOCKET_ERROR) {
+            const auto err = WSAGetLastError();
+            if (err != WSAEWOULDBLOCK) {
+                printf("IRC::flush_send_queue send() failed, %d\n", err);
+                connected = false;
+            }
+            // Socket buffer is full; FD_WRITE will wake us when there's room
+            return WSA_INFINITE;
+        }
+        if (!send_offset && !line.priority) {
+            send_tokens -= 1.0;
+        }
+        send_offset += static_cast<size_t>(sent);
+        if (send_offset == line.data.size()) {
+#if __IRC_DEBUG__
+            printf("IRC::raw sent %s", line.data.c_str());
+#endif
+            send_queue.pop_front();
+            send_offset = 0;
+        }
+    }
+    return WSA_INFINITE;
+}
+
 int IRC::kick(const char* channel, const char* nick, const char* message) const
 {
     return raw("KICK %s %s :%s\r\n", channel, nick, message);
@@ -820,7 +805,7 @@ int IRC::mode(const char* channel, const char* modes, const char* targets) const
 
 int IRC::mode(const char* modes) const
 {
-    return mode(cur_nick, modes, nullptr);
+    return mode(current_nick().c_str(), modes, nullptr);
 }
 
 int IRC::nick(const char* newnick) const
@@ -828,7 +813,8 @@ int IRC::nick(const char* newnick) const
     return raw("NICK %s\r\n", newnick);
 }
 
-char* IRC::current_nick() const
+std::string IRC::current_nick() const
 {
+    std::lock_guard lock(nick_mutex);
     return cur_nick;
 }
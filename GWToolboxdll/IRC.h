@@ -36,26 +36,24 @@
 #define IRC_USER_HALFOP 2
 #define IRC_USER_OP     4
 
+// IRCv3 message tags, e.g. "@badges=moderator/1;color=#8A2BE2 :nick!ident@host PRIVMSG #channel :hello"
+using irc_tags = std::unordered_map<std::string, std::string>;
+
 struct irc_reply_data {
     char* nick;
     char* ident;
     char* host;
     char* target;
-};
+    const irc_tags* tags; // nullptr if the line had no tags
 
-struct irc_command_hook {
-    char* irc_command;
-    int (*function)(const char*, irc_reply_data*, void*);
-    irc_command_hook* next;
+    // Unescaped value of an IRCv3 tag, or nullptr if the line didn't have it
+    [[nodiscard]] const char* tag(const char* name) const;
 };
 
-struct channel_user {
-    char* nick;
-    char* channel;
-    char flags;
-    channel_user* next;
-};
+using irc_hook_func = int (*)(const char*, irc_reply_data*, void*);
 
+// Runs a background thread that sleeps until the socket has data or there is something to send.
+// Outgoing lines are queued and released through a token bucket so that bursts don't exceed the server's rate limit.
 class IRC {
 public:
     IRC();
@@ -78,38 +76,58 @@ public:
     int raw(const wchar_t* fmt, ...) const;
     int join(const char* channel) const { return raw("JOIN %s\r\n", channel); }
     int kick(const char* channel, const char* nick) const { return raw("KICK %s %s\r\n", channel, nick); }
-    void hook_irc_command(const char* cmd_name, int (*function_ptr)(const char*, irc_reply_data*, void*));
+    void hook_irc_command(const char* cmd_name, irc_hook_func function_ptr);
+    // Allow at most burst lines per interval_ms; defaults to Twitch's limit for regular users (20 per 30 seconds)
+    void set_send_rate(uint32_t burst, uint32_t interval_ms);
     int message_loop();
     int message_fetch();
     int ping();
     int is_op(const char* channel, const char* nick) const;
     int is_voice(const char* channel, const char* nick) const;
-    char* current_nick() const;
+    // Copy, since the message loop thread can change it at any time
+    std::string current_nick() const;
     bool is_connected() const;
 
 private:
+    struct outgoing_line {
+        std::string data;
+        bool priority; // e.g. PONG; not rate limited
+    };
+
     static void error(int err);
     void call_hook(const char* irc_command, const char* params, irc_reply_data* hostd);
-    /*void call_the_hook(irc_command_hook* hook, char* irc_command, char*params, irc_host_data* hostd);*/
-    void parse_irc_reply(const char* data);
-    void split_to_replies(const char* data);
-    static void insert_irc_command_hook(irc_command_hook* hook, const char* cmd_name, int (*function_ptr)(const char*, irc_reply_data*, void*));
-    static void delete_irc_command_hook(const irc_command_hook* cmd_hook);
-    // int irc_socket; // This fails when using winsock2.h in Windows. Define as SOCKET to fix?
-    SOCKET irc_socket{};
-    char message_buffer[1024] = {0};
-    bool connected;
-    bool pending_disconnect;
-    bool sentnick;
-    bool sentpass;
-    bool sentuser;
+    void parse_irc_reply(char* data);
+    void split_to_replies();
+    int queue_line(std::string line, bool priority) const;
+    // Send as much of the queue as the rate limit allows; returns ms until more can be sent, or WSA_INFINITE
+    DWORD flush_send_queue();
+    void close_connection();
+    char channel_user_flags(const char* channel, const char* nick) const;
+
+    SOCKET irc_socket = INVALID_SOCKET;
+    WSAEVENT socket_event = WSA_INVALID_EVENT;
+    WSAEVENT wake_event = WSA_INVALID_EVENT; // Set when there's something to send or we need to disconnect
+    // NB: Events live as long as the IRC object so that other threads can always signal wake_event safely
+    std::string recv_buffer;
+    std::atomic<bool> connected = false;
+    std::atomic<bool> pending_disconnect = false;
     WSADATA wsaData = {0};
     clock_t ping_sent = 0;
     clock_t pong_recieved = 0;
-    char* cur_nick;
-    FILE* dataout{};
-    FILE* datain{};
-    channel_user* chan_users;
-    irc_command_hook* hooks;
+    mutable std::mutex nick_mutex;
+    std::string cur_nick;
+
+    mutable std::mutex send_mutex;
+    mutable std::deque<outgoing_line> send_queue;
+    size_t send_offset = 0; // Bytes of send_queue.front() already sent
+    uint32_t send_burst = 20;
+    uint32_t send_interval_ms = 30000;
+    double send_tokens = 20.0;
+    clock_t send_refilled = 0;
+
+    mutable std::mutex users_mutex;
+    // channel -> nick -> IRC_USER_* flags
+    std::unordered_map<std::string, std::unordered_map<std::string, char>> channel_users;
+    std::unordered_map<std::string, irc_hook_func> hooks;
     std::thread t;
 };
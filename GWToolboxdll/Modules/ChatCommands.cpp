@@ -38,6 +38,7 @@
 #include <GWCA/Utilities/Hooker.h>
 #include <GWCA/Utilities/Hook.h>
 
+#include <Utils/AliasIndex.h>
 #include <Utils/GuiUtils.h>
 #include <GWToolbox.h>
 #include <Keys.h>
@@ -233,6 +234,28 @@ namespace {
     GW::UI::UIInteractionCallback OnChatInteraction_Callback_Func = nullptr;
     GW::UI::UIInteractionCallback OnChatInteraction_Callback_Ret = nullptr;
 
+    // Maps the keywords a command accepts as an argument to what they mean for that command
+    template <typename T>
+    struct ChatKeyword {
+        const wchar_t* keyword;
+        T value;
+    };
+
+    // Case insensitive lookup of arg in a command's keyword table, or nullptr if it isn't one of them
+    template <typename T, size_t N>
+    const T* FindKeyword(const ChatKeyword<T> (&keywords)[N], const wchar_t* arg)
+    {
+        for (const auto& it : keywords) {
+            size_t i = 0;
+            while (it.keyword[i] && static_cast<wchar_t>(towlower(arg[i])) == it.keyword[i]) {
+                i++;
+            }
+            if (!it.keyword[i] && !arg[i])
+                return &it.value;
+        }
+        return nullptr;
+    }
+
     // '/chat [all|guild|team|trade|alliance|whisper|close]'
     const char* chat_tab_syntax = "'/chat [all|guild|team|trade|alliance|whisper]' open chat channel.";
 
@@ -241,29 +264,19 @@ namespace {
         if (argc < 2) {
             return Log::Error(chat_tab_syntax);
         }
-        uint32_t channel = 0xff;
-        if (wcscmp(argv[1], L"all") == 0) {
-            channel = 0;
-        }
-        else if (wcscmp(argv[1], L"guild") == 0) {
-            channel = 2;
-        }
-        else if (wcscmp(argv[1], L"team") == 0) {
-            channel = 3;
-        }
-        else if (wcscmp(argv[1], L"trade") == 0) {
-            channel = 4;
-        }
-        else if (wcscmp(argv[1], L"alliance") == 0) {
-            channel = 1;
-        }
-        else if (wcscmp(argv[1], L"whisper") == 0) {
-            channel = 5;
-        }
-        else {
+        static constexpr ChatKeyword<uint32_t> channels[] = {
+            {L"all", 0},
+            {L"alliance", 1},
+            {L"guild", 2},
+            {L"team", 3},
+            {L"trade", 4},
+            {L"whisper", 5}
+        };
+        const auto found = FindKeyword(channels, argv[1]);
+        if (!found) {
             return Log::Error(chat_tab_syntax);
         }
-        channel |= 0x8000;
+        const uint32_t channel = *found | 0x8000;
         GW::GameThread::Enqueue([channel] {
             // See OnChatUI_Callback for intercept
             SendUIMessage(GW::UI::UIMessage::kAppendMessageToChat, (void*)L"", (void*)channel);
@@ -633,13 +646,56 @@ namespace {
         wchar_t alias_wstr[128] = {};
         char command_cstr[512] = {};
         wchar_t command_wstr[256] = {};
-        bool processing = false;
     };
 
     std::vector<CmdAlias*> cmd_aliases;
+    // Guards cmd_aliases and alias_index; aliases are edited from the settings (render thread) and looked up when chat is
+    // sent (game thread). Recursive because loading and saving settings create and sort aliases with it held. Never held
+    // while an alias is sent, so an alias can run commands that edit or reload the aliases.
+    std::recursive_mutex alias_mutex;
+    AliasIndex alias_index;
+    bool alias_index_dirty = true; // Rebuilt on the next lookup after aliases change
+    // Names of the aliases being sent (game thread only), so an alias whose commands include itself goes to the game
+    std::vector<std::wstring> sending_aliases;
+
+    // Indices into cmd_aliases of the aliases named message; call with alias_mutex held
+    std::span<const uint32_t> FindAliases(const wchar_t* message)
+    {
+        if (alias_index_dirty) {
+            std::vector<const wchar_t*> names;
+            names.reserve(cmd_aliases.size());
+            for (const auto alias : cmd_aliases) {
+                names.push_back(alias->alias_wstr);
+            }
+            alias_index.Build(names);
+            alias_index_dirty = false;
+        }
+        return alias_index.Find(message);
+    }
+
+    // Sends each line of an alias's commands; the first character of a line is its channel
+    void SendAliasCommands(const wchar_t* commands)
+    {
+        wchar_t line[_countof(CmdAlias::command_wstr)];
+        const wchar_t* start = commands;
+        while (*start) {
+            const wchar_t* end = start;
+            while (*end && *end != L'\n') {
+                end++;
+            }
+            const auto len = static_cast<size_t>(end - start);
+            if (len >= 2 && len < _countof(line)) {
+                wmemcpy(line, start, len);
+                line[len] = 0;
+                GW::Chat::SendChat(static_cast<char>(line[0]), &line[1]);
+            }
+            start = *end ? end + 1 : end;
+        }
+    }
 
     void sort_cmd_aliases()
     {
+        std::lock_guard lock(alias_mutex);
         std::ranges::stable_sort(cmd_aliases, [](const auto* a, const auto* b) {
             if (a->alias_cstr[0] == '\0' && b->alias_cstr[0] != '\0') {
                 return false;
@@ -649,6 +705,7 @@ namespace {
             }
             return strcmp(a->alias_cstr, b->alias_cstr) < 0;
         });
+        alias_index_dirty = true;
     }
 
     GW::HookEntry OnSentChat_HookEntry;
@@ -664,22 +721,26 @@ namespace {
         if (channel != GW::Chat::CHANNEL_COMMAND || status->blocked) {
             return;
         }
-        for (const auto alias : cmd_aliases) {
-            const auto sent_alias = TextUtils::ToLower(&message[1]);
-            if (wcscmp(alias->alias_wstr, sent_alias.c_str()) == 0 && !alias->processing && wcslen(alias->command_wstr) > 1) {
-                status->blocked = true;
-                alias->processing = true;
-                std::wstring tmp;
-                std::vector<std::wstring> parts;
-                std::wstringstream wss(alias->command_wstr);
-                while (std::getline(wss, tmp, L'\n')) {
-                    if (tmp.length() < 2)
-                        continue;
-                    GW::Chat::SendChat((char)tmp[0], &tmp[1]);
-                }
-                alias->processing = false;
+        // Copied out: sending can reach LoadSettings (e.g. an alias running /config load), which frees every CmdAlias
+        std::wstring name;
+        std::vector<std::wstring> commands;
+        {
+            std::lock_guard lock(alias_mutex);
+            for (const auto i : FindAliases(&message[1])) {
+                const auto alias = cmd_aliases[i];
+                name = alias->alias_wstr;
+                if (alias->command_wstr[0] && alias->command_wstr[1])
+                    commands.emplace_back(alias->command_wstr);
             }
         }
+        if (commands.empty() || std::ranges::find(sending_aliases, name) != sending_aliases.end())
+            return;
+        status->blocked = true;
+        sending_aliases.push_back(name);
+        for (const auto& command : commands) {
+            SendAliasCommands(command.c_str());
+        }
+        sending_aliases.pop_back();
     }
 
     void CHAT_CMD_FUNC(CmdTick)
@@ -709,25 +770,19 @@ namespace {
         auto modules = GWToolbox::GetAllModules();
         ToolboxIni empty_ini;
         auto ini_disk = GWToolbox::OpenSettingsFile();
-        enum ActionType : uint8_t { Set, Get, Toggle, Load } action = Set;
-
-        const auto arg1 = TextUtils::ToLower(argv[1]);
-        if (arg1 == L"set") {
-            action = Set;
-        }
-        else if (arg1 == L"get") {
-            action = Get;
-        }
-        else if (arg1 == L"toggle") {
-            action = Toggle;
-        }
-        else if (arg1 == L"load") {
-            action = Load;
-        }
-        else {
+        enum ActionType : uint8_t { Set, Get, Toggle, Load };
+        static constexpr ChatKeyword<ActionType> actions[] = {
+            {L"set", Set},
+            {L"get", Get},
+            {L"toggle", Toggle},
+            {L"load", Load}
+        };
+        const auto found_action = FindKeyword(actions, argv[1]);
+        if (!found_action) {
             Log::Error(syntax);
             return;
         }
+        const auto action = *found_action;
         // make sure the loop will not run out of arguments mid tuple
         switch (action) {
             case Set:
@@ -846,12 +901,15 @@ namespace {
                 case SettingType::Bool:
                     if (argc < 2)
                         return Log::WarningW(L"Invalid syntax for %s\n%s", setting_name, ChatCommandSyntax().c_str());
+                    static constexpr ChatKeyword<bool> values[] = {
+                        {L"on", true},
+                        {L"1", true},
+                        {L"off", false},
+                        {L"0", false}
+                    };
                     auto current_val = (bool*)setting_ptr;
-                    bool new_val = !*current_val;
-                    if (wcscmp(argv[1], L"on") == 0 || wcscmp(argv[1], L"1") == 0)
-                        new_val = true;
-                    if (wcscmp(argv[1], L"off") == 0 || wcscmp(argv[1], L"0") == 0)
-                        new_val = false;
+                    const auto found_val = FindKeyword(values, argv[1]);
+                    const bool new_val = found_val ? *found_val : !*current_val;
                     if (*current_val == new_val)
                         return;
                     *current_val = new_val;
@@ -1069,10 +1127,12 @@ void ChatCommands::CreateAlias(const wchar_t* alias, const wchar_t* message)
         alias++;
     if (!(alias && *alias && message && *message))
         return;
+    std::lock_guard lock(alias_mutex);
     const auto found = std::ranges::find_if(cmd_aliases, [alias, message](const CmdAlias* cmp) {
         return wcscmp(alias, cmp->alias_wstr) == 0 && wcscmp(message, cmp->command_wstr) == 0;
     });
     CmdAlias* alias_obj = nullptr;
+    alias_index_dirty = true;
     if (found != cmd_aliases.end()) {
         alias_obj = *found;
     }
@@ -1263,13 +1323,16 @@ void ChatCommands::DrawSettingsInternal()
         if (!result)
             return;
         auto alias = (CmdAlias*)wparam;
+        std::lock_guard lock(alias_mutex);
         const auto found = std::ranges::find(cmd_aliases, alias);
         if (found != cmd_aliases.end()) {
+            alias_index_dirty = true;
             cmd_aliases.erase(found);
             delete alias;
         }
     };
 
+    std::lock_guard lock(alias_mutex);
     const auto avail_w = ImGui::GetContentRegionAvail().x - 128.f;
     for (auto it = cmd_aliases.begin(); it != cmd_aliases.end(); ++it) {
         ImGui::PushID(it._Ptr);
@@ -1277,6 +1340,7 @@ void ChatCommands::DrawSettingsInternal()
         ImGui::PushItemWidth(avail_w * .3f);
         if (ImGui::InputText("###cmd_alias", (*it)->alias_cstr, _countof(CmdAlias::alias_cstr))) {
             swprintf((*it)->alias_wstr, _countof(CmdAlias::alias_wstr), L"%S", (*it)->alias_cstr);
+            alias_index_dirty = true;
         }
         if (ImGui::IsItemHovered()) {
             ImGui::SetTooltip("Alias for this command");
@@ -1314,6 +1378,8 @@ void ChatCommands::LoadSettings(ToolboxIni* ini)
     LOAD_FLOAT(cam_speed);
     LOAD_UINT(default_title_id);
 
+    std::lock_guard lock(alias_mutex);
+    alias_index_dirty = true;
     for (const auto* it : cmd_aliases) {
         delete it;
     }
@@ -1357,6 +1423,7 @@ void ChatCommands::SaveSettings(ToolboxIni* ini)
     const auto section_name = "Chat Command Aliases";
 
     ini->Delete("Chat Command Aliases", nullptr);
+    std::lock_guard lock(alias_mutex);
     sort_cmd_aliases();
 
     for (const auto [index, alias] : cmd_aliases | std::views::enumerate) {
@@ -1515,6 +1582,8 @@ void ChatCommands::Terminate()
         delete it;
     }
     title_names.clear();
+    std::lock_guard lock(alias_mutex);
+    alias_index_dirty = true;
     for (const auto it : cmd_aliases) {
         delete it;
     }
@@ -3409,28 +3478,19 @@ void CHAT_CMD_FUNC(ChatCommands::CmdVolume)
             value = argv[1];
             break;
         case 3: {
-            const wchar_t* pref_str = argv[1];
-            if (wcscmp(pref_str, L"master") == 0) {
-                pref = GW::UI::NumberPreference::MasterVolume;
-            }
-            else if (wcscmp(pref_str, L"music") == 0) {
-                pref = GW::UI::NumberPreference::MusicVolume;
-            }
-            else if (wcscmp(pref_str, L"background") == 0) {
-                pref = GW::UI::NumberPreference::BackgroundVolume;
-            }
-            else if (wcscmp(pref_str, L"effects") == 0) {
-                pref = GW::UI::NumberPreference::EffectsVolume;
-            }
-            else if (wcscmp(pref_str, L"dialog") == 0) {
-                pref = GW::UI::NumberPreference::DialogVolume;
-            }
-            else if (wcscmp(pref_str, L"ui") == 0) {
-                pref = GW::UI::NumberPreference::UIVolume;
-            }
-            else {
+            static constexpr ChatKeyword<GW::UI::NumberPreference> volumes[] = {
+                {L"master", GW::UI::NumberPreference::MasterVolume},
+                {L"music", GW::UI::NumberPreference::MusicVolume},
+                {L"background", GW::UI::NumberPreference::BackgroundVolume},
+                {L"effects", GW::UI::NumberPreference::EffectsVolume},
+                {L"dialog", GW::UI::NumberPreference::DialogVolume},
+                {L"ui", GW::UI::NumberPreference::UIVolume}
+            };
+            const auto found = FindKeyword(volumes, argv[1]);
+            if (!found) {
                 return Log::Error(syntax);
             }
+            pref = *found;
             value = argv[2];
             break;
         }
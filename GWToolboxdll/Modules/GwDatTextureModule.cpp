@@ -1,5 +1,7 @@
 #include "stdafx.h"
 
+#include <condition_variable>
+
 #include <GWCA/Utilities/Scanner.h>
 #include <GWCA/Managers/ItemMgr.h>
 
@@ -9,6 +11,8 @@
 #include "Resources.h"
 #include <GWCA/Managers/MemoryMgr.h>
 #include <Utils/ArenaNetFileParser.h>
+#include <Utils/AtexDecoder.h>
+#include <Utils/GwDat.h>
 
 namespace {
 
@@ -87,33 +91,39 @@ namespace {
         return NULL;
     }
 
-    // OpenImage converts any GW format to ARGB. It is possible to skip conversion if gw format is compatible with D3FMT.
-    uint32_t OpenImage(uint32_t file_id, gw_image_bits* dst_bits, Vec2i& dims, int& levels, GR_FORMAT& format)
+    // Unwraps the ATEX chunk of ffna files; false unless what's left is an ATEX or DDS image
+    bool ExtractImageBytes(std::span<const uint8_t> file, std::vector<uint8_t>& image_bytes)
+    {
+        auto image = file;
+        if (file.size() >= 4 && memcmp(file.data(), "ffna", 4) == 0) {
+            // Don't insist on isValid(); the ATEX chunk is usable even if a later chunk is truncated or oversized
+            image = ArenaNetFileParser::FfnaView(file).Atex();
+        }
+        if (image.size() < 4 || (memcmp(image.data(), "ATEX", 4) != 0
+            && memcmp(image.data(), "DDS", 3) != 0)) {
+            return false;
+        }
+        image_bytes.assign(image.begin(), image.end());
+        return true;
+    }
+
+    // Uses the game's file handles, so has to run on the render thread
+    bool ReadImageBytes(uint32_t file_id, std::vector<uint8_t>& image_bytes)
+    {
+        wchar_t file_hash[4] = {0};
+        ArenaNetFileParser::FileIdToFileHash(file_id, file_hash);
+        std::vector<uint8_t> file;
+        return GwDatTextureModule::ReadDatFile(file_hash, &file) && ExtractImageBytes(file, image_bytes);
+    }
+
+    // OpenImage converts any GW format to ARGB using the game's decoder. It is possible to skip conversion if gw format is compatible with D3FMT.
+    uint32_t OpenImage(std::vector<uint8_t>& image, gw_image_bits* dst_bits, Vec2i& dims, int& levels, GR_FORMAT& format)
     {
         uint8_t* pallete = nullptr;
         gw_image_bits bits = nullptr;
 
-        ArenaNetFileParser::GameAssetFile asset;
-        if (!asset.readFromDat(file_id)) 
-            return 0;
-
-        uint8_t* image_bytes = asset.data.data();
-        size_t image_size = asset.data.size();
-
-        if (strncmp((char*)image_bytes, "ffna", 4) == 0) {
-            const auto anet_file = (ArenaNetFileParser::ArenaNetFile*)&asset;
-            if (!anet_file->isValid())
-                return 0;
-            const auto chunk = (ArenaNetFileParser::UnknownChunk*)anet_file->FindChunk(ArenaNetFileParser::ChunkType::ATEXFILE);
-            if (!chunk) 
-                return 0;
-            image_bytes = chunk->data;
-            image_size = chunk->chunk_size;
-        }
-        if (strncmp((char*)image_bytes, "ATEX", 4) != 0 
-            && strncmp((char*)image_bytes, "DDS", 3) != 0) {
-            return 0;
-        }
+        uint8_t* image_bytes = image.data();
+        const size_t image_size = image.size();
 
         uint32_t result = DecodeImage_func(image_size, image_bytes, &bits, pallete, &format, &dims, &levels);
 
@@ -127,21 +137,20 @@ namespace {
 
         GW::MemoryMgr::MemFree(bits);
 
-        // todo: free bytes;
         return result;
     }
 
-    // Replace your existing CreateTexture function with this:
-    IDirect3DTexture9* CreateTexture(IDirect3DDevice9* device, uint32_t file_id, Vec2i& dims)
+    // Fallback for images AtexDecoder doesn't handle (DDS, non-DXT ATEX), decoded by the game on the render thread
+    IDirect3DTexture9* CreateTexture(IDirect3DDevice9* device, std::vector<uint8_t>& image, Vec2i& dims)
     {
-        if (!device || !file_id) {
+        if (!device || image.empty()) {
             return nullptr;
         }
         
         gw_image_bits bits = nullptr;
         int levels;
         GR_FORMAT format;
-        auto ret = OpenImage(file_id, &bits, dims, levels, format);
+        auto ret = OpenImage(image, &bits, dims, levels, format);
         if (!ret || !bits || !dims.x || !dims.y) {
             if (bits) {
                 GW::MemoryMgr::MemFree(bits);
@@ -182,13 +191,267 @@ namespace {
         return tex;
     }
 
+    // Uploads an image decoded off-thread by AtexDecoder; DXT blocks go to the device as they are
+    IDirect3DTexture9* CreateTexture(IDirect3DDevice9* device, const AtexDecoder::Image& image)
+    {
+        D3DFORMAT d3d_format;
+        switch (image.format) {
+            case AtexDecoder::Format::DXT1:
+                d3d_format = D3DFMT_DXT1;
+                break;
+            case AtexDecoder::Format::DXT3:
+                d3d_format = D3DFMT_DXT3;
+                break;
+            case AtexDecoder::Format::DXT5:
+                d3d_format = D3DFMT_DXT5;
+                break;
+            default:
+                d3d_format = D3DFMT_A8R8G8B8;
+                break;
+        }
+        IDirect3DTexture9* tex = nullptr;
+        if (device->CreateTexture(image.width, image.height, 1, 0, d3d_format, D3DPOOL_MANAGED, &tex, 0) != D3D_OK) {
+            return nullptr;
+        }
+        D3DLOCKED_RECT rect;
+        if (tex->LockRect(0, &rect, 0, D3DLOCK_DISCARD) != D3D_OK) {
+            tex->Release();
+            return nullptr;
+        }
+        const uint32_t pitch = image.Pitch();
+        for (uint32_t row = 0; row < image.Rows(); row++) {
+            memcpy(static_cast<uint8_t*>(rect.pBits) + row * rect.Pitch, image.data.data() + row * pitch, pitch);
+        }
+        tex->UnlockRect(0);
+        return tex;
+    }
+
+    // Textures decoded per frame and kept in video memory. Uploads past the per-frame budget wait for the next frame.
+    constexpr size_t UPLOAD_BYTES_PER_FRAME = 4 * 1024 * 1024;
+    constexpr size_t RESIDENT_BYTES_BUDGET = 128 * 1024 * 1024;
+    // Frames a texture has to go unrequested before it can be evicted
+    constexpr uint32_t EVICT_AFTER_FRAMES = 600;
+
+    enum class ImageState : uint8_t { Loading, Ready, Failed, Evicted };
+
     struct GwImg {
         uint32_t m_file_id = 0;
         Vec2i m_dims;
         IDirect3DTexture9* m_tex = nullptr;
+        ImageState m_state = ImageState::Loading;
+        // Handed out by LoadTextureFromFileId; the caller may keep &m_tex for good, so the texture is never evicted
+        bool m_pinned = false;
+        uint32_t m_last_requested = 0;
+        size_t m_bytes = 0;
+    };
+
+    // Stable addresses, callers hold on to &m_tex. Entries are never removed, only their textures evicted.
+    // Render thread only, like everything else that touches an image outside a decode task.
+    std::vector<std::unique_ptr<GwImg>> images;
+    // Open addressed index into images by file id: image index + 1, or 0 for an empty slot
+    std::vector<uint32_t> image_slots;
+    uint32_t image_slot_bits = 0;
+
+    uint32_t frame = 1;
+    size_t resident_bytes = 0;
+
+    size_t SlotOf(const uint32_t file_id)
+    {
+        return (file_id * 0x9E3779B1u) >> (32 - image_slot_bits);
+    }
+
+    void InsertSlot(const uint32_t file_id, const uint32_t slot_value)
+    {
+        const size_t mask = image_slots.size() - 1;
+        size_t i = SlotOf(file_id);
+        while (image_slots[i]) {
+            i = (i + 1) & mask;
+        }
+        image_slots[i] = slot_value;
+    }
+
+    GwImg* FindImage(const uint32_t file_id)
+    {
+        if (image_slots.empty())
+            return nullptr;
+        const size_t mask = image_slots.size() - 1;
+        for (size_t i = SlotOf(file_id); image_slots[i]; i = (i + 1) & mask) {
+            const auto img = images[image_slots[i] - 1].get();
+            if (img->m_file_id == file_id)
+                return img;
+        }
+        return nullptr;
+    }
+
+    GwImg* AddImage(const uint32_t file_id)
+    {
+        // Keep the index at most 3/4 full
+        if ((images.size() + 1) * 4 > image_slots.size() * 3) {
+            image_slot_bits = std::max(image_slot_bits + 1, 6u);
+            image_slots.assign(size_t{1} << image_slot_bits, 0);
+            for (size_t i = 0; i < images.size(); i++) {
+                InsertSlot(images[i]->m_file_id, static_cast<uint32_t>(i + 1));
+            }
+        }
+        images.push_back(std::make_unique<GwImg>(file_id));
+        InsertSlot(file_id, static_cast<uint32_t>(images.size()));
+        return images.back().get();
+    }
+
+    // Result of a worker's read and decode, waiting for the render thread
+    struct StagedImage {
+        GwImg* img = nullptr;
+        AtexDecoder::Image decoded;
+        bool is_decoded = false;
+        std::vector<uint8_t> image_bytes; // For the game's decoder if AtexDecoder couldn't take it
+        bool read_from_game = false;      // Not found in the dat directly; read it with the game's file handles
     };
 
-    std::map<uint32_t,GwImg*> textures_by_file_id;
+    GwDat::DatFile dat;
+    std::mutex staged_mutex;
+    std::deque<StagedImage> staged;
+
+    void Stage(StagedImage&& image)
+    {
+        std::lock_guard lock(staged_mutex);
+        staged.push_back(std::move(image));
+    }
+
+    void DecodeOnWorker(GwImg* img, std::vector<uint8_t> image_bytes)
+    {
+        StagedImage result = {img};
+        if (image_bytes.empty()) {
+            const auto blob = dat.Read(img->m_file_id);
+            if (!blob) {
+                result.read_from_game = true;
+                return Stage(std::move(result));
+            }
+            if (!ExtractImageBytes(*blob, image_bytes))
+                return Stage(std::move(result));
+        }
+        if (AtexDecoder::CanDecode(image_bytes.data(), image_bytes.size())) {
+            result.is_decoded = AtexDecoder::Decode(image_bytes.data(), image_bytes.size(), result.decoded, true);
+        }
+        if (!result.is_decoded) {
+            result.image_bytes = std::move(image_bytes);
+        }
+        Stage(std::move(result));
+    }
+
+    // Decode tasks belong to the generation they were queued in. Terminate moves on to the next one and waits for any
+    // still running, so images and the dat outlive every task that can reach them.
+    std::mutex tasks_mutex;
+    std::condition_variable tasks_done;
+    uint32_t task_generation = 0;
+    size_t tasks_running = 0;
+
+    void EnqueueDecode(GwImg* img, std::vector<uint8_t> image_bytes = {})
+    {
+        uint32_t generation;
+        {
+            std::lock_guard lock(tasks_mutex);
+            generation = task_generation;
+        }
+        Resources::EnqueueWorkerTask([img, image_bytes = std::move(image_bytes), generation]() mutable {
+            {
+                std::lock_guard lock(tasks_mutex);
+                if (generation != task_generation)
+                    return; // Queued before Terminate; img is gone
+                tasks_running++;
+            }
+            DecodeOnWorker(img, std::move(image_bytes));
+            {
+                std::lock_guard lock(tasks_mutex);
+                tasks_running--;
+            }
+            tasks_done.notify_all();
+        });
+    }
+
+    void RequestImage(GwImg* img)
+    {
+        img->m_state = ImageState::Loading;
+        if (dat.IsOpen()) {
+            EnqueueDecode(img);
+        }
+        else {
+            Stage({.img = img, .read_from_game = true});
+        }
+    }
+
+    // Looks file_id up for this frame, queueing the load if it isn't resident
+    GwImg* RequestedImage(const uint32_t file_id)
+    {
+        auto img = FindImage(file_id);
+        if (!img) {
+            img = AddImage(file_id);
+            RequestImage(img);
+        }
+        else if (img->m_state == ImageState::Evicted) {
+            RequestImage(img);
+        }
+        img->m_last_requested = frame;
+        return img;
+    }
+
+    // Creates the texture for one staged image; returns the bytes uploaded
+    size_t Upload(IDirect3DDevice9* device, StagedImage& image)
+    {
+        const auto img = image.img;
+        if (image.read_from_game) {
+            std::vector<uint8_t> image_bytes;
+            if (!ReadImageBytes(img->m_file_id, image_bytes)) {
+                img->m_state = ImageState::Failed;
+                return 0;
+            }
+            if (AtexDecoder::CanDecode(image_bytes.data(), image_bytes.size())) {
+                EnqueueDecode(img, std::move(image_bytes));
+                return 0;
+            }
+            image.image_bytes = std::move(image_bytes);
+        }
+        if (image.is_decoded) {
+            img->m_dims = {static_cast<int>(image.decoded.width), static_cast<int>(image.decoded.height)};
+            img->m_tex = CreateTexture(device, image.decoded);
+            img->m_bytes = image.decoded.data.size();
+        }
+        else if (!image.image_bytes.empty()) {
+            img->m_tex = CreateTexture(device, image.image_bytes, img->m_dims);
+            img->m_bytes = static_cast<size_t>(img->m_dims.x) * img->m_dims.y * 4;
+        }
+        if (!img->m_tex) {
+            img->m_state = ImageState::Failed;
+            img->m_bytes = 0;
+            return 0;
+        }
+        img->m_state = ImageState::Ready;
+        resident_bytes += img->m_bytes;
+        return img->m_bytes;
+    }
+
+    // Releases least recently drawn textures until back under budget. Only textures reached through
+    // GetTextureForFrame qualify: those callers look the texture up again every frame and never keep it.
+    void EvictTextures()
+    {
+        if (resident_bytes <= RESIDENT_BYTES_BUDGET)
+            return;
+        std::vector<GwImg*> candidates;
+        for (const auto& img : images) {
+            if (img->m_state == ImageState::Ready && !img->m_pinned && frame - img->m_last_requested > EVICT_AFTER_FRAMES) {
+                candidates.push_back(img.get());
+            }
+        }
+        std::ranges::sort(candidates, {}, &GwImg::m_last_requested);
+        for (const auto img : candidates) {
+            if (resident_bytes <= RESIDENT_BYTES_BUDGET)
+                break;
+            img->m_tex->Release();
+            img->m_tex = nullptr;
+            img->m_state = ImageState::Evicted;
+            resident_bytes -= img->m_bytes;
+            img->m_bytes = 0;
+        }
+    }
 } // namespace
 
 bool GwDatTextureModule::CloseHandle(void* handle) {
@@ -210,6 +473,18 @@ bool GwDatTextureModule::ReadDatFile(const wchar_t* file_name, std::vector<uint8
     CloseRecObj_func(rec);
     return !bytes_out->empty();
 }
+GwDat::Blob GwDatTextureModule::ReadDatFile(uint32_t file_id)
+{
+    if (auto blob = dat.Read(file_id))
+        return blob;
+    wchar_t file_hash[4] = {0};
+    ArenaNetFileParser::FileIdToFileHash(file_id, file_hash);
+    std::vector<uint8_t> bytes;
+    if (!ReadDatFile(file_hash, &bytes))
+        return nullptr;
+    return std::make_shared<const std::vector<uint8_t>>(std::move(bytes));
+}
+
 void GwDatTextureModule::Initialize()
 {
     ToolboxModule::Initialize();
@@ -261,27 +536,62 @@ void GwDatTextureModule::Initialize()
     ASSERT(AllocateImage_func);
     ASSERT(Depalletize_func);
 #endif
+
+    // Decoded textures are the cache; the dat's own blob cache would only hold the same images twice
+    dat.SetCacheBudget(0);
+    if (!dat.Open(GwDat::DefaultPath())) {
+        Log::Log("[GwDatTextureModule] Gw.dat can't be read directly, textures will be read through the game");
+    }
 }
 
 
 
 IDirect3DTexture9** GwDatTextureModule::LoadTextureFromFileId(uint32_t file_id)
 {
-    auto found = textures_by_file_id.find(file_id);
-    if (found != textures_by_file_id.end())
-        return &found->second->m_tex;
-    auto gwimg_ptr = new GwImg(file_id);
-    textures_by_file_id[file_id] = gwimg_ptr;
-    Resources::Instance().EnqueueDxTask([gwimg_ptr](IDirect3DDevice9* device) {
-        gwimg_ptr->m_tex = CreateTexture(device, gwimg_ptr->m_file_id, gwimg_ptr->m_dims);
-        });
-    return &gwimg_ptr->m_tex;
+    const auto img = RequestedImage(file_id);
+    img->m_pinned = true;
+    return &img->m_tex;
 }
-void GwDatTextureModule::Terminate()
+
+IDirect3DTexture9* GwDatTextureModule::GetTextureForFrame(uint32_t file_id)
+{
+    return RequestedImage(file_id)->m_tex;
+}
+
+void GwDatTextureModule::DxUpdate(IDirect3DDevice9* device)
 {
-    for (auto gwimg_ptr : textures_by_file_id) {
-        delete gwimg_ptr.second;
+    frame++;
+    size_t uploaded = 0;
+    while (uploaded < UPLOAD_BYTES_PER_FRAME) {
+        StagedImage image;
+        {
+            std::lock_guard lock(staged_mutex);
+            if (staged.empty())
+                break;
+            image = std::move(staged.front());
+            staged.pop_front();
+        }
+        uploaded += Upload(device, image);
     }
-    textures_by_file_id.clear();
+    EvictTextures();
 }
 
+void GwDatTextureModule::Terminate()
+{
+    {
+        std::unique_lock lock(tasks_mutex);
+        task_generation++;
+        tasks_done.wait(lock, [] {
+            return tasks_running == 0;
+        });
+    }
+    {
+        std::lock_guard lock(staged_mutex);
+        staged.clear();
+    }
+    images.clear();
+    image_slots.clear();
+    image_slot_bits = 0;
+    resident_bytes = 0;
+    dat.Close();
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ToolboxModule.h>
+#include <Utils/GwDat.h>
 
 class GwDatTextureModule : public ToolboxModule {
     GwDatTextureModule() = default;
@@ -23,6 +24,16 @@ public:
 
     static bool CloseHandle(void* handle);
     static bool ReadDatFile(const wchar_t* fileHash, std::vector<uint8_t>* bytes_out);
+    // Contents of file_id straight from Gw.dat, or copied out of the game's file handles if the dat can't be read
+    static GwDat::Blob ReadDatFile(uint32_t file_id);
 
+    // Texture for file_id, null until it has been decoded and uploaded. The pointer stays valid until Terminate and the
+    // texture is never evicted, so callers can keep it. Render thread.
     static IDirect3DTexture9** LoadTextureFromFileId(uint32_t file_id);
+    // Same, for drawing this frame only: don't keep the result. Textures that are only ever asked for this way can be
+    // evicted once they go undrawn for a while, and are loaded again when next asked for. Render thread.
+    static IDirect3DTexture9* GetTextureForFrame(uint32_t file_id);
+
+    // Uploads decoded textures within a per-frame budget, and evicts unused ones over the memory budget. Render thread.
+    static void DxUpdate(IDirect3DDevice9* device);
 };
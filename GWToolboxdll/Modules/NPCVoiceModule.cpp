@@ -35,8 +35,8 @@ namespace {
 
     constexpr std::string empty_string = "";
 
-    struct PendingNPCAudio;
-    typedef std::string (*GenerateVoiceCallback)(PendingNPCAudio* audio);
+    struct VoiceRequest;
+    typedef std::string (*GenerateVoiceCallback)(const VoiceRequest& request, const std::wstring& text);
 
     // API Configuration structure
     struct APIConfig {
@@ -51,10 +51,10 @@ namespace {
     };
 
         // Add OpenAI TTS function
-    std::string GenerateVoiceOpenAI(PendingNPCAudio*);
-    std::string GenerateVoiceElevenLabs(PendingNPCAudio*);
-    std::string GenerateVoiceGoogle(PendingNPCAudio*);
-    std::string GenerateVoicePlayHT(PendingNPCAudio* );
+    std::string GenerateVoiceOpenAI(const VoiceRequest&, const std::wstring&);
+    std::string GenerateVoiceElevenLabs(const VoiceRequest&, const std::wstring&);
+    std::string GenerateVoiceGoogle(const VoiceRequest&, const std::wstring&);
+    std::string GenerateVoicePlayHT(const VoiceRequest&, const std::wstring&);
 
 
     // Static API configurations
@@ -124,20 +124,25 @@ namespace {
     // "If it dies, we can... assign a gender?"
     bool GetDeathSoundForModelFileId(uint32_t file_id, uint32_t* file_id_out)
     {
-        ArenaNetFileParser::ArenaNetFile asset;
+        using namespace ArenaNetFileParser;
+        ArenaNetFile asset;
         if (!asset.readFromDat(file_id)) return false;
 
-        auto animations_chunk = (ArenaNetFileParser::FileNamesChunk*)asset.FindChunk(ArenaNetFileParser::ChunkType::FILENAMES_BBC);
-        if (!animations_chunk) {
-            animations_chunk = (ArenaNetFileParser::FileNamesChunk*)asset.FindChunk(ArenaNetFileParser::ChunkType::FILENAMES_BBD);
-            if (!(animations_chunk && asset.readFromDat(animations_chunk->filenames[0].filename))) return false;
-            animations_chunk = (ArenaNetFileParser::FileNamesChunk*)asset.FindChunk(ArenaNetFileParser::ChunkType::FILENAMES_BBC);
-        }
-        if (!(animations_chunk && asset.readFromDat(animations_chunk->filenames[0].filename))) return false;
+        // File names point into asset and aren't null terminated; copy the first one out before reading over it
+        const auto read_first = [&asset](const std::span<const FileName> file_names) {
+            if (file_names.empty()) return false;
+            wchar_t file_hash[4] = {0};
+            std::copy_n(file_names[0].filename, _countof(file_names[0].filename), file_hash);
+            return asset.readFromDat(file_hash);
+        };
+        if (asset.view.FileNames(ChunkType::FILENAMES_BBC).empty()) {
+            if (!read_first(asset.view.FileNames(ChunkType::FILENAMES_BBD))) return false;
+        }
+        if (!read_first(asset.view.FileNames(ChunkType::FILENAMES_BBC))) return false;
         if (asset.getFFNAType() != 8) return false;
-        const auto soundtracks_chunk = (ArenaNetFileParser::FileNamesChunkWithoutLength*)asset.FindChunk(ArenaNetFileParser::ChunkType::SOUND_FILES_1);
-        if (!(soundtracks_chunk && soundtracks_chunk->num_filenames() > 0)) return false;
-        *file_id_out = ArenaNetFileParser::FileHashToFileId(soundtracks_chunk->filenames[0].filename);
+        const auto soundtracks = asset.view.FileNames(ChunkType::SOUND_FILES_1);
+        if (soundtracks.empty()) return false;
+        *file_id_out = FileHashToFileId(soundtracks[0].filename);
         return true;
     }
 
@@ -329,7 +334,12 @@ namespace {
     bool stop_speech_when_dialog_closed = false;
     bool play_goodbye_messages = false;
     bool only_use_first_dialog = true;
-    bool only_use_first_sentence = true; // NB: Not changable because we don't know how to stop a running audio file!
+    bool only_use_first_sentence = true;
+    // Following sentences are generated while the first one plays, and queued behind it
+    constexpr size_t max_sentences = 8;
+
+    // Least recently played files are deleted once the cache folder grows past this
+    unsigned int max_cache_size_mb = 256;
     bool play_speech_from_non_friendly_npcs = true;
     bool play_speech_bubbles_in_explorable = false;
     bool play_speech_bubbles_in_outpost = true;
@@ -345,6 +355,71 @@ namespace {
     std::wstring PreprocessEncodedTextForTTS(const std::wstring& text);
     VoiceProfile* GetVoiceProfile(uint32_t agent_id, GW::Constants::MapID map_id);
 
+    void UnpinAudioCacheFile(const std::string& key);
+
+    // Keeps a cached audio file from being evicted while it is queued or playing; see EvictAudioCache
+    class AudioCachePin {
+    public:
+        AudioCachePin() = default;
+        explicit AudioCachePin(std::string _key) : key(std::move(_key)) {}
+        AudioCachePin(const AudioCachePin&) = delete;
+        AudioCachePin(AudioCachePin&& other) noexcept : key(std::move(other.key)) { other.key.clear(); }
+        AudioCachePin& operator=(const AudioCachePin&) = delete;
+        AudioCachePin& operator=(AudioCachePin&& other) noexcept
+        {
+            if (this != &other) {
+                Release();
+                key = std::move(other.key);
+                other.key.clear();
+            }
+            return *this;
+        }
+        ~AudioCachePin() { Release(); }
+
+        void Release()
+        {
+            if (!key.empty()) {
+                UnpinAudioCacheFile(key);
+            }
+            key.clear();
+        }
+
+    private:
+        std::string key;
+    };
+
+    // Everything a TTS provider needs, copied when generation starts so the worker never touches a PendingNPCAudio
+    struct VoiceRequest {
+        VoiceProfile profile;
+        GW::Constants::Language language = GW::Constants::Language::English;
+        uint32_t agent_id = 0;
+        Gender gender = Gender::Unknown;
+    };
+
+    // Generation in progress for one PendingNPCAudio, shared with the worker; cancelled when the audio is deleted
+    struct VoiceJob {
+        VoiceRequest request;
+        std::vector<std::wstring> sentences;
+        std::atomic<bool> cancelled = false;
+    };
+
+    // Audio generated on the worker, waiting to be played from NPCVoiceModule::Update
+    struct GeneratedSentence {
+        std::shared_ptr<VoiceJob> job;
+        std::filesystem::path path; // Empty if generation failed
+        AudioCachePin pin;
+        clock_t duration = 0;
+        bool first = false;
+    };
+    std::mutex generated_mutex;
+    std::vector<GeneratedSentence> generated_sentences;
+
+    struct QueuedSentence {
+        std::filesystem::path path;
+        AudioCachePin pin;
+        clock_t duration = 0;
+    };
+
     struct PendingNPCAudio {
         GW::Constants::Language language = GW::Constants::Language::English;
         std::wstring encoded_message;
@@ -355,11 +430,16 @@ namespace {
         clock_t started = 0;
         clock_t duration = 0;
         void* gw_handle = 0;
+        std::shared_ptr<VoiceJob> job;
+        AudioCachePin pin; // For path
+        // Prefetched audio for the rest of the dialog, played in order once the current file finishes
+        std::deque<QueuedSentence> queued_sentences;
         bool IsPlaying() { 
             // NB: Duration of 0 implies the file is being generated, so for the purpose of this check, we assume it is about to play
             return duration == 0 || TIMER_DIFF(started) < duration;
         }
         void Play();
+        bool PlayNext();
         void Stop();
         PendingNPCAudio(uint32_t _agent_id, const wchar_t* message);
         ~PendingNPCAudio();
@@ -367,9 +447,85 @@ namespace {
     std::vector<PendingNPCAudio*> pending_audio; // Maps agent ID to pending audio generation requests
     std::map<uint32_t, PendingNPCAudio*> playing_audio_map; // Maps agent ID to currently playing audio
 
-        // Function to estimate audio duration from file size (rough approximation)
+    // Sums the duration of every MPEG audio frame in the file; returns 0 if no frames were found
+    clock_t GetMp3Duration(const std::filesystem::path& audio_file)
+    {
+        std::ifstream in(audio_file, std::ios::binary);
+        if (!in.is_open()) {
+            return 0;
+        }
+        const std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        const size_t size = data.size();
+        size_t pos = 0;
+        // Skip ID3v2 tag; size is a 28 bit syncsafe integer
+        if (size >= 10 && memcmp(data.data(), "ID3", 3) == 0) {
+            pos = 10 + (static_cast<size_t>(data[6] & 0x7f) << 21 | static_cast<size_t>(data[7] & 0x7f) << 14 | static_cast<size_t>(data[8] & 0x7f) << 7 | (data[9] & 0x7f));
+            if (data[5] & 0x10) {
+                pos += 10; // footer
+            }
+        }
+        // kbps, indexed by [mpeg1 ? 0 : 1][layer 1..3 - 1][bitrate index]
+        constexpr uint16_t bitrates[2][3][15] = {
+            {
+                {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},
+                {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},
+                {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320}
+            },
+            {
+                {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},
+                {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},
+                {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160}
+            }
+        };
+        // Hz, indexed by [version bits][sample rate index]; version 1 is reserved
+        constexpr uint32_t sample_rates[4][3] = {
+            {11025, 12000, 8000}, // MPEG 2.5
+            {0, 0, 0},
+            {22050, 24000, 16000}, // MPEG 2
+            {44100, 48000, 32000}  // MPEG 1
+        };
+        double seconds = 0.0;
+        while (pos + 4 <= size) {
+            const uint8_t b1 = data[pos + 1];
+            const uint8_t b2 = data[pos + 2];
+            if (data[pos] != 0xff || (b1 & 0xe0) != 0xe0) {
+                pos++;
+                continue;
+            }
+            const uint32_t version = b1 >> 3 & 0x3;
+            const uint32_t layer = 4 - (b1 >> 1 & 0x3); // 1, 2 or 3; 4 is reserved
+            const uint32_t bitrate_index = b2 >> 4;
+            const uint32_t sample_rate_index = b2 >> 2 & 0x3;
+            const uint32_t padding = b2 >> 1 & 0x1;
+            if (version == 1 || layer == 4 || bitrate_index == 0 || bitrate_index == 15 || sample_rate_index == 3) {
+                pos++;
+                continue;
+            }
+            const bool mpeg1 = version == 3;
+            const uint32_t bitrate = bitrates[mpeg1 ? 0 : 1][layer - 1][bitrate_index] * 1000;
+            const uint32_t sample_rate = sample_rates[version][sample_rate_index];
+            uint32_t samples;
+            size_t frame_len;
+            if (layer == 1) {
+                samples = 384;
+                frame_len = (12 * bitrate / sample_rate + padding) * 4;
+            }
+            else {
+                samples = layer == 3 && !mpeg1 ? 576 : 1152;
+                frame_len = samples / 8 * bitrate / sample_rate + padding;
+            }
+            seconds += static_cast<double>(samples) / sample_rate;
+            pos += frame_len;
+        }
+        return static_cast<clock_t>(seconds * CLOCKS_PER_SEC);
+    }
+
+    // Exact duration for mp3 files, otherwise a rough guess from the file size
     clock_t EstimateAudioDuration(const std::filesystem::path& audio_file)
     {
+        if (const auto mp3_duration = GetMp3Duration(audio_file)) {
+            return mp3_duration;
+        }
         std::error_code err;
         auto file_size = std::filesystem::file_size(audio_file, err);
         if (err.value() != 0) {
@@ -404,6 +560,8 @@ namespace {
         while (pending_audio.size()) {
             delete pending_audio[0];
         }
+        std::lock_guard lock(generated_mutex);
+        generated_sentences.clear();
     }
     void PendingNPCAudio::Play()
     {
@@ -413,12 +571,10 @@ namespace {
         }
         // Don't play more than one dialog track at once
         Stop();
-        if (!duration)
-            duration = EstimateAudioDuration(path);
 
         // Play the new audio
         const auto pos = GetAgentVec3f(agent_id);
-        VoiceLog("Playing audio file: %s (estimated duration: %dms)", path.filename().string().c_str(), duration);
+        VoiceLog("Playing audio file: %s (duration: %dms)", path.filename().string().c_str(), duration);
         // 0x1400 means "this audio file in positional", so it will play in 3D space relative to the position given
         // 0x4 means "this is a dialog audio file"
         if (!AudioSettings::PlaySound(path.wstring().c_str(), &pos, 0x1400 | 0x4, &gw_handle)) {
@@ -432,12 +588,27 @@ namespace {
         playing_audio_map[agent_id] = this;
         
     }
+    bool PendingNPCAudio::PlayNext()
+    {
+        if (queued_sentences.empty()) {
+            return false;
+        }
+        path = std::move(queued_sentences.front().path);
+        pin = std::move(queued_sentences.front().pin);
+        duration = queued_sentences.front().duration;
+        queued_sentences.pop_front();
+        Play();
+        return true;
+    }
     void PendingNPCAudio::Stop() {
         if (gw_handle) AudioSettings::StopSound(gw_handle);
         gw_handle = nullptr;
     }
     PendingNPCAudio::~PendingNPCAudio()
     {
+        if (job) {
+            job->cancelled = true;
+        }
         Stop();
         const auto found = playing_audio_map.find(agent_id);
         if (found != playing_audio_map.end()) {
@@ -456,7 +627,8 @@ namespace {
         pending_audio.push_back(this);
     }
 
-    bool generating_voice = false;
+    // Set until the worker has produced the first sentence of the current dialog
+    std::atomic<bool> generating_voice = false;
 
 
     GW::GamePos GetPlayerPosition()
@@ -918,7 +1090,7 @@ namespace {
     }
 
     // Add OpenAI TTS function
-    std::string GenerateVoiceOpenAI(PendingNPCAudio* audio)
+    std::string GenerateVoiceOpenAI(const VoiceRequest& request, const std::wstring& text)
     {
         const auto api_config = GetCurrentAPIConfig();
         if (!(api_config && *api_config->api_key)) {
@@ -927,13 +1099,13 @@ namespace {
 
         nlohmann::json request_body;
         request_body["model"] = "gpt-4o-mini-tts";
-        request_body["input"] = TextUtils::WStringToString(audio->decoded_message);
+        request_body["input"] = TextUtils::WStringToString(text);
 
-        std::string voice_name = (audio->profile->voice_id == voice_id_human_female) ? "nova" : "onyx";
+        std::string voice_name = (request.profile.voice_id == voice_id_human_female) ? "nova" : "onyx";
         request_body["voice"] = voice_name;
         request_body["response_format"] = "mp3";
-        request_body["speed"] = audio->profile->speaking_rate;
-        request_body["language"] = LanguageToAbbreviation(audio->language);
+        request_body["speed"] = request.profile.speaking_rate;
+        request_body["language"] = LanguageToAbbreviation(request.language);
 
         RestClient client;
         client.SetHeader("Authorization", ("Bearer " + std::string(api_config->api_key)).c_str());
@@ -945,7 +1117,7 @@ namespace {
         return audio_data;
     }
     // Refactored ElevenLabs voice generation
-    std::string GenerateVoiceElevenLabs(PendingNPCAudio* audio)
+    std::string GenerateVoiceElevenLabs(const VoiceRequest& request, const std::wstring& text)
     {
         const auto api_config = GetCurrentAPIConfig();
         if (!(api_config && *api_config->api_key)) {
@@ -953,29 +1125,29 @@ namespace {
         }
 
         nlohmann::json request_body;
-        request_body["text"] = TextUtils::WStringToString(audio->decoded_message);
+        request_body["text"] = TextUtils::WStringToString(text);
         request_body["model_id"] = "eleven_flash_v2_5";
 
         nlohmann::json voice_settings;
-        voice_settings["stability"] = audio->profile->stability;
-        voice_settings["similarity_boost"] = audio->profile->similarity;
-        voice_settings["style"] = audio->profile->style;
+        voice_settings["stability"] = request.profile.stability;
+        voice_settings["similarity_boost"] = request.profile.similarity;
+        voice_settings["style"] = request.profile.style;
         voice_settings["use_speaker_boost"] = false;
 
         request_body["voice_settings"] = voice_settings;
-        request_body["language"] = LanguageToAbbreviation(audio->language);
+        request_body["language"] = LanguageToAbbreviation(request.language);
 
         RestClient client;
         client.SetHeader("xi-api-key", api_config->api_key);
         client.SetHeader("Accept", "audio/mpeg");
-        const auto audio_data = PostJson(client, "https://api.elevenlabs.io/v1/text-to-speech/" + audio->profile->voice_id, request_body, api_config->name);
+        const auto audio_data = PostJson(client, "https://api.elevenlabs.io/v1/text-to-speech/" + request.profile.voice_id, request_body, api_config->name);
         if (!audio_data.empty()) {
             VoiceLog("ElevenLabs voice generation successful, received %zu bytes", audio_data.size());
         }
         return audio_data;
     }
 
-    std::string GenerateVoiceGoogle(PendingNPCAudio* audio)
+    std::string GenerateVoiceGoogle(const VoiceRequest& request, const std::wstring& text)
     {
         const auto api_config = GetCurrentAPIConfig();
         if (!(api_config && *api_config->api_key)) {
@@ -985,11 +1157,11 @@ namespace {
         // Build request body using safe JSON construction
         nlohmann::json request_body = nlohmann::json::object();
         request_body["input"] = nlohmann::json::object();
-        request_body["input"]["text"] = TextUtils::WStringToString(audio->decoded_message);
+        request_body["input"]["text"] = TextUtils::WStringToString(text);
 
         // Voice section - determine voice name based on gender/race
         std::string voice_name;
-        if (audio->profile->voice_id == voice_id_human_female) {
+        if (request.profile.voice_id == voice_id_human_female) {
             voice_name = "en-US-Studio-O";
         }
         else {
@@ -998,12 +1170,12 @@ namespace {
 
         request_body["voice"] = nlohmann::json::object();
         request_body["voice"]["name"] = voice_name;
-        request_body["voice"]["languageCode"] = LanguageToAbbreviation(audio->language);
+        request_body["voice"]["languageCode"] = LanguageToAbbreviation(request.language);
 
         // Audio config section
         request_body["audioConfig"] = nlohmann::json::object();
         request_body["audioConfig"]["audioEncoding"] = "MP3";
-        request_body["audioConfig"]["speakingRate"] = audio->profile->speaking_rate;
+        request_body["audioConfig"]["speakingRate"] = request.profile.speaking_rate;
         request_body["audioConfig"]["pitch"] = 0.0f;
 
         RestClient client;
@@ -1029,7 +1201,7 @@ namespace {
         return audio_data;
     }
 
-    std::string GenerateVoicePlayHT(PendingNPCAudio* audio)
+    std::string GenerateVoicePlayHT(const VoiceRequest& request, const std::wstring& text)
     {
         const auto api_config = GetCurrentAPIConfig();
         if (!(api_config && *api_config->api_key)) {
@@ -1042,14 +1214,14 @@ namespace {
         // Build request body
         nlohmann::json request_body = nlohmann::json::object();
 
-        request_body["text"] = TextUtils::WStringToString(audio->decoded_message);
+        request_body["text"] = TextUtils::WStringToString(text);
         request_body["output_format"] = "mp3";
         request_body["quality"] = "medium"; // Options: draft, low, medium, high, premium
-        request_body["speed"] = audio->profile->speaking_rate;
+        request_body["speed"] = request.profile.speaking_rate;
 
         // Determine voice based on gender/race
         std::string voice_id;
-        auto gender = GetAgentGender(audio->agent_id);
+        const auto gender = request.gender;
 
         if (gender == Gender::Female) {
             voice_id = playht_voice_female_default;
@@ -1061,7 +1233,7 @@ namespace {
         request_body["voice"] = voice_id;
 
         // Add language if supported (Play.ht auto-detects but we can specify)
-        std::string lang_code = LanguageToAbbreviation(audio->language);
+        std::string lang_code = LanguageToAbbreviation(request.language);
         if (lang_code == "en") {
             request_body["voice_engine"] = "PlayHT2.0-turbo";
         }
@@ -1084,6 +1256,245 @@ namespace {
         return audio_data;
     }
 
+    struct CachedAudioFile {
+        uint64_t size = 0;
+        int64_t last_used = 0; // unix time
+    };
+
+    // Keyed by path relative to the NPCVoiceCache folder
+    std::unordered_map<std::string, CachedAudioFile> audio_cache_index;
+    uint64_t audio_cache_bytes = 0;
+    bool audio_cache_loaded = false;
+    bool audio_cache_dirty = false;
+    std::mutex audio_cache_mutex;
+    // Reference counts of files that are queued or playing, by key; never evicted
+    std::unordered_map<std::string, uint32_t> audio_cache_pins;
+
+    std::filesystem::path GetAudioCacheFolder()
+    {
+        return Resources::GetPath("NPCVoiceCache");
+    }
+
+    std::string GetAudioCacheKey(const std::filesystem::path& path)
+    {
+        return std::filesystem::relative(path, GetAudioCacheFolder()).generic_string();
+    }
+
+    int64_t GetUnixTime()
+    {
+        return static_cast<int64_t>(time(nullptr));
+    }
+
+    // Rebuild the index from the files on disk; used when index.json is missing or unreadable
+    void ScanAudioCacheFolder()
+    {
+        std::error_code ec;
+        const auto folder = GetAudioCacheFolder();
+        for (auto it = std::filesystem::recursive_directory_iterator(folder, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            if (!it->is_regular_file(ec) || it->path().extension() != ".mp3") {
+                continue;
+            }
+            const auto write_time = std::chrono::clock_cast<std::chrono::system_clock>(it->last_write_time(ec));
+            audio_cache_index[GetAudioCacheKey(it->path())] = {
+                it->file_size(ec),
+                std::chrono::duration_cast<std::chrono::seconds>(write_time.time_since_epoch()).count()
+            };
+        }
+        audio_cache_dirty = true;
+    }
+
+    void LoadAudioCacheIndex()
+    {
+        if (audio_cache_loaded) {
+            return;
+        }
+        audio_cache_loaded = true;
+        audio_cache_index.clear();
+        std::ifstream in(GetAudioCacheFolder() / "index.json");
+        const auto json = in.is_open() ? nlohmann::json::parse(in, nullptr, false) : nlohmann::json();
+        if (json.is_object() && json.contains("files") && json["files"].is_object()) {
+            for (const auto& [key, value] : json["files"].items()) {
+                if (value.is_array() && value.size() == 2) {
+                    audio_cache_index[key] = {value[0].get<uint64_t>(), value[1].get<int64_t>()};
+                }
+            }
+        }
+        else {
+            ScanAudioCacheFolder();
+        }
+        audio_cache_bytes = 0;
+        for (const auto& file : audio_cache_index | std::views::values) {
+            audio_cache_bytes += file.size;
+        }
+    }
+
+    void SaveAudioCacheIndex()
+    {
+        std::lock_guard lock(audio_cache_mutex);
+        if (!audio_cache_dirty) {
+            return;
+        }
+        nlohmann::json files = nlohmann::json::object();
+        for (const auto& [key, file] : audio_cache_index) {
+            files[key] = {file.size, file.last_used};
+        }
+        const nlohmann::json json = {{"files", files}};
+        const auto folder = GetAudioCacheFolder();
+        if (!Resources::EnsureFolderExists(folder)) {
+            return;
+        }
+        std::ofstream out(folder / "index.json");
+        out << json.dump();
+        audio_cache_dirty = !out.good();
+    }
+
+    void UnpinAudioCacheFile(const std::string& key)
+    {
+        std::lock_guard lock(audio_cache_mutex);
+        const auto found = audio_cache_pins.find(key);
+        if (found != audio_cache_pins.end() && !--found->second) {
+            audio_cache_pins.erase(found);
+        }
+    }
+
+    // Caller holds audio_cache_mutex
+    AudioCachePin PinAudioCacheFile(const std::string& key)
+    {
+        audio_cache_pins[key]++;
+        return AudioCachePin(key);
+    }
+
+    // Delete least recently played files until the cache is under max_cache_size_mb. Caller holds audio_cache_mutex.
+    // Pinned files are skipped, and a file that can't be deleted (e.g. open for playback) stays in the index.
+    void EvictAudioCache()
+    {
+        const uint64_t max_bytes = static_cast<uint64_t>(max_cache_size_mb) * 1024 * 1024;
+        if (audio_cache_bytes <= max_bytes) {
+            return;
+        }
+        std::vector<std::pair<int64_t, std::string>> by_age;
+        by_age.reserve(audio_cache_index.size());
+        for (const auto& [key, file] : audio_cache_index) {
+            if (!audio_cache_pins.contains(key)) {
+                by_age.emplace_back(file.last_used, key);
+            }
+        }
+        std::ranges::sort(by_age);
+        const auto folder = GetAudioCacheFolder();
+        for (const auto& key : by_age | std::views::values) {
+            if (audio_cache_bytes <= max_bytes) {
+                break;
+            }
+            std::error_code ec;
+            std::filesystem::remove(folder / key, ec);
+            if (ec) {
+                continue;
+            }
+            audio_cache_bytes -= audio_cache_index[key].size;
+            audio_cache_index.erase(key);
+        }
+        audio_cache_dirty = true;
+    }
+
+    // Returns true, marks the file as recently used and pins it if it is in the cache
+    bool TouchAudioCache(const std::filesystem::path& path, AudioCachePin& pin)
+    {
+        std::lock_guard lock(audio_cache_mutex);
+        LoadAudioCacheIndex();
+        const auto key = GetAudioCacheKey(path);
+        const auto found = audio_cache_index.find(key);
+        std::error_code ec;
+        if (!std::filesystem::exists(path, ec)) {
+            if (found != audio_cache_index.end()) {
+                audio_cache_bytes -= found->second.size;
+                audio_cache_index.erase(found);
+                audio_cache_dirty = true;
+            }
+            return false;
+        }
+        if (found == audio_cache_index.end()) {
+            const auto size = std::filesystem::file_size(path, ec);
+            audio_cache_index[key] = {size, GetUnixTime()};
+            audio_cache_bytes += size;
+        }
+        else {
+            found->second.last_used = GetUnixTime();
+        }
+        audio_cache_dirty = true;
+        pin = PinAudioCacheFile(key);
+        return true;
+    }
+
+    void AddToAudioCache(const std::filesystem::path& path, const uint64_t size, AudioCachePin& pin)
+    {
+        std::lock_guard lock(audio_cache_mutex);
+        LoadAudioCacheIndex();
+        const auto key = GetAudioCacheKey(path);
+        auto& file = audio_cache_index[key];
+        audio_cache_bytes = audio_cache_bytes - file.size + size;
+        file = {size, GetUnixTime()};
+        audio_cache_dirty = true;
+        pin = PinAudioCacheFile(key);
+        EvictAudioCache();
+    }
+
+    // Split dialog into sentences so that the first one can play while the rest are generated
+    std::vector<std::wstring> SplitSentences(const std::wstring& text)
+    {
+        std::vector<std::wstring> sentences;
+        std::wstring remaining = text;
+        while (sentences.size() < max_sentences) {
+            auto sentence = ExtractFirstSentence(remaining);
+            if (sentence.empty()) {
+                break;
+            }
+            const auto pos = remaining.find(sentence);
+            if (!TextUtils::RemovePunctuation(sentence).empty()) {
+                sentences.push_back(sentence);
+            }
+            if (pos == std::wstring::npos) {
+                break; // Truncated, nothing more to split
+            }
+            remaining = remaining.substr(pos + sentence.size());
+        }
+        return sentences;
+    }
+
+    // Fetch audio for one sentence from the cache, or generate it. Returns an empty path on failure.
+    // Pins the file returned, so that it stays on disk until it has been played
+    std::filesystem::path GetOrGenerateSentence(const VoiceRequest& request, const std::wstring& text, AudioCachePin& pin)
+    {
+        pin.Release(); // Before audio_cache_mutex is taken to pin the new file
+        const auto cache_key = GenerateOptimizedCacheKey(&request.profile, text, request.language);
+        auto path = GetAudioCacheFolder() / LanguageToAbbreviation(request.language) / cache_key;
+
+        if (TouchAudioCache(path, pin)) {
+            return path;
+        }
+
+        const auto api_config = GetCurrentAPIConfig();
+        const std::string audio_data = api_config ? api_config->callback(request, text) : "";
+        if (!audio_data.size()) {
+            VoiceLog("Failed to generate voice data");
+            return {};
+        }
+
+        Resources::EnsureFolderExists(path.parent_path());
+        FILE* fp = fopen(path.string().c_str(), "wb");
+        if (!fp) {
+            VoiceLog("Failed to open file for writing: %s", path.string().c_str());
+            return {};
+        }
+        const auto written = fwrite(audio_data.data(), sizeof(audio_data[0]), audio_data.size(), fp);
+        fclose(fp);
+        if (written < 1) {
+            VoiceLog("Failed to write audio data to file: %s", path.string().c_str());
+            return {};
+        }
+        AddToAudioCache(path, written, pin);
+        return path;
+    }
+
     void GenerateVoice(PendingNPCAudio* audio)
     {
         if (generating_voice || !audio) return;
@@ -1095,50 +1506,91 @@ namespace {
             return;
         }
 
-        Resources::EnqueueWorkerTask([audio]() {
-            if (std::ranges::find(pending_audio, audio) == pending_audio.end())
-                return generating_voice = false;
-
-            const auto cache_key = GenerateOptimizedCacheKey(audio->profile, audio->decoded_message, audio->language);
-            audio->path = Resources::GetPath("NPCVoiceCache") / LanguageToAbbreviation(audio->language) / cache_key;
+        auto job = std::make_shared<VoiceJob>();
+        job->request.profile = *audio->profile;
+        job->request.language = audio->language;
+        job->request.agent_id = audio->agent_id;
+        job->request.gender = GetAgentGender(audio->agent_id);
+        job->sentences = only_use_first_sentence ? std::vector<std::wstring>() : SplitSentences(audio->decoded_message);
+        if (job->sentences.empty()) {
+            job->sentences.push_back(audio->decoded_message);
+        }
+        audio->job = job;
 
-            // Check cache first
-            if (std::filesystem::exists(audio->path)) {
-                audio->Play();
-                return generating_voice = false;
+        // The worker only sees the job; results go back through generated_sentences and are matched up in Update
+        Resources::EnqueueWorkerTask([job]() {
+            if (job->cancelled) {
+                generating_voice = false;
+                return;
+            }
+            for (size_t i = 0; i < job->sentences.size() && !job->cancelled; i++) {
+                GeneratedSentence generated;
+                generated.job = job;
+                generated.first = i == 0;
+                generated.path = GetOrGenerateSentence(job->request, job->sentences[i], generated.pin);
+                if (!generated.path.empty()) {
+                    generated.duration = EstimateAudioDuration(generated.path);
+                }
+                const bool failed = generated.path.empty();
+                {
+                    std::lock_guard lock(generated_mutex);
+                    generated_sentences.push_back(std::move(generated));
+                }
+                if (i == 0) {
+                    generating_voice = false;
+                }
+                if (failed) {
+                    break;
+                }
             }
+        });
+    }
 
-            std::string audio_data = "";
-            const auto api_config = GetCurrentAPIConfig();
-            audio_data = api_config ? api_config->callback(audio) : "";
-            if (std::ranges::find(pending_audio, audio) == pending_audio.end()) return generating_voice = false;
-            if (!audio_data.size()) {
-                VoiceLog("Failed to generate voice data");
-                delete audio;
-                return generating_voice = false;
+    PendingNPCAudio* FindAudioForJob(const VoiceJob* job)
+    {
+        for (const auto audio : pending_audio) {
+            if (audio->job.get() == job) {
+                return audio;
             }
+        }
+        for (const auto audio : playing_audio_map | std::views::values) {
+            if (audio->job.get() == job) {
+                return audio;
+            }
+        }
+        return nullptr;
+    }
 
-            // Save to cache
-            Resources::EnsureFolderExists(audio->path.parent_path());
-            FILE* fp = fopen(audio->path.string().c_str(), "wb");
-            if (!fp) {
-                VoiceLog("Failed to open file for writing: %s", audio->path.string().c_str());
-                delete audio;
-                return generating_voice = false;
+    // Plays or queues whatever the worker has generated since the last frame
+    void ProcessGeneratedSentences()
+    {
+        std::vector<GeneratedSentence> generated;
+        {
+            std::lock_guard lock(generated_mutex);
+            generated.swap(generated_sentences);
+        }
+        for (auto& it : generated) {
+            const auto audio = it.job->cancelled ? nullptr : FindAudioForJob(it.job.get());
+            if (!audio) {
+                continue;
             }
-            const auto written = fwrite(audio_data.data(), sizeof(audio_data[0]), audio_data.size(), fp);
-            fclose(fp);
-            if (written < 1) {
-                VoiceLog("Failed to write audio data to file: %s", audio->path.string().c_str());
+            if (!it.first) {
+                if (!it.path.empty()) {
+                    audio->queued_sentences.push_back({std::move(it.path), std::move(it.pin), it.duration});
+                }
+                continue;
+            }
+            if (it.path.empty()) {
                 delete audio;
-                return generating_voice = false;
+                continue;
             }
-            if (std::ranges::find(pending_audio, audio) == pending_audio.end()) return generating_voice = false;
+            audio->path = std::move(it.path);
+            audio->pin = std::move(it.pin);
+            audio->duration = it.duration;
             audio->Play();
-            return generating_voice = false;
-        });
+        }
     }
-    
+
     // Block any in-game speech from an agent that we're already doing TTS for
     void OnPlaySound(GW::HookStatus* status, const wchar_t* filename, SoundProps* props) {
         if (status->blocked) return;
@@ -1478,11 +1930,26 @@ void NPCVoiceModule::Terminate()
 {
     ToolboxModule::Terminate();
     ClearSounds();
+    SaveAudioCacheIndex();
     GW::UI::RemoveUIMessageCallback(&UIMessage_HookEntry);
     GW::UI::RemoveUIMessageCallback(&PreUIMessage_HookEntry);
     AudioSettings::RemovePlaySoundCallback(&UIMessage_HookEntry);
 }
 
+void NPCVoiceModule::Update(float)
+{
+    ProcessGeneratedSentences();
+    std::vector<PendingNPCAudio*> finished;
+    for (const auto audio : playing_audio_map | std::views::values) {
+        if (!audio->IsPlaying()) {
+            finished.push_back(audio);
+        }
+    }
+    for (const auto audio : finished) {
+        audio->PlayNext();
+    }
+}
+
 void NPCVoiceModule::LoadSettings(ToolboxIni* ini)
 {
     ToolboxModule::LoadSettings(ini);
@@ -1512,6 +1979,7 @@ void NPCVoiceModule::LoadSettings(ToolboxIni* ini)
     LOAD_BOOL(play_speech_from_vendors);
 
     LOAD_FLOAT(npc_speech_bubble_range);
+    LOAD_UINT(max_cache_size_mb);
 
     CSimpleIniA::TNamesDepend keys;
     ini->GetAllKeys(Name(), keys);
@@ -1559,6 +2027,9 @@ void NPCVoiceModule::SaveSettings(ToolboxIni* ini)
     SAVE_BOOL(play_speech_from_vendors);
 
     SAVE_FLOAT(npc_speech_bubble_range);
+    SAVE_UINT(max_cache_size_mb);
+
+    SaveAudioCacheIndex();
 
 
     // Remove existing custom voice entries (don't clear the whole section)
@@ -1622,7 +2093,8 @@ void NPCVoiceModule::DrawSettingsInternal()
 
     bool show_warning = false;
     ImGui::Checkbox("Only process the first sentence of a dialog", &only_use_first_sentence);
-    ImGui::ShowHelp("If enabled, only the first sentence of an NPC dialog will be processed.");
+    ImGui::ShowHelp("If enabled, only the first sentence of an NPC dialog will be processed.\n"
+                    "Otherwise the first sentence starts playing as soon as it is ready, and the rest are generated while it plays.");
     show_warning |= !only_use_first_sentence;
 
     ImGui::Checkbox("Only process the first dialog of an NPC", &only_use_first_dialog);
@@ -1664,6 +2136,20 @@ void NPCVoiceModule::DrawSettingsInternal()
         ImGui::TextColored(ImColor(IM_COL32(245, 245, 0, 255)), "Warning: Processing more lines of dialog will use up more API credits!");
     }
 
+    int cache_size_mb = static_cast<int>(max_cache_size_mb);
+    if (ImGui::InputInt("Max audio cache size (MB)", &cache_size_mb, 16, 128)) {
+        max_cache_size_mb = static_cast<unsigned int>(std::clamp(cache_size_mb, 16, 4096));
+        std::lock_guard lock(audio_cache_mutex);
+        LoadAudioCacheIndex();
+        EvictAudioCache();
+    }
+    ImGui::ShowHelp("Generated audio is kept in the NPCVoiceCache folder so the same line is never paid for twice.\n"
+                    "When the folder grows past this size, the least recently played files are deleted.");
+    if (audio_cache_loaded) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(%.1f MB used)", static_cast<float>(audio_cache_bytes) / (1024.f * 1024.f));
+    }
+
 // Custom NPC Voice Assignment Section
     ImGui::Separator();
     ImGui::Text("Custom NPC Voice Assignment:");
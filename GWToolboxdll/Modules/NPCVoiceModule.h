@@ -34,6 +34,7 @@ public:
 
     void Initialize() override;
     void Terminate() override;
+    void Update(float delta) override;
     void LoadSettings(ToolboxIni* ini) override;
     void SaveSettings(ToolboxIni* ini) override;
     void DrawSettingsInternal() override;
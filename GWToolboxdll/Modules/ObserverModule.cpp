@@ -32,6 +32,31 @@ namespace {
     {
         ObserverModule::Instance().Reset();
     }
+
+    void CHAT_CMD_FUNC(CmdObserverReplay)
+    {
+        if (argc < 2) {
+            Log::Error("Syntax: /observer:replay <file name in observer_logs folder>");
+            return;
+        }
+        const auto path = Resources::GetPath(L"observer_logs", argv[1]);
+        if (!ObserverModule::Instance().Replay(path)) {
+            Log::ErrorW(L"Failed to replay observer log %s", path.wstring().c_str());
+        }
+    }
+
+    std::string ProfessionString(const GW::Constants::Profession primary, const GW::Constants::Profession secondary)
+    {
+        if (primary == GW::Constants::Profession::None) {
+            return "";
+        }
+        std::string prof = GetProfessionAcronym(primary);
+        if (secondary != GW::Constants::Profession::None) {
+            const std::string s_prof = GetProfessionAcronym(secondary);
+            prof = prof + "/" + s_prof;
+        }
+        return prof;
+    }
 }
 
 constexpr auto INI_FILENAME = L"observerlog.ini";
@@ -124,7 +149,11 @@ void ObserverModule::Initialize()
             if (!InitializeObserverSession()) {
                 return;
             }
-            HandleJumboMessage(packet->type, packet->value);
+            ObserverEventLog::Event event;
+            event.type = ObserverEventLog::EventType::JumboMessage;
+            event.a = packet->type;
+            event.b = packet->value;
+            ProcessEvent(event);
         });
 
     GW::StoC::RegisterPacketCallback<GW::Packet::StoC::AgentState>(
@@ -135,7 +164,11 @@ void ObserverModule::Initialize()
             if (!InitializeObserverSession()) {
                 return;
             }
-            HandleAgentState(packet->agent_id, packet->state);
+            ObserverEventLog::Event event;
+            event.type = ObserverEventLog::EventType::AgentState;
+            event.a = packet->agent_id;
+            event.b = packet->state;
+            ProcessEvent(event);
         });
 
     GW::StoC::RegisterPacketCallback<GW::Packet::StoC::AgentAdd>(
@@ -147,7 +180,10 @@ void ObserverModule::Initialize()
             if (!InitializeObserverSession()) {
                 return;
             }
-            HandleAgentAdd(packet->agent_id);
+            ObserverEventLog::Event event;
+            event.type = ObserverEventLog::EventType::AgentAdd;
+            event.a = packet->agent_id;
+            ProcessEvent(event);
         });
 
     GW::StoC::RegisterPacketCallback<GW::Packet::StoC::AgentProjectileLaunched>(
@@ -159,7 +195,10 @@ void ObserverModule::Initialize()
             if (!InitializeObserverSession()) {
                 return;
             }
-            HandleAgentProjectileLaunched(packet);
+            ObserverEventLog::Event event;
+            event.type = ObserverEventLog::EventType::ProjectileLaunched;
+            event.a = packet->agent_id;
+            ProcessEvent(event);
         });
 
     GW::StoC::RegisterPacketCallback<GW::Packet::StoC::GenericModifier>(
@@ -172,12 +211,14 @@ void ObserverModule::Initialize()
                 return;
             }
 
-            const uint32_t value_id = packet->type;
-            const uint32_t caster_id = packet->cause_id;
-            const uint32_t target_id = packet->target_id;
-            const float value = packet->value;
-            constexpr bool no_target = false;
-            HandleGenericPacket(value_id, caster_id, target_id, value, no_target);
+            ObserverEventLog::Event event;
+            event.type = ObserverEventLog::EventType::GenericFloat;
+            event.a = packet->type;
+            event.b = packet->cause_id;
+            event.c = packet->target_id;
+            memcpy(&event.value, &packet->value, sizeof(event.value));
+            event.flags = 0; // no_target = false
+            ProcessEvent(event);
         }
     );
 
@@ -191,12 +232,14 @@ void ObserverModule::Initialize()
                 return;
             }
 
-            const uint32_t value_id = packet->Value_id;
-            const uint32_t caster_id = packet->caster;
-            const uint32_t target_id = packet->target;
-            const uint32_t value = packet->value;
-            constexpr bool no_target = false;
-            HandleGenericPacket(value_id, caster_id, target_id, value, no_target);
+            ObserverEventLog::Event event;
+            event.type = ObserverEventLog::EventType::GenericValue;
+            event.a = packet->Value_id;
+            event.b = packet->caster;
+            event.c = packet->target;
+            event.value = packet->value;
+            event.flags = 0; // no_target = false
+            ProcessEvent(event);
         });
 
     GW::StoC::RegisterPacketCallback<GW::Packet::StoC::GenericValue>(
@@ -209,12 +252,14 @@ void ObserverModule::Initialize()
                 return;
             }
 
-            const uint32_t value_id = packet->value_id;
-            const uint32_t caster_id = packet->agent_id;
-            constexpr uint32_t target_id = NO_AGENT;
-            const uint32_t value = packet->value;
-            constexpr bool no_target = true;
-            HandleGenericPacket(value_id, caster_id, target_id, value, no_target);
+            ObserverEventLog::Event event;
+            event.type = ObserverEventLog::EventType::GenericValue;
+            event.a = packet->value_id;
+            event.b = packet->agent_id;
+            event.c = NO_AGENT;
+            event.value = packet->value;
+            event.flags = 1; // no_target = true
+            ProcessEvent(event);
         });
 
     GW::StoC::RegisterPacketCallback<GW::Packet::StoC::GenericFloat>(
@@ -226,12 +271,14 @@ void ObserverModule::Initialize()
                 return;
             }
 
-            const uint32_t value_id = packet->type;
-            const uint32_t caster_id = packet->agent_id;
-            constexpr uint32_t target_id = NO_AGENT;
-            const float value = packet->value;
-            constexpr bool no_target = true;
-            HandleGenericPacket(value_id, caster_id, target_id, value, no_target);
+            ObserverEventLog::Event event;
+            event.type = ObserverEventLog::EventType::GenericFloat;
+            event.a = packet->type;
+            event.b = packet->agent_id;
+            event.c = NO_AGENT;
+            memcpy(&event.value, &packet->value, sizeof(event.value));
+            event.flags = 1; // no_target = true
+            ProcessEvent(event);
         }
     );
 
@@ -240,6 +287,7 @@ void ObserverModule::Initialize()
     }
 
     GW::Chat::CreateCommand(&ChatCmd_HookEntry, L"observer:reset", CmdObserverReset);
+    GW::Chat::CreateCommand(&ChatCmd_HookEntry, L"observer:replay", CmdObserverReplay);
 }
 
 void ObserverModule::Terminate()
@@ -265,6 +313,7 @@ void ObserverModule::HandleInstanceLoadInfo(const GW::HookStatus*, const GW::Pac
 {
     is_explorable = packet->is_explorable;
     is_observer = packet->is_observer;
+    replay_loaded = false;
 
     const bool is_active = IsActive();
 
@@ -540,12 +589,9 @@ void ObserverModule::HandleAgentAdd(const uint32_t)
 
 // Handle AgentProjectileLaunched Packet
 // can be used to determine when a ranged attack has finished
-void ObserverModule::HandleAgentProjectileLaunched(const GW::Packet::StoC::AgentProjectileLaunched* packet)
+void ObserverModule::HandleAgentProjectileLaunched(const uint32_t agent_id)
 {
-    if (!packet) {
-        return;
-    }
-    ObservableAgent* agent = GetObservableAgentById(packet->agent_id);
+    ObservableAgent* agent = GetObservableAgentById(agent_id);
     // ensure the projectile was from an attack we're currently undertaking
     if (!agent || !agent->current_target_action || !agent->current_target_action->is_attack) {
         return;
@@ -570,9 +616,9 @@ void ObserverModule::HandleAttackStopped(const uint32_t agent_id)
 // Handle AttackStarted Packet
 void ObserverModule::HandleAttackStarted(const uint32_t caster_id, const uint32_t target_id)
 {
-    const auto action = new TargetAction(caster_id, target_id, true, false, NO_SKILL);
+    const auto action = action_pool.Create(caster_id, target_id, true, false, NO_SKILL);
     if (!ReduceAction(GetObservableAgentById(caster_id), ActionStage::Started, action)) {
-        delete action;
+        action_pool.Release(action);
     }
 }
 
@@ -601,9 +647,9 @@ void ObserverModule::HandleAttackSkillStopped(const uint32_t agent_id)
 void ObserverModule::HandleInstantSkillActivated(const uint32_t caster_id, const uint32_t target_id, const GW::Constants::SkillID skill_id)
 {
     // assuming there are no instant attack skills...
-    const auto action = new TargetAction(caster_id, target_id, false, true, skill_id);
+    const auto action = action_pool.Create(caster_id, target_id, false, true, skill_id);
     if (!ReduceAction(GetObservableAgentById(caster_id), ActionStage::Instant, action)) {
-        delete action;
+        action_pool.Release(action);
     }
 }
 
@@ -611,9 +657,9 @@ void ObserverModule::HandleInstantSkillActivated(const uint32_t caster_id, const
 // Handle AttackSkillActivated Packet
 void ObserverModule::HandleAttackSkillStarted(const uint32_t caster_id, const uint32_t target_id, const GW::Constants::SkillID skill_id)
 {
-    const auto action = new TargetAction(caster_id, target_id, true, true, skill_id);
+    const auto action = action_pool.Create(caster_id, target_id, true, true, skill_id);
     if (!ReduceAction(GetObservableAgentById(caster_id), ActionStage::Started, action)) {
-        delete action;
+        action_pool.Release(action);
     }
 }
 
@@ -635,9 +681,9 @@ void ObserverModule::HandleSkillStopped(const uint32_t agent_id)
 // Handle SkillActivated Packet
 void ObserverModule::HandleSkillActivated(const uint32_t caster_id, const uint32_t target_id, const GW::Constants::SkillID skill_id)
 {
-    const auto action = new TargetAction(caster_id, target_id, false, true, skill_id);
+    const auto action = action_pool.Create(caster_id, target_id, false, true, skill_id);
     if (!ReduceAction(GetObservableAgentById(caster_id), ActionStage::Started, action)) {
-        delete action;
+        action_pool.Release(action);
     }
 }
 
@@ -715,7 +761,7 @@ void ObserverModule::HandleVictory(ObservableParty* winning_party)
 
     // note the final game duration
     // don't count the first minute before the gates open...
-    const uint32_t ms = GW::Map::GetInstanceTime() - 1000 * 60;
+    const uint32_t ms = GetInstanceTime() - 1000 * 60;
     match_duration_ms_total = std::chrono::milliseconds(ms);
     match_duration_ms = std::chrono::milliseconds(ms);
     match_duration_secs = std::chrono::duration_cast<std::chrono::seconds>(match_duration_ms);
@@ -735,8 +781,8 @@ void ObserverModule::HandleVictory(ObservableParty* winning_party)
 
 bool ObserverModule::ReduceAction(ObservableAgent* caster, const ActionStage stage, TargetAction* new_action)
 {
-    // if the action ends up owned by the caster, the observermodule is responsible for garbage collecting the action
-    // if the action ends up NOT owned by the caster, the caller is responsible for garbage collecting the action
+    // if the action ends up owned by the caster, the observermodule is responsible for releasing the action back to the pool
+    // if the action ends up NOT owned by the caster, the caller is responsible for releasing the action back to the pool
     bool action_ownership_transferred = false;
 
     if (!caster) {
@@ -745,7 +791,7 @@ bool ObserverModule::ReduceAction(ObservableAgent* caster, const ActionStage sta
 
     TargetAction* action;
 
-    // If starting a new action, delete the last stored action & store this new action
+    // If starting a new action, release the last stored action & store this new action
     if (new_action) {
         ASSERT(stage == ActionStage::Started || stage == ActionStage::Instant);
         // starting a new action
@@ -753,9 +799,10 @@ bool ObserverModule::ReduceAction(ObservableAgent* caster, const ActionStage sta
         // "instant" actions do not persist (don't received a "finished" packet) so we don't store them on the agent
         // and they may be activateable while using other skills (e.g. shouts/stances) so we don't clear the current action
         if (stage != ActionStage::Instant) {
-            // delete the previous blocking action
-
-            delete caster->current_target_action;
+            // release the previous blocking action
+            if (caster->current_target_action) {
+                action_pool.Release(caster->current_target_action);
+            }
 
             // store the new blocking action
             caster->current_target_action = new_action;
@@ -857,7 +904,7 @@ bool ObserverModule::ReduceAction(ObservableAgent* caster, const ActionStage sta
         if (caster) {
             caster->stats.total_attacks_dealt.Reduce(action, stage);
             if (target) {
-                caster->stats.LazyGetAttacksDealedAgainst(target->agent_id).Reduce(action, stage);
+                caster->stats.LazyGetAttacksDealedAgainst(*target).Reduce(action, stage);
             }
             // if the target belonged to a party, the caster just attacked that other party
             if (target_party) {
@@ -878,7 +925,7 @@ bool ObserverModule::ReduceAction(ObservableAgent* caster, const ActionStage sta
         if (target) {
             target->stats.total_attacks_received.Reduce(action, stage);
             if (caster) {
-                target->stats.LazyGetAttacksReceivedFrom(caster->agent_id).Reduce(action, stage);
+                target->stats.LazyGetAttacksReceivedFrom(*caster).Reduce(action, stage);
             }
             // if the caster belonged to a party, the target was just attacked by that other party
             if (caster_party) {
@@ -977,12 +1024,12 @@ bool ObserverModule::ReduceAction(ObservableAgent* caster, const ActionStage sta
         // notify the caster
         if (caster) {
             caster->stats.total_skills_used.Reduce(action, stage);
-            caster->stats.LazyGetSkillUsed(action->skill_id).Reduce(action, stage);
+            caster->stats.LazyGetSkillUsed(*skill).Reduce(action, stage);
 
             // used against a target?
             if (target) {
                 // use against agent
-                caster->stats.LazyGetSkillUsedOn(target->agent_id, action->skill_id).Reduce(action, stage);
+                caster->stats.LazyGetSkillUsedOn(*target, *skill).Reduce(action, stage);
 
                 // team:
                 // same team
@@ -1038,11 +1085,11 @@ bool ObserverModule::ReduceAction(ObservableAgent* caster, const ActionStage sta
         // notify the target
         if (target) {
             target->stats.total_skills_received.Reduce(action, stage);
-            target->stats.LazyGetSkillReceived(action->skill_id).Reduce(action, stage);
+            target->stats.LazyGetSkillReceived(*skill).Reduce(action, stage);
             // used from a living caster? (redundant)
             if (caster) {
                 // use against agent
-                target->stats.LazyGetSkillReceivedFrom(caster->agent_id, action->skill_id).Reduce(action, stage);
+                target->stats.LazyGetSkillReceivedFrom(*caster, *skill).Reduce(action, stage);
 
                 // team
                 // same team
@@ -1103,6 +1150,10 @@ bool ObserverModule::ReduceAction(ObservableAgent* caster, const ActionStage sta
 // Module: Reset the Modules state
 void ObserverModule::Reset()
 {
+    event_log.Close();
+    recorded_party_members.clear();
+    replay_loaded = false;
+
     if (map) {
         delete map;
         map = nullptr;
@@ -1143,6 +1194,9 @@ void ObserverModule::Reset()
         }
     }
     observable_parties.clear();
+
+    // agents have released their actions by now
+    action_pool.Clear();
 }
 
 
@@ -1150,6 +1204,10 @@ void ObserverModule::Reset()
 // Returns false if failed to initialise. True if successful
 bool ObserverModule::InitializeObserverSession()
 {
+    // live packets would be folded into the replayed stats
+    if (replay_loaded) {
+        return false;
+    }
     if (observer_session_initialized) {
         return true;
     }
@@ -1159,6 +1217,11 @@ bool ObserverModule::InitializeObserverSession()
         return false;
     }
 
+    // open the log before loading agents so their snapshots are recorded
+    if (record_events && !event_log.IsOpen()) {
+        StartRecording(GW::Map::GetMapID());
+    }
+
     // load parties
     if (!SynchroniseParties()) {
         return false;
@@ -1223,11 +1286,225 @@ bool ObserverModule::SynchroniseParties()
         }
     }
 
+    RecordParties();
+
     // success
     return true;
 }
 
 
+uint32_t ObserverModule::GetInstanceTime() const
+{
+    return replaying ? replay_time_ms : GW::Map::GetInstanceTime();
+}
+
+
+// Open a new event log for this match
+void ObserverModule::StartRecording(const GW::Constants::MapID map_id)
+{
+    const auto folder = Resources::GetPath(L"observer_logs");
+    if (!Resources::EnsureFolderExists(folder)) {
+        Log::Error("Failed to create observer_logs folder");
+        return;
+    }
+    const auto now = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+    const auto path = folder / std::format(L"{:%Y%m%d_%H%M%S}_{}.obslog", now, std::to_underlying(map_id));
+    recorded_party_members.clear();
+    ObserverEventLog::FileHeader header;
+    header.map_id = std::to_underlying(map_id);
+    header.started_at = static_cast<uint64_t>(time(nullptr));
+    if (!event_log.Open(path, header)) {
+        Log::ErrorW(L"Failed to open observer log %s", path.wstring().c_str());
+    }
+}
+
+
+void ObserverModule::RecordEvent(ObserverEventLog::Event event, const void* payload)
+{
+    if (replaying || !event_log.IsOpen()) {
+        return;
+    }
+    event.time_ms = GW::Map::GetInstanceTime();
+    event_log.Append(event, payload);
+}
+
+
+// Agents are looked up from the game while live; record what we need to recreate them on replay
+void ObserverModule::RecordAgentSnapshot(const GW::AgentLiving& agent_living)
+{
+    if (replaying || !event_log.IsOpen()) {
+        return;
+    }
+    wchar_t enc_name[64]{};
+    if (const wchar_t* agent_enc_name = GW::Agents::GetAgentEncName(&agent_living)) {
+        wcsncpy_s(enc_name, agent_enc_name, _TRUNCATE);
+    }
+    ObserverEventLog::Event event;
+    event.type = ObserverEventLog::EventType::AgentSnapshot;
+    event.a = agent_living.agent_id;
+    event.b = agent_living.login_number;
+    event.c = static_cast<uint32_t>(agent_living.team_id) | (static_cast<uint32_t>(agent_living.primary) << 8) | (static_cast<uint32_t>(agent_living.secondary) << 16);
+    event.value = static_cast<uint32_t>(agent_living.tags->guild_id);
+    event.flags = static_cast<uint8_t>((agent_living.IsPlayer() ? ObserverEventLog::AgentFlag_Player : 0) | (agent_living.IsNPC() ? ObserverEventLog::AgentFlag_Npc : 0));
+    event.payload_len = static_cast<uint16_t>((wcslen(enc_name) + 1) * sizeof(wchar_t));
+    RecordEvent(event, enc_name);
+}
+
+
+// Parties are synchronised from the game while live; record membership so replay can rebuild it
+void ObserverModule::RecordParties()
+{
+    if (replaying || !event_log.IsOpen()) {
+        return;
+    }
+    // Only slots that changed since they were last recorded; this runs every time parties are synchronised
+    for (const auto party : observable_parties | std::views::values) {
+        auto& recorded = recorded_party_members[party->party_id];
+        const auto slots = std::max(recorded.size(), party->agent_ids.size());
+        recorded.resize(slots, NO_AGENT);
+        for (size_t i = 0; i < slots; i++) {
+            const auto agent_id = i < party->agent_ids.size() ? party->agent_ids[i] : NO_AGENT;
+            if (recorded[i] == agent_id) {
+                continue;
+            }
+            recorded[i] = agent_id;
+            ObserverEventLog::Event event;
+            event.type = ObserverEventLog::EventType::PartyMember;
+            event.a = party->party_id;
+            event.b = agent_id;
+            event.c = static_cast<uint32_t>(i);
+            RecordEvent(event);
+        }
+    }
+}
+
+
+void ObserverModule::ProcessEvent(const ObserverEventLog::Event& event)
+{
+    // Load the agents this event refers to first, so their snapshots are logged ahead of it; a replay can't create them
+    using ObserverEventLog::EventType;
+    switch (event.type) {
+        case EventType::AgentState:
+        case EventType::AgentAdd:
+        case EventType::ProjectileLaunched:
+            GetObservableAgentById(event.a);
+            break;
+        case EventType::GenericFloat:
+        case EventType::GenericValue:
+            GetObservableAgentById(event.b);
+            GetObservableAgentById(event.c);
+            break;
+        default:
+            break;
+    }
+    RecordEvent(event);
+    ApplyEvent(event);
+}
+
+
+void ObserverModule::ApplyEvent(const ObserverEventLog::Event& event, const void* payload)
+{
+    using ObserverEventLog::EventType;
+    switch (event.type) {
+        case EventType::JumboMessage:
+            HandleJumboMessage(static_cast<uint8_t>(event.a), event.b);
+            break;
+        case EventType::AgentState:
+            HandleAgentState(event.a, event.b);
+            break;
+        case EventType::AgentAdd:
+            // parties are rebuilt from PartyMember events when replaying
+            if (!replaying) {
+                HandleAgentAdd(event.a);
+            }
+            break;
+        case EventType::ProjectileLaunched:
+            HandleAgentProjectileLaunched(event.a);
+            break;
+        case EventType::GenericFloat: {
+            float value;
+            memcpy(&value, &event.value, sizeof(value));
+            HandleGenericPacket(event.a, event.b, event.c, value, event.flags != 0);
+            break;
+        }
+        case EventType::GenericValue:
+            HandleGenericPacket(event.a, event.b, event.c, event.value, event.flags != 0);
+            break;
+        case EventType::AgentSnapshot: {
+            if (!replaying || observable_agents.contains(event.a)) {
+                break;
+            }
+            std::wstring enc_name;
+            if (payload && event.payload_len >= sizeof(wchar_t)) {
+                enc_name.assign(static_cast<const wchar_t*>(payload), event.payload_len / sizeof(wchar_t) - 1);
+            }
+            AddObservableAgent(new ObservableAgent(*this, event, enc_name.c_str()));
+            break;
+        }
+        case EventType::PartyMember: {
+            if (!replaying || event.a == NO_PARTY || event.c >= 64) {
+                break;
+            }
+            ObservableParty* party = GetObservablePartyById(event.a);
+            if (!party) {
+                party = AddObservableParty(new ObservableParty(*this, event.a));
+            }
+            if (party->agent_ids.size() <= event.c) {
+                party->agent_ids.resize(event.c + 1, NO_AGENT);
+            }
+            if (party->agent_ids[event.c] != event.b) {
+                // clear old party member
+                if (ObservableAgent* prev = GetObservableAgentById(party->agent_ids[event.c])) {
+                    prev->party_id = NO_PARTY;
+                    prev->party_index = 0;
+                }
+                party->agent_ids[event.c] = event.b;
+            }
+            if (ObservableAgent* agent = GetObservableAgentById(event.b)) {
+                agent->party_id = party->party_id;
+                agent->party_index = event.c;
+            }
+            break;
+        }
+    }
+}
+
+
+// Rebuild stats from a recorded event log, using the same reducers as live packets
+bool ObserverModule::Replay(const std::filesystem::path& path)
+{
+    ObserverEventLog::FileHeader header;
+    std::vector<uint8_t> buffer;
+    std::vector<const ObserverEventLog::Event*> events;
+    if (!ObserverEventLog::Read(path, header, buffer, events)) {
+        return false;
+    }
+
+    Reset();
+    if (const GW::AreaInfo* map_info = GW::Map::GetMapInfo(static_cast<GW::Constants::MapID>(header.map_id))) {
+        map = new ObservableMap(*map_info);
+    }
+    match_finished = false;
+    winning_party_id = NO_PARTY;
+    match_duration_ms_total = std::chrono::milliseconds(0);
+    match_duration_ms = std::chrono::milliseconds(0);
+    match_duration_secs = std::chrono::seconds(0);
+    match_duration_mins = std::chrono::minutes(0);
+
+    replaying = true;
+    for (const auto event : events) {
+        replay_time_ms = event->time_ms;
+        ApplyEvent(*event, ObserverEventLog::Payload(event));
+    }
+    replaying = false;
+    replay_time_ms = 0;
+
+    // keep the replayed stats until the next map load or reset, ignoring live packets until then
+    replay_loaded = true;
+    return true;
+}
+
+
 // Load settings
 void ObserverModule::LoadSettings(ToolboxIni* ini)
 {
@@ -1235,6 +1512,7 @@ void ObserverModule::LoadSettings(ToolboxIni* ini)
     LOAD_BOOL(is_enabled);
     LOAD_BOOL(trim_hench_names);
     LOAD_BOOL(enable_in_explorable_areas);
+    LOAD_BOOL(record_events);
 }
 
 
@@ -1245,6 +1523,7 @@ void ObserverModule::SaveSettings(ToolboxIni* ini)
     SAVE_BOOL(is_enabled);
     SAVE_BOOL(trim_hench_names);
     SAVE_BOOL(enable_in_explorable_areas);
+    SAVE_BOOL(record_events);
 }
 
 
@@ -1256,6 +1535,8 @@ void ObserverModule::DrawSettingsInternal()
     ImGui::Checkbox("Enabled", &is_enabled);
     ImGui::Checkbox("Trim henchman names", &trim_hench_names);
     ImGui::Checkbox("Enable in all Explorable Areas (experimental and unsupported)", &enable_in_explorable_areas);
+    ImGui::Checkbox("Record match events", &record_events);
+    ImGui::ShowHelp("Saves every observed packet to the observer_logs folder.\nUse /observer:replay <file> to rebuild stats from a recording.");
 }
 
 
@@ -1264,7 +1545,7 @@ void ObserverModule::Update(const float)
     if (party_sync_timer == 0) {
         return;
     }
-    if (!IsActive()) {
+    if (!IsActive() || replay_loaded) {
         party_sync_timer = 0;
         return;
     }
@@ -1291,7 +1572,7 @@ ObserverModule::ObservableGuild* ObserverModule::GetObservableGuildById(const ui
     }
 
     // create if active
-    if (!IsActive()) {
+    if (replaying || replay_loaded || !IsActive()) {
         return nullptr;
     }
     const GW::Guild* guild = GW::GuildMgr::GetGuildInfo(guild_id);
@@ -1334,8 +1615,8 @@ ObserverModule::ObservableAgent* ObserverModule::GetObservableAgentById(const ui
         return it->second;
     }
 
-    // create if active
-    if (!IsActive()) {
+    // create if active; replayed agents come from AgentSnapshot events instead
+    if (replaying || replay_loaded || !IsActive()) {
         return nullptr;
     }
     const GW::Agent* agent = GW::Agents::GetAgentByID(agent_id);
@@ -1361,7 +1642,15 @@ ObserverModule::ObservableAgent* ObserverModule::CreateObservableAgent(const GW:
     // ensure the guild is loaded...
     GetObservableGuildById(agent_living.tags->guild_id);
     auto observable_agent = new ObservableAgent(*this, agent_living);
-    // cache
+    RecordAgentSnapshot(agent_living);
+    return AddObservableAgent(observable_agent);
+}
+
+
+// Cache a newly created ObservableAgent
+ObserverModule::ObservableAgent* ObserverModule::AddObservableAgent(ObservableAgent* observable_agent)
+{
+    observable_agent->ordinal = static_cast<uint32_t>(observable_agents.size());
     observable_agents.insert({observable_agent->agent_id, observable_agent});
     observable_agent_ids.push_back(observable_agent->agent_id);
     std::ranges::sort(observable_agent_ids);
@@ -1385,8 +1674,8 @@ ObserverModule::ObservableSkill* ObserverModule::GetObservableSkillById(const GW
         return it_existing->second;
     }
 
-    // create if active
-    if (!IsActive()) {
+    // create if active; skill constant data is still available when replaying
+    if (!(replaying || IsActive())) {
         return nullptr;
     }
     const GW::Skill* gw_skill = GW::SkillbarMgr::GetSkillConstantData(skill_id);
@@ -1404,6 +1693,7 @@ ObserverModule::ObservableSkill* ObserverModule::CreateObservableSkill(const GW:
 {
     // create
     auto observable_skill = new ObservableSkill(*this, gw_skill);
+    observable_skill->ordinal = static_cast<uint32_t>(observable_skills.size());
     // cache
     observable_skills.insert({gw_skill.skill_id, observable_skill});
     observable_skill_ids.push_back(observable_skill->skill_id);
@@ -1423,7 +1713,7 @@ ObserverModule::ObservableParty* ObserverModule::GetObservablePartyByPartyInfo(c
     }
 
     // create if active
-    if (!IsActive()) {
+    if (replaying || replay_loaded || !IsActive()) {
         return nullptr;
     }
     ObservableParty* observable_party = this->CreateObservableParty(party_info);
@@ -1447,8 +1737,8 @@ ObserverModule::ObservableParty* ObserverModule::GetObservablePartyById(const ui
         return it_party->second;
     }
 
-    // create if active
-    if (!IsActive()) {
+    // create if active; replayed parties come from PartyMember events instead
+    if (replaying || replay_loaded || !IsActive()) {
         return nullptr;
     }
     const GW::PartyContext* party_ctx = GW::GetGameContext()->party;
@@ -1483,8 +1773,13 @@ ObserverModule::ObservableParty* ObserverModule::GetObservablePartyById(const ui
 ObserverModule::ObservableParty* ObserverModule::CreateObservableParty(const GW::PartyInfo& party_info)
 {
     // create
-    auto observable_party = new ObservableParty(*this, party_info);
-    // cache
+    return AddObservableParty(new ObservableParty(*this, party_info));
+}
+
+
+// Cache a newly created ObservableParty
+ObserverModule::ObservableParty* ObserverModule::AddObservableParty(ObservableParty* observable_party)
+{
     observable_parties.insert({observable_party->party_id, observable_party});
     observable_party_ids.push_back(observable_party->party_id);
     std::ranges::sort(observable_party_ids);
@@ -1567,211 +1862,83 @@ void ObserverModule::SharedStats::HandleKill()
 }
 
 
-ObserverModule::ObservableAgentStats::~ObservableAgentStats()
+ObserverModule::TargetAction* ObserverModule::TargetActionPool::Create(const uint32_t caster_id, const uint32_t target_id,
+                                                                     const bool is_attack, const bool is_skill,
+                                                                     const GW::Constants::SkillID skill_id)
 {
-    // attacks received (by agent)
-    for (const auto& [_, o_atk] : attacks_received_from_agents) {
-        if (o_atk) {
-            delete o_atk;
+    if (free_slots.empty()) {
+        auto& block = blocks.emplace_back(std::make_unique<Block>());
+        // push in reverse so slots are handed out in address order
+        for (size_t i = block_size; i > 0; i--) {
+            free_slots.push_back(block->storage + (i - 1) * sizeof(TargetAction));
         }
     }
-    attacks_received_from_agents.clear();
+    void* slot = free_slots.back();
+    free_slots.pop_back();
+    return new (slot) TargetAction(caster_id, target_id, is_attack, is_skill, skill_id);
+}
 
-    // attacks dealed (by agent)
-    for (const auto& [_, o_atk] : attacks_dealt_to_agents) {
-        if (o_atk) {
-            delete o_atk;
-        }
-    }
-    attacks_dealt_to_agents.clear();
 
-    // skills used
-    skill_ids_used.clear();
-    for (const auto& [_, o_skill] : skills_used) {
-        if (o_skill) {
-            delete o_skill;
-        }
-    }
-    skills_used.clear();
+void ObserverModule::TargetActionPool::Release(TargetAction* action)
+{
+    ASSERT(action);
+    action->~TargetAction();
+    free_slots.push_back(action);
+}
 
-    // skills received
-    skill_ids_received.clear();
-    for (const auto& [_, o_skill] : skills_received) {
-        if (o_skill) {
-            delete o_skill;
-        }
-    }
-    skills_received.clear();
 
-    // skill received (by agent)
-    for (auto& [_, skill_ids] : skill_ids_received_from_agents) {
-        skill_ids.clear();
-    }
-    skill_ids_received_from_agents.clear();
-    for (auto& [_, agent_skills] : skills_received_from_agents) {
-        for (const auto [__, o_skill] : agent_skills) {
-            if (o_skill) {
-                delete o_skill;
-            }
-        }
-        agent_skills.clear();
-    }
-    skills_received_from_agents.clear();
-
-    // skill used (by agent)
-    for (auto& [_, skill_ids] : skill_ids_used_on_agents) {
-        skill_ids.clear();
-    }
-    skill_ids_used_on_agents.clear();
-    for (auto& [_, agent_skills] : skills_used_on_agents) {
-        for (const auto [__, o_skill] : agent_skills) {
-            if (o_skill) {
-                delete o_skill;
-            }
-        }
-        agent_skills.clear();
-    }
-    skills_used_on_agents.clear();
+void ObserverModule::TargetActionPool::Clear()
+{
+    free_slots.clear();
+    blocks.clear();
 }
 
 
-// Get attacks dealed against this agent, by a caster_agent_id
-// Lazy initialises the caster_agent_id
-ObserverModule::ObservedAction& ObserverModule::ObservableAgentStats::LazyGetAttacksDealedAgainst(const uint32_t target_agent_id)
+// Get attacks dealt against the target by this agent
+// Lazy initialises the target
+ObserverModule::ObservedAction& ObserverModule::ObservableAgentStats::LazyGetAttacksDealedAgainst(const ObservableAgent& target)
 {
-    const auto it = attacks_dealt_to_agents.find(target_agent_id);
-    if (it == attacks_dealt_to_agents.end()) {
-        // receiver not registered
-        auto observed_action = new ObservedAction();
-        attacks_dealt_to_agents.insert({target_agent_id, observed_action});
-        return *observed_action;
-    }
-    // receiver is already reigstered
-    return *it->second;
+    return attacks_dealt_to_agents.LazyGet(target.ordinal, target.agent_id);
 }
 
 
-// Get attacks dealed against this agent, by a caster_agent_id
-// Lazy initialises the caster_agent_id
-ObserverModule::ObservedAction& ObserverModule::ObservableAgentStats::LazyGetAttacksReceivedFrom(const uint32_t caster_agent_id)
+// Get attacks received by this agent from the attacker
+// Lazy initialises the attacker
+ObserverModule::ObservedAction& ObserverModule::ObservableAgentStats::LazyGetAttacksReceivedFrom(const ObservableAgent& attacker)
 {
-    const auto it = attacks_received_from_agents.find(caster_agent_id);
-    if (it == attacks_received_from_agents.end()) {
-        // attacker not registered
-        auto observed_action = new ObservedAction();
-        attacks_received_from_agents.insert({caster_agent_id, observed_action});
-        return *observed_action;
-    }
-    // attacker is already reigstered
-    return *it->second;
+    return attacks_received_from_agents.LazyGet(attacker.ordinal, attacker.agent_id);
 }
 
 
 // Get skills used by this agent
-// Lazy initialises the skill_id
-ObserverModule::ObservedAction& ObserverModule::ObservableAgentStats::LazyGetSkillUsed(const GW::Constants::SkillID skill_id)
+// Lazy initialises the skill
+ObserverModule::ObservedSkill& ObserverModule::ObservableAgentStats::LazyGetSkillUsed(const ObservableSkill& skill)
 {
-    const auto it_skill = skills_used.find(skill_id);
-    if (it_skill == skills_used.end()) {
-        // skill not registered
-        skill_ids_used.push_back(skill_id);
-        // re-sort skills
-        std::ranges::sort(skill_ids_used);
-        auto observed_skill = new ObservedSkill(skill_id);
-        skills_used.insert({skill_id, observed_skill});
-        return *observed_skill;
-    }
-    // skill already registered
-    return *it_skill->second;
+    return skills_used.LazyGet(skill.ordinal, skill.skill_id);
 }
 
 
-// Get skills used received by this agent
-// Lazy initialises the skill_id
-ObserverModule::ObservedAction& ObserverModule::ObservableAgentStats::LazyGetSkillReceived(const GW::Constants::SkillID skill_id)
+// Get skills received by this agent
+// Lazy initialises the skill
+ObserverModule::ObservedSkill& ObserverModule::ObservableAgentStats::LazyGetSkillReceived(const ObservableSkill& skill)
 {
-    const auto it_skill = skills_received.find(skill_id);
-    if (it_skill == skills_received.end()) {
-        // skill not registered
-        skill_ids_received.push_back(skill_id);
-        // re-sort skills
-        std::ranges::sort(skill_ids_received);
-        auto observed_skill = new ObservedSkill(skill_id);
-        skills_received.insert({skill_id, observed_skill});
-        return *observed_skill;
-    }
-    // skill already registered
-    return *it_skill->second;
+    return skills_received.LazyGet(skill.ordinal, skill.skill_id);
 }
 
 
 // Get a skill received by this agent, from another agent
-// Lazy initialises the skill_id and caster_agent_id
-ObserverModule::ObservedSkill& ObserverModule::ObservableAgentStats::LazyGetSkillReceivedFrom(const uint32_t caster_agent_id, const GW::Constants::SkillID skill_id)
-{
-    const auto it_caster = skills_received_from_agents.find(caster_agent_id);
-    if (it_caster == skills_received_from_agents.end()) {
-        // receiver and his skills are not registered with this agent
-        std::vector received_skill_ids = {skill_id};
-        skill_ids_received_from_agents.insert({caster_agent_id, received_skill_ids});
-        auto observed_skill = new ObservedSkill(skill_id);
-        std::unordered_map<GW::Constants::SkillID, ObservedSkill*> received_skills = {{skill_id, observed_skill}};
-        skills_received_from_agents.insert({caster_agent_id, received_skills});
-        return *observed_skill;
-    }
-    // receiver is registered with this agent
-    std::unordered_map<GW::Constants::SkillID, ObservedSkill*>& used_by_caster = it_caster->second;
-    const auto it_observed_skill = used_by_caster.find(skill_id);
-    // does receiver have the skill registered from/against us?
-    if (it_observed_skill == used_by_caster.end()) {
-        // caster hasn't registered this skill with this agent
-        // add & re-sort skill_ids by the caster
-        std::vector<GW::Constants::SkillID>& skills_ids_received_by_agent_vec = skill_ids_received_from_agents.find(caster_agent_id)->second;
-        skills_ids_received_by_agent_vec.push_back(skill_id);
-        // re-sort
-        std::ranges::sort(skills_ids_received_by_agent_vec);
-        // add the observed skill for the caster
-        auto observed_skill = new ObservedSkill(skill_id);
-        used_by_caster.insert({skill_id, observed_skill});
-        return *observed_skill;
-    }
-    // receivers already registered this skill
-    return *it_observed_skill->second;
+// Lazy initialises the skill and caster
+ObserverModule::ObservedSkill& ObserverModule::ObservableAgentStats::LazyGetSkillReceivedFrom(const ObservableAgent& caster, const ObservableSkill& skill)
+{
+    return skills_received_from_agents.LazyGet(caster.ordinal, caster.agent_id).LazyGet(skill.ordinal, skill.skill_id);
 }
 
 
-// Get a skill received by this agent, from another agent
-// Lazy initialises the skill_id and caster_agent_id
-ObserverModule::ObservedSkill& ObserverModule::ObservableAgentStats::LazyGetSkillUsedOn(const uint32_t target_agent_id, const GW::Constants::SkillID skill_id)
-{
-    const auto it_target = skills_used_on_agents.find(target_agent_id);
-    if (it_target == skills_used_on_agents.end()) {
-        // receiver and his skills are not registered with this agent
-        std::vector used_skill_ids = {skill_id};
-        skill_ids_used_on_agents.insert({target_agent_id, used_skill_ids});
-        auto observed_skill = new ObservedSkill(skill_id);
-        std::unordered_map<GW::Constants::SkillID, ObservedSkill*> used_skills = {{skill_id, observed_skill}};
-        skills_used_on_agents.insert({target_agent_id, used_skills});
-        return *observed_skill;
-    }
-    std::unordered_map<GW::Constants::SkillID, ObservedSkill*>& used_on_target = it_target->second;
-    // receiver is registered with this agent
-    const auto it_observed_skill = used_on_target.find(skill_id);
-    // does receiver have the skill registered from/against us?
-    if (it_observed_skill == used_on_target.end()) {
-        // target hasn't registered this skill with this agent
-        // add & re-sort skill_ids by the caster
-        std::vector<GW::Constants::SkillID>& skills_ids_used_on_agent_vec = skill_ids_used_on_agents.find(target_agent_id)->second;
-        skills_ids_used_on_agent_vec.push_back(skill_id);
-        // re-sort
-        std::ranges::sort(skills_ids_used_on_agent_vec);
-        // add the observed skill for the caster
-        auto observed_skill = new ObservedSkill(skill_id);
-        used_on_target.insert({skill_id, observed_skill});
-        return *observed_skill;
-    }
-    // receivers already registered this skill
-    return *it_observed_skill->second;
+// Get a skill used by this agent, on another agent
+// Lazy initialises the skill and target
+ObserverModule::ObservedSkill& ObserverModule::ObservableAgentStats::LazyGetSkillUsedOn(const ObservableAgent& target, const ObservableSkill& skill)
+{
+    return skills_used_on_agents.LazyGet(target.ordinal, target.agent_id).LazyGet(skill.ordinal, skill.skill_id);
 }
 
 
@@ -1781,6 +1948,12 @@ ObserverModule::ObservableParty::ObservableParty(ObserverModule& parent, const G
     , parent(parent) {}
 
 
+// Constructor for a party recreated from an event log
+ObserverModule::ObservableParty::ObservableParty(ObserverModule& parent, const uint32_t party_id)
+    : party_id(party_id)
+    , parent(parent) {}
+
+
 // Destructor
 ObserverModule::ObservableParty::~ObservableParty()
 {
@@ -2025,22 +2198,37 @@ ObserverModule::ObservableAgent::ObservableAgent(ObserverModule& parent, const G
 {
     // async initialise the agents name now because we probably want it later
     GW::UI::AsyncDecodeStr(GW::Agents::GetAgentEncName(&agent_living), &_raw_name_w);
+    profession = ProfessionString(primary, secondary);
+};
 
-    if (primary != GW::Constants::Profession::None) {
-        std::string prof = GetProfessionAcronym(primary);
-        if (secondary != GW::Constants::Profession::None) {
-            const std::string s_prof = GetProfessionAcronym(secondary);
-            prof = prof + "/" + s_prof;
-        }
-        profession = prof;
+
+// Constructor from a recorded AgentSnapshot
+ObserverModule::ObservableAgent::ObservableAgent(ObserverModule& parent, const ObserverEventLog::Event& snapshot, const wchar_t* enc_name)
+    : parent(parent)
+    , agent_id(snapshot.a)
+    , login_number(snapshot.b)
+    , state(0)
+    , guild_id(snapshot.value)
+    , team_id(snapshot.c & 0xff)
+    , primary(static_cast<GW::Constants::Profession>((snapshot.c >> 8) & 0xff))
+    , secondary(static_cast<GW::Constants::Profession>((snapshot.c >> 16) & 0xff))
+    , is_player((snapshot.flags & ObserverEventLog::AgentFlag_Player) != 0)
+    , is_npc((snapshot.flags & ObserverEventLog::AgentFlag_Npc) != 0)
+{
+    if (enc_name && *enc_name) {
+        _raw_name_enc = enc_name;
+        GW::UI::AsyncDecodeStr(_raw_name_enc.c_str(), &_raw_name_w);
     }
-};
+    profession = ProfessionString(primary, secondary);
+}
 
 
 // Destructor
 ObserverModule::ObservableAgent::~ObservableAgent()
 {
-    delete current_target_action;
+    if (current_target_action) {
+        parent.action_pool.Release(current_target_action);
+    }
 }
 
 
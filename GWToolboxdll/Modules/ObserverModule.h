@@ -13,6 +13,7 @@
 #include <GWCA/Utilities/Hook.h>
 
 #include <ToolboxModule.h>
+#include <Utils/ObserverEventLog.h>
 
 constexpr auto NO_SKILL = static_cast<GW::Constants::SkillID>(0);
 constexpr auto NO_AGENT = 0;
@@ -111,9 +112,102 @@ public:
         ObservedSkill(const GW::Constants::SkillID skill_id)
             : skill_id(skill_id) { }
 
-        const GW::Constants::SkillID skill_id;
+        // not const; ObservedSkills are shuffled around inside an OrdinalTable
+        GW::Constants::SkillID skill_id;
+    };
+
+    // Recycles TargetActions for the duration of a match.
+    // Attack and skill packets arrive far too often in 8v8 to heap allocate one per packet.
+    class TargetActionPool {
+    public:
+        TargetActionPool() = default;
+        TargetActionPool(const TargetActionPool&) = delete;
+        ~TargetActionPool() { Clear(); }
+
+        TargetAction* Create(uint32_t caster_id, uint32_t target_id, bool is_attack, bool is_skill, GW::Constants::SkillID skill_id);
+        void Release(TargetAction* action);
+        // Frees all blocks; any TargetAction not yet released is invalidated
+        void Clear();
+
+    private:
+        static constexpr size_t block_size = 256;
+
+        struct Block {
+            alignas(TargetAction) std::byte storage[sizeof(TargetAction) * block_size];
+        };
+
+        std::vector<std::unique_ptr<Block>> blocks;
+        std::vector<void*> free_slots;
+    };
+
+    // Stats keyed by agent_id or skill_id, stored contiguously in key order.
+    // Lookups go through a small per-match ordinal (ObservableAgent::ordinal, ObservableSkill::ordinal) instead of hashing.
+    template <typename Key, typename T>
+    class OrdinalTable {
+    public:
+        // Get the entry for this key, inserting it in key order if not found
+        T& LazyGet(const uint32_t ordinal, const Key key)
+        {
+            if (T* found = Find(ordinal)) {
+                return *found;
+            }
+            const auto pos = static_cast<size_t>(std::ranges::lower_bound(keys, key) - keys.begin());
+            keys.insert(keys.begin() + pos, key);
+            ordinals.insert(ordinals.begin() + pos, ordinal);
+            if constexpr (std::constructible_from<T, Key>) {
+                values.insert(values.begin() + pos, T(key));
+            }
+            else {
+                values.insert(values.begin() + pos, T());
+            }
+            if (slots.size() <= ordinal) {
+                slots.resize(ordinal + 1, 0);
+            }
+            // entries after pos have shifted by one
+            for (size_t i = pos; i < ordinals.size(); i++) {
+                slots[ordinals[i]] = static_cast<uint32_t>(i + 1);
+            }
+            return values[pos];
+        }
+
+        [[nodiscard]] T* Find(const uint32_t ordinal)
+        {
+            const uint32_t slot = ordinal < slots.size() ? slots[ordinal] : 0;
+            return slot ? &values[slot - 1] : nullptr;
+        }
+
+        [[nodiscard]] const T* Find(const uint32_t ordinal) const
+        {
+            const uint32_t slot = ordinal < slots.size() ? slots[ordinal] : 0;
+            return slot ? &values[slot - 1] : nullptr;
+        }
+
+        // Sorted keys, parallel to Values()
+        [[nodiscard]] const std::vector<Key>& Keys() const { return keys; }
+        [[nodiscard]] const std::vector<T>& Values() const { return values; }
+        [[nodiscard]] size_t size() const { return values.size(); }
+        [[nodiscard]] bool empty() const { return values.empty(); }
+
+        void clear()
+        {
+            keys.clear();
+            values.clear();
+            ordinals.clear();
+            slots.clear();
+        }
+
+    private:
+        std::vector<Key> keys;
+        std::vector<T> values;
+        std::vector<uint32_t> ordinals;
+        // ordinal -> index into values + 1; 0 if not present
+        std::vector<uint32_t> slots;
     };
 
+    class ObservableAgent;
+    class ObservableSkill;
+    using ObservedSkillTable = OrdinalTable<GW::Constants::SkillID, ObservedSkill>;
+
 
     // Shared stats for an Agent or Team
     class SharedStats {
@@ -190,39 +284,33 @@ public:
     // Stats for Agents
     class ObservableAgentStats : public SharedStats {
     public:
-        ~ObservableAgentStats();
+        // agent_id -> ObservedAction
+        OrdinalTable<uint32_t, ObservedAction> attacks_dealt_to_agents;
+        ObservedAction& LazyGetAttacksDealedAgainst(const ObservableAgent& target);
 
-        // map of agent_id -> ObservedAction
-        std::unordered_map<uint32_t, ObservedAction*> attacks_dealt_to_agents = {};
-        ObservedAction& LazyGetAttacksDealedAgainst(uint32_t target_agent_id);
-
-        // map of agent_id -> ObservedAction
-        std::unordered_map<uint32_t, ObservedAction*> attacks_received_from_agents = {};
-        ObservedAction& LazyGetAttacksReceivedFrom(uint32_t attacker_agent_id);
+        // agent_id -> ObservedAction
+        OrdinalTable<uint32_t, ObservedAction> attacks_received_from_agents;
+        ObservedAction& LazyGetAttacksReceivedFrom(const ObservableAgent& attacker);
 
         // skills
 
-        // map of skill_id -> count of times received
-        std::unordered_map<GW::Constants::SkillID, ObservedSkill*> skills_used = {};
-        std::vector<GW::Constants::SkillID> skill_ids_used = {};
-        ObservedAction& LazyGetSkillUsed(GW::Constants::SkillID skill_id);
+        // skill_id -> count of times used
+        ObservedSkillTable skills_used;
+        ObservedSkill& LazyGetSkillUsed(const ObservableSkill& skill);
 
-        // map of skill_id -> count of times used
-        std::unordered_map<GW::Constants::SkillID, ObservedSkill*> skills_received = {};
-        std::vector<GW::Constants::SkillID> skill_ids_received = {};
-        ObservedAction& LazyGetSkillReceived(GW::Constants::SkillID skill_id);
+        // skill_id -> count of times received
+        ObservedSkillTable skills_received;
+        ObservedSkill& LazyGetSkillReceived(const ObservableSkill& skill);
 
         // skills by agent
 
-        // map of agent_id -> skill_id -> count of times received
-        std::unordered_map<uint32_t, std::unordered_map<GW::Constants::SkillID, ObservedSkill*>> skills_received_from_agents = {};
-        std::unordered_map<uint32_t, std::vector<GW::Constants::SkillID>> skill_ids_received_from_agents = {};
-        ObservedSkill& LazyGetSkillReceivedFrom(uint32_t caster_agent_id, GW::Constants::SkillID skill_id);
+        // agent_id -> skill_id -> count of times received
+        OrdinalTable<uint32_t, ObservedSkillTable> skills_received_from_agents;
+        ObservedSkill& LazyGetSkillReceivedFrom(const ObservableAgent& caster, const ObservableSkill& skill);
 
-        // map of agent_id -> skill_id -> count of times used
-        std::unordered_map<uint32_t, std::unordered_map<GW::Constants::SkillID, ObservedSkill*>> skills_used_on_agents = {};
-        std::unordered_map<uint32_t, std::vector<GW::Constants::SkillID>> skill_ids_used_on_agents = {};
-        ObservedSkill& LazyGetSkillUsedOn(uint32_t target_agent_id, GW::Constants::SkillID skill_id);
+        // agent_id -> skill_id -> count of times used
+        OrdinalTable<uint32_t, ObservedSkillTable> skills_used_on_agents;
+        ObservedSkill& LazyGetSkillUsedOn(const ObservableAgent& target, const ObservableSkill& skill);
     };
 
     // Stats for Parties
@@ -251,12 +339,16 @@ public:
     class ObservableAgent {
     public:
         ObservableAgent(ObserverModule& parent, const GW::AgentLiving& agent_living);
+        // Recreate an agent from an ObserverEventLog AgentSnapshot when replaying
+        ObservableAgent(ObserverModule& parent, const ObserverEventLog::Event& snapshot, const wchar_t* enc_name);
         ~ObservableAgent();
 
         std::string profession = "";
 
         ObserverModule& parent;
         uint32_t agent_id;
+        // index of this agent in the match, used to look up per-agent stat tables
+        uint32_t ordinal = 0;
         uint32_t login_number;
         uint32_t state = state;
 
@@ -304,6 +396,8 @@ public:
         // raw_name is inially unknown for NPC's
         // raw_name is asynchronously initialized
         std::wstring _raw_name_w = L"";
+        // encoded name of a replayed agent; kept here because it's still being decoded after the constructor returns
+        std::wstring _raw_name_enc = L"";
         std::string _raw_name = "";
 
         std::wstring _sanitized_name_w = L"";
@@ -335,6 +429,8 @@ public:
         ObservableSkill(ObserverModule& parent, const GW::Skill& _gw_skill);
 
         GW::Constants::SkillID skill_id;
+        // index of this skill in the match, used to look up per-skill stat tables
+        uint32_t ordinal = 0;
         ObserverModule& parent;
         const GW::Skill& gw_skill;
 
@@ -359,6 +455,7 @@ public:
     class ObservableParty {
     public:
         ObservableParty(ObserverModule& parent, const GW::PartyInfo& info);
+        ObservableParty(ObserverModule& parent, uint32_t party_id);
         ~ObservableParty();
 
         uint32_t party_id;
@@ -453,6 +550,10 @@ public:
     bool InitializeObserverSession();
     void Reset();
 
+    // Rebuild stats from a log written with record_events enabled. Replaces the current session's stats.
+    bool Replay(const std::filesystem::path& path);
+    [[nodiscard]] bool IsReplaying() const { return replaying; }
+
     ObservableGuild* GetObservableGuildById(uint32_t guild_id);
     ObservableAgent* GetObservableAgentById(uint32_t agent_id);
     ObservableSkill* GetObservableSkillById(GW::Constants::SkillID skill_id);
@@ -481,6 +582,8 @@ private:
     ObservableSkill* CreateObservableSkill(const GW::Skill& gw_skill);
     ObservableParty* CreateObservableParty(const GW::PartyInfo& party_info);
     ObservableParty* GetObservablePartyByPartyInfo(const GW::PartyInfo& party_info);
+    ObservableAgent* AddObservableAgent(ObservableAgent* observable_agent);
+    ObservableParty* AddObservableParty(ObservableParty* observable_party);
 
     clock_t party_sync_timer = 0;
 
@@ -495,11 +598,32 @@ private:
     bool is_observer = false;
     bool is_explorable = false;
 
+    // event log
+    bool record_events = false;
+    bool replaying = false;
+    // A replay's stats are on show; live packets are ignored until the next map load or reset
+    bool replay_loaded = false;
+    uint32_t replay_time_ms = 0;
+    // Party slots as last written to the event log, so only changes are recorded
+    std::unordered_map<uint32_t, std::vector<uint32_t>> recorded_party_members;
+    ObserverEventLog::Writer event_log;
+
+    // Instance time of the event being processed; the recorded time when replaying
+    uint32_t GetInstanceTime() const;
+    void StartRecording(GW::Constants::MapID map_id);
+    void RecordEvent(ObserverEventLog::Event event, const void* payload = nullptr);
+    void RecordAgentSnapshot(const GW::AgentLiving& agent_living);
+    void RecordParties();
+    // Record (when enabled) and reduce a packet
+    void ProcessEvent(const ObserverEventLog::Event& event);
+    // Feed an event into the reducers; shared by live packets and replay
+    void ApplyEvent(const ObserverEventLog::Event& event, const void* payload = nullptr);
+
     // packet handlers
 
     void HandleInstanceLoadInfo(const GW::HookStatus* status, const GW::Packet::StoC::InstanceLoadInfo* packet);
     void HandleJumboMessage(uint8_t type, uint32_t value);
-    void HandleAgentProjectileLaunched(const GW::Packet::StoC::AgentProjectileLaunched* packet);
+    void HandleAgentProjectileLaunched(uint32_t agent_id);
 
     // generic handlers
 
@@ -539,6 +663,8 @@ private:
 
     ObservableMap* map{};
 
+    TargetActionPool action_pool;
+
     // lazy loaded observed guilds
     std::unordered_map<uint32_t, ObservableGuild*> observable_guilds = {};
     std::vector<uint32_t> observable_guild_ids = {};
@@ -21,44 +21,16 @@
 #include <Utils/GuiUtils.h>
 #include <Constants/EncStrings.h>
 #include <Utils/TextUtils.h>
-
-using nlohmann::json;
+#include <Utils/PriceIndex.h>
 
 namespace {
     float high_price_threshold = 1000;
-    bool fetching_prices;
     const char* trader_quotes_url = "https://kamadan.gwtoolbox.com/trader_quotes";
 
     constexpr clock_t request_interval = CLOCKS_PER_SEC * 60 * 5;
     clock_t last_request_time = request_interval * -1;
-    std::unordered_map<std::string, uint32_t> prices_by_identifier;
-
-    bool ParsePriceJson(const std::string& prices_json_str) {
 
-        const json& prices_json = json::parse(prices_json_str, nullptr, false);
-        if (prices_json == json::value_t::discarded) {
-            return false;
-        }
-
-        prices_by_identifier.clear();
-        const auto& it_buy = prices_json.find("sell");
-        if (it_buy == prices_json.end() || !it_buy->is_object()) {
-            return false;
-        }
-
-        const auto& buy = it_buy.value();
-
-        for (auto it = buy.begin(); it != buy.end(); it++) {
-            const auto& identifier = it.key();
-            if (!it->is_object())
-                continue;
-            const auto& price_value = it->find("p");
-            if (!(price_value != it->end() && price_value->is_number_unsigned()))
-                continue;
-            prices_by_identifier[identifier] = price_value->get<uint32_t>();
-        }
-        return !prices_by_identifier.empty();
-    }
+    std::atomic<std::shared_ptr<const PriceIndex>> price_index;
 
     std::unordered_map<uint32_t, const char*> mod_to_name =
     {
@@ -442,53 +414,29 @@ namespace {
     }
 
     float GetPriceByItem(const GW::Item* item, std::string* item_name_out = nullptr, unsigned int mod_start_index = 0) {
-        const auto prices = PriceCheckerModule::FetchPrices();
-        auto price = .0f;
-        const auto model_id_str = std::to_string(item->model_id);
+        PriceCheckerModule::FetchPrices();
+        const auto index = price_index.load();
+        if (!index)
+            return .0f;
         if (item->type == GW::Constants::ItemType::Materials_Zcoins) {
             // Find my model id
-            const auto found = prices.find(model_id_str);
-            if (found != prices.end()) 
-                price = static_cast<float>(found->second);
+            return static_cast<float>(index->Find(item->model_id, 0));
         }
-        else {
-            std::string mod_to_find;
-            std::string model_id_to_find;
-            // Find by mod struct id and model id
-            for (size_t i = mod_start_index; i < item->mod_struct_size; i++) {
-                const auto found = mod_to_id.find(item->mod_struct[i].mod);
-                if (found != mod_to_id.end() && found->second) {
-                    mod_to_find = std::format("{:08X}", found->first);
-                    model_id_to_find = std::string(found->second, strchr(found->second, '-'));
-                    if (item_name_out) {
-                        const auto name_found = mod_to_name.find(found->first);
-                        if (name_found != mod_to_name.end())
-                            *item_name_out = name_found->second;
-                    }
-                    break;
-                }
-            }
-            if (mod_to_find.empty())
-                return price;
-             
-            for (auto& it : prices) {
-                if (!it.first.starts_with(model_id_to_find))
-                    continue;
-                if (!it.first.contains(mod_to_find))
-                    continue;
-                price = static_cast<float>(it.second);
-                break;
+        // Find by mod struct id and model id
+        for (size_t i = mod_start_index; i < item->mod_struct_size; i++) {
+            const auto found = mod_to_id.find(item->mod_struct[i].mod);
+            if (found == mod_to_id.end() || !found->second)
+                continue;
+            const std::string_view identifier = found->second;
+            uint32_t model_id = 0;
+            if (!PriceIndex::ParseModelId(identifier.substr(0, identifier.find('-')), model_id))
+                continue;
+            if (item_name_out) {
+                const auto name_found = mod_to_name.find(found->first);
+                if (name_found != mod_to_name.end())
+                    *item_name_out = name_found->second;
             }
-        }
-        return price;
-    }
-
-    float GetPriceById(const char* id)
-    {
-        const auto prices = PriceCheckerModule::FetchPrices();
-        const auto found = prices.find(id);
-        if (found != prices.end()) {
-            return static_cast<float>(found->second);
+            return static_cast<float>(index->Find(model_id, found->first));
         }
         return .0f;
     }
@@ -605,13 +553,22 @@ void PriceCheckerModule::DrawSettingsInternal()
     ImGui::SliderFloat("Price Checker high price threshold", &high_price_threshold, 100, 50000);
 }
 
-const std::unordered_map<std::string,uint32_t>& PriceCheckerModule::FetchPrices() {
-    if (TIMER_DIFF(last_request_time) > request_interval) {
-        last_request_time = TIMER_INIT();
-        Resources::Download(trader_quotes_url, [](bool success, const std::string& response, void*) {
-            if (success)
-                ParsePriceJson(response);
-            });
-    }
-    return prices_by_identifier;
+void PriceCheckerModule::FetchPrices() {
+    if (TIMER_DIFF(last_request_time) <= request_interval)
+        return;
+    last_request_time = TIMER_INIT();
+    Resources::EnqueueWorkerTask([] {
+        std::string response;
+        if (!Resources::Download(trader_quotes_url, response))
+            return;
+        if (auto index = PriceIndex::Parse(response))
+            price_index.store(std::move(index));
+    });
+}
+
+uint32_t PriceCheckerModule::GetPrice(const uint32_t model_id, const uint32_t mod)
+{
+    FetchPrices();
+    const auto index = price_index.load();
+    return index ? index->Find(model_id, mod) : 0;
 }
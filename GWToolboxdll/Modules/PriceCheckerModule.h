@@ -24,6 +24,9 @@ public:
     void DrawSettingsInternal() override;
     void SaveSettings(ToolboxIni* ini) override;
 
-    // Returns a list of prices by identifier. Materials have identifiers are "model_id", but runes and mods are "model_id-mod_struct"
-    static const std::unordered_map<std::string,uint32_t>& FetchPrices();
+    // Re-downloads the trader quotes in the background if they're stale
+    static void FetchPrices();
+    // Sell price in gold, or 0 if unknown. Materials are looked up by model_id alone; runes and mods by model_id and one
+    // word of their mod struct.
+    static uint32_t GetPrice(uint32_t model_id, uint32_t mod = 0);
 };
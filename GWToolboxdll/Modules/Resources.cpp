@@ -33,6 +33,7 @@
 
 #include <Modules/GwDatTextureModule.h>
 #include <Constants/EncStrings.h>
+#include <Utils/DecodedStringCache.h>
 #include <Utils/TextUtils.h>
 
 namespace {
@@ -375,6 +376,7 @@ void Resources::Initialize()
     for (size_t i = 0; i < MAX_WORKERS; i++) {
         workers.push_back(new WorkerThread());
     }
+    DecodedStringCache::Initialize(GetPath("cache"));
     RegisterUIMessageCallback(&OnUIMessage_Hook, GW::UI::UIMessage::kPreferenceEnumChanged, OnUIMessage, 0x8000);
 }
 
@@ -403,6 +405,7 @@ void Resources::Cleanup()
     }
     encoded_string_ids.clear();
     map_names.clear(); // NB: Map names are pointers to encoded_string_ids
+    DecodedStringCache::Terminate();
 }
 
 void Resources::Terminate()
@@ -0,0 +1,68 @@
+#include "stdafx.h"
+
+#include "AliasIndex.h"
+
+uint32_t AliasIndex::Hash(const wchar_t* str, const size_t len, const bool lower)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ static_cast<uint32_t>(lower ? towlower(str[i]) : str[i])) * 16777619u;
+    }
+    return hash;
+}
+
+void AliasIndex::Build(const std::span<const wchar_t* const> names)
+{
+    by_name.clear();
+    text.clear();
+    for (uint32_t i = 0; i < names.size(); i++) {
+        if (names[i] && names[i][0])
+            by_name.push_back(i);
+    }
+    std::ranges::stable_sort(by_name, [names](const uint32_t a, const uint32_t b) {
+        return wcscmp(names[a], names[b]) < 0;
+    });
+    size_t size = 8;
+    while (size < by_name.size() * 2) {
+        size *= 2;
+    }
+    slots.assign(size, {});
+    for (uint32_t i = 0; i < by_name.size();) {
+        const auto name = names[by_name[i]];
+        auto end = i + 1;
+        while (end < by_name.size() && wcscmp(names[by_name[end]], name) == 0) {
+            end++;
+        }
+        const auto len = wcslen(name);
+        const auto hash = Hash(name, len, false);
+        auto slot = hash & (size - 1);
+        while (slots[slot].count) {
+            slot = (slot + 1) & (size - 1);
+        }
+        slots[slot] = {hash, static_cast<uint32_t>(text.size()), static_cast<uint32_t>(len), i, end - i};
+        text.append(name, len);
+        i = end;
+    }
+}
+
+std::span<const uint32_t> AliasIndex::Find(const wchar_t* message) const
+{
+    if (slots.empty() || !message)
+        return {};
+    const auto len = wcslen(message);
+    const auto hash = Hash(message, len, true);
+    const auto mask = slots.size() - 1;
+    for (auto slot = hash & mask; slots[slot].count; slot = (slot + 1) & mask) {
+        const auto& it = slots[slot];
+        if (it.hash != hash || it.name_length != len)
+            continue;
+        const auto name = text.data() + it.name_offset;
+        size_t i = 0;
+        while (i < len && name[i] == static_cast<wchar_t>(towlower(message[i]))) {
+            i++;
+        }
+        if (i == len)
+            return {by_name.data() + it.first, it.count};
+    }
+    return {};
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <span>
+
+// Chat command aliases grouped by name behind an open addressed table of the distinct names, so each sent command costs
+// one hash and one compare no matter how many aliases there are. Keeps its own copy of the names; rebuild it after
+// aliases are added, renamed, removed or reordered.
+class AliasIndex {
+public:
+    // names[i] is the name of alias i. Empty names are left out; aliases that share a name keep their order.
+    void Build(std::span<const wchar_t* const> names);
+
+    // Indices of the aliases named exactly message, ignoring the case of message; aliases only match if they're lower case
+    [[nodiscard]] std::span<const uint32_t> Find(const wchar_t* message) const;
+
+private:
+    struct Slot {
+        uint32_t hash = 0;
+        uint32_t name_offset = 0; // Into text
+        uint32_t name_length = 0;
+        uint32_t first = 0; // Range in by_name; count is 0 for an empty slot
+        uint32_t count = 0;
+    };
+
+    // FNV-1a, lower casing str as it's hashed if lower is set
+    static uint32_t Hash(const wchar_t* str, size_t len, bool lower);
+
+    std::vector<Slot> slots; // Power of two sized, at most half full
+    std::vector<uint32_t> by_name;
+    std::wstring text;
+};
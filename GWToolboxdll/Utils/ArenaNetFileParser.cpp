@@ -1,6 +1,9 @@
+#include "stdafx.h"
+
 #include "ArenaNetFileParser.h"
 #include <algorithm>
 #include <cstring>
+#include <ranges>
 #include <fstream>
 #include <vector>
 #include <Modules/GwDatTextureModule.h>
@@ -14,10 +17,10 @@ namespace {
     static constexpr uint32_t fvf_array_2[16] = {0x0, 0xC, 0x4, 0x10, 0xC, 0x18, 0x10, 0x1C, 0x4, 0x10, 0x8, 0x14, 0x10, 0x1C, 0x14, 0x20};
 
     // Helper functions
-    uint32_t getFVF(uint32_t dat_fvf) {
+    [[maybe_unused]] uint32_t getFVF(uint32_t dat_fvf) {
         return ((dat_fvf & 0xff0) << 4) | ((dat_fvf >> 8) & 0x30) | (dat_fvf & 0xf);
     }
-    uint32_t getVertexSizeFromFVF(uint32_t fvf) {
+    [[maybe_unused]] uint32_t getVertexSizeFromFVF(uint32_t fvf) {
         return fvf_array_0[(fvf >> 0xc) & 0xf] + fvf_array_0[(fvf >> 8) & 0xf] + fvf_array_1[(fvf >> 4) & 7] + fvf_array_2[fvf & 0xf];
     }
 } // namespace
@@ -37,48 +40,102 @@ namespace ArenaNetFileParser {
         return 0;
     }
 
-    char* GameAssetFile::fileType()
+    const char* GameAssetFile::fileType() const
     {
-        if (data_size < 4) return 0;
-        return (char*)data.data(); // Read file type from the first 4 bytes
+        if (bytes().size() < 4) return 0;
+        return reinterpret_cast<const char*>(data->data()); // Read file type from the first 4 bytes
     }
     bool GameAssetFile::parse(std::vector<uint8_t>& _data)
     {
-        data = std::move(_data);
-        data_size = data.size();
+        return parse(std::make_shared<const std::vector<uint8_t>>(std::move(_data)));
+    }
+    bool GameAssetFile::parse(GwDat::Blob blob)
+    {
+        data = std::move(blob);
         return isValid();
     }
     bool GameAssetFile::readFromDat(const uint32_t file_id)
     {
-        wchar_t fileHash[4] = {0};
-        FileIdToFileHash(file_id, fileHash);
-        return readFromDat(fileHash);
+        auto blob = GwDatTextureModule::ReadDatFile(file_id);
+        return blob && parse(std::move(blob));
     }
     bool GameAssetFile::readFromDat(const wchar_t* file_hash)
     {
+        // Plain file ids are read straight out of the dat; anything else goes through the game
+        const uint32_t file_id = FileHashToFileId(file_hash);
+        if (file_id && !file_hash[2]) return readFromDat(file_id);
         std::vector<uint8_t> bytes;
         if (!GwDatTextureModule::ReadDatFile(file_hash, &bytes)) return false;
         return parse(bytes);
     }
-    const uint8_t ArenaNetFile::getFFNAType() const
+    bool ArenaNetFile::parse(GwDat::Blob blob)
     {
-        return (uint8_t)data[4];
+        data = std::move(blob);
+        view = FfnaView(bytes());
+        return isValid();
     }
-    const bool ArenaNetFile::isValid() {
+    bool ArenaNetFile::isValid() const
+    {
         return GameAssetFile::isValid() && strncmp(fileType(), "ffna", 4) == 0;
     }
-    const Chunk* ArenaNetFile::FindChunk(ChunkType chunk_type)
+
+    FfnaView::FfnaView(const std::span<const uint8_t> _bytes)
+        : bytes(_bytes)
     {
-        ASSERT(isValid());
+        if (bytes.size() < 5 || memcmp(bytes.data(), "ffna", 4) != 0)
+            return;
         size_t offset = 5;
-        // Parse chunk headers and record their locations
-        while (offset < data_size) {
-            const auto chunk = (Chunk*)&data[offset];
-            if (chunk->chunk_id == chunk_type)
-                return chunk;
-            offset += chunk->chunk_size + 8;
+        valid = true;
+        // Anything shorter than a chunk header at the end is padding
+        while (offset + sizeof(Chunk) <= bytes.size()) {
+            uint32_t chunk_id, chunk_size;
+            memcpy(&chunk_id, &bytes[offset], sizeof(chunk_id));
+            memcpy(&chunk_size, &bytes[offset + 4], sizeof(chunk_size));
+            if (chunk_size > bytes.size() - offset - sizeof(Chunk)) {
+                valid = false;
+                break;
+            }
+            chunks.push_back({chunk_id, static_cast<uint32_t>(offset), chunk_size});
+            offset += sizeof(Chunk) + chunk_size;
+        }
+        // Ties on offset, so the first chunk of each id in the file comes first
+        std::ranges::sort(chunks, [](const IndexedChunk& a, const IndexedChunk& b) {
+            return a.chunk_id != b.chunk_id ? a.chunk_id < b.chunk_id : a.offset < b.offset;
+        });
+    }
+    const FfnaView::IndexedChunk* FfnaView::Find(ChunkType chunk_type) const
+    {
+        const auto found = std::ranges::lower_bound(chunks, static_cast<uint32_t>(chunk_type), {}, &IndexedChunk::chunk_id);
+        return found != chunks.end() && found->chunk_id == static_cast<uint32_t>(chunk_type) ? &*found : nullptr;
+    }
+    const Chunk* FfnaView::FindChunk(ChunkType chunk_type) const
+    {
+        const auto found = Find(chunk_type);
+        return found ? reinterpret_cast<const Chunk*>(&bytes[found->offset]) : nullptr;
+    }
+    std::span<const uint8_t> FfnaView::ChunkData(ChunkType chunk_type) const
+    {
+        const auto found = Find(chunk_type);
+        if (!found) return {};
+        return bytes.subspan(found->offset + sizeof(Chunk), found->size);
+    }
+    const GeometryChunk* FfnaView::Geometry() const
+    {
+        const auto data = ChunkData(GEOMETRY);
+        return data.size() >= sizeof(GeometryChunk) - sizeof(Chunk) ? reinterpret_cast<const GeometryChunk*>(data.data() - sizeof(Chunk)) : nullptr;
+    }
+    std::span<const FileName> FfnaView::FileNames(ChunkType chunk_type) const
+    {
+        const auto data = ChunkData(chunk_type);
+        if (chunk_type == SOUND_FILES_1) {
+            return {reinterpret_cast<const FileName*>(data.data()), data.size() / sizeof(FileName)};
         }
-        return nullptr;
+        constexpr size_t header_size = sizeof(FileNamesChunk) - sizeof(Chunk);
+        if (data.size() < header_size) return {};
+        uint32_t num_filenames;
+        memcpy(&num_filenames, data.data() + sizeof(uint32_t), sizeof(num_filenames)); // After unk
+        const size_t capacity = (data.size() - header_size) / sizeof(FileName);
+        return {reinterpret_cast<const FileName*>(data.data() + header_size), std::min<size_t>(num_filenames, capacity)};
     }
 }
 
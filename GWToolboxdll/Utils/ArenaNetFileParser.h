@@ -1,9 +1,12 @@
 #pragma once
 #include <cstdint>
 #include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
+#include <Utils/GwDat.h>
+
 // ArenaNet File Format (FFNA) Parser
 // Used in Guild Wars and Guild Wars 2 for 3D models, textures, and game assets
 namespace ArenaNetFileParser {
@@ -167,36 +170,79 @@ namespace ArenaNetFileParser {
 
     #pragma warning(pop)
     struct GameAssetFile {
-        std::vector<uint8_t> data; // Reference to the original data
-        size_t data_size;          // Size of the data
-        GameAssetFile() {
-            data.clear();
-            data_size = 0;
-        }
+        GwDat::Blob data; // Shared with the dat reader that produced it, never copied. Set through parse.
+
+        GameAssetFile() = default;
         GameAssetFile(std::vector<uint8_t>& _data) : GameAssetFile() { parse(_data); }
-        char* fileType();
+        virtual ~GameAssetFile() = default;
+
+        [[nodiscard]] std::span<const uint8_t> bytes() const { return data ? std::span<const uint8_t>(*data) : std::span<const uint8_t>(); }
+        const char* fileType() const;
 
-        virtual bool parse(std::vector<uint8_t>& _data);
+        // Takes over _data
+        bool parse(std::vector<uint8_t>& _data);
+        virtual bool parse(GwDat::Blob blob);
 
-        virtual const bool isValid() { return fileType() != 0; }
+        virtual bool isValid() const { return fileType() != 0; }
         bool readFromDat(const wchar_t* file_hash);
         bool readFromDat(const uint32_t file_id);
     };
 
+    // Non-owning view over an FFNA file, e.g. straight out of a GwDat blob. Chunks are indexed by id once on construction
+    // instead of walked on every lookup, and every accessor is bounds checked; the bytes have to outlive the view.
+    class FfnaView {
+    public:
+        FfnaView() = default;
+        explicit FfnaView(std::span<const uint8_t> bytes);
+
+        // "ffna" header, and every chunk fits in the buffer. Chunks before one that doesn't fit are still indexed, so
+        // lookups work on a truncated file as long as the chunk wanted comes first.
+        [[nodiscard]] bool isValid() const { return valid; }
+        [[nodiscard]] uint8_t getFFNAType() const { return bytes.size() > 4 ? bytes[4] : 0; }
+
+        [[nodiscard]] const Chunk* FindChunk(ChunkType chunk_type) const;
+        // Contents of the chunk after its 8 byte header; empty if there isn't one
+        [[nodiscard]] std::span<const uint8_t> ChunkData(ChunkType chunk_type) const;
+
+        // nullptr unless the chunk is big enough for its fixed header
+        [[nodiscard]] const GeometryChunk* Geometry() const;
+        // Embedded ATEX/DDS image of an ATEXFILE chunk
+        [[nodiscard]] std::span<const uint8_t> Atex() const { return ChunkData(ATEXFILE); }
+        // File references of a FILENAMES_* or SOUND_FILES_1 chunk (texture references are FILENAMES_FA5/FA6),
+        // clamped to what the chunk holds
+        [[nodiscard]] std::span<const FileName> FileNames(ChunkType chunk_type) const;
+
+    private:
+        struct IndexedChunk {
+            uint32_t chunk_id;
+            uint32_t offset; // Of the chunk header
+            uint32_t size;   // Of the data after it
+        };
+        [[nodiscard]] const IndexedChunk* Find(ChunkType chunk_type) const;
+
+        std::span<const uint8_t> bytes;
+        std::vector<IndexedChunk> chunks; // Sorted by chunk id, then by offset
+        bool valid = false;
+    };
+
     struct ArenaNetFile : GameAssetFile {
+        FfnaView view; // Over data, indexed once per parse
 
         // Copy parent constructors
         ArenaNetFile() : GameAssetFile() {}
         ArenaNetFile(std::vector<uint8_t>& _data) : ArenaNetFile() { parse(_data); }
 
-        const uint8_t getFFNAType() const;
+        using GameAssetFile::parse;
+        bool parse(GwDat::Blob blob) override;
+
+        uint8_t getFFNAType() const { return view.getFFNAType(); }
 
-        const bool isValid() override;
+        bool isValid() const override;
         // Get chunk by type
-        const Chunk* FindChunk(ChunkType chunk_type);
+        const Chunk* FindChunk(ChunkType chunk_type) const { return view.FindChunk(chunk_type); }
     };
 
     struct ATexFile : GameAssetFile {
-        const bool isValid() override { return GameAssetFile::isValid() && strncmp(fileType(), "atex", 4) == 0; }
+        bool isValid() const override { return GameAssetFile::isValid() && strncmp(fileType(), "atex", 4) == 0; }
     };
 };
@@ -0,0 +1,690 @@
+#include "stdafx.h"
+
+#include <Utils/AtexDecoder.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ATEX_SSE2 1
+#endif
+
+namespace {
+    using AtexDecoder::Format;
+    using AtexDecoder::Image;
+
+    constexpr uint32_t FourCC(const char a, const char b, const char c, const char d)
+    {
+        return static_cast<uint32_t>(a) | static_cast<uint32_t>(b) << 8 | static_cast<uint32_t>(c) << 16 | static_cast<uint32_t>(d) << 24;
+    }
+
+    // The game's image formats the ATEX subformats unpack to, which decide the block layout and the packing passes
+    enum GrFormat : uint32_t {
+        GR_FORMAT_DXT1 = 0xF,
+        GR_FORMAT_DXT3 = 0x11,
+        GR_FORMAT_DXTL = 0x12,
+        GR_FORMAT_DXT5 = 0x13
+    };
+
+    constexpr size_t HEADER_SIZE = 12;
+
+    bool SubformatToGrFormat(const uint32_t subformat, GrFormat& out)
+    {
+        switch (subformat) {
+            case '1':
+                out = GR_FORMAT_DXT1;
+                return true;
+            case '2':
+            case '3':
+            case 'N':
+                out = GR_FORMAT_DXT3;
+                return true;
+            case '4':
+            case '5':
+                out = GR_FORMAT_DXT5;
+                return true;
+            case 'L':
+                out = GR_FORMAT_DXTL;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    uint32_t LoadU32(const uint8_t* p)
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    void StoreU32(uint8_t* p, const uint32_t v)
+    {
+        memcpy(p, &v, sizeof(v));
+    }
+
+    bool IsSet(const std::vector<uint32_t>& bits, const size_t i)
+    {
+        return (bits[i >> 5] & 1u << (i & 31)) != 0;
+    }
+
+    void Set(std::vector<uint32_t>& bits, const size_t i)
+    {
+        bits[i >> 5] |= 1u << (i & 31);
+    }
+
+    // 256x256 DXT3 textures only store the blocks away from the edges and the middle seams; the others are mirrored
+    bool IsMirroredBlock(const uint32_t x, const uint32_t y)
+    {
+        constexpr uint32_t mirrored = 0xC0000003; // 0, 1, 30 and 31 of every 32
+        return (1u << (x & 31) & mirrored) || (1u << (y & 31) & mirrored);
+    }
+
+    // MSB-first reader over the little endian words of the packed stream
+    class BitReader {
+    public:
+        BitReader(const uint8_t* begin, const uint8_t* end)
+            : pos(begin),
+              end(end)
+        {
+            if (pos + 4 <= end) {
+                window = LoadU32(pos);
+                pos += 4;
+            }
+        }
+
+        [[nodiscard]] const uint8_t* Position() const { return pos; }
+
+        uint32_t Read(const uint32_t n)
+        {
+            const uint32_t value = window >> (32 - n);
+            Drop(n);
+            return value;
+        }
+
+        // Length of the next run of blocks: 1 -> 1, 01 -> 18, 00xxxx -> 17 - xxxx
+        uint32_t ReadRun()
+        {
+            const uint32_t top = window >> 26;
+            if (top & 0x20) {
+                Drop(1);
+                return 1;
+            }
+            if (top & 0x10) {
+                Drop(2);
+                return 18;
+            }
+            Drop(6);
+            return 17 - top;
+        }
+
+    private:
+        void Drop(const uint32_t n)
+        {
+            window = window << n | buffer >> (32 - n);
+            if (n <= available) {
+                buffer <<= n;
+                available -= n;
+            }
+            else if (pos + 4 <= end) {
+                const uint32_t next = LoadU32(pos);
+                pos += 4;
+                const uint32_t had = available;
+                available = available + 32 - n;
+                window |= next >> available;
+                buffer = next << (n - had);
+            }
+            else {
+                buffer = 0;
+            }
+        }
+
+        const uint8_t* pos;
+        const uint8_t* end;
+        uint32_t window = 0;
+        uint32_t buffer = 0;
+        uint32_t available = 0;
+    };
+
+    // Walks runs of blocks, skipping those flagged in skip: a run of n covers the next n unflagged blocks,
+    // and read_mode picks what to do with all of them (0 leaves them for the raw data).
+    template <typename ReadMode, typename Fill>
+    void DecodeRuns(BitReader& bits, const std::vector<uint32_t>& skip, const size_t block_count, ReadMode read_mode, Fill fill)
+    {
+        size_t i = 0;
+        while (i < block_count) {
+            uint32_t count = bits.ReadRun();
+            const uint32_t mode = read_mode();
+            for (; count && i < block_count; i++) {
+                if (!IsSet(skip, i)) {
+                    if (mode) {
+                        fill(i, mode);
+                    }
+                    count--;
+                }
+            }
+            while (i < block_count && IsSet(skip, i)) {
+                i++;
+            }
+        }
+    }
+
+    // DXT1 colour block closest to a flat colour, as the game builds it for packed runs of one colour
+    void SolidColorBlock(const uint32_t color, const bool dxt1, uint32_t out[2])
+    {
+        const uint32_t c[3] = {color & 0xFF, color >> 8 & 0xFF, color >> 16 & 0xFF}; // b, g, r
+        const uint32_t q[3] = {(c[0] - (c[0] >> 5)) >> 3, (c[1] - (c[1] >> 6)) >> 2, (c[2] - (c[2] >> 5)) >> 3};
+        const auto expand5 = [](const uint32_t v) {
+            return v * 8 + (v >> 2);
+        };
+        const auto expand6 = [](const uint32_t v) {
+            return v * 4 + (v >> 4);
+        };
+        const uint32_t lo[3] = {expand5(q[0]), expand6(q[1]), expand5(q[2])};
+        const uint32_t hi[3] = {expand5(q[0] + 1), expand6(q[1] + 1), expand5(q[2] + 1)};
+
+        // Where each channel sits between its two nearest representable values, in twelfths
+        uint32_t t[3];
+        uint32_t pair[3][2];
+        for (size_t k = 0; k < 3; k++) {
+            t[k] = (c[k] * 12 - lo[k] * 12) / (hi[k] - lo[k]);
+            if (t[k] < 2) {
+                pair[k][0] = pair[k][1] = q[k];
+            }
+            else if (t[k] < 6) {
+                pair[k][0] = q[k];
+                pair[k][1] = q[k] + 1;
+            }
+            else if (t[k] < 10) {
+                pair[k][0] = q[k] + 1;
+                pair[k][1] = q[k];
+            }
+            else {
+                pair[k][0] = pair[k][1] = q[k] + 1;
+            }
+        }
+        uint32_t color0 = (pair[2][0] << 6 | pair[1][0]) << 5 | pair[0][0];
+        uint32_t color1 = (pair[2][1] << 6 | pair[1][1]) << 5 | pair[0][1];
+
+        uint32_t weight = 0;
+        uint32_t differing = 0;
+        for (size_t k = 0; k < 3; k++) {
+            if (pair[k][0] != pair[k][1]) {
+                weight += pair[k][0] == q[k] ? t[k] : 12 - t[k];
+                differing++;
+            }
+        }
+        if (differing) {
+            weight = (weight + differing / 2) / differing;
+        }
+
+        const bool three_color = dxt1 && (weight == 5 || weight == 6 || !differing);
+        if (!differing && !three_color) {
+            if (color1 == 0xFFFF) {
+                weight = 12;
+                color0--;
+            }
+            else {
+                weight = 0;
+                color1++;
+            }
+        }
+        if (three_color != (color1 >= color0)) {
+            std::swap(color0, color1);
+            weight = 12 - weight;
+        }
+
+        uint32_t index;
+        if (three_color) {
+            index = 2;
+        }
+        else if (weight < 2) {
+            index = 0;
+        }
+        else if (weight < 6) {
+            index = 2;
+        }
+        else {
+            index = weight < 10 ? 3 : 1;
+        }
+        out[0] = color1 << 16 | color0;
+        out[1] = index * 0x55555555;
+    }
+
+    // Mirrors the 4x4 DXT3 block at (src_x, src_y) into (x, y); see IsMirroredBlock
+    void MirrorBlock(uint8_t* blocks, const uint32_t x, const uint32_t y)
+    {
+        constexpr uint32_t mirrored = 0xC0000003;
+        const bool flip_x = (1u << (x & 31) & mirrored) != 0;
+        const bool flip_y = (1u << (y & 31) & mirrored) != 0;
+        const uint32_t src_x = flip_x ? x ^ 3 : x;
+        const uint32_t src_y = flip_y ? y ^ 3 : y;
+        const uint8_t* src = blocks + (src_y * 64 + src_x) * 16;
+        uint32_t alpha0 = LoadU32(src);
+        uint32_t alpha1 = LoadU32(src + 4);
+        const uint32_t colors = LoadU32(src + 8);
+        uint32_t indices = LoadU32(src + 12);
+
+        if (flip_x) {
+            // Reverse the 4 bit alphas within each 16 bit row, and the 2 bit indices within each byte
+            const auto reverse_nibbles = [](const uint32_t v) {
+                const uint32_t low = ((v >> 8 & 0x00F000F0) | (v & 0x0F000F00)) >> 4;
+                const uint32_t high = ((v & 0xFFFF000F) << 8 | (v & 0x00F000F0)) << 4;
+                return low | high;
+            };
+            // As the game does it: the second word is the first one reversed again, which leaves the source's first word
+            // unchanged, and the source's second word is never used. Kept so the output matches the game's.
+            alpha0 = reverse_nibbles(alpha0);
+            alpha1 = reverse_nibbles(alpha0);
+            indices = ((indices & 0x03030303) << 4 | (indices & 0x0C0C0C0C)) << 2
+                      | ((indices >> 4 & 0x0C0C0C0C) | (indices & 0x30303030)) >> 2;
+        }
+        if (flip_y) {
+            // Reverse the row order
+            const uint32_t old_alpha0 = alpha0;
+            alpha0 = alpha1 >> 16 | alpha1 << 16;
+            alpha1 = old_alpha0 >> 16 | old_alpha0 << 16;
+            indices = ((indices & 0x00FF0000) | indices >> 16) >> 8 | (indices << 16 | (indices & 0x0000FF00)) << 8;
+        }
+
+        uint8_t* dst = blocks + (y * 64 + x) * 16;
+        StoreU32(dst, alpha0);
+        StoreU32(dst + 4, alpha1);
+        StoreU32(dst + 8, colors);
+        StoreU32(dst + 12, indices);
+    }
+
+    // Undoes the packing: block flags and runs from the bit stream, then raw alpha, colour and index words
+    // for every block the runs didn't fill. Output has the D3D layout of the DXT format.
+    bool Unpack(const uint8_t* bytes, const size_t size, const GrFormat format, const uint32_t width, const uint32_t height, std::vector<uint8_t>& blocks)
+    {
+        const bool has_alpha = format != GR_FORMAT_DXT1;
+        const size_t block_words = has_alpha ? 4 : 2;
+        const size_t color_offset = has_alpha ? 8 : 0;
+        const size_t block_count = static_cast<size_t>(width) * height / 16;
+        if (!block_count || size < HEADER_SIZE + 8) {
+            return false;
+        }
+
+        const uint32_t data_size = LoadU32(bytes + HEADER_SIZE);
+        const uint32_t compression = LoadU32(bytes + HEADER_SIZE + 4);
+        if (data_size <= 8 || data_size > size - HEADER_SIZE) {
+            return false;
+        }
+        const uint8_t* data = bytes + HEADER_SIZE + 8;
+        const uint8_t* end = bytes + size;
+
+        blocks.assign(block_count * block_words * 4, 0);
+        std::vector<uint32_t> alpha_done((block_count + 31) / 32, 0);
+        std::vector<uint32_t> color_done((block_count + 31) / 32, 0);
+        const auto block = [&](const size_t i) {
+            return blocks.data() + i * block_words * 4;
+        };
+        const bool mirrored = (compression & 0x10) && width == 256 && height == 256 && format == GR_FORMAT_DXT3;
+
+        const uint8_t* raw = data;
+        if (compression) {
+            BitReader bits(data, data + ((data_size - 8) & ~3u));
+            const auto read_flag = [&bits] {
+                return bits.Read(1);
+            };
+            const auto read_mode = [&bits] {
+                return bits.Read(1) ? 1 + bits.Read(1) : 0;
+            };
+
+            if (mirrored) {
+                for (size_t i = 0; i < block_count; i++) {
+                    if (IsMirroredBlock(static_cast<uint32_t>(i), static_cast<uint32_t>(i >> 6))) {
+                        Set(alpha_done, i);
+                        Set(color_done, i);
+                    }
+                }
+            }
+            if ((compression & 1) && !has_alpha) {
+                // Runs of fully transparent blocks
+                DecodeRuns(bits, color_done, block_count, read_flag, [&](const size_t i, uint32_t) {
+                    StoreU32(block(i), 0xFFFFFFFE);
+                    StoreU32(block(i) + 4, 0xFFFFFFFF);
+                    Set(color_done, i);
+                    Set(alpha_done, i);
+                });
+            }
+            if ((compression & 2) && format == GR_FORMAT_DXT3) {
+                // Runs of transparent or constant 4 bit alpha
+                const uint32_t alpha = bits.Read(4) * 0x11111111;
+                DecodeRuns(bits, color_done, block_count, read_mode, [&](const size_t i, const uint32_t mode) {
+                    const uint32_t value = mode == 1 ? 0 : alpha;
+                    StoreU32(block(i), value);
+                    StoreU32(block(i) + 4, value);
+                    Set(alpha_done, i);
+                });
+            }
+            if ((compression & 4) && format >= GR_FORMAT_DXTL) {
+                // Runs of transparent or constant 8 bit alpha
+                const uint32_t alpha = bits.Read(8);
+                DecodeRuns(bits, color_done, block_count, read_mode, [&](const size_t i, const uint32_t mode) {
+                    StoreU32(block(i), mode == 1 ? 0 : alpha << 8 | alpha);
+                    StoreU32(block(i) + 4, 0);
+                    Set(alpha_done, i);
+                });
+            }
+            if (compression & 8) {
+                // Runs of one flat colour
+                uint32_t solid[2];
+                SolidColorBlock(bits.Read(24) | 0xFF000000, format == GR_FORMAT_DXT1, solid);
+                DecodeRuns(bits, color_done, block_count, read_flag, [&](const size_t i, uint32_t) {
+                    StoreU32(block(i) + color_offset, solid[0]);
+                    StoreU32(block(i) + color_offset + 4, solid[1]);
+                    Set(color_done, i);
+                });
+            }
+            // The reader always holds the word it's in the middle of; raw data starts there
+            raw = bits.Position() - 4;
+        }
+
+        const auto take = [&raw, end](uint8_t* dst, const size_t n) {
+            if (raw < end && static_cast<size_t>(end - raw) >= n) {
+                memcpy(dst, raw, n);
+                raw += n;
+                return true;
+            }
+            return false;
+        };
+        if (has_alpha) {
+            for (size_t i = 0; i < block_count; i++) {
+                if (!IsSet(alpha_done, i) && !take(block(i), 8)) {
+                    return false;
+                }
+            }
+        }
+        for (size_t i = 0; i < block_count; i++) {
+            if (!IsSet(color_done, i) && !take(block(i) + color_offset, 4)) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < block_count; i++) {
+            if (!IsSet(color_done, i) && !take(block(i) + color_offset + 4, 4)) {
+                return false;
+            }
+        }
+
+        if (mirrored) {
+            for (uint32_t i = 0; i < block_count; i++) {
+                if (IsMirroredBlock(i & 63, i >> 6)) {
+                    MirrorBlock(blocks.data(), i & 63, i >> 6);
+                }
+            }
+        }
+        return true;
+    }
+
+    // 0xAARRGGBB from a 565 colour
+    uint32_t Expand565(const uint32_t c)
+    {
+        const uint32_t r = c >> 11 & 0x1F;
+        const uint32_t g = c >> 5 & 0x3F;
+        const uint32_t b = c & 0x1F;
+        return 0xFF000000 | (r << 3 | r >> 2) << 16 | (g << 2 | g >> 4) << 8 | (b << 3 | b >> 2);
+    }
+
+    uint32_t Mix(const uint32_t a, const uint32_t b, const uint32_t wa, const uint32_t wb, const uint32_t div)
+    {
+        uint32_t out = 0xFF000000;
+        for (uint32_t shift = 0; shift < 24; shift += 8) {
+            out |= ((a >> shift & 0xFF) * wa + (b >> shift & 0xFF) * wb) / div << shift;
+        }
+        return out;
+    }
+
+    // The 4 colours a DXT colour block indexes into
+    void ColorPaletteScalar(const uint8_t* color_block, const bool dxt1, uint32_t palette[4])
+    {
+        const uint32_t c0 = color_block[0] | color_block[1] << 8;
+        const uint32_t c1 = color_block[2] | color_block[3] << 8;
+        palette[0] = Expand565(c0);
+        palette[1] = Expand565(c1);
+        if (c0 > c1 || !dxt1) {
+            palette[2] = Mix(palette[0], palette[1], 2, 1, 3);
+            palette[3] = Mix(palette[0], palette[1], 1, 2, 3);
+        }
+        else {
+            palette[2] = Mix(palette[0], palette[1], 1, 1, 2);
+            palette[3] = 0;
+        }
+    }
+
+    void AlphaPalette5(const uint8_t* alpha_block, uint32_t palette[8])
+    {
+        const uint32_t a0 = alpha_block[0];
+        const uint32_t a1 = alpha_block[1];
+        palette[0] = a0;
+        palette[1] = a1;
+        if (a0 > a1) {
+            for (uint32_t i = 1; i < 7; i++) {
+                palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+            }
+        }
+        else {
+            for (uint32_t i = 1; i < 5; i++) {
+                palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    // 16 alphas in the top byte of each pixel, in row order
+    void BlockAlphas(const Format format, const uint8_t* block, uint32_t alphas[16])
+    {
+        if (format == Format::DXT3) {
+            for (size_t i = 0; i < 16; i++) {
+                alphas[i] = (block[i / 2] >> (i & 1) * 4 & 0xF) * 0x11 << 24;
+            }
+        }
+        else {
+            uint32_t palette[8];
+            AlphaPalette5(block, palette);
+            uint64_t indices = 0;
+            memcpy(&indices, block + 2, 6);
+            for (size_t i = 0; i < 16; i++) {
+                alphas[i] = palette[indices >> i * 3 & 7] << 24;
+            }
+        }
+    }
+
+#ifdef ATEX_SSE2
+    // Same as BlockAlphas for DXT3: the 16 nibbles spread into bytes in pixel order, widened to n * 0x11 << 24
+    void BlockAlphasDxt3Sse2(const uint8_t* block, uint32_t alphas[16])
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i nibble = _mm_set1_epi8(0x0F);
+        const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(block));
+        const __m128i low = _mm_and_si128(bytes, nibble);
+        const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble);
+        __m128i spread = _mm_unpacklo_epi8(low, high);
+        spread = _mm_or_si128(spread, _mm_slli_epi16(spread, 4));
+        const __m128i words_low = _mm_unpacklo_epi8(zero, spread);
+        const __m128i words_high = _mm_unpackhi_epi8(zero, spread);
+        const auto out = reinterpret_cast<__m128i*>(alphas);
+        _mm_storeu_si128(out, _mm_unpacklo_epi16(zero, words_low));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(zero, words_low));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(zero, words_high));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(zero, words_high));
+    }
+
+    // Same as ColorPaletteScalar, with the four channels of both blends computed side by side. (2a + b) / 3 is exact as a
+    // 16 bit multiply-high by 0x5556 for the sums that can occur.
+    void ColorPaletteSse2(const uint8_t* color_block, const bool dxt1, uint32_t palette[4])
+    {
+        const uint32_t c0 = color_block[0] | color_block[1] << 8;
+        const uint32_t c1 = color_block[2] | color_block[3] << 8;
+        palette[0] = Expand565(c0);
+        palette[1] = Expand565(c1);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i p0 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(palette[0])), zero);
+        const __m128i p1 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(palette[1])), zero);
+        __m128i mixed;
+        if (c0 > c1 || !dxt1) {
+            // Low 4 lanes 2 * p0 + p1, high 4 lanes p0 + 2 * p1
+            const __m128i a = _mm_unpacklo_epi64(_mm_add_epi16(_mm_add_epi16(p0, p0), p1), _mm_add_epi16(_mm_add_epi16(p1, p1), p0));
+            mixed = _mm_mulhi_epu16(a, _mm_set1_epi16(0x5556));
+        }
+        else {
+            mixed = _mm_srli_epi16(_mm_add_epi16(p0, p1), 1);
+        }
+        const __m128i packed = _mm_packus_epi16(mixed, zero);
+        palette[2] = static_cast<uint32_t>(_mm_cvtsi128_si32(packed)) | 0xFF000000;
+        palette[3] = c0 > c1 || !dxt1 ? static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(packed, 4))) | 0xFF000000 : 0;
+    }
+#endif
+
+    template <bool Simd>
+    void DecompressBlock(const Format format, const uint8_t* block, uint32_t* out, const uint32_t pitch)
+    {
+        const bool has_alpha = format != Format::DXT1;
+        const uint8_t* color_block = block + (has_alpha ? 8 : 0);
+        uint32_t palette[4];
+#ifdef ATEX_SSE2
+        if constexpr (Simd) {
+            ColorPaletteSse2(color_block, !has_alpha, palette);
+        }
+        else
+#endif
+        {
+            ColorPaletteScalar(color_block, !has_alpha, palette);
+        }
+        uint32_t alphas[16];
+#ifdef ATEX_SSE2
+        if (Simd && format == Format::DXT3) {
+            BlockAlphasDxt3Sse2(block, alphas);
+        }
+        else
+#endif
+        if (has_alpha) {
+            BlockAlphas(format, block, alphas);
+        }
+        const uint32_t indices = LoadU32(color_block + 4);
+
+        for (uint32_t y = 0; y < 4; y++) {
+            uint32_t row[4];
+            for (uint32_t x = 0; x < 4; x++) {
+                row[x] = palette[indices >> (y * 4 + x) * 2 & 3];
+            }
+#ifdef ATEX_SSE2
+            if constexpr (Simd) {
+                __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+                if (has_alpha) {
+                    const __m128i alpha = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alphas + y * 4));
+                    pixels = _mm_or_si128(_mm_and_si128(pixels, _mm_set1_epi32(0x00FFFFFF)), alpha);
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + y * pitch), pixels);
+                continue;
+            }
+#endif
+            for (uint32_t x = 0; x < 4; x++) {
+                out[y * pitch + x] = has_alpha ? (row[x] & 0x00FFFFFF) | alphas[y * 4 + x] : row[x];
+            }
+        }
+    }
+
+    template <bool Simd>
+    void DecompressAll(const Format format, const uint8_t* blocks, const uint32_t width, const uint32_t height, uint32_t* pixels)
+    {
+        const size_t block_size = format == Format::DXT1 ? 8 : 16;
+        for (uint32_t y = 0; y < height; y += 4) {
+            for (uint32_t x = 0; x < width; x += 4) {
+                DecompressBlock<Simd>(format, blocks, pixels + static_cast<size_t>(y) * width + x, width);
+                blocks += block_size;
+            }
+        }
+    }
+
+    void Premultiply(uint32_t* pixels, const size_t count)
+    {
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t a = pixels[i] >> 24;
+            uint32_t out = pixels[i] & 0xFF000000;
+            for (uint32_t shift = 0; shift < 24; shift += 8) {
+                out |= (pixels[i] >> shift & 0xFF) * a / 255 << shift;
+            }
+            pixels[i] = out;
+        }
+    }
+}
+
+namespace AtexDecoder {
+    uint32_t Image::Pitch() const
+    {
+        switch (format) {
+            case Format::DXT1:
+                return (width + 3) / 4 * 8;
+            case Format::DXT3:
+            case Format::DXT5:
+                return (width + 3) / 4 * 16;
+            default:
+                return width * 4;
+        }
+    }
+
+    uint32_t Image::Rows() const
+    {
+        return format == Format::A8R8G8B8 ? height : (height + 3) / 4;
+    }
+
+    bool CanDecode(const uint8_t* bytes, const size_t size)
+    {
+        if (size < HEADER_SIZE + 8) {
+            return false;
+        }
+        const uint32_t magic = LoadU32(bytes);
+        const uint32_t type = LoadU32(bytes + 4);
+        GrFormat format = GR_FORMAT_DXT1;
+        return (magic == FourCC('A', 'T', 'E', 'X') || magic == FourCC('A', 'T', 'T', 'X'))
+               && (type & 0xFFFFFF) == FourCC('D', 'X', 'T', 0)
+               && SubformatToGrFormat(type >> 24, format);
+    }
+
+    bool Decode(const uint8_t* bytes, const size_t size, Image& out, const bool keep_compressed)
+    {
+        if (!CanDecode(bytes, size)) {
+            return false;
+        }
+        GrFormat format = GR_FORMAT_DXT1;
+        SubformatToGrFormat(LoadU32(bytes + 4) >> 24, format);
+        const uint32_t width = bytes[8] | bytes[9] << 8;
+        const uint32_t height = bytes[10] | bytes[11] << 8;
+        if (!width || !height || width % 4 || height % 4) {
+            return false;
+        }
+
+        std::vector<uint8_t> blocks;
+        if (!Unpack(bytes, size, format, width, height, blocks)) {
+            return false;
+        }
+
+        const Format block_format = format == GR_FORMAT_DXT1 ? Format::DXT1 : format == GR_FORMAT_DXT3 ? Format::DXT3 : Format::DXT5;
+        out.width = width;
+        out.height = height;
+        if (keep_compressed && format != GR_FORMAT_DXTL) {
+            out.format = block_format;
+            out.data = std::move(blocks);
+            return true;
+        }
+        out.format = Format::A8R8G8B8;
+        out.data.resize(static_cast<size_t>(width) * height * 4);
+        const auto pixels = reinterpret_cast<uint32_t*>(out.data.data());
+        DecompressBlocks(block_format, blocks.data(), width, height, pixels);
+        if (format == GR_FORMAT_DXTL) {
+            Premultiply(pixels, static_cast<size_t>(width) * height);
+        }
+        return true;
+    }
+
+    void DecompressBlocks(const Format format, const uint8_t* blocks, const uint32_t width, const uint32_t height, uint32_t* pixels)
+    {
+        DecompressAll<true>(format, blocks, width, height, pixels);
+    }
+
+    void DecompressBlocksScalar(const Format format, const uint8_t* blocks, const uint32_t width, const uint32_t height, uint32_t* pixels)
+    {
+        DecompressAll<false>(format, blocks, width, height, pixels);
+    }
+}
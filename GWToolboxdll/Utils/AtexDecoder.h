@@ -0,0 +1,36 @@
+#pragma once
+
+// Decoder for ATEX/ATTX textures (DXT1/2/3/4/5/L/N plus the ANet run-length packing on top of the DXT blocks),
+// ported from the game's decompressor. Doesn't touch game memory or D3D, so it can run on any thread.
+namespace AtexDecoder {
+    enum class Format : uint8_t {
+        A8R8G8B8, // 0xAARRGGBB per pixel, rows packed
+        DXT1,     // D3DFMT_DXT1 blocks, block rows packed
+        DXT3,     // D3DFMT_DXT3 blocks
+        DXT5      // D3DFMT_DXT5 blocks
+    };
+
+    struct Image {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        Format format = Format::A8R8G8B8;
+        std::vector<uint8_t> data;
+
+        // Bytes per row of pixels, or per row of 4x4 blocks for DXT formats
+        [[nodiscard]] uint32_t Pitch() const;
+        // Number of rows of Pitch() bytes in data
+        [[nodiscard]] uint32_t Rows() const;
+    };
+
+    // True if bytes starts with an ATEX/ATTX header for a subformat Decode handles
+    bool CanDecode(const uint8_t* bytes, size_t size);
+
+    // Unpacks the image. With keep_compressed, DXT1/2/3/4/5/N images stay as DXT blocks that can be uploaded as is;
+    // DXTL is always expanded because its colour has to be premultiplied by alpha.
+    bool Decode(const uint8_t* bytes, size_t size, Image& out, bool keep_compressed = false);
+
+    // Expands DXT blocks to A8R8G8B8 pixels; width and height must be multiples of 4. Used by Decode.
+    void DecompressBlocks(Format format, const uint8_t* blocks, uint32_t width, uint32_t height, uint32_t* pixels);
+    // Same, one block at a time without SIMD; kept as the reference the vectorised path has to match.
+    void DecompressBlocksScalar(Format format, const uint8_t* blocks, uint32_t width, uint32_t height, uint32_t* pixels);
+}
@@ -0,0 +1,319 @@
+#include "stdafx.h"
+
+#include <GWCA/Constants/Constants.h>
+
+#include <GWCA/Managers/MemoryMgr.h>
+#include <GWCA/Managers/UIMgr.h>
+
+#include <Utils/DecodedStringCache.h>
+
+namespace {
+    constexpr uint32_t CACHE_MAGIC = 0x43534254; // "TBSC"
+    constexpr uint32_t CACHE_VERSION = 1;
+    // Encoded strings longer than this are almost always formatted messages with arguments
+    constexpr size_t MAX_ENCODED_LEN = 32;
+    // Stop recording new strings for a language once the table is this big
+    constexpr size_t MAX_ENTRIES = 0x40000;
+
+    struct CacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t gw_version;
+        uint32_t language;
+        uint32_t entry_count;
+        uint32_t blob_len; // in wchar_t
+    };
+
+    // Sorted by hash. Offsets and lengths are in wchar_t, relative to the start of the string blob.
+    struct CacheEntry {
+        uint64_t hash;
+        uint32_t encoded_offset;
+        uint32_t encoded_len;
+        uint32_t decoded_offset;
+        uint32_t decoded_len;
+    };
+
+    struct PendingEntry {
+        std::wstring encoded;
+        std::wstring decoded;
+    };
+
+    struct LanguageTable {
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+        const uint8_t* view = nullptr;
+        const CacheEntry* entries = nullptr;
+        const wchar_t* blob = nullptr;
+        uint32_t entry_count = 0;
+        uint32_t blob_len = 0;
+        std::unordered_map<uint64_t, PendingEntry> pending;
+
+        void Unmap()
+        {
+            if (view) {
+                UnmapViewOfFile(view);
+            }
+            if (mapping) {
+                CloseHandle(mapping);
+            }
+            if (file != INVALID_HANDLE_VALUE) {
+                CloseHandle(file);
+            }
+            file = INVALID_HANDLE_VALUE;
+            mapping = nullptr;
+            view = nullptr;
+            entries = nullptr;
+            blob = nullptr;
+            entry_count = blob_len = 0;
+        }
+
+        [[nodiscard]] std::wstring_view BlobString(const uint32_t offset, const uint32_t len) const
+        {
+            return {blob + offset, len};
+        }
+
+        [[nodiscard]] const CacheEntry* FindMapped(const uint64_t hash, const std::wstring_view encoded) const
+        {
+            const auto end = entries + entry_count;
+            for (auto it = std::lower_bound(entries, end, hash, [](const CacheEntry& e, const uint64_t h) { return e.hash < h; });
+                 it != end && it->hash == hash; ++it) {
+                if (BlobString(it->encoded_offset, it->encoded_len) == encoded) {
+                    return it;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    std::filesystem::path cache_folder;
+    std::unordered_map<GW::Constants::Language, LanguageTable> tables;
+    std::mutex cache_mutex;
+
+    uint64_t HashEncoded(const std::wstring_view encoded)
+    {
+        // FNV-1a
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (const auto c : encoded) {
+            hash ^= static_cast<uint16_t>(c);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    GW::Constants::Language ResolveLanguage(const GW::Constants::Language language)
+    {
+        return language == GW::Constants::Language::Unknown ? GW::UI::GetTextLanguage() : language;
+    }
+
+    std::filesystem::path TablePath(const GW::Constants::Language language)
+    {
+        return cache_folder / std::format(L"decoded_strings_{}.bin", static_cast<uint32_t>(language));
+    }
+
+    bool MapTable(LanguageTable& table, const GW::Constants::Language language)
+    {
+        const auto path = TablePath(language);
+        table.file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (table.file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(table.file, &file_size) || file_size.QuadPart < static_cast<LONGLONG>(sizeof(CacheHeader)) || file_size.HighPart) {
+            table.Unmap();
+            return false;
+        }
+        table.mapping = CreateFileMappingW(table.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!table.mapping) {
+            table.Unmap();
+            return false;
+        }
+        table.view = static_cast<const uint8_t*>(MapViewOfFile(table.mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!table.view) {
+            table.Unmap();
+            return false;
+        }
+        const auto header = reinterpret_cast<const CacheHeader*>(table.view);
+        const size_t expected_size = sizeof(CacheHeader)
+                                     + static_cast<size_t>(header->entry_count) * sizeof(CacheEntry)
+                                     + static_cast<size_t>(header->blob_len) * sizeof(wchar_t);
+        if (header->magic != CACHE_MAGIC
+            || header->version != CACHE_VERSION
+            || header->gw_version != GW::MemoryMgr::GetGWVersion()
+            || header->language != static_cast<uint32_t>(language)
+            || header->entry_count > MAX_ENTRIES
+            || expected_size != static_cast<size_t>(file_size.QuadPart)) {
+            // Stale (game was patched) or corrupt; will be overwritten on Terminate
+            table.Unmap();
+            return false;
+        }
+        table.entries = reinterpret_cast<const CacheEntry*>(table.view + sizeof(CacheHeader));
+        table.blob = reinterpret_cast<const wchar_t*>(table.entries + header->entry_count);
+        table.entry_count = header->entry_count;
+        table.blob_len = header->blob_len;
+        for (uint32_t i = 0; i < table.entry_count; i++) {
+            const auto& e = table.entries[i];
+            if (static_cast<size_t>(e.encoded_offset) + e.encoded_len > table.blob_len
+                || static_cast<size_t>(e.decoded_offset) + e.decoded_len > table.blob_len
+                || (i && table.entries[i - 1].hash > e.hash)) {
+                table.Unmap();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    LanguageTable& GetTable(const GW::Constants::Language language)
+    {
+        const auto found = tables.find(language);
+        if (found != tables.end()) {
+            return found->second;
+        }
+        auto& table = tables[language];
+        if (!cache_folder.empty()) {
+            MapTable(table, language);
+        }
+        return table;
+    }
+
+    bool SaveTable(LanguageTable& table, const GW::Constants::Language language)
+    {
+        if (table.pending.empty()) {
+            return true;
+        }
+        std::vector<CacheEntry> entries;
+        entries.reserve(table.entry_count + table.pending.size());
+        std::wstring blob;
+        // Intern strings so that ids that decode to the same text share storage
+        std::unordered_map<std::wstring, uint32_t> interned;
+        const auto intern = [&](const std::wstring_view str) -> uint32_t {
+            const auto [it, inserted] = interned.emplace(std::wstring(str), static_cast<uint32_t>(blob.size()));
+            if (inserted) {
+                blob.append(str);
+            }
+            return it->second;
+        };
+        const auto add_entry = [&](const uint64_t hash, const std::wstring_view encoded, const std::wstring_view decoded) {
+            entries.push_back({
+                hash,
+                intern(encoded), static_cast<uint32_t>(encoded.size()),
+                intern(decoded), static_cast<uint32_t>(decoded.size())
+            });
+        };
+        for (uint32_t i = 0; i < table.entry_count; i++) {
+            const auto& e = table.entries[i];
+            add_entry(e.hash, table.BlobString(e.encoded_offset, e.encoded_len), table.BlobString(e.decoded_offset, e.decoded_len));
+        }
+        for (const auto& [hash, entry] : table.pending) {
+            add_entry(hash, entry.encoded, entry.decoded);
+        }
+        std::ranges::stable_sort(entries, {}, &CacheEntry::hash);
+
+        const CacheHeader header = {
+            CACHE_MAGIC,
+            CACHE_VERSION,
+            GW::MemoryMgr::GetGWVersion(),
+            static_cast<uint32_t>(language),
+            static_cast<uint32_t>(entries.size()),
+            static_cast<uint32_t>(blob.size())
+        };
+
+        const auto path = TablePath(language);
+        // Per process, so two clients saving at once don't write into the same file
+        auto tmp_path = path;
+        tmp_path += std::format(L".{}.tmp", GetCurrentProcessId());
+        {
+            std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                return false;
+            }
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(CacheEntry));
+            out.write(reinterpret_cast<const char*>(blob.data()), blob.size() * sizeof(wchar_t));
+            if (!out.good()) {
+                return false;
+            }
+        }
+        // The view has to be released before the file can be replaced
+        table.Unmap();
+        table.pending.clear();
+        if (!MoveFileExW(tmp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+            // Another client still has the old table mapped; theirs or the next save will publish it instead
+            std::error_code ec;
+            std::filesystem::remove(tmp_path, ec);
+        }
+        return true;
+    }
+}
+
+namespace DecodedStringCache {
+    void Initialize(const std::filesystem::path& folder)
+    {
+        std::lock_guard lock(cache_mutex);
+        cache_folder = folder;
+    }
+
+    void Terminate()
+    {
+        std::lock_guard lock(cache_mutex);
+        std::error_code ec;
+        if (!cache_folder.empty() && (std::filesystem::exists(cache_folder, ec) || std::filesystem::create_directories(cache_folder, ec))) {
+            for (auto& [language, table] : tables) {
+                if (!SaveTable(table, language)) {
+                    Log::Warning("Failed to save decoded string cache for language %d", static_cast<uint32_t>(language));
+                }
+            }
+        }
+        for (auto& table : tables | std::views::values) {
+            table.Unmap();
+        }
+        tables.clear();
+        // Nothing is mapped again until the next Initialize
+        cache_folder.clear();
+    }
+
+    bool IsCacheable(const std::wstring_view encoded)
+    {
+        if (encoded.empty() || encoded.size() > MAX_ENCODED_LEN) {
+            return false;
+        }
+        // 0x107 starts a literal string argument e.g. a player name
+        return encoded.find(static_cast<wchar_t>(0x107)) == std::wstring_view::npos;
+    }
+
+    bool Find(GW::Constants::Language language, const std::wstring_view encoded, std::wstring& out)
+    {
+        if (!IsCacheable(encoded)) {
+            return false;
+        }
+        language = ResolveLanguage(language);
+        const auto hash = HashEncoded(encoded);
+        std::lock_guard lock(cache_mutex);
+        const auto& table = GetTable(language);
+        if (const auto found = table.FindMapped(hash, encoded)) {
+            out = table.BlobString(found->decoded_offset, found->decoded_len);
+            return true;
+        }
+        const auto pending = table.pending.find(hash);
+        if (pending != table.pending.end() && pending->second.encoded == encoded) {
+            out = pending->second.decoded;
+            return true;
+        }
+        return false;
+    }
+
+    void Store(GW::Constants::Language language, const std::wstring_view encoded, const std::wstring_view decoded)
+    {
+        if (decoded.empty() || !IsCacheable(encoded)) {
+            return;
+        }
+        language = ResolveLanguage(language);
+        const auto hash = HashEncoded(encoded);
+        std::lock_guard lock(cache_mutex);
+        auto& table = GetTable(language);
+        if (table.entry_count + table.pending.size() >= MAX_ENTRIES || table.FindMapped(hash, encoded)) {
+            return;
+        }
+        // On the rare hash collision, first one wins
+        table.pending.try_emplace(hash, std::wstring(encoded), std::wstring(decoded));
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+namespace GW::Constants {
+    enum class Language;
+}
+
+// Persistent, per-language table of encoded string -> decoded string.
+// Each language is stored in its own file which is memory mapped on first use; strings decoded during the session are
+// merged into the file on Terminate(). Files written by a different Gw.exe build are discarded.
+namespace DecodedStringCache {
+    // Set the folder where cache files are kept. Nothing is loaded until the first lookup for a language.
+    void Initialize(const std::filesystem::path& folder);
+    // Write any newly decoded strings to disk and unmap all tables.
+    void Terminate();
+
+    // Only short encoded strings without literal arguments (player names, chat text) are worth persisting.
+    bool IsCacheable(std::wstring_view encoded);
+
+    // Copies the decoded string into out and returns true if found. Language 0xff means current text language.
+    bool Find(GW::Constants::Language language, std::wstring_view encoded, std::wstring& out);
+    // Remember a decoded string for next time. Language 0xff means current text language.
+    void Store(GW::Constants::Language language, std::wstring_view encoded, std::wstring_view decoded);
+}
@@ -6,7 +6,6 @@
 
 #include "FontLoader.h"
 #include <Modules/Resources.h>
-#include <Utils/TextUtils.h>
 #include "toolbox_default_font.h"
 
 #include "fonts/fontawesome5.h"
@@ -39,6 +38,114 @@ namespace {
         std::wstring font_name;
     };
 
+    // Read-only view of a file on disk
+    struct MappedFile {
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+        const uint8_t* view = nullptr;
+        size_t size = 0;
+
+        MappedFile() = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile() { Unmap(); }
+
+        bool Map(const std::filesystem::path& path)
+        {
+            Unmap();
+            file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                return false;
+            }
+            LARGE_INTEGER file_size;
+            if (!GetFileSizeEx(file, &file_size) || !file_size.QuadPart || file_size.HighPart) {
+                Unmap();
+                return false;
+            }
+            mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            view = mapping ? static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+            if (!view) {
+                Unmap();
+                return false;
+            }
+            size = static_cast<size_t>(file_size.QuadPart);
+            return true;
+        }
+
+        void Unmap()
+        {
+            if (view) {
+                UnmapViewOfFile(view);
+            }
+            if (mapping) {
+                CloseHandle(mapping);
+            }
+            if (file != INVALID_HANDLE_VALUE) {
+                CloseHandle(file);
+            }
+            file = INVALID_HANDLE_VALUE;
+            mapping = nullptr;
+            view = nullptr;
+            size = 0;
+        }
+    };
+
+    // A font file on disk, mapped once and shared by the atlas builds for every size
+    struct FontSource {
+        const FontData* data = nullptr;
+        MappedFile ttf;
+        uint64_t hash = 0;
+    };
+
+    // Baked atlas for one font size, stored as font_cache/font_<size>.bin:
+    // CacheHeader, glyph_count CachedGlyph, then tex_width * tex_height bytes of alpha (the RGBA texture is white + alpha).
+    constexpr uint32_t CACHE_MAGIC = 0x46544254; // "TBTF"
+    constexpr uint32_t CACHE_VERSION = 1;
+
+    struct CacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        float font_size;
+        float ascent;
+        float descent;
+        uint32_t tex_width;
+        uint32_t tex_height;
+        float white_pixel_u;
+        float white_pixel_v;
+        uint32_t glyph_count;
+    };
+
+    struct CachedGlyph {
+        uint32_t codepoint;
+        float advance_x;
+        float x0, y0, x1, y1;
+        float u0, v0, u1, v1;
+    };
+
+    // FNV-1a, a word at a time
+    uint64_t Hash(const void* data, const size_t len, uint64_t hash = 0xcbf29ce484222325ull)
+    {
+        const auto bytes = static_cast<const uint8_t*>(data);
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, bytes + i, sizeof(word));
+            hash ^= word;
+            hash *= 0x100000001b3ull;
+        }
+        for (; i < len; i++) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    uint64_t Hash(const std::vector<ImWchar>& glyph_ranges, const uint64_t hash)
+    {
+        return Hash(glyph_ranges.data(), glyph_ranges.size() * sizeof(ImWchar), hash);
+    }
+
     const std::vector<ImWchar> fontawesome5_glyph_ranges = {ICON_MIN_FA, ICON_MAX_FA, 0};
 
     [[maybe_unused]] ImFontGlyphRangesBuilder GetGWGlyphRange()
@@ -306,54 +413,233 @@ namespace {
     }
 
 
-    ImFont* BuildFont(const float size, const bool default_only = false)
+    constexpr ImFontAtlasFlags AtlasFlags()
     {
-        const auto atlas = IM_NEW(ImFontAtlas);
-
         ImFontAtlasFlags flags = 0;
         flags |= ImFontAtlasFlags_NoPowerOfTwoHeight;
         flags |= ImFontAtlasFlags_NoMouseCursors;
         flags |= ImFontAtlasFlags_NoBakedLines;
+        return flags;
+    }
+
+    bool IncludesFontAwesome(const float size)
+    {
+        return size <= 20.f;
+    }
 
-        atlas->Flags = flags;
+    struct DecompressedTTF {
+        void* data = nullptr;
+        int size = 0;
+    };
 
-        static ImFontConfig cfg;
+    // ImGui's stb_decompress keeps its state in file statics, so compressed fonts can't be added from several threads at once.
+    // Decompress through a throwaway atlas and keep the buffer for the life of the process instead.
+    DecompressedTTF DecompressTTF(const void* compressed_data, const int compressed_size)
+    {
+        ImFontAtlas atlas;
+        ImFontConfig cfg;
+        cfg.SizePixels = 13.f;
+        if (!atlas.AddFontFromMemoryCompressedTTF(compressed_data, compressed_size, cfg.SizePixels, &cfg))
+            return {};
+        auto& added = atlas.ConfigData.back();
+        added.FontDataOwnedByAtlas = false; // Take ownership before the atlas is destroyed
+        return {added.FontData, added.FontDataSize};
+    }
+
+    const DecompressedTTF& DefaultFontTTF()
+    {
+        static const auto ttf = DecompressTTF(toolbox_default_font_compressed_data, toolbox_default_font_compressed_size);
+        return ttf;
+    }
+
+    const DecompressedTTF& FontAwesomeTTF()
+    {
+        static const auto ttf = DecompressTTF(fontawesome5_compressed_data, fontawesome5_compressed_size);
+        return ttf;
+    }
+
+    // Safe to call for different sizes in parallel once the TTFs it needs have been decompressed; sources are only read.
+    ImFont* BuildFont(const float size, const std::vector<FontSource>* sources = nullptr)
+    {
+        const auto atlas = IM_NEW(ImFontAtlas);
+        atlas->Flags = AtlasFlags();
+
+        ImFontConfig cfg;
         cfg.PixelSnapH = true;
         cfg.OversampleH = 1; // OversampleH = 2 for base text size (harder to read if OversampleH < 2)
         cfg.OversampleV = 1;
 
         // Always load the default font
         cfg.MergeMode = false;
+        cfg.FontDataOwnedByAtlas = false; // Decompressed once by DecompressTTF; the atlas mustn't free it
 
-        if (default_only) {
-            atlas->AddFontFromMemoryCompressedTTF(toolbox_default_font_compressed_data, toolbox_default_font_compressed_size, size, &cfg, toolbox_default_font_glyph_ranges);
+        if (!sources) {
+            const auto& ttf = DefaultFontTTF();
+            atlas->AddFontFromMemoryTTF(ttf.data, ttf.size, size, &cfg, toolbox_default_font_glyph_ranges);
         }
         else {
             // Load more fonts from disk, overriding glyph ranges from original
-            for (const auto& [glyph_ranges, font_name] : GetFontData()) {
-                size_t data_size;
-
-                ASSERT(!font_name.empty() && "Font name is empty, this shouldn't happen. Contact the developers.");
-                const auto font_name_str = TextUtils::WStringToString(font_name);
-                void* data = ImFileLoadToMemory(font_name_str.c_str(), "rb", &data_size, 0);
-
-                if (!data)
+            ImFontConfig file_cfg = cfg; // Mapped once in LoadFontsThread and shared between sizes
+            for (const auto& source : *sources) {
+                if (!source.ttf.view)
                     continue; // Failed to load data from disk
-                atlas->AddFontFromMemoryTTF(data, data_size, size, &cfg, glyph_ranges.data());
-                cfg.MergeMode = true;
+                atlas->AddFontFromMemoryTTF(const_cast<uint8_t*>(source.ttf.view), static_cast<int>(source.ttf.size), size, &file_cfg, source.data->glyph_ranges.data());
+                file_cfg.MergeMode = true;
             }
+            cfg.MergeMode = file_cfg.MergeMode;
         }
-        if (size <= 20.f) {
+        if (IncludesFontAwesome(size)) {
             cfg.MergeMode = true;
-            atlas->AddFontFromMemoryCompressedTTF(fontawesome5_compressed_data, fontawesome5_compressed_size, size, &cfg, fontawesome5_glyph_ranges.data());
+            const auto& ttf = FontAwesomeTTF();
+            atlas->AddFontFromMemoryTTF(ttf.data, ttf.size, size, &cfg, fontawesome5_glyph_ranges.data());
         }
         atlas->Build();
         unsigned char* unused = nullptr;
         // Preload the data for this font
         atlas->GetTexDataAsRGBA32(&unused, nullptr, nullptr, nullptr);
+        if (sources) {
+            // Drop the references to the mapped font files; the atlas is never rebuilt
+            atlas->ClearInputData();
+        }
         return atlas->Fonts.back();
     }
 
+    // Anything that changes the baked atlas for this size has to be part of the key
+    uint64_t CacheKey(const float size, const std::vector<FontSource>& sources)
+    {
+        const uint32_t versions[] = {CACHE_VERSION, IMGUI_VERSION_NUM, static_cast<uint32_t>(AtlasFlags())};
+        uint64_t key = Hash(versions, sizeof(versions));
+        key = Hash(&size, sizeof(size), key);
+        for (const auto& source : sources) {
+            if (!source.ttf.view)
+                continue;
+            key = Hash(&source.hash, sizeof(source.hash), key);
+            key = Hash(source.data->glyph_ranges, key);
+        }
+        if (IncludesFontAwesome(size)) {
+            key = Hash(fontawesome5_compressed_data, fontawesome5_compressed_size, key);
+            key = Hash(fontawesome5_glyph_ranges, key);
+        }
+        return key;
+    }
+
+    std::filesystem::path CachePath(const float size)
+    {
+        return Resources::GetPath(L"font_cache", std::format(L"font_{}.bin", static_cast<uint32_t>(size)));
+    }
+
+    // Recreates the atlas and font metrics from a cache file, without touching the font files
+    ImFont* LoadCachedFont(const float size, const uint64_t key)
+    {
+        MappedFile cache;
+        if (!cache.Map(CachePath(size)) || cache.size < sizeof(CacheHeader))
+            return nullptr;
+        CacheHeader header;
+        memcpy(&header, cache.view, sizeof(header));
+        const size_t pixel_count = static_cast<size_t>(header.tex_width) * header.tex_height;
+        if (header.magic != CACHE_MAGIC
+            || header.version != CACHE_VERSION
+            || header.key != key
+            || header.font_size != size
+            || !header.glyph_count
+            || !pixel_count
+            || cache.size != sizeof(CacheHeader) + static_cast<size_t>(header.glyph_count) * sizeof(CachedGlyph) + pixel_count) {
+            return nullptr; // Stale (fonts or sizes changed) or corrupt; rebuilt and overwritten by the caller
+        }
+
+        const auto atlas = IM_NEW(ImFontAtlas);
+        atlas->Flags = AtlasFlags();
+        atlas->TexWidth = static_cast<int>(header.tex_width);
+        atlas->TexHeight = static_cast<int>(header.tex_height);
+        atlas->TexUvScale = ImVec2(1.0f / static_cast<float>(atlas->TexWidth), 1.0f / static_cast<float>(atlas->TexHeight));
+        atlas->TexUvWhitePixel = ImVec2(header.white_pixel_u, header.white_pixel_v);
+        atlas->TexPixelsAlpha8 = static_cast<unsigned char*>(IM_ALLOC(pixel_count));
+        memcpy(atlas->TexPixelsAlpha8, cache.view + cache.size - pixel_count, pixel_count);
+
+        // Give the font a config like ImFontAtlas::AddFont would; it is cleared again below with the rest of the input data
+        ImFontConfig cfg;
+        cfg.SizePixels = size;
+        cfg.FontDataOwnedByAtlas = false;
+        atlas->ConfigData.push_back(cfg);
+        const auto font = IM_NEW(ImFont);
+        atlas->Fonts.push_back(font);
+        atlas->ConfigData.back().DstFont = font;
+        font->ContainerAtlas = atlas;
+        font->ConfigData = &atlas->ConfigData.back();
+        font->ConfigDataCount = 1;
+        font->FontSize = header.font_size;
+        font->Ascent = header.ascent;
+        font->Descent = header.descent;
+
+        const auto glyphs = reinterpret_cast<const CachedGlyph*>(cache.view + sizeof(CacheHeader));
+        font->Glyphs.reserve(static_cast<int>(header.glyph_count));
+        for (uint32_t i = 0; i < header.glyph_count; i++) {
+            const auto& g = glyphs[i];
+            // Metrics were already adjusted by the config when baked
+            font->AddGlyph(nullptr, static_cast<ImWchar>(g.codepoint), g.x0, g.y0, g.x1, g.y1, g.u0, g.v0, g.u1, g.v1, g.advance_x);
+        }
+        font->BuildLookupTable();
+        atlas->TexReady = true;
+        atlas->ClearInputData();
+
+        unsigned char* unused = nullptr;
+        // Preload the data for this font
+        atlas->GetTexDataAsRGBA32(&unused, nullptr, nullptr, nullptr);
+        return font;
+    }
+
+    bool SaveCachedFont(const ImFont* font, const uint64_t key)
+    {
+        const auto atlas = font->ContainerAtlas;
+        if (!atlas->TexPixelsAlpha8)
+            return false;
+        const auto path = CachePath(font->FontSize);
+        if (!Resources::EnsureFolderExists(path.parent_path()))
+            return false;
+        const CacheHeader header = {
+            CACHE_MAGIC, CACHE_VERSION, key,
+            font->FontSize, font->Ascent, font->Descent,
+            static_cast<uint32_t>(atlas->TexWidth), static_cast<uint32_t>(atlas->TexHeight),
+            atlas->TexUvWhitePixel.x, atlas->TexUvWhitePixel.y,
+            static_cast<uint32_t>(font->Glyphs.Size)
+        };
+        std::vector<CachedGlyph> glyphs;
+        glyphs.reserve(static_cast<size_t>(font->Glyphs.Size));
+        for (const auto& g : font->Glyphs) {
+            glyphs.push_back({g.Codepoint, g.AdvanceX, g.X0, g.Y0, g.X1, g.Y1, g.U0, g.V0, g.U1, g.V1});
+        }
+        auto tmp_path = path;
+        tmp_path += L".tmp";
+        {
+            std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(glyphs.data()), static_cast<std::streamsize>(glyphs.size() * sizeof(CachedGlyph)));
+            out.write(reinterpret_cast<const char*>(atlas->TexPixelsAlpha8), static_cast<std::streamsize>(atlas->TexWidth) * atlas->TexHeight);
+            if (!out.good())
+                return false;
+        }
+        return MoveFileExW(tmp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+    }
+
+    ImFont* LoadOrBuildFont(const float size, const std::vector<FontSource>& sources)
+    {
+        const auto started = std::chrono::steady_clock::now();
+        const auto elapsed_ms = [started] {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+        };
+        const auto key = CacheKey(size, sources);
+        if (const auto font = LoadCachedFont(size, key)) {
+            printf("Font %.0f loaded from cache in %lldms\n", size, elapsed_ms());
+            return font;
+        }
+        const auto font = BuildFont(size, &sources);
+        printf("Font %.0f built in %lldms\n", size, elapsed_ms());
+        if (!SaveCachedFont(font, key)) {
+            printf("Failed to save font cache for size %.0f\n", size);
+        }
+        return font;
+    }
+
     // Load fonts into memory; run on a separate thread.
     void LoadFontsThread()
     {
@@ -380,9 +666,10 @@ namespace {
                 : dst_font(dst_font),
                   font_size(font_size) {}
 
-            void build(const bool default_font_only = false)
+            void build(const std::vector<FontSource>* sources = nullptr)
             {
-                src_font = BuildFont(static_cast<float>(font_size), default_font_only);
+                const auto size = static_cast<float>(font_size);
+                src_font = sources ? LoadOrBuildFont(size, *sources) : BuildFont(size);
             }
         };
 
@@ -399,7 +686,7 @@ namespace {
         };
 
         FontPending default_font = {&font_text, FontLoader::FontSize::text};
-        default_font.build(true);
+        default_font.build();
 
         Resources::EnqueueDxTask([assign_fonts, default_font](IDirect3DDevice9*) {
             assign_fonts({default_font});
@@ -416,8 +703,29 @@ namespace {
             {&font_widget_small, FontLoader::FontSize::widget_small},
             {&font_widget_large, FontLoader::FontSize::widget_large}
         };
-        for (auto& pending : all_fonts) {
-            pending.build();
+
+        // Font files are read once and shared by every size; the hash keys the atlas cache
+        const auto& font_data = GetFontData();
+        std::vector<FontSource> sources(font_data.size());
+        for (size_t i = 0; i < font_data.size(); i++) {
+            auto& source = sources[i];
+            source.data = &font_data[i];
+            ASSERT(!source.data->font_name.empty() && "Font name is empty, this shouldn't happen. Contact the developers.");
+            if (source.ttf.Map(source.data->font_name)) {
+                source.hash = Hash(source.ttf.view, source.ttf.size);
+            }
+        }
+
+        // Each size has its own atlas, so they can be loaded or rasterised in parallel; decompress FontAwesome before they start
+        FontAwesomeTTF();
+        {
+            std::vector<std::jthread> builders;
+            builders.reserve(all_fonts.size());
+            for (auto& pending : all_fonts) {
+                builders.emplace_back([&pending, &sources] {
+                    pending.build(&sources);
+                });
+            }
         }
 
         Resources::EnqueueDxTask([assign_fonts, fonts = std::move(all_fonts)](IDirect3DDevice9*) {
@@ -10,6 +10,7 @@
 #include <Modules/Resources.h>
 
 #include "GuiUtils.h"
+#include <Utils/DecodedStringCache.h>
 #include <Utils/TextUtils.h>
 
 namespace {
@@ -483,6 +484,10 @@ namespace GuiUtils {
 
     void EncString::decode() {
         if (!decoded && !decoding && !encoded_ws.empty()) {
+            if (DecodedStringCache::Find(language_id, encoded_ws, decoded_ws)) {
+                decoded = true;
+                return;
+            }
             decoding = true;
             GW::GameThread::Enqueue([&] {
                 GW::UI::AsyncDecodeStr(encoded_ws.c_str(), OnStringDecoded, this, language_id);
@@ -527,6 +532,7 @@ namespace GuiUtils {
         }
         if (decoded && decoded[0]) {
             context->decoded_ws = decoded;
+            DecodedStringCache::Store(context->language_id, context->encoded_ws, context->decoded_ws);
         }
         context->decoded = true;
         context->decoding = false;
@@ -0,0 +1,818 @@
+#include "stdafx.h"
+
+#include <atomic>
+
+#include <Utils/GwDat.h>
+
+#ifndef _WIN32
+// The tests and tools build this on Linux
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr uint32_t NONE = 0xFFFFFFFF;
+    // The MFT doesn't record unpacked sizes, only the stream does; nothing in Gw.dat comes close to this
+    constexpr uint32_t MAX_DECOMPRESSED_SIZE = 64 * 1024 * 1024;
+
+    uint32_t LoadU32(const uint8_t* p)
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    uint64_t LoadU64(const uint8_t* p)
+    {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    // Prefix code for the code lengths of the two trees in each block: thresholds on the next 32 bits, with the index
+    // into CODE_LENGTH_SYMBOLS they count down from. Entry i is i + 3 bits long.
+    constexpr std::pair<uint32_t, uint32_t> CODE_LENGTH_CODES[] = {
+        {0xA0000000, 0x02}, {0x60000000, 0x06}, {0x40000000, 0x0A}, {0x20000000, 0x12}, {0x12000000, 0x19},
+        {0x0C000000, 0x1F}, {0x07000000, 0x29}, {0x03000000, 0x39}, {0x01600000, 0x46}, {0x00F00000, 0x4D},
+        {0x00C00000, 0x53}, {0x00B00000, 0x57}, {0x00A00000, 0x5F}, {0x00000000, 0xFF}
+    };
+
+    // Code length symbols: low 5 bits are the length, high 3 bits how many more symbols repeat it
+    constexpr uint8_t CODE_LENGTH_SYMBOLS[256] = {
+        0x08, 0x09, 0x0A, 0x00, 0x07, 0x0B, 0x0C, 0x06, 0x29, 0x2A, 0xE0, 0x04, 0x05, 0x20, 0x28, 0x2B,
+        0x2C, 0x40, 0x4A, 0x03, 0x0D, 0x25, 0x26, 0x27, 0x48, 0x49, 0x24, 0x47, 0x4B, 0x4C, 0x69, 0x6A,
+        0x23, 0x46, 0x60, 0x63, 0x67, 0x68, 0x88, 0x89, 0xA0, 0xE8, 0x01, 0x02, 0x2D, 0x43, 0x44, 0x45,
+        0x65, 0x66, 0x80, 0x87, 0x8A, 0xA8, 0xA9, 0xC0, 0xC9, 0xE9, 0x0E, 0x4D, 0x64, 0x6B, 0x6C, 0x84,
+        0x85, 0x8B, 0xA4, 0xA5, 0xAA, 0xC8, 0xE5, 0x83, 0x86, 0xA6, 0xA7, 0xC7, 0xCA, 0xE7, 0x22, 0x2E,
+        0x8C, 0xC4, 0xE4, 0xE6, 0x4E, 0x6D, 0xC6, 0xEC, 0x0F, 0x10, 0x11, 0x8D, 0xAB, 0xAC, 0xCC, 0xEA,
+        0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x21, 0x2F,
+        0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,
+        0x41, 0x42, 0x4F, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x5C,
+        0x5D, 0x5E, 0x5F, 0x61, 0x62, 0x6E, 0x6F, 0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78,
+        0x79, 0x7A, 0x7B, 0x7C, 0x7D, 0x7E, 0x7F, 0x81, 0x82, 0x8E, 0x8F, 0x90, 0x91, 0x92, 0x93, 0x94,
+        0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0x9B, 0x9C, 0x9D, 0x9E, 0x9F, 0xA1, 0xA2, 0xA3, 0xAD, 0xAE,
+        0xAF, 0xB0, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xBB, 0xBC, 0xBD, 0xBE,
+        0xBF, 0xC1, 0xC2, 0xC3, 0xC5, 0xCB, 0xCD, 0xCE, 0xCF, 0xD0, 0xD1, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6,
+        0xD7, 0xD8, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE, 0xDF, 0xE1, 0xE2, 0xE3, 0xEB, 0xED, 0xEE, 0xEF,
+        0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF
+    };
+
+    // Literal/length symbols from 0x100 are match lengths, distance symbols are distances; same scheme as deflate
+    constexpr uint8_t LENGTH_BASE[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 14, 16, 20, 24, 28, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 255};
+    constexpr uint8_t LENGTH_BITS[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    constexpr uint16_t DISTANCE_BASE[] = {
+        0, 1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096, 6144, 8192, 12288, 16384, 24576
+    };
+    constexpr uint8_t DISTANCE_BITS[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    // MSB-first reader over little endian words. Always holds the next 32 bits in bits, and up to 32 more in next.
+    class BitStream {
+    public:
+        // The first 4 bits of the stream are skipped
+        BitStream(const uint8_t* data, const size_t size)
+            : pos(data + 8),
+              end(data + size / 4 * 4)
+        {
+            const uint32_t first = LoadU32(data);
+            const uint32_t second = LoadU32(data + 4);
+            bits = first << 4 | second >> 28;
+            next = second << 4;
+            available = 28;
+        }
+
+        [[nodiscard]] uint32_t Bits() const { return bits; }
+
+        // n in 1..31
+        uint32_t Read(const uint32_t n)
+        {
+            const uint32_t value = bits >> (32 - n);
+            Skip(n);
+            return value;
+        }
+
+        // n in 0..31
+        void Skip(const uint32_t n)
+        {
+            if (!n) {
+                return;
+            }
+            bits = next >> (32 - n) | bits << n;
+            if (n <= available) {
+                next <<= n;
+                available -= n;
+            }
+            else if (pos == end) {
+                next = available = 0;
+            }
+            else {
+                const uint32_t word = LoadU32(pos);
+                pos += 4;
+                const uint32_t remaining = available + 32 - n;
+                bits |= word >> remaining;
+                next = word << (n - available);
+                available = remaining;
+            }
+        }
+
+    private:
+        const uint8_t* pos;
+        const uint8_t* end;
+        uint32_t bits;
+        uint32_t next;
+        uint32_t available;
+    };
+
+    // Canonical prefix code, codes counting down from all ones. Codes up to 8 bits resolve from the top byte in one
+    // lookup; longer ones are marked there and found by threshold in long_codes.
+    struct HuffmanTree {
+        struct FastEntry {
+            uint32_t bits = 0;
+            uint32_t symbol = 0;
+        };
+        struct LongCode {
+            uint32_t threshold = 0; // Smallest 32 bit window with this length
+            uint32_t last = 0;      // Index in long_symbols of the code at threshold
+            uint32_t bits = 0;
+        };
+        std::array<FastEntry, 256> fast{};
+        std::array<LongCode, 24> long_codes{};
+        std::vector<uint32_t> long_symbols;
+
+        // Reads the code lengths from the stream and builds the lookup tables. Like the game, a table that runs out of
+        // codes early is left as far as it got rather than rejected.
+        bool Build(BitStream& in)
+        {
+            // Nothing may survive from the previous block's tree; Decode stops at the first unused long code
+            fast.fill({});
+            long_codes.fill({});
+            long_symbols.clear();
+            const uint32_t count = in.Read(16);
+            std::vector<uint32_t> next_with_length(count, NONE);
+            std::array<uint32_t, 32> first_with_length;
+            first_with_length.fill(NONE);
+            uint32_t total = 0;
+
+            // Symbols are listed from the last one down; each list ends up in ascending order
+            for (uint32_t symbol = count - 1; symbol != NONE;) {
+                size_t i = 0;
+                while (in.Bits() < CODE_LENGTH_CODES[i].first) {
+                    i++;
+                }
+                const uint32_t n = static_cast<uint32_t>(i) + 3;
+                const uint32_t index = CODE_LENGTH_CODES[i].second - ((in.Bits() - CODE_LENGTH_CODES[i].first) >> (32 - n));
+                if (index >= _countof(CODE_LENGTH_SYMBOLS)) {
+                    return false;
+                }
+                const uint32_t code = CODE_LENGTH_SYMBOLS[index];
+                in.Skip(n);
+
+                const uint32_t repeat = code >> 5;
+                const uint32_t length = code & 31;
+                if (repeat > symbol) {
+                    return true;
+                }
+                if (!length && count >= 2) {
+                    symbol -= repeat + 1;
+                    continue;
+                }
+                total += repeat + 1;
+                for (uint32_t k = 0; k <= repeat; k++, symbol--) {
+                    next_with_length[symbol] = first_with_length[length];
+                    first_with_length[length] = symbol;
+                }
+            }
+            if (count && !total) {
+                // A single symbol gets a zero length code
+                next_with_length[count - 1] = first_with_length[0];
+                first_with_length[0] = count - 1;
+                total = 1;
+            }
+
+            uint32_t filled = 0;
+            uint32_t code = 0;
+            uint32_t length = 0;
+            for (; length <= 8; length++, code = code * 2 + 1) {
+                for (uint32_t symbol = first_with_length[length]; symbol != NONE; symbol = next_with_length[symbol], filled++, code--) {
+                    if (code >= 1u << length || symbol >= count) {
+                        return true;
+                    }
+                    const uint32_t first = code << (8 - length);
+                    for (uint32_t i = 0; i < 1u << (8 - length); i++) {
+                        fast[first | i] = {length, symbol};
+                    }
+                }
+            }
+            if (filled > total) {
+                return false;
+            }
+            if (filled == total) {
+                return true;
+            }
+
+            long_symbols.assign(total - filled, 0);
+            uint32_t index = 0;
+            size_t long_code = 0;
+            for (; length <= 31; length++, code = code * 2 + 1) {
+                uint32_t symbol = first_with_length[length];
+                if (symbol == NONE) {
+                    continue;
+                }
+                for (; symbol != NONE; symbol = next_with_length[symbol], code--) {
+                    if (code > 1u << length || symbol >= count) {
+                        return true;
+                    }
+                    const uint32_t top = code >> (length - 8);
+                    if (top >= fast.size() || index >= long_symbols.size()) {
+                        return false;
+                    }
+                    fast[top].bits = NONE;
+                    long_symbols[index++] = symbol;
+                }
+                long_codes[long_code++] = {(code + 1) << (32 - length), index - 1, length};
+            }
+            return true;
+        }
+
+        bool Decode(BitStream& in, uint32_t& symbol) const
+        {
+            const uint32_t bits = in.Bits();
+            uint32_t n = fast[bits >> 24].bits;
+            symbol = fast[bits >> 24].symbol;
+            if (n == NONE) {
+                size_t i = 0;
+                while (i < long_codes.size() && bits < long_codes[i].threshold) {
+                    i++;
+                }
+                if (i == long_codes.size()) {
+                    return false;
+                }
+                const auto& entry = long_codes[i];
+                n = entry.bits;
+                if (!n || n >= 32) {
+                    return false;
+                }
+                const uint32_t index = entry.last - ((bits - entry.threshold) >> (32 - n));
+                if (index >= long_symbols.size()) {
+                    return false;
+                }
+                symbol = long_symbols[index];
+            }
+            if (n >= 32) {
+                return false;
+            }
+            in.Skip(n);
+            return true;
+        }
+    };
+}
+
+namespace GwDat {
+    namespace {
+        constexpr size_t HEADER_SIZE = 0x20;
+        constexpr size_t RECORD_SIZE = 24;
+        constexpr uint32_t FIRST_FILE_RECORD = 16;
+
+        const Entry* FindIn(const std::vector<Entry>& entries, const uint32_t file_id)
+        {
+            const auto found = std::ranges::lower_bound(entries, file_id, {}, &Entry::file_id);
+            return found != entries.end() && found->file_id == file_id ? &*found : nullptr;
+        }
+    }
+
+    // The open dat: a file mapping on Windows, a file descriptor elsewhere. Views are mapped from it on demand.
+    struct DatFile::Mapping {
+        uint64_t size = 0;
+        uint32_t granularity = 0x10000;
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE section = nullptr;
+#else
+        int fd = -1;
+#endif
+
+        Mapping() = default;
+        Mapping(const Mapping&) = delete;
+        ~Mapping()
+        {
+#ifdef _WIN32
+            if (section) {
+                CloseHandle(section);
+            }
+            if (file != INVALID_HANDLE_VALUE) {
+                CloseHandle(file);
+            }
+#else
+            if (fd >= 0) {
+                close(fd);
+            }
+#endif
+        }
+
+        static std::shared_ptr<const Mapping> Open(const std::filesystem::path& path);
+        bool Map(uint64_t offset, size_t length, View& view) const;
+    };
+
+    // Read only view over part of the mapping, aligned down to the allocation granularity
+    struct DatFile::View {
+        void* base = nullptr;
+        size_t length = 0;
+        const uint8_t* data = nullptr;
+
+        View() = default;
+        View(const View&) = delete;
+        ~View()
+        {
+            if (base) {
+#ifdef _WIN32
+                UnmapViewOfFile(base);
+#else
+                munmap(base, length);
+#endif
+            }
+        }
+    };
+
+    // One reading of the MFT, replaced whole when the game changes it. Readers keep the one they started with, and the
+    // mapping it came from, until they're done.
+    struct DatFile::Index {
+        std::shared_ptr<const Mapping> mapping;
+        uint64_t mft_offset = 0;
+        std::array<uint8_t, HEADER_SIZE> header{};        // As read, to tell when the game has rewritten it
+        std::array<uint8_t, RECORD_SIZE * 2> mft_head{}; // Records 0 and 1: the record count and the file id table
+        std::vector<Entry> entries;                       // Sorted by file id
+    };
+
+    // Threads for ReadMany, kept between calls. Each batch is a range of indices the threads pull from as they finish,
+    // so a few big files don't hold up one thread's whole share.
+    class DatFile::WorkerPool {
+    public:
+        explicit WorkerPool(const size_t size)
+        {
+            for (size_t i = 0; i < size; i++) {
+                threads.emplace_back([this, i] {
+                    Work(i);
+                });
+            }
+        }
+
+        ~WorkerPool()
+        {
+            {
+                std::lock_guard lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+        }
+
+        [[nodiscard]] size_t Size() const { return threads.size(); }
+
+        // Calls fn(i) for every i below count on up to max_threads threads, and returns once they're all done
+        void Run(const size_t count, const size_t max_threads, const std::function<void(size_t)>& fn)
+        {
+            std::lock_guard batch_lock(batch_mutex);
+            std::unique_lock lock(mutex);
+            job = &fn;
+            job_count = count;
+            job_threads = std::min(max_threads, threads.size());
+            next = 0;
+            finished = 0;
+            generation++;
+            wake.notify_all();
+            done.wait(lock, [this] {
+                return finished == job_threads;
+            });
+            job = nullptr;
+        }
+
+    private:
+        void Work(const size_t worker)
+        {
+            uint64_t seen = 0;
+            std::unique_lock lock(mutex);
+            while (true) {
+                wake.wait(lock, [&] {
+                    return stopping || generation != seen;
+                });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+                if (worker >= job_threads) {
+                    continue;
+                }
+                const auto& fn = *job;
+                const size_t count = job_count;
+                lock.unlock();
+                for (size_t i = next++; i < count; i = next++) {
+                    fn(i);
+                }
+                lock.lock();
+                if (++finished == job_threads) {
+                    done.notify_all();
+                }
+            }
+        }
+
+        std::mutex batch_mutex; // One batch at a time
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        const std::function<void(size_t)>* job = nullptr;
+        size_t job_count = 0;
+        size_t job_threads = 0;
+        std::atomic<size_t> next = 0;
+        size_t finished = 0;
+        uint64_t generation = 0;
+        bool stopping = false;
+        std::vector<std::jthread> threads; // Last, so they're joined before anything they use goes
+    };
+
+    bool Decompress(const uint8_t* bytes, const size_t size, std::vector<uint8_t>& out)
+    {
+        if (!bytes || size < 8) {
+            return false;
+        }
+        const uint32_t out_size = LoadU32(bytes + (size / 4 - 1) * 4);
+        if (out_size > MAX_DECOMPRESSED_SIZE) {
+            return false; // Corrupt; don't let it allocate gigabytes
+        }
+        out.assign(out_size, 0);
+        if (!out_size) {
+            return true;
+        }
+
+        BitStream in(bytes, size);
+        const uint32_t min_length = in.Read(4) + 1;
+        // Trees carry over between blocks, as the game's decoder keeps them
+        HuffmanTree literals;
+        HuffmanTree distances;
+        size_t pos = 0;
+        do {
+            if (!literals.Build(in) || !distances.Build(in)) {
+                return false;
+            }
+            for (uint32_t symbols = (in.Read(4) + 1) << 12; symbols && pos < out_size; symbols--) {
+                uint32_t symbol;
+                if (!literals.Decode(in, symbol)) {
+                    return false;
+                }
+                if (symbol < 0x100) {
+                    out[pos++] = static_cast<uint8_t>(symbol);
+                    continue;
+                }
+                symbol -= 0x100;
+                if (symbol >= _countof(LENGTH_BASE)) {
+                    return false;
+                }
+                uint32_t length = LENGTH_BASE[symbol];
+                if (LENGTH_BITS[symbol]) {
+                    length |= in.Read(LENGTH_BITS[symbol]);
+                }
+                length += min_length;
+
+                if (!distances.Decode(in, symbol) || symbol >= _countof(DISTANCE_BASE)) {
+                    return false;
+                }
+                uint32_t distance = DISTANCE_BASE[symbol];
+                if (DISTANCE_BITS[symbol]) {
+                    distance |= in.Read(DISTANCE_BITS[symbol]);
+                }
+                if (length > out_size - pos || distance >= pos) {
+                    return false;
+                }
+                // Byte by byte; matches overlap their own output
+                for (size_t src = pos - distance - 1, end = pos + length; pos < end;) {
+                    out[pos++] = out[src++];
+                }
+            }
+        } while (pos != out_size);
+        return true;
+    }
+
+
+    std::filesystem::path DefaultPath()
+    {
+#ifdef _WIN32
+        wchar_t exe_path[MAX_PATH];
+        const DWORD len = GetModuleFileNameW(nullptr, exe_path, _countof(exe_path));
+        if (!len || len == _countof(exe_path)) {
+            return {};
+        }
+        return std::filesystem::path(exe_path).parent_path() / L"Gw.dat";
+#else
+        return {};
+#endif
+    }
+
+    DatFile::DatFile() = default;
+
+    DatFile::~DatFile()
+    {
+        Close();
+    }
+
+    std::shared_ptr<const DatFile::Mapping> DatFile::Mapping::Open(const std::filesystem::path& path)
+    {
+        auto mapping = std::make_shared<Mapping>();
+#ifdef _WIN32
+        // Gw.exe has the dat open for writing
+        mapping->file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (mapping->file == INVALID_HANDLE_VALUE) {
+            Log::Log("[GwDat] Failed to open %ls (%lu)", path.c_str(), GetLastError());
+            return nullptr;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(mapping->file, &size)) {
+            return nullptr;
+        }
+        mapping->size = static_cast<uint64_t>(size.QuadPart);
+        // Covers the file as it is now; if the game grows it, the next index gets a new mapping
+        mapping->section = CreateFileMappingW(mapping->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping->section) {
+            Log::Log("[GwDat] Failed to map %ls (%lu)", path.c_str(), GetLastError());
+            return nullptr;
+        }
+        SYSTEM_INFO system_info;
+        GetSystemInfo(&system_info);
+        mapping->granularity = system_info.dwAllocationGranularity;
+#else
+        mapping->fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (mapping->fd < 0 || fstat(mapping->fd, &st) != 0) {
+            Log::Log("[GwDat] Failed to open %s", path.c_str());
+            return nullptr;
+        }
+        mapping->size = static_cast<uint64_t>(st.st_size);
+        mapping->granularity = static_cast<uint32_t>(sysconf(_SC_PAGESIZE));
+#endif
+        return mapping;
+    }
+
+    bool DatFile::Mapping::Map(const uint64_t offset, const size_t length, View& view) const
+    {
+        if (!length || offset > size || length > size - offset) {
+            return false;
+        }
+        const uint64_t aligned = offset - offset % granularity;
+        const auto skip = static_cast<size_t>(offset - aligned);
+#ifdef _WIN32
+        view.base = MapViewOfFile(section, FILE_MAP_READ, static_cast<DWORD>(aligned >> 32), static_cast<DWORD>(aligned), skip + length);
+        if (!view.base) {
+            return false;
+        }
+#else
+        void* base = mmap(nullptr, skip + length, PROT_READ, MAP_SHARED, fd, static_cast<off_t>(aligned));
+        if (base == MAP_FAILED) {
+            return false;
+        }
+        view.base = base;
+#endif
+        view.length = skip + length;
+        view.data = static_cast<const uint8_t*>(view.base) + skip;
+        return true;
+    }
+
+    std::shared_ptr<const DatFile::Index> DatFile::LoadIndex(const std::filesystem::path& path)
+    {
+        auto index = std::make_shared<Index>();
+        index->mapping = Mapping::Open(path);
+        if (!index->mapping) {
+            return nullptr;
+        }
+        const Mapping& mapping = *index->mapping;
+
+        // Header: "3AN\x1A", header size, sector size, crc, MFT offset (u64), MFT size, flags
+        uint32_t mft_size;
+        {
+            View header;
+            if (!mapping.Map(0, HEADER_SIZE, header) || memcmp(header.data, "3AN\x1A", 4) != 0) {
+                return nullptr;
+            }
+            memcpy(index->header.data(), header.data, HEADER_SIZE);
+            index->mft_offset = LoadU64(header.data + 0x10);
+            mft_size = LoadU32(header.data + 0x18);
+        }
+
+        // MFT: 24 byte records. Record 0 is the MFT's own header ("Mft\x1A", ..., record count at 0xC);
+        // records 1..15 are reserved, with 1 pointing at the (file id, record) pairs.
+        View mft;
+        if (mft_size < sizeof(index->mft_head) || !mapping.Map(index->mft_offset, mft_size, mft) || memcmp(mft.data, "Mft\x1A", 4) != 0) {
+            return nullptr;
+        }
+        memcpy(index->mft_head.data(), mft.data, sizeof(index->mft_head));
+        const uint32_t record_count = std::min(LoadU32(mft.data + 0xC), static_cast<uint32_t>(mft_size / RECORD_SIZE));
+        const auto read_record = [&mft](const uint32_t record) {
+            const uint8_t* p = mft.data + record * RECORD_SIZE;
+            Entry entry;
+            entry.offset = LoadU64(p);
+            entry.size = LoadU32(p + 8);
+            entry.compression = static_cast<uint16_t>(p[12] | p[13] << 8);
+            entry.flags = static_cast<uint16_t>(p[14] | p[15] << 8);
+            entry.record = record;
+            return entry;
+        };
+
+        const Entry hash_table = read_record(1);
+        View ids;
+        if (!mapping.Map(hash_table.offset, hash_table.size, ids)) {
+            return nullptr;
+        }
+        auto& entries = index->entries;
+        entries.reserve(hash_table.size / 8);
+        for (size_t i = 0; i + 8 <= hash_table.size; i += 8) {
+            const uint32_t file_id = LoadU32(ids.data + i);
+            const uint32_t record = LoadU32(ids.data + i + 4);
+            if (record < FIRST_FILE_RECORD || record >= record_count) {
+                continue;
+            }
+            Entry entry = read_record(record);
+            if (!entry.size || entry.offset > mapping.size || entry.size > mapping.size - entry.offset) {
+                continue;
+            }
+            entry.file_id = file_id;
+            entries.push_back(entry);
+        }
+        std::ranges::stable_sort(entries, {}, &Entry::file_id);
+        const auto [first, last] = std::ranges::unique(entries, {}, &Entry::file_id);
+        entries.erase(first, last);
+        return index;
+    }
+
+    bool DatFile::IsCurrent(const Index& index)
+    {
+        View header;
+        View mft;
+        return index.mapping->Map(0, HEADER_SIZE, header) && memcmp(header.data, index.header.data(), HEADER_SIZE) == 0
+               && index.mapping->Map(index.mft_offset, sizeof(index.mft_head), mft)
+               && memcmp(mft.data, index.mft_head.data(), sizeof(index.mft_head)) == 0;
+    }
+
+    bool DatFile::RecordIsCurrent(const Index& index, const Entry& entry)
+    {
+        View record;
+        return index.mapping->Map(index.mft_offset + static_cast<uint64_t>(entry.record) * RECORD_SIZE, RECORD_SIZE, record)
+               && LoadU64(record.data) == entry.offset && LoadU32(record.data + 8) == entry.size;
+    }
+
+    std::shared_ptr<const DatFile::Index> DatFile::Reindex(const std::shared_ptr<const Index>& stale_index)
+    {
+        std::lock_guard lock(reindex_mutex);
+        auto current = index.load();
+        if (current != stale_index) {
+            return current; // Another thread got here first, or the dat was closed
+        }
+        auto fresh = LoadIndex(path);
+        if (!fresh) {
+            return current; // Most likely caught the game mid-write; a later read will try again
+        }
+        index.store(fresh);
+        ClearCache();
+        Log::Log("[GwDat] Re-indexed %zu files", fresh->entries.size());
+        return fresh;
+    }
+
+    bool DatFile::Open(const std::filesystem::path& dat_path)
+    {
+        Close();
+        auto loaded = LoadIndex(dat_path);
+        if (!loaded) {
+            return false;
+        }
+        Log::Log("[GwDat] Indexed %zu files in %ls", loaded->entries.size(), dat_path.wstring().c_str());
+        std::lock_guard lock(reindex_mutex);
+        path = dat_path;
+        index.store(std::move(loaded));
+        return true;
+    }
+
+    void DatFile::Close()
+    {
+        {
+            std::lock_guard lock(reindex_mutex);
+            index.store(nullptr);
+            path.clear();
+        }
+        ClearCache();
+    }
+
+    std::optional<Entry> DatFile::Find(const uint32_t file_id) const
+    {
+        const auto current = index.load();
+        const Entry* entry = current ? FindIn(current->entries, file_id) : nullptr;
+        return entry ? std::optional(*entry) : std::nullopt;
+    }
+
+    std::vector<Entry> DatFile::Entries() const
+    {
+        const auto current = index.load();
+        return current ? current->entries : std::vector<Entry>{};
+    }
+
+    bool DatFile::Refresh()
+    {
+        const auto current = index.load();
+        if (!current || IsCurrent(*current)) {
+            return false;
+        }
+        return Reindex(current) != current;
+    }
+
+    Blob DatFile::Read(const uint32_t file_id)
+    {
+        auto current = index.load();
+        if (!current) {
+            return nullptr;
+        }
+        const Entry* entry = FindIn(current->entries, file_id);
+        // A missing file may have been added since, a file whose record changed has been moved. Either way the cache
+        // goes with the old index.
+        if (entry ? !RecordIsCurrent(*current, *entry) : !IsCurrent(*current)) {
+            current = Reindex(current);
+            entry = current ? FindIn(current->entries, file_id) : nullptr;
+        }
+        if (!entry) {
+            return nullptr;
+        }
+        {
+            std::lock_guard lock(cache_mutex);
+            const auto cached = cache_index.find(file_id);
+            if (cached != cache_index.end()) {
+                cache_lru.splice(cache_lru.begin(), cache_lru, cached->second);
+                return cached->second->second;
+            }
+        }
+        View view;
+        if (!current->mapping->Map(entry->offset, entry->size, view)) {
+            return nullptr;
+        }
+        const auto contents = std::make_shared<std::vector<uint8_t>>();
+        if (entry->compression) {
+            if (!Decompress(view.data, entry->size, *contents)) {
+                Log::Log("[GwDat] Failed to decompress file %u", file_id);
+                return nullptr;
+            }
+        }
+        else {
+            contents->assign(view.data, view.data + entry->size);
+        }
+        AddToCache(*current, file_id, contents);
+        return contents;
+    }
+
+    void DatFile::ReadMany(const std::span<const uint32_t> file_ids, const std::function<void(uint32_t file_id, Blob blob)>& callback, const size_t num_threads)
+    {
+        if (file_ids.empty()) {
+            return;
+        }
+        WorkerPool* workers;
+        {
+            std::lock_guard lock(pool_mutex);
+            if (!pool) {
+                pool = std::make_unique<WorkerPool>(std::max(1u, std::thread::hardware_concurrency()));
+            }
+            workers = pool.get();
+        }
+        workers->Run(file_ids.size(), num_threads ? num_threads : workers->Size(), [&](const size_t i) {
+            callback(file_ids[i], Read(file_ids[i]));
+        });
+    }
+
+    void DatFile::SetCacheBudget(const size_t bytes)
+    {
+        std::lock_guard lock(cache_mutex);
+        cache_budget = bytes;
+        TrimCache();
+    }
+
+    void DatFile::AddToCache(const Index& read_with, const uint32_t file_id, const Blob& blob)
+    {
+        std::lock_guard lock(cache_mutex);
+        // Reindex replaces the index before it clears the cache, under this lock
+        if (blob->size() > cache_budget || cache_index.contains(file_id) || index.load().get() != &read_with) {
+            return;
+        }
+        cache_lru.emplace_front(file_id, blob);
+        cache_index[file_id] = cache_lru.begin();
+        cache_bytes += blob->size();
+        TrimCache();
+    }
+
+    void DatFile::TrimCache()
+    {
+        while (cache_bytes > cache_budget && !cache_lru.empty()) {
+            cache_bytes -= cache_lru.back().second->size();
+            cache_index.erase(cache_lru.back().first);
+            cache_lru.pop_back();
+        }
+    }
+
+    void DatFile::ClearCache()
+    {
+        std::lock_guard lock(cache_mutex);
+        cache_lru.clear();
+        cache_index.clear();
+        cache_bytes = 0;
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <span>
+
+// Direct reader for Gw.dat, independent of the game's file handles so it can be used from any thread.
+// The MFT is flattened into a table sorted by file id; entries are mapped in on demand (the dat is bigger than a
+// 32 bit address space) and decompressed with a port of the game's Huffman/LZ unpacker.
+// The game keeps writing to the dat while it runs, so the table is rebuilt when a read finds it out of date.
+namespace GwDat {
+    struct Entry {
+        uint32_t file_id = 0;
+        uint32_t size = 0;        // Bytes stored in the dat
+        uint64_t offset = 0;
+        uint16_t compression = 0; // Non-zero if packed
+        uint16_t flags = 0;
+        uint32_t record = 0;      // MFT record the entry came from
+    };
+
+    using Blob = std::shared_ptr<const std::vector<uint8_t>>;
+
+    class DatFile {
+    public:
+        DatFile();
+        ~DatFile();
+        DatFile(const DatFile&) = delete;
+        DatFile& operator=(const DatFile&) = delete;
+
+        // Opens the dat read only, sharing it with the running game, and indexes the MFT
+        bool Open(const std::filesystem::path& path);
+        void Close();
+        [[nodiscard]] bool IsOpen() const { return index.load() != nullptr; }
+
+        [[nodiscard]] std::optional<Entry> Find(uint32_t file_id) const;
+        // Copy of the current table, sorted by file id
+        [[nodiscard]] std::vector<Entry> Entries() const;
+
+        // Re-indexes if the game has changed the MFT since it was read. Returns true if the table was rebuilt.
+        // Read does this by itself when a file id is missing or its record has moved.
+        bool Refresh();
+
+        // Decompressed contents of file_id, or nullptr. Thread safe.
+        Blob Read(uint32_t file_id);
+        // Reads file_ids on up to num_threads of the reader's worker threads (one per core, started on first use; 0 for
+        // all of them), calling callback from those threads with each result as it completes. Blocks until all are done.
+        // Not to be called from a callback.
+        void ReadMany(std::span<const uint32_t> file_ids, const std::function<void(uint32_t file_id, Blob blob)>& callback, size_t num_threads = 0);
+
+        // Bytes of decompressed files kept around for repeated reads; least recently used go first
+        void SetCacheBudget(size_t bytes);
+
+    private:
+        struct Mapping;
+        struct View;
+        struct Index;
+        class WorkerPool;
+
+        static std::shared_ptr<const Index> LoadIndex(const std::filesystem::path& path);
+        static bool IsCurrent(const Index& index);
+        static bool RecordIsCurrent(const Index& index, const Entry& entry);
+        // Rebuilds the table unless another thread already replaced stale_index
+        std::shared_ptr<const Index> Reindex(const std::shared_ptr<const Index>& stale_index);
+        void AddToCache(const Index& read_with, uint32_t file_id, const Blob& blob);
+        void TrimCache();
+        void ClearCache();
+
+        std::filesystem::path path;
+        std::atomic<std::shared_ptr<const Index>> index;
+        std::mutex reindex_mutex;
+
+        std::mutex cache_mutex;
+        std::list<std::pair<uint32_t, Blob>> cache_lru; // Most recently used first
+        std::unordered_map<uint32_t, decltype(cache_lru)::iterator> cache_index;
+        size_t cache_bytes = 0;
+        size_t cache_budget = 64 * 1024 * 1024;
+
+        // Started on the first ReadMany and kept until the reader is destroyed
+        std::mutex pool_mutex;
+        std::unique_ptr<WorkerPool> pool;
+    };
+
+    // Gw.dat next to the running Gw.exe
+    std::filesystem::path DefaultPath();
+
+    // Unpacks one compressed dat entry; the unpacked size is stored in the entry's last 4 bytes
+    bool Decompress(const uint8_t* bytes, size_t size, std::vector<uint8_t>& out);
+}
@@ -0,0 +1,231 @@
+#include "stdafx.h"
+
+#include "MapSearchIndex.h"
+
+namespace {
+    // Deeper prefixes are rare enough to be checked against the keys under the deepest node instead
+    constexpr uint32_t MAX_TRIE_DEPTH = 8;
+    constexpr size_t MAX_TRIGRAMS = 128;
+
+    uint32_t TrigramCode(const char a, const char b, const char c)
+    {
+        return static_cast<uint32_t>(static_cast<uint8_t>(a)) << 16 | static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8 | static_cast<uint8_t>(c);
+    }
+}
+
+void MapSearchIndex::Clear()
+{
+    text.clear();
+    names.clear();
+    keys.clear();
+    trie.clear();
+    trigram_codes.clear();
+    trigram_offsets.clear();
+    trigram_names.clear();
+}
+
+void MapSearchIndex::Add(const uint32_t id, const std::string_view name)
+{
+    if (name.empty())
+        return;
+    Name n{};
+    n.id = id;
+    n.offset = static_cast<uint32_t>(text.size());
+    n.length = static_cast<uint32_t>(name.size());
+    text.append(name);
+    n.initials_offset = static_cast<uint32_t>(text.size());
+    for (size_t i = 0; i < name.size(); i++) {
+        if (name[i] != ' ' && (i == 0 || name[i - 1] == ' '))
+            text.push_back(name[i]);
+    }
+    n.initials_length = static_cast<uint32_t>(text.size()) - n.initials_offset;
+    names.push_back(n);
+}
+
+void MapSearchIndex::Build()
+{
+    std::ranges::stable_sort(names, [this](const Name& a, const Name& b) {
+        return NameText(a) < NameText(b);
+    });
+
+    keys.clear();
+    for (uint32_t i = 0; i < static_cast<uint32_t>(names.size()); i++) {
+        const auto& name = names[i];
+        keys.push_back({i, name.offset, name.length, KeyType::Name});
+        for (uint32_t pos = 1; pos < name.length; pos++) {
+            if (text[name.offset + pos - 1] == ' ' && text[name.offset + pos] != ' ')
+                keys.push_back({i, name.offset + pos, name.length - pos, KeyType::Word});
+        }
+        // Single word names would only repeat their own first letter
+        if (name.initials_length > 1)
+            keys.push_back({i, name.initials_offset, name.initials_length, KeyType::Initials});
+    }
+    std::ranges::sort(keys, [this](const Key& a, const Key& b) {
+        const auto a_text = KeyText(a);
+        const auto b_text = KeyText(b);
+        if (a_text != b_text)
+            return a_text < b_text;
+        if (a.type != b.type)
+            return a.type < b.type;
+        return a.name < b.name;
+    });
+
+    trie.clear();
+    trie.push_back({0, 0, 0, static_cast<uint32_t>(keys.size()), 0});
+    BuildTrie(0, 0);
+
+    std::vector<std::pair<uint32_t, uint16_t>> trigrams;
+    uint32_t codes[MAX_TRIGRAMS];
+    for (uint32_t i = 0; i < static_cast<uint32_t>(names.size()); i++) {
+        const auto count = Trigrams(NameText(names[i]), codes, _countof(codes));
+        for (size_t j = 0; j < count; j++) {
+            trigrams.emplace_back(codes[j], static_cast<uint16_t>(i));
+        }
+    }
+    std::ranges::sort(trigrams);
+    trigram_codes.clear();
+    trigram_offsets.clear();
+    trigram_names.clear();
+    trigram_names.reserve(trigrams.size());
+    for (const auto& [code, name] : trigrams) {
+        if (trigram_codes.empty() || trigram_codes.back() != code) {
+            trigram_codes.push_back(code);
+            trigram_offsets.push_back(static_cast<uint32_t>(trigram_names.size()));
+        }
+        trigram_names.push_back(name);
+    }
+    trigram_offsets.push_back(static_cast<uint32_t>(trigram_names.size()));
+}
+
+void MapSearchIndex::BuildTrie(const uint32_t node, const uint32_t depth)
+{
+    if (depth >= MAX_TRIE_DEPTH)
+        return;
+    auto begin = trie[node].keys_begin;
+    const auto end = trie[node].keys_end;
+    // Keys that end at this depth sort before any longer ones
+    while (begin < end && keys[begin].length <= depth) {
+        begin++;
+    }
+    const auto first_child = static_cast<uint32_t>(trie.size());
+    while (begin < end) {
+        const char c = text[keys[begin].offset + depth];
+        auto group_end = begin + 1;
+        while (group_end < end && text[keys[group_end].offset + depth] == c) {
+            group_end++;
+        }
+        trie.push_back({0, 0, begin, group_end, c});
+        begin = group_end;
+    }
+    trie[node].first_child = first_child;
+    trie[node].child_count = static_cast<uint32_t>(trie.size()) - first_child;
+    for (auto child = first_child, last = first_child + trie[node].child_count; child < last; child++) {
+        BuildTrie(child, depth + 1);
+    }
+}
+
+size_t MapSearchIndex::Trigrams(const std::string_view str, uint32_t* out, const size_t max)
+{
+    // Pad with a space either side so that the start and end of the string count for more
+    const auto at = [str](const size_t i) {
+        return i == 0 || i > str.size() ? ' ' : str[i - 1];
+    };
+    size_t count = 0;
+    for (size_t i = 0; i + 3 <= str.size() + 2 && count < max; i++) {
+        out[count++] = TrigramCode(at(i), at(i + 1), at(i + 2));
+    }
+    std::sort(out, out + count);
+    return static_cast<size_t>(std::unique(out, out + count) - out);
+}
+
+size_t MapSearchIndex::Search(const std::string_view query, const std::span<Result> results) const
+{
+    if (query.empty() || names.empty() || results.empty())
+        return 0;
+
+    std::vector<uint32_t> scores(names.size(), 0);
+
+    // Prefix matches; walk the trie as far as it goes, then check the rest of the query against each key
+    uint32_t node = 0;
+    const auto depth = std::min<size_t>(query.size(), MAX_TRIE_DEPTH);
+    for (size_t i = 0; i < depth && node != UINT32_MAX; i++) {
+        const auto& parent = trie[node];
+        node = UINT32_MAX;
+        for (auto child = parent.first_child, last = parent.first_child + parent.child_count; child < last; child++) {
+            if (trie[child].c == query[i]) {
+                node = child;
+                break;
+            }
+        }
+    }
+    if (node != UINT32_MAX) {
+        for (auto i = trie[node].keys_begin; i < trie[node].keys_end; i++) {
+            const auto& key = keys[i];
+            if (query.size() > depth && !KeyText(key).starts_with(query))
+                continue;
+            uint32_t score = 0;
+            switch (key.type) {
+                case KeyType::Name:
+                    score = key.length == query.size() ? SCORE_EXACT : SCORE_NAME_PREFIX;
+                    break;
+                case KeyType::Word:
+                    score = SCORE_WORD_PREFIX;
+                    break;
+                case KeyType::Initials:
+                    score = SCORE_INITIALS_PREFIX;
+                    break;
+            }
+            scores[key.name] = std::max(scores[key.name], score);
+        }
+    }
+
+    // Fuzzy matches; names sharing at least half of the query's trigrams, shorter names first
+    uint32_t query_trigrams[MAX_TRIGRAMS];
+    const auto query_trigram_count = query.size() >= 3 ? Trigrams(query, query_trigrams, _countof(query_trigrams)) : 0;
+    if (query_trigram_count) {
+        std::vector<uint8_t> shared(names.size(), 0);
+        for (size_t i = 0; i < query_trigram_count; i++) {
+            const auto found = std::ranges::lower_bound(trigram_codes, query_trigrams[i]);
+            if (found == trigram_codes.end() || *found != query_trigrams[i])
+                continue;
+            const auto code_index = found - trigram_codes.begin();
+            for (auto j = trigram_offsets[code_index]; j < trigram_offsets[code_index + 1]; j++) {
+                shared[trigram_names[j]]++;
+            }
+        }
+        for (size_t i = 0; i < names.size(); i++) {
+            if (static_cast<size_t>(shared[i]) * 2 < query_trigram_count)
+                continue;
+            const auto length_penalty = std::min<uint32_t>(names[i].length, 999);
+            const auto score = static_cast<uint32_t>((SCORE_FUZZY_MAX - 1000) * shared[i] / query_trigram_count + 1000 - length_penalty);
+            scores[i] = std::max(scores[i], score);
+        }
+    }
+
+    // Keep the best few, in order; names are sorted so the earlier index wins a tie
+    size_t count = 0;
+    for (uint32_t i = 0; i < static_cast<uint32_t>(names.size()); i++) {
+        if (!scores[i])
+            continue;
+        auto pos = count;
+        while (pos > 0 && results[pos - 1].score < scores[i]) {
+            pos--;
+        }
+        if (pos >= results.size())
+            continue;
+        if (count < results.size())
+            count++;
+        for (auto j = count - 1; j > pos; j--) {
+            results[j] = results[j - 1];
+        }
+        results[pos] = {names[i].id, scores[i]};
+    }
+    return count;
+}
+
+MapSearchIndex::Result MapSearchIndex::Best(const std::string_view query) const
+{
+    Result result;
+    Search(query, {&result, 1});
+    return result;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <span>
+
+// Ranked lookup over a fixed set of sanitised map names (lower case, no punctuation - see SanitiseForSearch).
+// Prefixes of the whole name, of any word in it, or of its initials are found through a trie; anything else falls back
+// to trigram overlap, so typos like "kamadn" still resolve. Build once the names are known, then query from any thread.
+class MapSearchIndex {
+public:
+    struct Result {
+        uint32_t id = 0;
+        uint32_t score = 0;
+    };
+
+    // Score bands; within a band, ties go to the alphabetically first name
+    static constexpr uint32_t SCORE_EXACT = 1000000;
+    static constexpr uint32_t SCORE_NAME_PREFIX = 900000;
+    static constexpr uint32_t SCORE_WORD_PREFIX = 800000;
+    static constexpr uint32_t SCORE_INITIALS_PREFIX = 700000;
+    static constexpr uint32_t SCORE_FUZZY_MAX = 600000;
+    // Fuzzy matches sharing at least 70% of the query's trigrams score this or more. Anything below is a guess: fine to
+    // list for the user to pick from, not to act on by itself.
+    static constexpr uint32_t SCORE_FUZZY_CONFIDENT = (SCORE_FUZZY_MAX - 1000) / 10 * 7;
+
+    void Clear();
+    void Add(uint32_t id, std::string_view name);
+    // Sorts the names and builds the trie and trigram tables; call after the last Add
+    void Build();
+    [[nodiscard]] bool Empty() const { return names.empty(); }
+
+    // Best matches first; returns the number of results written
+    size_t Search(std::string_view query, std::span<Result> results) const;
+    // Best match, or a result with score 0 if nothing matched
+    [[nodiscard]] Result Best(std::string_view query) const;
+
+private:
+    enum class KeyType : uint8_t {
+        Name,
+        Word,
+        Initials
+    };
+    struct Name {
+        uint32_t id;
+        uint32_t offset; // Into text
+        uint32_t length;
+        uint32_t initials_offset; // Into text
+        uint32_t initials_length;
+    };
+    struct Key {
+        uint32_t name;
+        uint32_t offset; // Into text
+        uint32_t length;
+        KeyType type;
+    };
+    struct TrieNode {
+        uint32_t first_child = 0;
+        uint32_t child_count = 0;
+        uint32_t keys_begin = 0; // Range of keys sharing this prefix
+        uint32_t keys_end = 0;
+        char c = 0;
+    };
+
+    [[nodiscard]] std::string_view KeyText(const Key& key) const { return {text.data() + key.offset, key.length}; }
+    [[nodiscard]] std::string_view NameText(const Name& name) const { return {text.data() + name.offset, name.length}; }
+    void BuildTrie(uint32_t node, uint32_t depth);
+    static size_t Trigrams(std::string_view str, uint32_t* out, size_t max);
+
+    std::string text;
+    std::vector<Name> names;
+    std::vector<Key> keys; // Sorted by key text
+    std::vector<TrieNode> trie;
+    std::vector<uint32_t> trigram_codes;   // Sorted, unique
+    std::vector<uint32_t> trigram_offsets; // trigram_codes.size() + 1 offsets into trigram_names
+    std::vector<uint16_t> trigram_names;   // Name indices containing each trigram
+};
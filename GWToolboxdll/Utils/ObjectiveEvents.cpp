@@ -0,0 +1,132 @@
+#include "stdafx.h"
+
+#include <Utils/ObjectiveEvents.h>
+
+namespace ObjectiveEvents {
+    bool IsMessageEvent(const EventType type)
+    {
+        return type == EventType::ServerMessage || type == EventType::DisplayDialogue;
+    }
+
+    bool Match(const EventType type, const uint32_t id1, const uintptr_t id2, const Event& event)
+    {
+        if (type != event.type) {
+            return false;
+        }
+        switch (type) {
+            // for these, use id2 as a wchar_t*
+            case EventType::ServerMessage:
+            case EventType::DisplayDialogue: {
+                const auto msg1 = reinterpret_cast<const wchar_t*>(id2);
+                const auto msg2 = reinterpret_cast<const wchar_t*>(event.id2);
+                if (msg1 == nullptr) {
+                    return false;
+                }
+                if (msg2 == nullptr) {
+                    return false;
+                }
+                for (auto i = 0u; i < id1 && i < event.id1; i++) {
+                    if (msg2[i] != 0 && msg1[i] != msg2[i]) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            default:
+                if (id1 != 0 && id1 != event.id1) {
+                    return false;
+                }
+                if (id2 != 0 && id2 != event.id2) {
+                    return false;
+                }
+                return true;
+        }
+    }
+
+    void DispatchTable::Clear()
+    {
+        for (auto& index : table) {
+            index.by_key.clear();
+            index.by_first_char.clear();
+            index.unkeyed.clear();
+            index.all.clear();
+        }
+    }
+
+    void DispatchTable::Add(const uint32_t objective, const Event& event)
+    {
+        const auto add = [objective](std::vector<uint32_t>& bucket) {
+            if (bucket.empty() || bucket.back() != objective) {
+                bucket.push_back(objective);
+            }
+        };
+        auto& index = table[static_cast<size_t>(event.type)];
+        add(index.all);
+        if (!IsMessageEvent(event.type)) {
+            add(index.by_key[event.id1]);
+            return;
+        }
+        const auto msg = reinterpret_cast<const wchar_t*>(event.id2);
+        if (!msg) {
+            return; // never matches
+        }
+        // A zero character in the pattern is a wildcard
+        if (!event.id1 || !msg[0]) {
+            add(index.unkeyed);
+            return;
+        }
+        add(index.by_first_char[msg[0]]);
+        if (event.id1 >= 2 && msg[1]) {
+            add(index.by_key[static_cast<uint32_t>(msg[0]) << 16 | msg[1]]);
+        }
+        else {
+            add(index.by_key[msg[0]]);
+        }
+    }
+
+    void DispatchTable::Candidates(const EventType type, const uint32_t id1, const uintptr_t id2, std::vector<uint32_t>& out) const
+    {
+        out.clear();
+        const auto& index = table[static_cast<size_t>(type)];
+        const auto add_bucket = [&out](const std::unordered_map<uint32_t, std::vector<uint32_t>>& buckets, const uint32_t key) {
+            const auto found = buckets.find(key);
+            if (found != buckets.end()) {
+                out.insert(out.end(), found->second.begin(), found->second.end());
+            }
+        };
+        if (IsMessageEvent(type)) {
+            const auto msg = reinterpret_cast<const wchar_t*>(id2);
+            if (!msg) {
+                return;
+            }
+            if (!id1) {
+                out = index.all; // compares nothing, so everything matches
+                return;
+            }
+            if (msg[0]) {
+                if (id1 == 1) {
+                    // Only the first character gets compared
+                    add_bucket(index.by_first_char, msg[0]);
+                }
+                else {
+                    if (msg[1]) {
+                        add_bucket(index.by_key, static_cast<uint32_t>(msg[0]) << 16 | msg[1]);
+                    }
+                    add_bucket(index.by_key, msg[0]);
+                }
+            }
+            out.insert(out.end(), index.unkeyed.begin(), index.unkeyed.end());
+        }
+        else if (!id1) {
+            out = index.all;
+            return;
+        }
+        else {
+            add_bucket(index.by_key, id1);
+        }
+        std::ranges::sort(out);
+        const auto [last, end] = std::ranges::unique(out);
+        out.erase(last, end);
+    }
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <span>
+
+// Objective timer events, how they match an objective's start/end events, and the table that narrows an incoming
+// event down to the objectives that could match it. No game or Windows headers, so it builds in the tests project.
+namespace ObjectiveEvents {
+    // TODO: many of those are not hooked up
+    enum class EventType {
+        ServerMessage,
+        // id1=msg length, id2=pointer to msg
+
+        // dialog from owner. Can be in chat or middle of screen.
+        DisplayDialogue,
+        // id1=msg length, id2=pointer to msg
+
+        InstanceLoadInfo,
+        // id1 is mapid
+        InstanceEnd,
+        // id1 is mapid we're leaving. Use as "end of instance".
+        DoorOpen,
+        // id=object_id
+        DoorClose,
+        // id=object_id
+        ObjectiveStarted,
+        // id=objective_id
+        ObjectiveDone,
+        // id=objective_id
+
+        AgentUpdateAllegiance,
+        // id1 = agent model id, id2 = allegiance_bits
+        DoACompleteZone,
+        // id1 = second wchar of message (doa "id")
+        CountdownStart,
+        // id1 = mapid
+        DungeonReward,
+
+        Count
+    };
+
+    struct Event {
+        EventType type;
+        uint32_t id1 = 0;
+        uintptr_t id2 = 0;
+    };
+
+    [[nodiscard]] bool IsMessageEvent(EventType type);
+
+    // Whether an incoming event satisfies an objective's event. Messages compare up to the shorter of the two lengths,
+    // with a zero character in the objective's message as a wildcard; other events match unless a non-zero id differs.
+    [[nodiscard]] bool Match(EventType type, uint32_t id1, uintptr_t id2, const Event& event);
+
+    // Objective indices that have a start or end event of a given type, so an incoming event only runs Match on
+    // objectives that can match. Keyed by id1, or for ServerMessage/DisplayDialogue by the first two characters of the
+    // message (first_char << 16 | second_char), or just the first if the pattern is one character long or its second is
+    // a wildcard.
+    class DispatchTable {
+    public:
+        void Clear();
+        // Objectives have to be added in index order
+        void Add(uint32_t objective, const Event& event);
+        // Sorted and without duplicates; a superset of the objectives with an event that matches
+        void Candidates(EventType type, uint32_t id1, uintptr_t id2, std::vector<uint32_t>& out) const;
+
+    private:
+        struct EventIndex {
+            std::unordered_map<uint32_t, std::vector<uint32_t>> by_key;
+            std::unordered_map<uint32_t, std::vector<uint32_t>> by_first_char; // every keyed message pattern
+            std::vector<uint32_t> unkeyed; // messages whose first character is a wildcard
+            std::vector<uint32_t> all;
+        };
+        std::array<EventIndex, static_cast<size_t>(EventType::Count)> table;
+    };
+
+    // Starts/finishes the given objectives that match the event, visiting them in order as starting or finishing one
+    // completes the ones before it. Returns true if any objective was finished by one of its end events.
+    template <typename Objective>
+    bool Apply(std::span<Objective* const> objectives, std::span<const uint32_t> candidates, const EventType type,
+               const uint32_t id1, const uintptr_t id2)
+    {
+        const auto complete_previous = [&](const Objective& obj, const size_t i) {
+            size_t to_set_done_from = i - obj.starting_completes_n_previous_objectives;
+            if (obj.starting_completes_n_previous_objectives == -1) {
+                to_set_done_from = 0;
+            }
+            for (size_t j = to_set_done_from; j < i; ++j) {
+                Objective& other = *objectives[j];
+                if (!other.IsDone()) {
+                    other.SetDone();
+                }
+            }
+        };
+
+        bool just_set_something_done = false;
+        for (const size_t i : candidates) {
+            Objective& obj = *objectives[i];
+            if (obj.IsDone()) {
+                continue; // nothing to check
+            }
+
+            if (!obj.IsStarted()) {
+                for (const Event& event : obj.start_events) {
+                    if (Match(type, id1, id2, event)) {
+                        obj.SetStarted();
+                        complete_previous(obj, i);
+                        break;
+                    }
+                }
+            }
+
+            for (const Event& event : obj.end_events) {
+                if (Match(type, id1, id2, event)) {
+                    obj.SetDone();
+                    complete_previous(obj, i);
+                    just_set_something_done = true;
+                    break;
+                }
+            }
+        }
+        return just_set_something_done;
+    }
+}
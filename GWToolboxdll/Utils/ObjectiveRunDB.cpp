@@ -0,0 +1,325 @@
+#include "stdafx.h"
+
+#include <Utils/ObjectiveRunDB.h>
+
+namespace {
+    using namespace ObjectiveRunDB;
+
+    // Matches ObjectiveTimerWindow::Objective::Status::Completed
+    constexpr uint8_t SPLIT_STATUS_COMPLETED = 2;
+    constexpr uint32_t TIME_UNKNOWN = std::numeric_limits<uint32_t>::max();
+    // Rewrite the file on open once superseded records outnumber live ones (and there are at least this many)
+    constexpr size_t COMPACT_MIN_DEAD = 64;
+
+    struct IndexEntry {
+        uint64_t offset = 0; // of the RunRecord
+        RunRecord header;
+        std::string name;
+    };
+
+    std::map<uint32_t, IndexEntry> runs; // by utc_start
+    size_t dead_records = 0;
+    // run name + '\n' + objective name -> sorted done times of completed splits in finished runs
+    std::unordered_map<std::string, std::vector<uint32_t>> split_times;
+
+    std::filesystem::path db_path;
+    FILE* append_file = nullptr;
+    std::mutex db_mutex;
+
+    std::string StatsKey(const std::string_view run_name, const std::string_view objective_name)
+    {
+        std::string key;
+        key.reserve(run_name.size() + objective_name.size() + 1);
+        key.append(run_name);
+        key += '\n';
+        key.append(objective_name);
+        return key;
+    }
+
+    bool ParseSplits(const RunRecord& header, const std::string_view body, std::vector<Split>& out)
+    {
+        out.clear();
+        size_t offset = header.name_len;
+        for (uint16_t i = 0; i < header.split_count; i++) {
+            SplitRecord split_header;
+            if (offset + sizeof(split_header) > body.size()) {
+                return false;
+            }
+            memcpy(&split_header, body.data() + offset, sizeof(split_header));
+            offset += sizeof(split_header);
+            if (offset + split_header.name_len > body.size()) {
+                return false;
+            }
+            out.push_back({
+                split_header.start, split_header.done, split_header.duration, split_header.status, split_header.indent,
+                std::string(body.substr(offset, split_header.name_len))
+            });
+            offset += split_header.name_len;
+        }
+        return true;
+    }
+
+    std::string BuildBody(const Run& run, RunRecord& out_header)
+    {
+        std::string body;
+        const auto name_len = static_cast<uint16_t>(std::min<size_t>(run.name.size(), 0xffff));
+        body.append(run.name, 0, name_len);
+        const auto split_count = static_cast<uint16_t>(std::min<size_t>(run.splits.size(), 0xffff));
+        for (uint16_t i = 0; i < split_count; i++) {
+            const auto& split = run.splits[i];
+            const SplitRecord split_header = {
+                split.start, split.done, split.duration, split.status, split.indent,
+                static_cast<uint16_t>(std::min<size_t>(split.name.size(), 0xffff))
+            };
+            body.append(reinterpret_cast<const char*>(&split_header), sizeof(split_header));
+            body.append(split.name, 0, split_header.name_len);
+        }
+        out_header = {};
+        out_header.utc_start = run.utc_start;
+        out_header.instance_start = run.instance_start;
+        out_header.duration = run.duration;
+        out_header.flags = run.flags;
+        out_header.split_count = split_count;
+        out_header.name_len = name_len;
+        out_header.body_len = static_cast<uint32_t>(body.size());
+        return body;
+    }
+
+    void Index(const RunRecord& header, const uint64_t offset, const std::string_view body)
+    {
+        const auto found = runs.find(header.utc_start);
+        const bool counted = found != runs.end() && (found->second.header.flags & RunFlag_Finished);
+        if (found != runs.end()) {
+            dead_records++;
+        }
+        auto& entry = runs[header.utc_start];
+        entry.offset = offset;
+        entry.header = header;
+        entry.name = std::string(body.substr(0, header.name_len));
+        if (counted || !(header.flags & RunFlag_Finished)) {
+            return;
+        }
+        std::vector<Split> splits;
+        ParseSplits(header, body, splits);
+        for (const auto& split : splits) {
+            if (split.status != SPLIT_STATUS_COMPLETED || split.done == TIME_UNKNOWN) {
+                continue;
+            }
+            auto& times = split_times[StatsKey(entry.name, split.name)];
+            times.insert(std::ranges::upper_bound(times, split.done), split.done);
+        }
+    }
+
+    bool ReadBody(std::ifstream& in, const IndexEntry& entry, std::string& out)
+    {
+        out.resize(entry.header.body_len);
+        in.seekg(static_cast<std::streamoff>(entry.offset + sizeof(RunRecord)));
+        return static_cast<bool>(in.read(out.data(), out.size()));
+    }
+
+    // Rewrites the file with only the latest record for each run
+    bool Compact(const std::filesystem::path& path)
+    {
+        auto tmp_path = path;
+        tmp_path += L".tmp";
+        {
+            std::ifstream in(path, std::ios::binary);
+            std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+            if (!in.is_open() || !out.is_open()) {
+                return false;
+            }
+            constexpr FileHeader file_header;
+            out.write(reinterpret_cast<const char*>(&file_header), sizeof(file_header));
+            uint64_t offset = sizeof(file_header);
+            std::string body;
+            for (auto& entry : runs | std::views::values) {
+                if (!ReadBody(in, entry, body)) {
+                    return false;
+                }
+                out.write(reinterpret_cast<const char*>(&entry.header), sizeof(entry.header));
+                out.write(body.data(), body.size());
+                entry.offset = offset;
+                offset += sizeof(entry.header) + body.size();
+            }
+            if (!out.good()) {
+                return false;
+            }
+        }
+        dead_records = 0;
+        return MoveFileExW(tmp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+    }
+
+    // Returns false if the file is missing or isn't a run database. out_clean is false if the tail was truncated.
+    bool Scan(const std::filesystem::path& path, bool& out_clean)
+    {
+        out_clean = true;
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in.is_open()) {
+            return false;
+        }
+        const auto size = static_cast<uint64_t>(in.tellg());
+        in.seekg(0);
+        FileHeader file_header;
+        if (size < sizeof(file_header) || !in.read(reinterpret_cast<char*>(&file_header), sizeof(file_header))
+            || file_header.magic != FILE_MAGIC || file_header.version != FILE_VERSION) {
+            return false;
+        }
+        uint64_t offset = sizeof(file_header);
+        std::string body;
+        while (offset + sizeof(RunRecord) <= size) {
+            RunRecord header;
+            if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+                || offset + sizeof(header) + header.body_len > size) {
+                break;
+            }
+            body.resize(header.body_len);
+            if (!in.read(body.data(), body.size())) {
+                break;
+            }
+            Index(header, offset, body);
+            offset += sizeof(header) + header.body_len;
+        }
+        out_clean = offset == size;
+        return true;
+    }
+
+    void Reset()
+    {
+        if (append_file) {
+            fclose(append_file);
+            append_file = nullptr;
+        }
+        runs.clear();
+        split_times.clear();
+        dead_records = 0;
+        db_path.clear();
+    }
+}
+
+namespace ObjectiveRunDB {
+    bool Open(const std::filesystem::path& path, bool& out_created)
+    {
+        std::lock_guard lock(db_mutex);
+        Reset();
+        out_created = false;
+        bool clean = true;
+        if (!Scan(path, clean)) {
+            // Missing or unreadable; keep any unreadable file around before starting again
+            Reset();
+            std::error_code ec;
+            if (std::filesystem::exists(path, ec)) {
+                auto bad_path = path;
+                bad_path += std::format(L".{}.bad", time(nullptr));
+                Log::Error("Objective run history %s is unreadable; moving it to %s and starting a new one",
+                           path.filename().string().c_str(), bad_path.filename().string().c_str());
+                std::filesystem::rename(path, bad_path, ec);
+                if (ec) {
+                    Log::Log("ObjectiveRunDB: failed to move %s aside: %s\n", path.string().c_str(), ec.message().c_str());
+                    return false;
+                }
+            }
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            constexpr FileHeader file_header;
+            out.write(reinterpret_cast<const char*>(&file_header), sizeof(file_header));
+            if (!out.good()) {
+                return false;
+            }
+            out_created = true;
+        }
+        else if (!clean || (dead_records >= COMPACT_MIN_DEAD && dead_records > runs.size())) {
+            if (!Compact(path)) {
+                Log::Log("ObjectiveRunDB: failed to compact %s\n", path.string().c_str());
+                Reset();
+                return false;
+            }
+        }
+        if (_wfopen_s(&append_file, path.c_str(), L"ab") != 0 || !append_file) {
+            append_file = nullptr;
+            Reset();
+            return false;
+        }
+        db_path = path;
+        return true;
+    }
+
+    void Close()
+    {
+        std::lock_guard lock(db_mutex);
+        Reset();
+    }
+
+    bool IsOpen()
+    {
+        std::lock_guard lock(db_mutex);
+        return append_file != nullptr;
+    }
+
+    bool Append(const Run& run)
+    {
+        std::lock_guard lock(db_mutex);
+        if (!append_file) {
+            return false;
+        }
+        RunRecord header;
+        const auto body = BuildBody(run, header);
+        _fseeki64(append_file, 0, SEEK_END);
+        const auto offset = static_cast<uint64_t>(_ftelli64(append_file));
+        if (fwrite(&header, sizeof(header), 1, append_file) != 1
+            || fwrite(body.data(), 1, body.size(), append_file) != body.size()
+            || fflush(append_file) != 0) {
+            return false;
+        }
+        Index(header, offset, body);
+        return true;
+    }
+
+    bool Contains(const uint32_t utc_start)
+    {
+        std::lock_guard lock(db_mutex);
+        return runs.contains(utc_start);
+    }
+
+    void ListRuns(const uint32_t from_utc, const size_t max_runs, std::vector<RunInfo>& out)
+    {
+        out.clear();
+        std::lock_guard lock(db_mutex);
+        for (auto it = runs.rbegin(); it != runs.rend() && it->first >= from_utc && out.size() < max_runs; ++it) {
+            out.push_back({it->first, it->second.header.duration, it->second.header.flags, it->second.name});
+        }
+    }
+
+    bool ReadRun(const uint32_t utc_start, Run& out)
+    {
+        std::lock_guard lock(db_mutex);
+        const auto found = runs.find(utc_start);
+        if (found == runs.end()) {
+            return false;
+        }
+        const auto& entry = found->second;
+        std::ifstream in(db_path, std::ios::binary);
+        std::string body;
+        if (!in.is_open() || !ReadBody(in, entry, body)) {
+            return false;
+        }
+        out.utc_start = entry.header.utc_start;
+        out.instance_start = entry.header.instance_start;
+        out.duration = entry.header.duration;
+        out.flags = entry.header.flags;
+        out.name = entry.name;
+        return ParseSplits(entry.header, body, out.splits);
+    }
+
+    bool GetSplitStats(const std::string_view run_name, const std::string_view objective_name, SplitStats& out)
+    {
+        std::lock_guard lock(db_mutex);
+        const auto found = split_times.find(StatsKey(run_name, objective_name));
+        if (found == split_times.end() || found->second.empty()) {
+            return false;
+        }
+        const auto& times = found->second;
+        out.best = times.front();
+        out.median = times[times.size() / 2];
+        out.samples = static_cast<uint32_t>(times.size());
+        return true;
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+// Append-only store of objective timer runs, replacing the per-day JSON files.
+// File layout: FileHeader, then a stream of RunRecord headers each followed by body_len bytes: the run name, then
+// split_count SplitRecord headers each followed by the objective name.
+// A run saved again (e.g. while still in progress) is appended again; the last record for a utc_start wins.
+// Opening the file only reads run headers, plus the splits of finished runs to work out best/median split times.
+namespace ObjectiveRunDB {
+    constexpr uint32_t FILE_MAGIC = 0x4244524F; // "ORDB"
+    constexpr uint32_t FILE_VERSION = 1;
+
+    enum RunFlags : uint8_t {
+        RunFlag_Failed = 0x1,
+        RunFlag_Finished = 0x2 // No longer active when saved; only finished runs count towards split stats
+    };
+
+#pragma pack(push, 1)
+    struct FileHeader {
+        uint32_t magic = FILE_MAGIC;
+        uint32_t version = FILE_VERSION;
+    };
+
+    struct RunRecord {
+        uint32_t utc_start = 0;
+        uint32_t instance_start = 0;
+        uint32_t duration = 0;
+        uint8_t flags = 0;
+        uint8_t reserved = 0;
+        uint16_t split_count = 0;
+        uint16_t name_len = 0;
+        uint16_t reserved2 = 0;
+        uint32_t body_len = 0;
+    };
+
+    struct SplitRecord {
+        uint32_t start = 0;
+        uint32_t done = 0;
+        uint32_t duration = 0;
+        uint8_t status = 0;
+        uint8_t indent = 0;
+        uint16_t name_len = 0;
+    };
+#pragma pack(pop)
+    static_assert(sizeof(RunRecord) == 24);
+    static_assert(sizeof(SplitRecord) == 16);
+
+    struct Split {
+        uint32_t start = 0;
+        uint32_t done = 0; // ms since run start
+        uint32_t duration = 0;
+        uint8_t status = 0;
+        uint8_t indent = 0;
+        std::string name;
+    };
+
+    struct Run {
+        uint32_t utc_start = 0;
+        uint32_t instance_start = 0;
+        uint32_t duration = 0;
+        uint8_t flags = 0;
+        std::string name;
+        std::vector<Split> splits;
+    };
+
+    // What the run list needs without reading the splits
+    struct RunInfo {
+        uint32_t utc_start = 0;
+        uint32_t duration = 0;
+        uint8_t flags = 0;
+        std::string name;
+    };
+
+    struct SplitStats {
+        uint32_t best = 0;   // fastest done time across finished runs
+        uint32_t median = 0;
+        uint32_t samples = 0;
+    };
+
+    // Scans the file and builds the index, creating the file if needed. out_created is set if the file was missing or
+    // unreadable and has been started afresh, in which case the caller may want to import older runs.
+    bool Open(const std::filesystem::path& path, bool& out_created);
+    void Close();
+    [[nodiscard]] bool IsOpen();
+
+    bool Append(const Run& run);
+    [[nodiscard]] bool Contains(uint32_t utc_start);
+    // Runs started at or after from_utc, newest first
+    void ListRuns(uint32_t from_utc, size_t max_runs, std::vector<RunInfo>& out);
+    // Reads the splits for one run from disk
+    bool ReadRun(uint32_t utc_start, Run& out);
+    // Completed splits for this objective across finished runs with this name
+    bool GetSplitStats(std::string_view run_name, std::string_view objective_name, SplitStats& out);
+}
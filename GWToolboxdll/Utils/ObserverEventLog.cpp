@@ -0,0 +1,122 @@
+#include "stdafx.h"
+
+#include <Utils/ObserverEventLog.h>
+
+namespace {
+    // Wake the writer thread once this much is pending
+    constexpr size_t FLUSH_THRESHOLD = 0x10000;
+}
+
+namespace ObserverEventLog {
+    bool Writer::Open(const std::filesystem::path& path, const FileHeader& header)
+    {
+        Close();
+        if (_wfopen_s(&file, path.c_str(), L"wb") != 0 || !file) {
+            file = nullptr;
+            return false;
+        }
+        if (fwrite(&header, sizeof(header), 1, file) != 1) {
+            fclose(file);
+            file = nullptr;
+            return false;
+        }
+        stopping = false;
+        pending.reserve(FLUSH_THRESHOLD * 2);
+        writer = std::thread([this] {
+            WriterLoop();
+        });
+        return true;
+    }
+
+    void Writer::Append(const Event& event, const void* payload)
+    {
+        if (!file) {
+            return;
+        }
+        const auto event_bytes = reinterpret_cast<const uint8_t*>(&event);
+        std::unique_lock lock(mutex);
+        pending.insert(pending.end(), event_bytes, event_bytes + sizeof(event));
+        if (payload && event.payload_len) {
+            const auto payload_bytes = static_cast<const uint8_t*>(payload);
+            pending.insert(pending.end(), payload_bytes, payload_bytes + event.payload_len);
+        }
+        const bool should_flush = pending.size() >= FLUSH_THRESHOLD;
+        lock.unlock();
+        if (should_flush) {
+            cv.notify_one();
+        }
+    }
+
+    void Writer::Close()
+    {
+        if (!file) {
+            return;
+        }
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        cv.notify_one();
+        if (writer.joinable()) {
+            writer.join();
+        }
+        fclose(file);
+        file = nullptr;
+    }
+
+    void Writer::WriterLoop()
+    {
+        std::vector<uint8_t> writing;
+        writing.reserve(FLUSH_THRESHOLD * 2);
+        bool done = false;
+        while (!done) {
+            {
+                std::unique_lock lock(mutex);
+                // Flush at least once a second so a crash doesn't lose the whole match
+                cv.wait_for(lock, std::chrono::seconds(1), [this] {
+                    return stopping || pending.size() >= FLUSH_THRESHOLD;
+                });
+                std::swap(writing, pending);
+                done = stopping;
+            }
+            if (!writing.empty()) {
+                fwrite(writing.data(), 1, writing.size(), file);
+                writing.clear();
+            }
+        }
+        fflush(file);
+    }
+
+    bool Read(const std::filesystem::path& path, FileHeader& out_header, std::vector<uint8_t>& out_buffer, std::vector<const Event*>& out_events)
+    {
+        out_events.clear();
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in.is_open()) {
+            return false;
+        }
+        const auto size = static_cast<size_t>(in.tellg());
+        if (size < sizeof(FileHeader)) {
+            return false;
+        }
+        in.seekg(0);
+        out_buffer.resize(size);
+        if (!in.read(reinterpret_cast<char*>(out_buffer.data()), size)) {
+            return false;
+        }
+        memcpy(&out_header, out_buffer.data(), sizeof(out_header));
+        if (out_header.magic != FILE_MAGIC || out_header.version != FILE_VERSION) {
+            return false;
+        }
+        size_t offset = sizeof(FileHeader);
+        while (offset + sizeof(Event) <= size) {
+            const auto event = reinterpret_cast<const Event*>(out_buffer.data() + offset);
+            const size_t next = offset + sizeof(Event) + event->payload_len;
+            if (next > size) {
+                break; // truncated by a crash; keep what we have
+            }
+            out_events.push_back(event);
+            offset = next;
+        }
+        return true;
+    }
+}
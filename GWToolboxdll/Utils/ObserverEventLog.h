@@ -0,0 +1,79 @@
+#pragma once
+
+#include <condition_variable>
+
+// Append-only binary log of the packets ObserverModule reduces into stats.
+// File layout: FileHeader, then a stream of Event records, each followed by payload_len bytes of payload.
+namespace ObserverEventLog {
+    enum class EventType : uint8_t {
+        JumboMessage,       // a = type, b = value
+        AgentState,         // a = agent_id, b = state
+        AgentAdd,           // a = agent_id
+        ProjectileLaunched, // a = agent_id
+        GenericFloat,       // a = value_id, b = caster_id, c = target_id, value = float bits, flags = no_target
+        GenericValue,       // a = value_id, b = caster_id, c = target_id, value = uint32, flags = no_target
+        AgentSnapshot,      // a = agent_id, b = login_number, c = team_id | primary << 8 | secondary << 16, value = guild_id, flags = AgentFlags, payload = encoded name
+        PartyMember         // a = party_id, b = agent_id, c = party_index
+    };
+
+    enum AgentFlags : uint8_t {
+        AgentFlag_Player = 0x1,
+        AgentFlag_Npc = 0x2
+    };
+
+    constexpr uint32_t FILE_MAGIC = 0x4C424F54; // "TOBL"
+    constexpr uint32_t FILE_VERSION = 1;
+
+#pragma pack(push, 1)
+    struct FileHeader {
+        uint32_t magic = FILE_MAGIC;
+        uint32_t version = FILE_VERSION;
+        uint32_t map_id = 0;
+        uint32_t reserved = 0;
+        uint64_t started_at = 0; // unix time
+    };
+
+    struct Event {
+        uint32_t time_ms = 0; // instance time
+        EventType type{};
+        uint8_t flags = 0;
+        uint16_t payload_len = 0;
+        uint32_t a = 0;
+        uint32_t b = 0;
+        uint32_t c = 0;
+        uint32_t value = 0;
+    };
+#pragma pack(pop)
+    static_assert(sizeof(Event) == 24);
+
+    // Buffers events on the calling thread and writes them to disk from a background thread.
+    class Writer {
+    public:
+        Writer() = default;
+        Writer(const Writer&) = delete;
+        ~Writer() { Close(); }
+
+        bool Open(const std::filesystem::path& path, const FileHeader& header);
+        // Cheap; copies the event into the pending buffer
+        void Append(const Event& event, const void* payload = nullptr);
+        // Flushes pending events and joins the writer thread
+        void Close();
+        [[nodiscard]] bool IsOpen() const { return file != nullptr; }
+
+    private:
+        void WriterLoop();
+
+        FILE* file = nullptr;
+        std::thread writer;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<uint8_t> pending;
+        bool stopping = false;
+    };
+
+    // Read a whole log back; events point into out_buffer. Returns false if the file is missing or not a valid log.
+    bool Read(const std::filesystem::path& path, FileHeader& out_header, std::vector<uint8_t>& out_buffer, std::vector<const Event*>& out_events);
+
+    // Payload bytes following an event read via Read()
+    inline const void* Payload(const Event* event) { return event + 1; }
+}
@@ -0,0 +1,179 @@
+#include "stdafx.h"
+
+#include <Utils/PacketCapture.h>
+
+namespace {
+    // How often the writer thread drains the ring
+    constexpr auto DRAIN_INTERVAL = std::chrono::milliseconds(50);
+}
+
+namespace PacketCapture {
+    bool Writer::Open(const std::filesystem::path& path, const FileHeader& header, const std::vector<FieldTable>& field_tables)
+    {
+        Close();
+        if (_wfopen_s(&file, path.c_str(), L"wb") != 0 || !file) {
+            file = nullptr;
+            return false;
+        }
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+        for (const auto& fields : field_tables) {
+            const auto field_count = static_cast<uint32_t>(fields.size());
+            ok = ok && fwrite(&field_count, sizeof(field_count), 1, file) == 1;
+            ok = ok && (fields.empty() || fwrite(fields.data(), sizeof(uint32_t), fields.size(), file) == fields.size());
+        }
+        if (!ok) {
+            fclose(file);
+            file = nullptr;
+            return false;
+        }
+        if (!ring) {
+            ring = std::make_unique<uint8_t[]>(RING_SIZE);
+        }
+        drained.reserve(RING_SIZE);
+        head = 0;
+        tail = 0;
+        dropped = 0;
+        written = 0;
+        stopping = false;
+        writer = std::thread([this] {
+            WriterLoop();
+        });
+        std::lock_guard lock(append_mutex);
+        open = true;
+        return true;
+    }
+
+    void Writer::CopyIn(const size_t pos, const void* src, const size_t len)
+    {
+        const size_t offset = pos & (RING_SIZE - 1);
+        const size_t first = std::min(len, RING_SIZE - offset);
+        memcpy(ring.get() + offset, src, first);
+        if (first < len) {
+            memcpy(ring.get(), static_cast<const uint8_t*>(src) + first, len - first);
+        }
+    }
+
+    bool Writer::Append(const Record& record, const void* packet)
+    {
+        if (!open.load(std::memory_order_acquire)) {
+            return false;
+        }
+        // Uncontended unless Close() is running
+        std::lock_guard lock(append_mutex);
+        if (!open.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        const size_t len = sizeof(record) + record.size;
+        const size_t h = head.load(std::memory_order_relaxed);
+        const size_t t = tail.load(std::memory_order_acquire);
+        if (RING_SIZE - (h - t) < len) {
+            ++dropped;
+            return false;
+        }
+        CopyIn(h, &record, sizeof(record));
+        CopyIn(h + sizeof(record), packet, record.size);
+        // Publish the whole record at once so the consumer never sees half of it
+        head.store(h + len, std::memory_order_release);
+        return true;
+    }
+
+    size_t Writer::Drain()
+    {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        const size_t h = head.load(std::memory_order_acquire);
+        const size_t len = h - t;
+        if (!len) {
+            return 0;
+        }
+        const size_t offset = t & (RING_SIZE - 1);
+        const size_t first = std::min(len, RING_SIZE - offset);
+        drained.assign(ring.get() + offset, ring.get() + offset + first);
+        if (first < len) {
+            drained.insert(drained.end(), ring.get(), ring.get() + (len - first));
+        }
+        tail.store(h, std::memory_order_release);
+        fwrite(drained.data(), 1, drained.size(), file);
+        written += drained.size();
+        return len;
+    }
+
+    void Writer::Close()
+    {
+        {
+            // Once this is released no Append() is writing to the ring, and none will start
+            std::lock_guard lock(append_mutex);
+            open = false;
+        }
+        if (!file) {
+            return;
+        }
+        stopping = true;
+        if (writer.joinable()) {
+            writer.join();
+        }
+        fclose(file);
+        file = nullptr;
+    }
+
+    void Writer::WriterLoop()
+    {
+        while (!stopping) {
+            if (!Drain()) {
+                std::this_thread::sleep_for(DRAIN_INTERVAL);
+            }
+        }
+        // Whatever was published before Close() was called
+        Drain();
+        fflush(file);
+    }
+
+    bool Read(const std::filesystem::path& path, FileHeader& out_header, std::vector<FieldTable>& out_field_tables,
+              std::vector<uint8_t>& out_buffer, std::vector<const Record*>& out_records)
+    {
+        out_field_tables.clear();
+        out_records.clear();
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in.is_open()) {
+            return false;
+        }
+        const auto size = static_cast<size_t>(in.tellg());
+        if (size < sizeof(FileHeader)) {
+            return false;
+        }
+        in.seekg(0);
+        out_buffer.resize(size);
+        if (!in.read(reinterpret_cast<char*>(out_buffer.data()), size)) {
+            return false;
+        }
+        memcpy(&out_header, out_buffer.data(), sizeof(out_header));
+        if (out_header.magic != FILE_MAGIC || out_header.version != FILE_VERSION) {
+            return false;
+        }
+        size_t offset = sizeof(FileHeader);
+        out_field_tables.resize(out_header.handler_count);
+        for (auto& fields : out_field_tables) {
+            uint32_t field_count;
+            if (offset + sizeof(field_count) > size) {
+                return false;
+            }
+            memcpy(&field_count, out_buffer.data() + offset, sizeof(field_count));
+            offset += sizeof(field_count);
+            if (offset + static_cast<size_t>(field_count) * sizeof(uint32_t) > size) {
+                return false;
+            }
+            fields.resize(field_count);
+            memcpy(fields.data(), out_buffer.data() + offset, field_count * sizeof(uint32_t));
+            offset += field_count * sizeof(uint32_t);
+        }
+        while (offset + sizeof(Record) <= size) {
+            const auto record = reinterpret_cast<const Record*>(out_buffer.data() + offset);
+            const size_t next = offset + sizeof(Record) + record->size;
+            if (next > size) {
+                break; // truncated by a crash; keep what we have
+            }
+            out_records.push_back(record);
+            offset = next;
+        }
+        return true;
+    }
+}
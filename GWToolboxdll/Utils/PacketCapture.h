@@ -0,0 +1,75 @@
+#pragma once
+
+// Binary capture of raw StoC packets, written by PacketLoggerWindow.
+// File layout: FileHeader, then handler_count field tables (uint32_t field_count followed by field_count uint32_t fields),
+// then a stream of Record headers, each followed by size bytes of raw packet data (starting with the packet header).
+// The field tables are stored alongside the packets so a capture can be decoded without the game client that recorded it.
+namespace PacketCapture {
+    constexpr uint32_t FILE_MAGIC = 0x50435754; // "TWCP"
+    constexpr uint32_t FILE_VERSION = 1;
+
+#pragma pack(push, 1)
+    struct FileHeader {
+        uint32_t magic = FILE_MAGIC;
+        uint32_t version = FILE_VERSION;
+        uint32_t gw_version = 0;
+        uint32_t handler_count = 0;
+        uint64_t started_at = 0; // unix time
+    };
+
+    struct Record {
+        uint64_t local_time = 0;    // FILETIME, UTC
+        uint32_t instance_time = 0; // ms
+        uint32_t size = 0;          // bytes of packet data following this record
+    };
+#pragma pack(pop)
+    static_assert(sizeof(Record) == 16);
+
+    using FieldTable = std::vector<uint32_t>;
+
+    // Single producer, single consumer. Append() never allocates; the packet is copied into a ring buffer which a
+    // background thread drains to disk. Packets that don't fit are dropped and counted.
+    // Open() and Close() may be called from another thread than Append(); a mutex keeps Close() from pulling the file
+    // out from under an Append() in progress.
+    class Writer {
+    public:
+        Writer() = default;
+        Writer(const Writer&) = delete;
+        ~Writer() { Close(); }
+
+        bool Open(const std::filesystem::path& path, const FileHeader& header, const std::vector<FieldTable>& field_tables);
+        // Called from the packet hook only
+        bool Append(const Record& record, const void* packet);
+        // Drains the ring and joins the writer thread
+        void Close();
+        [[nodiscard]] bool IsOpen() const { return open.load(std::memory_order_acquire); }
+        [[nodiscard]] uint32_t DroppedCount() const { return dropped; }
+        [[nodiscard]] uint64_t BytesWritten() const { return written; }
+
+    private:
+        static constexpr size_t RING_SIZE = 0x400000; // must be a power of 2
+
+        void WriterLoop();
+        void CopyIn(size_t pos, const void* src, size_t len);
+        size_t Drain();
+
+        FILE* file = nullptr;
+        std::thread writer;
+        std::unique_ptr<uint8_t[]> ring;
+        std::vector<uint8_t> drained;
+        std::atomic<size_t> head = 0; // total bytes produced
+        std::atomic<size_t> tail = 0; // total bytes consumed
+        std::atomic<uint32_t> dropped = 0;
+        std::atomic<uint64_t> written = 0;
+        std::atomic<bool> stopping = false;
+        std::atomic<bool> open = false;
+        std::mutex append_mutex; // Held by Append(), and by Open()/Close() while changing open
+    };
+
+    // Read a whole capture back; records point into out_buffer. Returns false if the file is missing or not a valid capture.
+    bool Read(const std::filesystem::path& path, FileHeader& out_header, std::vector<FieldTable>& out_field_tables,
+              std::vector<uint8_t>& out_buffer, std::vector<const Record*>& out_records);
+
+    // Packet bytes following a record read via Read()
+    inline const uint8_t* Packet(const Record* record) { return reinterpret_cast<const uint8_t*>(record + 1); }
+}
@@ -0,0 +1,411 @@
+#include "stdafx.h"
+
+#include <Utils/PmapMesh.h>
+
+namespace {
+    using namespace PmapMesh;
+
+    // Relative tolerance when checking that the sides of two stacked trapezoids line up
+    constexpr float COLLINEAR_EPSILON = 1e-4f;
+    // How far apart (in game units) the sides of two neighbouring trapezoids may be and still count as one line
+    constexpr float SIDE_EPSILON = 0.05f;
+    // Sides are bucketed by the angle and distance from the origin of their line; neighbouring buckets are searched too
+    constexpr float SIDE_ANGLE_CELL = 0.02f;
+    constexpr float SIDE_DISTANCE_CELL = 2.f;
+    constexpr uint32_t FILE_MAGIC = 0x50414D50; // "PMAP"
+    static_assert(sizeof(Trapezoid) == 28);
+
+    uint64_t PointKey(const float x, const float y)
+    {
+        return static_cast<uint64_t>(std::bit_cast<uint32_t>(x)) << 32 | std::bit_cast<uint32_t>(y);
+    }
+
+    struct EdgeKey {
+        float y, x_left, x_right;
+        uint32_t plane;
+
+        bool operator==(const EdgeKey&) const = default;
+    };
+
+    struct EdgeKeyHash {
+        size_t operator()(const EdgeKey& key) const
+        {
+            size_t hash = std::hash<uint64_t>()(PointKey(key.y, key.x_left));
+            hash ^= std::hash<uint64_t>()(static_cast<uint64_t>(std::bit_cast<uint32_t>(key.x_right)) << 32 | key.plane) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            return hash;
+        }
+    };
+
+    EdgeKey TopEdge(const Trapezoid& t)
+    {
+        return {t.YT, t.XTL, t.XTR, t.plane};
+    }
+
+    EdgeKey BottomEdge(const Trapezoid& t)
+    {
+        return {t.YB, t.XBL, t.XBR, t.plane};
+    }
+
+    bool IsDegenerate(const Trapezoid& t)
+    {
+        return t.YT == t.YB || (t.XTL == t.XTR && t.XBL == t.XBR);
+    }
+
+    bool Collinear(const float x0, const float y0, const float x1, const float y1, const float x2, const float y2)
+    {
+        const float ax = x1 - x0, ay = y1 - y0;
+        const float bx = x2 - x0, by = y2 - y0;
+        const float cross = ax * by - ay * bx;
+        return std::abs(cross) <= COLLINEAR_EPSILON * std::sqrt((ax * ax + ay * ay) * (bx * bx + by * by));
+    }
+
+    // upper's bottom edge is already known to be lower's top edge. corner_uses counts the trapezoids with a corner at
+    // each point; the shared edge's corners must belong to just these two, or a neighbour's corner would be left
+    // halfway along the merged trapezoid's side.
+    bool CanMerge(const Trapezoid& upper, const Trapezoid& lower, const std::unordered_map<uint64_t, uint32_t>& corner_uses)
+    {
+        const auto only_shared = [&](const float x, const float y) {
+            const auto found = corner_uses.find(PointKey(x, y));
+            return found != corner_uses.end() && found->second == 2;
+        };
+        return Collinear(upper.XTL, upper.YT, upper.XBL, upper.YB, lower.XBL, lower.YB)
+               && Collinear(upper.XTR, upper.YT, upper.XBR, upper.YB, lower.XBR, lower.YB)
+               && only_shared(upper.XBL, upper.YB) && only_shared(upper.XBR, upper.YB);
+    }
+
+    std::unordered_map<uint64_t, uint32_t> CountCorners(const std::vector<Trapezoid>& trapezoids)
+    {
+        std::unordered_map<uint64_t, uint32_t> corner_uses;
+        corner_uses.reserve(trapezoids.size() * 2);
+        for (const auto& t : trapezoids) {
+            const uint64_t corners[] = {PointKey(t.XTL, t.YT), PointKey(t.XTR, t.YT), PointKey(t.XBL, t.YB), PointKey(t.XBR, t.YB)};
+            for (size_t i = 0; i < std::size(corners); i++) {
+                // A pointed end has both corners at the same point
+                if (std::find(corners, corners + i, corners[i]) == corners + i) {
+                    corner_uses[corners[i]]++;
+                }
+            }
+        }
+        return corner_uses;
+    }
+
+    class MeshWriter {
+    public:
+        explicit MeshWriter(Mesh& mesh)
+            : mesh(mesh) {}
+
+        uint32_t Vertex(const float x, const float y)
+        {
+            const auto [it, inserted] = vertex_index.emplace(PointKey(x, y), static_cast<uint32_t>(mesh.vertices.size()));
+            if (inserted) {
+                mesh.vertices.push_back({x, y});
+            }
+            return it->second;
+        }
+
+        void Triangle(const float x0, const float y0, const float x1, const float y1, const float x2, const float y2)
+        {
+            const auto a = Vertex(x0, y0);
+            const auto b = Vertex(x1, y1);
+            const auto c = Vertex(x2, y2);
+            if (a == b || b == c || a == c) {
+                return;
+            }
+            mesh.indices.insert(mesh.indices.end(), {a, b, c});
+        }
+
+        void Line(const float x0, const float y0, const float x1, const float y1)
+        {
+            const auto a = Vertex(x0, y0);
+            const auto b = Vertex(x1, y1);
+            if (a != b) {
+                mesh.indices.insert(mesh.indices.end(), {a, b});
+            }
+        }
+
+    private:
+        Mesh& mesh;
+        std::unordered_map<uint64_t, uint32_t> vertex_index;
+    };
+
+    void EmitTriangles(const std::vector<Trapezoid>& trapezoids, MeshWriter& writer)
+    {
+        for (const auto& t : trapezoids) {
+            // Same winding as PmapRenderer always used
+            writer.Triangle(t.XTL, t.YT, t.XTR, t.YT, t.XBL, t.YB);
+            writer.Triangle(t.XBL, t.YB, t.XTR, t.YT, t.XBR, t.YB);
+        }
+    }
+
+    // A left or right side of a trapezoid, from its lower y to its higher y
+    struct Side {
+        uint32_t plane;
+        float y0, x0;
+        float y1, x1;
+
+        [[nodiscard]] float XAt(const float y) const
+        {
+            if (y == y0) {
+                return x0;
+            }
+            if (y == y1) {
+                return x1;
+            }
+            return x0 + (x1 - x0) * (y - y0) / (y1 - y0);
+        }
+    };
+
+    Side MakeSide(const uint32_t plane, const float xt, const float yt, const float xb, const float yb)
+    {
+        return yt < yb ? Side{plane, yt, xt, yb, xb} : Side{plane, yb, xb, yt, xt};
+    }
+
+    // Buckets sides by plane and line so the ones lying on the same line can be found
+    class SideIndex {
+    public:
+        struct Key {
+            uint32_t plane;
+            int32_t angle;
+            int32_t distance;
+            bool operator==(const Key&) const = default;
+        };
+
+        static Key KeyOf(const Side& side)
+        {
+            const float dx = side.x1 - side.x0;
+            const float dy = side.y1 - side.y0; // always positive
+            const float length = std::sqrt(dx * dx + dy * dy);
+            const float distance = (side.x0 * dy - side.y0 * dx) / length;
+            return {
+                side.plane,
+                static_cast<int32_t>(std::floor(std::atan2(dx, dy) / SIDE_ANGLE_CELL)),
+                static_cast<int32_t>(std::floor(distance / SIDE_DISTANCE_CELL))
+            };
+        }
+
+        void Add(const Side& side, const uint32_t i) { buckets[KeyOf(side)].push_back(i); }
+
+        // Calls fn(i) for every side added in this bucket or the ones around it
+        template <typename Fn>
+        void ForEachNear(const Side& side, Fn&& fn) const
+        {
+            const auto key = KeyOf(side);
+            for (int32_t angle = key.angle - 1; angle <= key.angle + 1; angle++) {
+                for (int32_t distance = key.distance - 1; distance <= key.distance + 1; distance++) {
+                    const auto found = buckets.find({key.plane, angle, distance});
+                    if (found == buckets.end()) {
+                        continue;
+                    }
+                    for (const auto i : found->second) {
+                        fn(i);
+                    }
+                }
+            }
+        }
+
+    private:
+        struct KeyHash {
+            size_t operator()(const Key& key) const
+            {
+                size_t hash = std::hash<uint64_t>()(static_cast<uint64_t>(static_cast<uint32_t>(key.angle)) << 32 | static_cast<uint32_t>(key.distance));
+                hash ^= key.plane + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+                return hash;
+            }
+        };
+
+        std::unordered_map<Key, std::vector<uint32_t>, KeyHash> buckets;
+    };
+
+    // Emits the parts of each side that aren't covered by a side of the opposite kind lying on the same line
+    void EmitWalls(const std::vector<Side>& sides, const std::vector<Side>& opposite_sides, const SideIndex& opposite_index,
+                   MeshWriter& writer)
+    {
+        std::vector<std::pair<float, float>> covered;
+        for (const auto& side : sides) {
+            covered.clear();
+            opposite_index.ForEachNear(side, [&](const uint32_t i) {
+                const auto& other = opposite_sides[i];
+                const float lo = std::max(side.y0, other.y0);
+                const float hi = std::min(side.y1, other.y1);
+                if (hi <= lo || std::abs(side.XAt(lo) - other.XAt(lo)) > SIDE_EPSILON
+                    || std::abs(side.XAt(hi) - other.XAt(hi)) > SIDE_EPSILON) {
+                    return;
+                }
+                covered.emplace_back(lo, hi);
+            });
+            std::ranges::sort(covered);
+            float y = side.y0;
+            for (const auto& [lo, hi] : covered) {
+                if (lo > y) {
+                    writer.Line(side.XAt(y), y, side.XAt(lo), lo);
+                }
+                y = std::max(y, hi);
+            }
+            if (y < side.y1) {
+                writer.Line(side.XAt(y), y, side.x1, side.y1);
+            }
+        }
+    }
+
+    void EmitOutline(const std::vector<Trapezoid>& trapezoids, MeshWriter& writer)
+    {
+        // Sides are walls except where a trapezoid on the same plane is on the other side. Neighbours don't have to
+        // start and end at the same y, so each side is split into the stretches that nothing lines up with.
+        std::vector<Side> left_sides;
+        std::vector<Side> right_sides;
+        left_sides.reserve(trapezoids.size());
+        right_sides.reserve(trapezoids.size());
+        SideIndex left_index;
+        SideIndex right_index;
+        for (const auto& t : trapezoids) {
+            left_sides.push_back(MakeSide(t.plane, t.XTL, t.YT, t.XBL, t.YB));
+            left_index.Add(left_sides.back(), static_cast<uint32_t>(left_sides.size() - 1));
+            right_sides.push_back(MakeSide(t.plane, t.XTR, t.YT, t.XBR, t.YB));
+            right_index.Add(right_sides.back(), static_cast<uint32_t>(right_sides.size() - 1));
+        }
+        EmitWalls(left_sides, right_sides, right_index, writer);
+        EmitWalls(right_sides, left_sides, left_index, writer);
+
+        // Horizontal edges only partly overlap the ones on the other side, so walk each line and keep the parts
+        // that have a trapezoid on one side but not the other
+        struct Span {
+            uint32_t plane;
+            float y;
+            float x;
+            int top_delta;    // coverage change of top edges (trapezoid on one side)
+            int bottom_delta; // coverage change of bottom edges (trapezoid on the other side)
+        };
+        std::vector<Span> spans;
+        spans.reserve(trapezoids.size() * 4);
+        for (const auto& t : trapezoids) {
+            if (t.XTL != t.XTR) {
+                spans.push_back({t.plane, t.YT, std::min(t.XTL, t.XTR), 1, 0});
+                spans.push_back({t.plane, t.YT, std::max(t.XTL, t.XTR), -1, 0});
+            }
+            if (t.XBL != t.XBR) {
+                spans.push_back({t.plane, t.YB, std::min(t.XBL, t.XBR), 0, 1});
+                spans.push_back({t.plane, t.YB, std::max(t.XBL, t.XBR), 0, -1});
+            }
+        }
+        std::ranges::sort(spans, [](const Span& a, const Span& b) {
+            return std::tie(a.plane, a.y, a.x) < std::tie(b.plane, b.y, b.x);
+        });
+        int top = 0, bottom = 0;
+        float open_x = 0.f;
+        for (size_t i = 0; i < spans.size();) {
+            const auto& span = spans[i];
+            const bool was_boundary = (top > 0) != (bottom > 0);
+            // Apply every change at this x before deciding
+            size_t j = i;
+            for (; j < spans.size() && spans[j].plane == span.plane && spans[j].y == span.y && spans[j].x == span.x; j++) {
+                top += spans[j].top_delta;
+                bottom += spans[j].bottom_delta;
+            }
+            const bool is_boundary = (top > 0) != (bottom > 0);
+            // Every edge opens and closes on the same line, so coverage is back to zero at the end of each line
+            if (!was_boundary && is_boundary) {
+                open_x = span.x;
+            }
+            else if (was_boundary && !is_boundary) {
+                writer.Line(open_x, span.y, span.x, span.y);
+            }
+            i = j;
+        }
+    }
+}
+
+namespace PmapMesh {
+    void Simplify(std::vector<Trapezoid>& trapezoids)
+    {
+        std::erase_if(trapezoids, IsDegenerate);
+
+        const auto corner_uses = CountCorners(trapezoids);
+        std::unordered_multimap<EdgeKey, size_t, EdgeKeyHash> by_top_edge;
+        by_top_edge.reserve(trapezoids.size());
+        for (size_t i = 0; i < trapezoids.size(); i++) {
+            by_top_edge.emplace(TopEdge(trapezoids[i]), i);
+        }
+
+        std::vector<bool> merged(trapezoids.size(), false);
+        for (size_t i = 0; i < trapezoids.size(); i++) {
+            if (merged[i]) {
+                continue;
+            }
+            auto& upper = trapezoids[i];
+            // Keep absorbing the trapezoid below; one that has already grown downwards is absorbed whole
+            bool extended = true;
+            while (extended) {
+                extended = false;
+                const auto [first, last] = by_top_edge.equal_range(BottomEdge(upper));
+                for (auto it = first; it != last; ++it) {
+                    const auto j = it->second;
+                    if (j == i || merged[j] || !CanMerge(upper, trapezoids[j], corner_uses)) {
+                        continue;
+                    }
+                    const auto& lower = trapezoids[j];
+                    upper.XBL = lower.XBL;
+                    upper.XBR = lower.XBR;
+                    upper.YB = lower.YB;
+                    merged[j] = true;
+                    extended = true;
+                    break;
+                }
+            }
+        }
+
+        size_t kept = 0;
+        for (size_t i = 0; i < trapezoids.size(); i++) {
+            if (!merged[i]) {
+                trapezoids[kept++] = trapezoids[i];
+            }
+        }
+        trapezoids.resize(kept);
+    }
+
+    Mesh Build(std::vector<Trapezoid> trapezoids, const bool outline_only)
+    {
+        Mesh mesh;
+        mesh.lines = outline_only;
+        mesh.source_trapezoids = trapezoids.size();
+        MeshWriter writer(mesh);
+        if (outline_only) {
+            std::erase_if(trapezoids, IsDegenerate);
+            mesh.merged_trapezoids = trapezoids.size();
+            EmitOutline(trapezoids, writer);
+        }
+        else {
+            Simplify(trapezoids);
+            mesh.merged_trapezoids = trapezoids.size();
+            EmitTriangles(trapezoids, writer);
+        }
+        mesh.vertices.shrink_to_fit();
+        mesh.indices.shrink_to_fit();
+        return mesh;
+    }
+
+    bool WriteTrapezoids(const std::filesystem::path& path, const std::span<const Trapezoid> trapezoids)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        const uint32_t header[] = {FILE_MAGIC, static_cast<uint32_t>(trapezoids.size())};
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(trapezoids.data()), static_cast<std::streamsize>(trapezoids.size_bytes()));
+        return out.good();
+    }
+
+    bool ReadTrapezoids(const std::filesystem::path& path, std::vector<Trapezoid>& out)
+    {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in.is_open()) {
+            return false;
+        }
+        const auto size = static_cast<uint64_t>(in.tellg());
+        in.seekg(0);
+        uint32_t header[2];
+        if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != FILE_MAGIC
+            || size != sizeof(header) + static_cast<uint64_t>(header[1]) * sizeof(Trapezoid)) {
+            return false;
+        }
+        out.resize(header[1]);
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(out.size() * sizeof(Trapezoid))));
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <span>
+
+// Builds the minimap's pathing map geometry on the CPU, without touching the game or the device,
+// so it can run on a worker thread and be cached per map.
+// For filled maps, trapezoids stacked on top of each other with collinear sides are merged before emitting anything,
+// and vertices shared between trapezoids are only emitted once.
+namespace PmapMesh {
+    // Copy of the corners of a GW::PathingTrapezoid
+    struct Trapezoid {
+        float XTL, XTR, YT;
+        float XBL, XBR, YB;
+        uint32_t plane; // index of the GW::PathingMap it came from; only trapezoids on the same plane are merged
+    };
+
+    struct Vertex {
+        float x, y;
+    };
+
+    struct Mesh {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        bool lines = false; // index pairs for a line list rather than triangles
+        size_t source_trapezoids = 0;
+        size_t merged_trapezoids = 0;
+
+        [[nodiscard]] size_t PrimitiveCount() const { return indices.size() / (lines ? 2 : 3); }
+    };
+
+    // Merges stacked trapezoids on the same plane where the result is still a trapezoid, and where no other trapezoid
+    // has a corner on the edge being removed (that would leave a T-junction in the filled mesh)
+    void Simplify(std::vector<Trapezoid>& trapezoids);
+
+    // Filled triangles, or with outline_only the edges of the walkable area.
+    // Trapezoids are simplified first for the filled mesh. The outline is traced from the trapezoids as they are;
+    // a side only counts as a wall where no trapezoid on the same plane shares that stretch of the line.
+    Mesh Build(std::vector<Trapezoid> trapezoids, bool outline_only);
+
+    // Raw dump of a map's trapezoids, for looking at a map's geometry or benchmarking outside the game
+    bool WriteTrapezoids(const std::filesystem::path& path, std::span<const Trapezoid> trapezoids);
+    bool ReadTrapezoids(const std::filesystem::path& path, std::vector<Trapezoid>& out);
+}
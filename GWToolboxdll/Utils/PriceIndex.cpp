@@ -0,0 +1,73 @@
+#include "stdafx.h"
+
+#include <charconv>
+
+#include <nlohmann/json.hpp>
+
+#include <Utils/PriceIndex.h>
+
+bool PriceIndex::ParseModelId(const std::string_view str, uint32_t& model_id)
+{
+    const auto res = std::from_chars(str.data(), str.data() + str.size(), model_id);
+    return res.ec == std::errc() && res.ptr == str.data() + str.size();
+}
+
+// Identifiers are "model_id" for materials, or "model_id-mod_struct" with the mod struct as hex words for runes and mods
+void PriceIndex::AddIdentifier(const std::string_view identifier, const uint32_t price)
+{
+    const auto dash = identifier.find('-');
+    uint32_t model_id = 0;
+    if (!ParseModelId(identifier.substr(0, dash), model_id))
+        return;
+    if (dash == std::string_view::npos) {
+        entries.push_back({Key(model_id, 0), price});
+        return;
+    }
+    const auto mod_struct = identifier.substr(dash + 1);
+    for (size_t i = 0; i + 8 <= mod_struct.size(); i += 8) {
+        uint32_t mod = 0;
+        const auto res = std::from_chars(mod_struct.data() + i, mod_struct.data() + i + 8, mod, 16);
+        if (res.ec != std::errc() || res.ptr != mod_struct.data() + i + 8)
+            break;
+        if (mod)
+            entries.push_back({Key(model_id, mod), price});
+    }
+}
+
+std::shared_ptr<const PriceIndex> PriceIndex::Parse(const std::string_view trader_quotes_json)
+{
+    const auto prices_json = nlohmann::json::parse(trader_quotes_json, nullptr, false);
+    if (prices_json.is_discarded()) {
+        return nullptr;
+    }
+
+    const auto it_sell = prices_json.find("sell");
+    if (it_sell == prices_json.end() || !it_sell->is_object()) {
+        return nullptr;
+    }
+
+    auto index = std::make_shared<PriceIndex>();
+    for (auto it = it_sell->begin(); it != it_sell->end(); it++) {
+        if (!it->is_object())
+            continue;
+        const auto price_value = it->find("p");
+        if (!(price_value != it->end() && price_value->is_number_unsigned()))
+            continue;
+        index->AddIdentifier(it.key(), price_value->get<uint32_t>());
+    }
+    if (index->entries.empty())
+        return nullptr;
+    // The same rune can be listed under more than one identifier; keep one price per key
+    std::ranges::stable_sort(index->entries, {}, &Entry::key);
+    const auto dupes = std::ranges::unique(index->entries, {}, &Entry::key);
+    index->entries.erase(dupes.begin(), dupes.end());
+    index->entries.shrink_to_fit();
+    return index;
+}
+
+uint32_t PriceIndex::Find(const uint32_t model_id, const uint32_t mod) const
+{
+    const auto key = Key(model_id, mod);
+    const auto found = std::ranges::lower_bound(entries, key, {}, &Entry::key);
+    return found != entries.end() && found->key == key ? found->price : 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+// Trader sell prices from kamadan.gwtoolbox.com's trader_quotes, keyed by (model_id, mod), where mod is one 32 bit word
+// of a rune or mod's mod struct, or 0 for plain model ids. Built once per download and never modified after, so
+// readers only need a reference.
+class PriceIndex {
+public:
+    // Parses the "sell" quotes of a trader_quotes response; nullptr if there aren't any
+    static std::shared_ptr<const PriceIndex> Parse(std::string_view trader_quotes_json);
+
+    // Sell price in gold, or 0 if unknown
+    [[nodiscard]] uint32_t Find(uint32_t model_id, uint32_t mod = 0) const;
+    [[nodiscard]] size_t size() const { return entries.size(); }
+
+    // The model id at the start of an identifier ("model_id" or "model_id-mod_struct")
+    static bool ParseModelId(std::string_view str, uint32_t& model_id);
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint32_t price;
+    };
+
+    static constexpr uint64_t Key(const uint32_t model_id, const uint32_t mod) { return static_cast<uint64_t>(model_id) << 32 | mod; }
+    void AddIdentifier(std::string_view identifier, uint32_t price);
+
+    std::vector<Entry> entries; // Sorted by key
+};
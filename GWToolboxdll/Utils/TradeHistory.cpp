@@ -0,0 +1,387 @@
+#include "stdafx.h"
+
+#include <Modules/Resources.h>
+#include <Utils/TradeHistory.h>
+
+namespace {
+    using namespace TradeHistory;
+
+    constexpr uint32_t FILE_MAGIC = 0x48545754; // "TWTH"
+    constexpr uint32_t FILE_VERSION = 1;
+    // Kept in memory and in the log; older messages are dropped in batches
+    constexpr size_t MAX_ENTRIES = 100000;
+    constexpr size_t EVICT_BATCH = MAX_ENTRIES / 8;
+    // On load, the log is rewritten once it holds this many more messages than we keep
+    constexpr size_t COMPACT_SLACK = MAX_ENTRIES / 4;
+
+#pragma pack(push, 1)
+    struct FileHeader {
+        uint32_t magic = FILE_MAGIC;
+        uint32_t version = FILE_VERSION;
+    };
+
+    struct Record {
+        uint32_t timestamp = 0;
+        Channel channel{};
+        uint8_t name_len = 0;
+        uint16_t message_len = 0;
+    };
+#pragma pack(pop)
+    static_assert(sizeof(Record) == 8);
+
+    // Entries are numbered in the order they were added; entries[i] has id first_id + i.
+    // Posting lists hold ids in ascending order, so they are trimmed from the front when old entries are evicted.
+    std::deque<Entry> entries;
+    uint32_t first_id = 0;
+    std::unordered_map<std::string, std::vector<uint32_t>> postings;
+    std::unordered_set<uint64_t> seen;
+    // Messages that arrived while Load() was still reading the log
+    std::vector<Entry> added_while_loading;
+    bool loaded = false;
+    // Bumped by Load and Terminate, so a load that finishes after Terminate (or a later Load) is dropped
+    uint32_t load_generation = 0;
+
+    FILE* log_file = nullptr;
+    std::recursive_mutex history_mutex;
+
+    uint64_t EntryKey(const Channel channel, const uint32_t timestamp, const std::string_view name, const std::string_view message)
+    {
+        // FNV-1a
+        uint64_t hash = 0xcbf29ce484222325ull;
+        const auto mix = [&hash](const void* data, const size_t len) {
+            for (size_t i = 0; i < len; i++) {
+                hash ^= static_cast<const uint8_t*>(data)[i];
+                hash *= 0x100000001b3ull;
+            }
+        };
+        mix(&channel, sizeof(channel));
+        mix(&timestamp, sizeof(timestamp));
+        mix(name.data(), name.size());
+        mix("\0", 1);
+        mix(message.data(), message.size());
+        return hash;
+    }
+
+    bool IsWordChar(const char c)
+    {
+        // Bytes >= 0x80 are part of a UTF-8 sequence; treat them as letters
+        return isalpha(static_cast<unsigned char>(c)) || static_cast<unsigned char>(c) >= 0x80;
+    }
+
+    bool IsDigit(const char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    // Reads a price or quantity starting at text[i]: "1200", "1,200", "1.2k", "1k2", "15". Advances i.
+    std::string ReadNumber(const std::string_view text, size_t& i)
+    {
+        std::string int_part;
+        std::string frac_part;
+        while (i < text.size()) {
+            if (IsDigit(text[i])) {
+                int_part += text[i++];
+            }
+            else if (text[i] == ',' && i + 3 < text.size()
+                     && IsDigit(text[i + 1]) && IsDigit(text[i + 2]) && IsDigit(text[i + 3])
+                     && (i + 4 == text.size() || !IsDigit(text[i + 4]))) {
+                i++; // thousands separator
+            }
+            else {
+                break;
+            }
+        }
+        if (i + 1 < text.size() && text[i] == '.' && IsDigit(text[i + 1])) {
+            i++;
+            while (i < text.size() && IsDigit(text[i])) {
+                frac_part += text[i++];
+            }
+        }
+        const bool kilo = i < text.size() && (text[i] == 'k' || text[i] == 'K') && (i + 1 == text.size() || !IsWordChar(text[i + 1]));
+        if (!kilo || int_part.size() > 9) {
+            if (kilo) {
+                i++;
+            }
+            return frac_part.empty() ? int_part : int_part + "." + frac_part;
+        }
+        i++;
+        if (frac_part.empty()) {
+            // "1k2" means 1200
+            while (i < text.size() && IsDigit(text[i])) {
+                frac_part += text[i++];
+            }
+        }
+        frac_part.resize(3, '0');
+        return std::to_string(std::stoull(int_part) * 1000 + std::stoull(frac_part));
+    }
+
+    void IndexEntry(const uint32_t id, const Entry& entry, std::vector<std::string>& tokens)
+    {
+        Tokenize(entry.message, tokens);
+        std::ranges::sort(tokens);
+        const auto [last, end] = std::ranges::unique(tokens);
+        tokens.erase(last, end);
+        for (auto& token : tokens) {
+            postings[std::move(token)].push_back(id);
+        }
+    }
+
+    void EvictOldest(const size_t count)
+    {
+        for (size_t i = 0; i < count && !entries.empty(); i++) {
+            const auto& entry = entries.front();
+            seen.erase(EntryKey(entry.channel, entry.timestamp, entry.name, entry.message));
+            entries.pop_front();
+            first_id++;
+        }
+        for (auto it = postings.begin(); it != postings.end();) {
+            auto& ids = it->second;
+            ids.erase(ids.begin(), std::ranges::lower_bound(ids, first_id));
+            it = ids.empty() ? postings.erase(it) : std::next(it);
+        }
+    }
+
+    void WriteEntry(FILE* file, const Entry& entry)
+    {
+        const Record record = {
+            entry.timestamp,
+            entry.channel,
+            static_cast<uint8_t>(std::min<size_t>(entry.name.size(), 0xff)),
+            static_cast<uint16_t>(std::min<size_t>(entry.message.size(), 0xffff))
+        };
+        fwrite(&record, sizeof(record), 1, file);
+        fwrite(entry.name.data(), 1, record.name_len, file);
+        fwrite(entry.message.data(), 1, record.message_len, file);
+    }
+
+    // Adds to the in-memory index only
+    bool Insert(Entry&& entry, std::vector<std::string>& tokens)
+    {
+        if (!seen.insert(EntryKey(entry.channel, entry.timestamp, entry.name, entry.message)).second) {
+            return false;
+        }
+        if (entries.size() >= MAX_ENTRIES) {
+            EvictOldest(EVICT_BATCH);
+        }
+        const auto id = first_id + static_cast<uint32_t>(entries.size());
+        IndexEntry(id, entry, tokens);
+        entries.push_back(std::move(entry));
+        return true;
+    }
+
+    // Fills out with the newest MAX_ENTRIES messages. Returns false if the log is missing, invalid or has a truncated tail.
+    bool ReadLog(const std::filesystem::path& path, std::vector<Entry>& out, size_t& out_total)
+    {
+        out_total = 0;
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in.is_open()) {
+            return false;
+        }
+        const auto size = static_cast<size_t>(in.tellg());
+        std::vector<char> buffer(size);
+        in.seekg(0);
+        if (size < sizeof(FileHeader) || !in.read(buffer.data(), size)) {
+            return false;
+        }
+        FileHeader header;
+        memcpy(&header, buffer.data(), sizeof(header));
+        if (header.magic != FILE_MAGIC || header.version != FILE_VERSION) {
+            return false;
+        }
+        // First pass to count, so only the newest MAX_ENTRIES are copied out
+        std::vector<size_t> offsets;
+        size_t offset = sizeof(FileHeader);
+        while (offset + sizeof(Record) <= size) {
+            Record record;
+            memcpy(&record, buffer.data() + offset, sizeof(record));
+            const size_t next = offset + sizeof(Record) + record.name_len + record.message_len;
+            if (next > size) {
+                break; // truncated by a crash; keep what we have, but the log needs rewriting before we append to it
+            }
+            offsets.push_back(offset);
+            offset = next;
+        }
+        out_total = offsets.size();
+        const size_t skip = offsets.size() > MAX_ENTRIES ? offsets.size() - MAX_ENTRIES : 0;
+        out.reserve(offsets.size() - skip);
+        for (size_t i = skip; i < offsets.size(); i++) {
+            Record record;
+            memcpy(&record, buffer.data() + offsets[i], sizeof(record));
+            const char* data = buffer.data() + offsets[i] + sizeof(Record);
+            out.push_back({record.timestamp, record.channel, std::string(data, record.name_len), std::string(data + record.name_len, record.message_len)});
+        }
+        return offset == size;
+    }
+
+    bool RewriteLog(const std::filesystem::path& path)
+    {
+        auto tmp_path = path;
+        tmp_path += L".tmp";
+        FILE* file = nullptr;
+        if (_wfopen_s(&file, tmp_path.c_str(), L"wb") != 0 || !file) {
+            return false;
+        }
+        constexpr FileHeader header;
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+        for (const auto& entry : entries) {
+            WriteEntry(file, entry);
+        }
+        ok = ok && !ferror(file);
+        fclose(file);
+        return ok && MoveFileExW(tmp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+    }
+
+    void LoadOnWorker(const std::filesystem::path& path, const uint32_t generation)
+    {
+        // Parse outside of the lock; this is the slow part
+        std::vector<Entry> from_disk;
+        size_t total_on_disk = 0;
+        const bool valid = ReadLog(path, from_disk, total_on_disk);
+
+        std::lock_guard lock(history_mutex);
+        if (loaded || generation != load_generation) {
+            return;
+        }
+        std::vector<std::string> tokens;
+        for (auto& entry : from_disk) {
+            Insert(std::move(entry), tokens);
+        }
+        std::vector<Entry> while_loading;
+        while_loading.swap(added_while_loading);
+        loaded = true;
+
+        if (!valid || total_on_disk > MAX_ENTRIES + COMPACT_SLACK) {
+            // Missing, truncated or overgrown: start the log again from what's in memory
+            if (!RewriteLog(path)) {
+                Log::Log("TradeHistory: failed to rewrite %s\n", path.string().c_str());
+            }
+        }
+        if (_wfopen_s(&log_file, path.c_str(), L"ab") != 0) {
+            log_file = nullptr;
+        }
+        for (const auto& entry : while_loading) {
+            Add(entry.channel, entry.timestamp, entry.name, entry.message);
+        }
+    }
+}
+
+namespace TradeHistory {
+    void Load(const std::filesystem::path& path)
+    {
+        uint32_t generation;
+        {
+            std::lock_guard lock(history_mutex);
+            generation = ++load_generation;
+        }
+        Resources::EnqueueWorkerTask([path, generation] {
+            LoadOnWorker(path, generation);
+        });
+    }
+
+    void Terminate()
+    {
+        std::lock_guard lock(history_mutex);
+        load_generation++;
+        if (log_file) {
+            fclose(log_file);
+            log_file = nullptr;
+        }
+        entries.clear();
+        first_id = 0;
+        postings.clear();
+        seen.clear();
+        added_while_loading.clear();
+        loaded = false;
+    }
+
+    void Add(const Channel channel, const uint32_t timestamp, const std::string& name, const std::string& message)
+    {
+        std::lock_guard lock(history_mutex);
+        if (!loaded) {
+            added_while_loading.push_back({timestamp, channel, name, message});
+            return;
+        }
+        static std::vector<std::string> tokens;
+        if (!Insert({timestamp, channel, name, message}, tokens)) {
+            return;
+        }
+        if (log_file) {
+            WriteEntry(log_file, entries.back());
+        }
+    }
+
+    size_t Search(const Channel channel, const std::string_view query, const size_t max_results, std::vector<Entry>& out)
+    {
+        out.clear();
+        std::vector<std::string> tokens;
+        Tokenize(query, tokens);
+        if (tokens.empty()) {
+            return 0;
+        }
+        std::lock_guard lock(history_mutex);
+        std::vector<const std::vector<uint32_t>*> lists;
+        for (const auto& token : tokens) {
+            const auto found = postings.find(token);
+            if (found == postings.end()) {
+                return 0;
+            }
+            lists.push_back(&found->second);
+        }
+        // Walk the shortest list newest first, checking membership in the others
+        std::ranges::sort(lists, {}, [](const std::vector<uint32_t>* ids) { return ids->size(); });
+        const auto& shortest = *lists.front();
+        for (auto it = shortest.rbegin(); it != shortest.rend() && out.size() < max_results; ++it) {
+            const uint32_t id = *it;
+            const bool in_all = std::all_of(lists.begin() + 1, lists.end(), [id](const std::vector<uint32_t>* ids) {
+                return std::ranges::binary_search(*ids, id);
+            });
+            if (!in_all) {
+                continue;
+            }
+            const auto& entry = entries[id - first_id];
+            if (entry.channel == channel) {
+                out.push_back(entry);
+            }
+        }
+        // Ids are in arrival order; older messages can arrive late via search results
+        std::ranges::stable_sort(out, std::greater{}, &Entry::timestamp);
+        return out.size();
+    }
+
+    size_t Size()
+    {
+        std::lock_guard lock(history_mutex);
+        return entries.size();
+    }
+
+    void Tokenize(const std::string_view text, std::vector<std::string>& out)
+    {
+        out.clear();
+        size_t i = 0;
+        while (i < text.size()) {
+            if (IsDigit(text[i])) {
+                auto number = ReadNumber(text, i);
+                if (!number.empty()) {
+                    out.push_back(std::move(number));
+                }
+                continue;
+            }
+            if (!IsWordChar(text[i])) {
+                i++;
+                continue;
+            }
+            std::string word;
+            while (i < text.size() && (IsWordChar(text[i]) || IsDigit(text[i]))) {
+                word += static_cast<char>(tolower(static_cast<unsigned char>(text[i++])));
+            }
+            if (word.size() < 2) {
+                continue;
+            }
+            // Crude plural folding so "ectos" finds "ecto"; "glass" is left alone
+            if (word.size() > 3 && word.back() == 's' && word[word.size() - 2] != 's') {
+                word.pop_back();
+            }
+            out.push_back(std::move(word));
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+// Local, bounded history of trade chat messages received from the trade feeds.
+// Messages are appended to a log on disk and indexed by normalised token (lower case words, prices like "1.2k" -> "1200"),
+// so searches are answered locally without a round trip to the server, including when offline.
+// File layout: FileHeader, then a stream of Record headers each followed by name_len + message_len bytes of UTF-8.
+namespace TradeHistory {
+    enum class Channel : uint8_t {
+        Kamadan,
+        Ascalon
+    };
+
+    struct Entry {
+        uint32_t timestamp = 0; // unix time
+        Channel channel = Channel::Kamadan;
+        std::string name;
+        std::string message;
+    };
+
+    // Reads the log and builds the index on a worker thread. Messages added before this finishes are kept.
+    void Load(const std::filesystem::path& path);
+    // Closes the log and frees the index. A Load still in progress is abandoned.
+    void Terminate();
+
+    // Indexes the message and appends it to the log. Duplicates (e.g. a message seen live, then again in search results) are ignored.
+    void Add(Channel channel, uint32_t timestamp, const std::string& name, const std::string& message);
+    // Newest first. Every token in the query has to appear in the message. Returns the number of results.
+    size_t Search(Channel channel, std::string_view query, size_t max_results, std::vector<Entry>& out);
+    [[nodiscard]] size_t Size();
+
+    // The normalisation applied to both messages and queries
+    void Tokenize(std::string_view text, std::vector<std::string>& out);
+}
@@ -0,0 +1,402 @@
+#include "stdafx.h"
+
+#include <Logger.h>
+#include <Utils/WebSocketFeeds.h>
+
+using easywsclient::WebSocket;
+using nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    constexpr auto INITIAL_BACKOFF = std::chrono::seconds(5);
+    constexpr auto MAX_BACKOFF = std::chrono::seconds(60);
+    // Upper bound on how long the thread sleeps when no socket is open; Connect()/Send()/Close() wake it earlier
+    constexpr auto IDLE_WAIT = std::chrono::seconds(1);
+    // Total time spent blocked in select() per loop when sockets are open; bounds Send() latency
+    constexpr int POLL_BUDGET_MS = 100;
+    constexpr auto CLOSE_TIMEOUT = std::chrono::seconds(2);
+}
+
+namespace WebSocketFeeds {
+    struct FeedState {
+        // Guards the request fields below; set by the UI thread, read by the network thread
+        std::mutex mutex;
+        std::string url;
+        bool wanted = false;
+        bool released = false;
+        bool reconnect_now = false;
+        std::vector<std::string> outgoing;
+        std::vector<std::string> search_terms;
+
+        std::atomic<Status> status = Status::Disconnected;
+        std::atomic<uint32_t> dropped = 0;
+        SpscQueue<Event, 256> events;
+
+        // Network thread only
+        WebSocket* ws = nullptr;
+        std::string connected_url;
+        Clock::time_point next_attempt{};
+        Clock::duration backoff{};
+    };
+}
+
+namespace {
+    using namespace WebSocketFeeds;
+
+    std::mutex feeds_mutex;
+    std::condition_variable feeds_cv;
+    std::vector<std::shared_ptr<FeedState>> feeds;
+    std::thread network_thread;
+    bool network_running = false;
+
+    void Wake()
+    {
+        std::lock_guard lock(feeds_mutex);
+        feeds_cv.notify_all();
+    }
+
+    void PushEvent(FeedState& feed, Event&& event)
+    {
+        if (!feed.events.Push(std::move(event))) {
+            ++feed.dropped;
+        }
+    }
+
+    bool ParseMessage(const json& js, ChatMessage& msg)
+    {
+        if (!(js.is_object() && js.contains("s") && js["s"].is_string() && js.contains("m") && js["m"].is_string() && js.contains("t"))) {
+            return false;
+        }
+        unsigned long long timestamp_ull = 0ull;
+        if (js["t"].is_string()) {
+            timestamp_ull = strtoull(js["t"].get_ref<const std::string&>().c_str(), nullptr, 10);
+        }
+        else if (js["t"].is_number_unsigned()) {
+            timestamp_ull = js["t"].get<uint64_t>();
+        }
+        if (timestamp_ull == 0ull) {
+            return false;
+        }
+        msg.name = js["s"].get<std::string>();
+        msg.message = js["m"].get<std::string>();
+        msg.timestamp = static_cast<uint32_t>(timestamp_ull / 1000);
+        return true;
+    }
+
+    bool MatchesSearch(const std::string& message, const std::vector<std::string>& lower_terms)
+    {
+        if (lower_terms.empty()) {
+            return true;
+        }
+        std::string input(message);
+        std::ranges::transform(input, input.begin(), [](const char c) -> char {
+            return static_cast<char>(tolower(c));
+        });
+        return std::ranges::all_of(lower_terms, [&input](const std::string& term) {
+            return input.find(term) != std::string::npos;
+        });
+    }
+
+    void OnFrame(FeedState& feed, const std::string& data, const std::vector<std::string>& search_terms)
+    {
+        const json res = json::parse(data, nullptr, false);
+        if (res.is_discarded()) {
+            Log::Log("ERROR: Failed to parse JSON from %s\n", feed.connected_url.c_str());
+            return;
+        }
+        Event event;
+        if (res.is_object() && res.contains("query") && res["query"].is_string()) {
+            event.type = Event::Type::SearchResults;
+            event.query = res["query"].get<std::string>();
+            if (res.contains("results") && res["results"].is_array()) {
+                const auto& results = res["results"];
+                event.messages.reserve(results.size());
+                for (const auto& result : results) {
+                    ChatMessage msg;
+                    if (ParseMessage(result, msg)) {
+                        event.messages.push_back(std::move(msg));
+                    }
+                }
+            }
+            else {
+                Log::Log("ERROR: Failed to parse search results from %s\n", feed.connected_url.c_str());
+            }
+            PushEvent(feed, std::move(event));
+            return;
+        }
+        event.messages.resize(1);
+        if (!ParseMessage(res, event.messages[0])) {
+            return; // Not valid message object
+        }
+        event.matches_search = MatchesSearch(event.messages[0].message, search_terms);
+        PushEvent(feed, std::move(event));
+    }
+
+    void ScheduleRetry(FeedState& feed)
+    {
+        feed.backoff = feed.backoff.count() ? std::min<Clock::duration>(feed.backoff * 2, MAX_BACKOFF) : INITIAL_BACKOFF;
+        feed.next_attempt = Clock::now() + feed.backoff;
+    }
+
+    // Graceful close; bounded so a dead peer can't hold up shutdown
+    void CloseSocket(FeedState& feed)
+    {
+        if (!feed.ws) {
+            return;
+        }
+        if (feed.ws->getReadyState() == WebSocket::OPEN) {
+            feed.ws->close();
+        }
+        const auto deadline = Clock::now() + CLOSE_TIMEOUT;
+        while (feed.ws->getReadyState() != WebSocket::CLOSED && Clock::now() < deadline) {
+            feed.ws->poll(50);
+        }
+        delete feed.ws;
+        feed.ws = nullptr;
+        feed.connected_url.clear();
+        feed.status = Status::Disconnected;
+        PushEvent(feed, {Event::Type::Disconnected});
+    }
+
+    // Returns true if the feed has an open socket that was polled
+    bool Service(FeedState& feed, const int poll_timeout_ms, Clock::time_point& wake_at)
+    {
+        std::string url;
+        bool wanted;
+        bool released;
+        bool reconnect_now;
+        std::vector<std::string> outgoing;
+        std::vector<std::string> search_terms;
+        {
+            std::lock_guard lock(feed.mutex);
+            url = feed.url;
+            wanted = feed.wanted;
+            released = feed.released;
+            reconnect_now = std::exchange(feed.reconnect_now, false);
+            search_terms = feed.search_terms;
+            if (feed.ws) {
+                outgoing.swap(feed.outgoing);
+            }
+        }
+        if (feed.ws && (released || !wanted || url != feed.connected_url)) {
+            const bool switching_host = wanted && !released;
+            CloseSocket(feed);
+            if (switching_host) {
+                feed.backoff = {};
+                feed.next_attempt = {};
+            }
+        }
+        if (released) {
+            return false;
+        }
+        if (!feed.ws) {
+            if (!wanted) {
+                feed.backoff = {};
+                feed.next_attempt = {};
+                return false;
+            }
+            if (reconnect_now) {
+                feed.next_attempt = {};
+            }
+            if (Clock::now() < feed.next_attempt) {
+                wake_at = std::min(wake_at, feed.next_attempt);
+                return false;
+            }
+            feed.status = Status::Connecting;
+            feed.ws = WebSocket::from_url(url);
+            if (!feed.ws) {
+                Log::Log("Couldn't connect to the host '%s'\n", url.c_str());
+                feed.status = Status::Disconnected;
+                ScheduleRetry(feed);
+                wake_at = std::min(wake_at, feed.next_attempt);
+                return false;
+            }
+            feed.connected_url = url;
+            feed.backoff = {};
+            feed.status = Status::Open;
+            PushEvent(feed, {Event::Type::Connected});
+        }
+        for (const auto& text : outgoing) {
+            feed.ws->send(text);
+        }
+        feed.ws->poll(poll_timeout_ms);
+        feed.ws->dispatch([&feed, &search_terms](const std::string& data) {
+            OnFrame(feed, data, search_terms);
+        });
+        if (feed.ws->getReadyState() == WebSocket::CLOSED) {
+            // Dropped by the server
+            CloseSocket(feed);
+            ScheduleRetry(feed);
+            return false;
+        }
+        return true;
+    }
+
+    void NetworkLoop()
+    {
+        WSAData wsa_data{};
+        if (const int res = WSAStartup(MAKEWORD(2, 2), &wsa_data); res != 0) {
+            Log::Log("Failed to call WSAStartup: %d\n", res);
+        }
+        size_t open_sockets = 0;
+        while (true) {
+            std::vector<std::shared_ptr<FeedState>> snapshot;
+            {
+                std::lock_guard lock(feeds_mutex);
+                // Released feeds have had their socket closed by the previous pass
+                const auto removed = std::erase_if(feeds, [](const std::shared_ptr<FeedState>& feed) {
+                    std::lock_guard feed_lock(feed->mutex);
+                    return feed->released && !feed->ws;
+                });
+                if (removed) {
+                    feeds_cv.notify_all();
+                }
+                if (feeds.empty()) {
+                    network_running = false;
+                    break;
+                }
+                snapshot = feeds;
+            }
+            // Spread the select() budget over the open sockets so one busy loop covers all of them
+            const int poll_timeout_ms = POLL_BUDGET_MS / static_cast<int>(std::max<size_t>(open_sockets, 1));
+            auto wake_at = Clock::now() + IDLE_WAIT;
+            open_sockets = 0;
+            for (const auto& feed : snapshot) {
+                if (Service(*feed, poll_timeout_ms, wake_at)) {
+                    open_sockets++;
+                }
+            }
+            if (!open_sockets) {
+                std::unique_lock lock(feeds_mutex);
+                feeds_cv.wait_until(lock, wake_at);
+            }
+        }
+        WSACleanup();
+    }
+
+    void Register(const std::shared_ptr<FeedState>& state)
+    {
+        std::lock_guard lock(feeds_mutex);
+        if (std::ranges::find(feeds, state) == feeds.end()) {
+            feeds.push_back(state);
+        }
+        if (!network_running) {
+            // A previous thread has already left its loop; reap it before starting a new one
+            if (network_thread.joinable()) {
+                network_thread.join();
+            }
+            network_running = true;
+            network_thread = std::thread(NetworkLoop);
+        }
+        feeds_cv.notify_all();
+    }
+}
+
+namespace WebSocketFeeds {
+    void Feed::Connect(const char* url)
+    {
+        if (!state) {
+            state = std::make_shared<FeedState>();
+        }
+        {
+            std::lock_guard lock(state->mutex);
+            if (state->wanted && state->url == url) {
+                return;
+            }
+            state->url = url;
+            state->wanted = true;
+        }
+        Register(state);
+    }
+
+    void Feed::Disconnect()
+    {
+        if (!state) {
+            return;
+        }
+        {
+            std::lock_guard lock(state->mutex);
+            if (!state->wanted) {
+                return;
+            }
+            state->wanted = false;
+            state->outgoing.clear();
+        }
+        Wake();
+    }
+
+    void Feed::Reconnect()
+    {
+        if (!state) {
+            return;
+        }
+        {
+            std::lock_guard lock(state->mutex);
+            state->reconnect_now = true;
+        }
+        Wake();
+    }
+
+    void Feed::Close()
+    {
+        if (!state) {
+            return;
+        }
+        {
+            std::lock_guard lock(state->mutex);
+            state->released = true;
+            state->wanted = false;
+        }
+        std::thread finished;
+        {
+            std::unique_lock lock(feeds_mutex);
+            feeds_cv.notify_all();
+            feeds_cv.wait(lock, [this] {
+                return std::ranges::find(feeds, state) == feeds.end();
+            });
+            if (!network_running && network_thread.joinable()) {
+                finished = std::move(network_thread);
+            }
+        }
+        if (finished.joinable()) {
+            finished.join();
+        }
+        state.reset();
+    }
+
+    void Feed::Send(std::string text)
+    {
+        if (!state) {
+            return;
+        }
+        {
+            std::lock_guard lock(state->mutex);
+            state->outgoing.push_back(std::move(text));
+        }
+        Wake();
+    }
+
+    void Feed::SetSearchTerms(const std::vector<std::string>& lower_terms)
+    {
+        if (!state) {
+            return;
+        }
+        std::lock_guard lock(state->mutex);
+        state->search_terms = lower_terms;
+    }
+
+    bool Feed::Poll(Event& out)
+    {
+        return state && state->events.Pop(out);
+    }
+
+    Status Feed::GetStatus() const
+    {
+        return state ? state->status.load() : Status::Disconnected;
+    }
+
+    uint32_t Feed::DroppedCount() const
+    {
+        return state ? state->dropped.load() : 0;
+    }
+}
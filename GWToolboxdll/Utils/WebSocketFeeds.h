@@ -0,0 +1,96 @@
+#pragma once
+
+// Shared background networking for the toolbox websocket feeds (trade chat, party search).
+// One thread owns every socket: it connects with backoff, blocks on the sockets instead of being polled each frame,
+// parses JSON and applies the search filter off the render thread. The UI thread only drains ready-made events.
+namespace WebSocketFeeds {
+    // Single producer, single consumer ring; Push() and Pop() never block or allocate.
+    template <typename T, size_t Capacity>
+    class SpscQueue {
+        static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+    public:
+        bool Push(T&& item)
+        {
+            const size_t h = head.load(std::memory_order_relaxed);
+            if (h - tail.load(std::memory_order_acquire) == Capacity) {
+                return false;
+            }
+            items[h & (Capacity - 1)] = std::move(item);
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool Pop(T& out)
+        {
+            const size_t t = tail.load(std::memory_order_relaxed);
+            if (t == head.load(std::memory_order_acquire)) {
+                return false;
+            }
+            out = std::move(items[t & (Capacity - 1)]);
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        std::array<T, Capacity> items{};
+        std::atomic<size_t> head = 0;
+        std::atomic<size_t> tail = 0;
+    };
+
+    struct ChatMessage {
+        uint32_t timestamp = 0;
+        std::string name;
+        std::string message;
+    };
+
+    struct Event {
+        enum class Type : uint8_t {
+            Message,       // messages[0] is a live message
+            SearchResults, // reply to a {"query": ...} request; messages are newest first, empty if nothing was found
+            Connected,
+            Disconnected
+        } type = Type::Message;
+        std::vector<ChatMessage> messages;
+        std::string query;
+        // Live messages only: true if the message contains every search term
+        bool matches_search = true;
+    };
+
+    enum class Status : uint8_t {
+        Disconnected,
+        Connecting,
+        Open
+    };
+
+    struct FeedState;
+
+    // A websocket owned by the shared network thread. All methods are called from the UI thread.
+    class Feed {
+    public:
+        Feed() = default;
+        Feed(const Feed&) = delete;
+        ~Feed() { Close(); }
+
+        // Keep a connection to url open, reconnecting with backoff; switches host if url changed.
+        void Connect(const char* url);
+        // Close the socket but keep the feed; cheap to call every frame.
+        void Disconnect();
+        // Skip the current backoff and try to connect straight away.
+        void Reconnect();
+        // Release the feed, waiting for the network thread to close the socket.
+        void Close();
+
+        // Queued until the socket is open
+        void Send(std::string text);
+        // Lower case terms; live messages are flagged with whether they contain all of them
+        void SetSearchTerms(const std::vector<std::string>& lower_terms);
+        bool Poll(Event& out);
+        [[nodiscard]] Status GetStatus() const;
+        // Events thrown away because the UI thread wasn't draining the queue
+        [[nodiscard]] uint32_t DroppedCount() const;
+
+    private:
+        std::shared_ptr<FeedState> state;
+    };
+}
@@ -27,6 +27,7 @@
 #include "GWToolbox.h"
 
 constexpr auto AGENTCOLOR_INIFILENAME = L"AgentColors.ini";
+static_assert(sizeof(ShapeBatch::Vertex) == sizeof(D3DVertex), "ShapeBatch writes straight into the vertex buffer");
 
 namespace {
 
@@ -487,6 +488,15 @@ void AgentRenderer::DrawSettings()
     }
 }
 
+void AgentRenderer::Invalidate()
+{
+    VBuffer::Invalidate();
+    if (index_buffer) {
+        index_buffer->Release();
+    }
+    index_buffer = nullptr;
+}
+
 void AgentRenderer::Terminate()
 {
     VBuffer::Terminate();
@@ -573,11 +583,13 @@ AgentRenderer::AgentRenderer()
         shapes[Star].AddVertex(0.0f, 0.0f, CircleCenter);
     }
 
-    max_shape_verts = 0;
-    for (int shape = 0; shape < shape_size; ++shape) {
-        if (max_shape_verts < shapes[shape].vertices.size()) {
-            max_shape_verts = shapes[shape].vertices.size();
+    std::vector<ShapeBatch::ShapeVertex> triangle_list;
+    for (size_t shape = 0; shape < shape_size; ++shape) {
+        triangle_list.clear();
+        for (const auto& vert : shapes[shape].vertices) {
+            triangle_list.push_back({vert.x, vert.y, static_cast<ShapeBatch::Modifier>(vert.modifier)});
         }
+        shape_ids[shape] = batch.AddShape(triangle_list);
     }
 }
 
@@ -632,10 +644,16 @@ void AgentRenderer::Initialize(IDirect3DDevice9* device)
     }
     initialized = true;
     type = D3DPT_TRIANGLELIST;
-    vertices_max = max_shape_verts * 0x200; // support for up to 512 agents, should be enough
-    vertices = nullptr;
-    const HRESULT hr = device->CreateVertexBuffer(sizeof(D3DVertex) * vertices_max, 0,
-                                                  D3DFVF_CUSTOMVERTEX, D3DPOOL_MANAGED, &buffer, nullptr);
+    // 512 agents per draw call; more are drawn in further calls
+    vertices_max = batch.MaxShapeVertices() * 0x200;
+    indices_max = batch.MaxShapeIndices() * 0x200;
+    HRESULT hr = device->CreateVertexBuffer(sizeof(D3DVertex) * vertices_max, 0,
+                                            D3DFVF_CUSTOMVERTEX, D3DPOOL_MANAGED, &buffer, nullptr);
+    if (FAILED(hr)) {
+        printf("AgentRenderer initialize error: HRESULT: 0x%lX\n", hr);
+    }
+    hr = device->CreateIndexBuffer(sizeof(uint16_t) * indices_max, 0,
+                                   D3DFMT_INDEX16, D3DPOOL_MANAGED, &index_buffer, nullptr);
     if (FAILED(hr)) {
         printf("AgentRenderer initialize error: HRESULT: 0x%lX\n", hr);
     }
@@ -694,12 +712,7 @@ void AgentRenderer::Render(IDirect3DDevice9* device)
         initialized = true;
     }
 
-    const HRESULT res = buffer->Lock(0, sizeof(D3DVertex) * vertices_max, (VOID**)&vertices, D3DLOCK_DISCARD);
-    if (FAILED(res)) {
-        printf("AgentRenderer Lock() HRESULT: 0x%lX\n", res);
-    }
-
-    vertices_count = 0;
+    batch.Clear();
 
     if (show_props_on_minimap) {
         const auto& props = GW::GetMapContext()->props->propArray;
@@ -909,13 +922,37 @@ void AgentRenderer::Render(IDirect3DDevice9* device)
         Enqueue(player);
     }
 
-    buffer->Unlock();
-
-    if (vertices_count != 0) {
-        device->SetStreamSource(0, buffer, 0, sizeof(D3DVertex));
-        device->DrawPrimitive(D3DPT_TRIANGLELIST, 0, vertices_count / 3);
-        vertices_count = 0;
+    if (!(buffer && index_buffer)) {
+        return;
+    }
+    device->SetStreamSource(0, buffer, 0, sizeof(D3DVertex));
+    device->SetIndices(index_buffer);
+    for (size_t drawn = 0; drawn < batch.InstanceCount();) {
+        ShapeBatch::Vertex* vertices = nullptr;
+        uint16_t* indices = nullptr;
+        HRESULT res = buffer->Lock(0, sizeof(D3DVertex) * vertices_max, reinterpret_cast<void**>(&vertices), D3DLOCK_DISCARD);
+        if (FAILED(res)) {
+            printf("AgentRenderer Lock() HRESULT: 0x%lX\n", res);
+            break;
+        }
+        res = index_buffer->Lock(0, sizeof(uint16_t) * indices_max, reinterpret_cast<void**>(&indices), D3DLOCK_DISCARD);
+        if (FAILED(res)) {
+            printf("AgentRenderer Lock() HRESULT: 0x%lX\n", res);
+            buffer->Unlock();
+            break;
+        }
+        size_t vertex_count = 0;
+        size_t index_count = 0;
+        const size_t emitted = batch.Emit(drawn, vertices, vertices_max, indices, indices_max, vertex_count, index_count);
+        index_buffer->Unlock();
+        buffer->Unlock();
+        if (!emitted) {
+            break;
+        }
+        device->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, 0, 0, static_cast<UINT>(vertex_count), 0, static_cast<UINT>(index_count / 3));
+        drawn += emitted;
     }
+    device->SetIndices(nullptr);
 }
 
 void AgentRenderer::Enqueue(const GW::Agent* agent, const CustomAgent* ca)
@@ -980,47 +1017,8 @@ Color AgentRenderer::GetColor(const GW::Agent* agent, const CustomAgent* ca) con
                 c = &profession_colors[prof];
             }
         }
-        const auto& polygons = Minimap::Instance().custom_renderer.polygons;
-        const auto& markers = Minimap::Instance().custom_renderer.markers;
-        const auto is_relevant = [living](const CustomRenderer::CustomPolygon& polygon)-> bool {
-            return (polygon.visible && polygon.map == GW::Constants::MapID::None || polygon.map == GW::Map::GetMapID()) && !polygon.points.empty() && (polygon.color_sub & IM_COL32_A_MASK) != 0 &&
-                   GetDistance(living->pos, polygon.points.at(0)) < 2500.f;
-        };
-        const auto is_relevant_circle = [living](const CustomRenderer::CustomMarker& marker) {
-            return (marker.visible && marker.map == GW::Constants::MapID::None || marker.map == GW::Map::GetMapID()) && (marker.color_sub & IM_COL32_A_MASK) != 0 &&
-                   GetDistance(living->pos, marker.pos) < 2500.f;
-        };
-        const auto is_inside = [](const GW::GamePos pos, const std::vector<GW::GamePos>& points) -> bool {
-            bool b = false;
-            //TODO: This might need adjust to take into account zlevels
-            for (auto i = 0u, j = points.size() - 1; i < points.size(); j = i++) {
-                if (points[i].y >= pos.y != points[j].y >= pos.y &&
-                    pos.x <= (points[j].x - points[i].x) * (pos.y - points[i].y) / (points[j].y - points[i].y) +
-                    points[i].x) {
-                    b = !b;
-                }
-            }
-            return b;
-        };
-
-        auto is_inside_circle = [](const GW::Vec2f pos, const GW::Vec2f circle, const float radius) -> bool {
-            return GetSquareDistance(pos, circle) <= radius * radius;
-        };
-        for (const auto& polygon : polygons) {
-            if (!is_relevant(polygon)) {
-                continue;
-            }
-            if (is_inside(living->pos, polygon.points)) {
-                c = &polygon.color_sub;
-            }
-        }
-        for (const auto& marker : markers) {
-            if (!is_relevant_circle(marker)) {
-                continue;
-            }
-            if (is_inside_circle(living->pos, marker.pos, marker.size)) {
-                c = &marker.color_sub;
-            }
+        if (const auto zone_color = Minimap::Instance().custom_renderer.GetZoneColor(living->pos)) {
+            c = zone_color;
         }
         if (living->hp > 0.9f) {
             return *c;
@@ -1266,32 +1264,14 @@ void AgentRenderer::Enqueue(const Shape_e shape, const RenderPosition& pos, cons
     if ((color & IM_COL32_A_MASK) == 0) {
         return;
     }
-    const size_t num_v = shapes[shape].vertices.size();
-    ASSERT(vertices_count < vertices_max - num_v);
-
-    for (size_t i = 0; i < num_v; ++i) {
-        const Shape_Vertex& vert = shapes[shape].vertices[i];
-        const GW::Vec2f calc_pos = Rotate(vert, pos.rotation_cos, pos.rotation_sin) * size + pos.position;
-        switch (vert.modifier) {
-            case Dark:
-                vertices[i].color = Colors::Sub(color, modifier);
-                break;
-            case Light:
-                vertices[i].color = Colors::Add(color, modifier);
-                break;
-            case CircleCenter:
-                vertices[i].color = Colors::Sub(color, IM_COL32(0, 0, 0, 50));
-                break;
-            default:
-                vertices[i].color = color;
-                break;
-        }
-        vertices[i].z = 0.0f;
-        vertices[i].x = calc_pos.x;
-        vertices[i].y = calc_pos.y;
-    }
-    vertices += num_v;
-    vertices_count += num_v;
+    // Indexed by Color_Modifier
+    const ShapeBatch::ModifierColors colors = {
+        color,
+        Colors::Sub(color, modifier),
+        Colors::Add(color, modifier),
+        Colors::Sub(color, IM_COL32(0, 0, 0, 50))
+    };
+    batch.Add(shape_ids[shape], pos.position.x, pos.position.y, pos.rotation_cos, pos.rotation_sin, size, colors);
 }
 
 void AgentRenderer::BuildCustomAgentsMap()
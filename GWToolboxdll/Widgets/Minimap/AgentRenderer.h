@@ -4,6 +4,7 @@
 
 #include <GWCA/GameContainers/GamePos.h>
 
+#include <Widgets/Minimap/ShapeBatch.h>
 #include <Widgets/Minimap/VBuffer.h>
 
 namespace GW {
@@ -25,6 +26,7 @@ public:
     AgentRenderer();
 
     void Terminate() override;
+    void Invalidate() override;
     static AgentRenderer& Instance();
 
     void Render(IDirect3DDevice9* device) override;
@@ -53,6 +55,7 @@ private:
 
     enum Shape_e { Tear, Circle, Quad, BigCircle, Star };
 
+    // Same order as ShapeBatch::Modifier
     enum Color_Modifier {
         None,
         // rgb 0,0,0
@@ -116,6 +119,8 @@ private:
     };
 
     Shape_t shapes[shape_size];
+    uint32_t shape_ids[shape_size]{}; // in batch
+    ShapeBatch batch;
 
     void Initialize(IDirect3DDevice9* device) override;
 
@@ -137,10 +142,9 @@ private:
 
     std::vector<const CustomAgent*>* GetCustomAgentsToDraw(const GW::Agent* agent);
 
-    D3DVertex* vertices = nullptr;    // vertices array
-    unsigned int vertices_count = 0;  // count of vertices
-    unsigned int vertices_max = 0;    // max number of vertices to draw in one call
-    unsigned int max_shape_verts = 0; // max number of triangles in a single shape
+    IDirect3DIndexBuffer9* index_buffer = nullptr;
+    size_t vertices_max = 0; // max number of vertices to draw in one call
+    size_t indices_max = 0;  // max number of indices to draw in one call
 
     Color color_agent_modifier = 0;
     Color color_agent_damaged_modifier = 0;
@@ -27,6 +27,29 @@ constexpr auto ini_filename = L"Markers.ini";
 
 namespace {
     ToolboxIni inifile{};
+
+    // Hostiles only take the colour of zones within this distance of the polygon's first point or the marker's centre
+    constexpr float zone_range = 2500.f;
+
+    bool IsInside(const GW::GamePos& pos, const std::vector<GW::GamePos>& points)
+    {
+        bool b = false;
+        //TODO: This might need adjust to take into account zlevels
+        for (auto i = 0u, j = points.size() - 1; i < points.size(); j = i++) {
+            if (points[i].y >= pos.y != points[j].y >= pos.y &&
+                pos.x <= (points[j].x - points[i].x) * (pos.y - points[i].y) / (points[j].y - points[i].y) +
+                points[i].x) {
+                b = !b;
+            }
+        }
+        return b;
+    }
+
+    template <typename T>
+    bool IsZoneRelevant(const T& zone, const GW::Constants::MapID map_id)
+    {
+        return (zone.visible && zone.map == GW::Constants::MapID::None || zone.map == map_id) && (zone.color_sub & IM_COL32_A_MASK) != 0;
+    }
 }
 
 CustomRenderer::CustomLine::CustomLine(const float x1, const float y1, const float x2, const float y2, const GW::Constants::MapID m, const char* _name, bool draw_everywhere)
@@ -141,6 +164,7 @@ void CustomRenderer::LoadMarkers()
 
     marker_file_dirty = false;
     markers_changed = true;
+    zones_dirty = true;
 }
 
 void CustomRenderer::SaveSettings(ToolboxIni* ini, const char* section)
@@ -833,6 +857,7 @@ void CustomRenderer::Render(IDirect3DDevice9* device)
         GameWorldRenderer::TriggerSyncAllMarkers();
         marker_file_dirty = true;
         markers_changed = false;
+        zones_dirty = true;
         Invalidate();
         return;
     }
@@ -857,6 +882,78 @@ void CustomRenderer::Render(IDirect3DDevice9* device)
     }
 }
 
+void CustomRenderer::BuildZoneIndex(const GW::Constants::MapID map_id)
+{
+    zones.clear();
+    std::vector<ZoneGrid::Box> boxes;
+    for (uint32_t i = 0; i < polygons.size(); i++) {
+        const auto& polygon = polygons[i];
+        if (polygon.points.empty() || !IsZoneRelevant(polygon, map_id)) {
+            continue;
+        }
+        // Only the part of the polygon within range of its first point can recolour anything
+        const auto& first = polygon.points[0];
+        ZoneGrid::Box box{first.x, first.y, first.x, first.y};
+        for (const auto& point : polygon.points) {
+            box.min_x = std::min(box.min_x, point.x);
+            box.min_y = std::min(box.min_y, point.y);
+            box.max_x = std::max(box.max_x, point.x);
+            box.max_y = std::max(box.max_y, point.y);
+        }
+        box.min_x = std::max(box.min_x, first.x - zone_range);
+        box.min_y = std::max(box.min_y, first.y - zone_range);
+        box.max_x = std::min(box.max_x, first.x + zone_range);
+        box.max_y = std::min(box.max_y, first.y + zone_range);
+        zones.push_back({false, i});
+        boxes.push_back(box);
+    }
+    for (uint32_t i = 0; i < markers.size(); i++) {
+        const auto& marker = markers[i];
+        if (!IsZoneRelevant(marker, map_id)) {
+            continue;
+        }
+        const float radius = std::min(std::abs(marker.size), zone_range);
+        zones.push_back({true, i});
+        boxes.push_back({marker.pos.x - radius, marker.pos.y - radius, marker.pos.x + radius, marker.pos.y + radius});
+    }
+    zone_grid.Build(boxes);
+    zone_map = map_id;
+    zones_dirty = false;
+}
+
+const Color* CustomRenderer::GetZoneColor(const GW::GamePos& pos)
+{
+    const auto map_id = GW::Map::GetMapID();
+    if (zones_dirty || zone_map != map_id) {
+        BuildZoneIndex(map_id);
+    }
+    const auto candidates = zone_grid.Candidates(pos.x, pos.y);
+    // Highest id first: markers override polygons, and later entries override earlier ones
+    for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+        const auto& zone = zones[*it];
+        if (zone.is_marker) {
+            // Markers or polygons may have been removed since the index was built
+            if (zone.index >= markers.size()) {
+                continue;
+            }
+            const auto& marker = markers[zone.index];
+            if (GetDistance(pos, marker.pos) < zone_range && GetSquareDistance(pos, marker.pos) <= marker.size * marker.size) {
+                return &marker.color_sub;
+            }
+        }
+        else {
+            if (zone.index >= polygons.size()) {
+                continue;
+            }
+            const auto& polygon = polygons[zone.index];
+            if (!polygon.points.empty() && GetDistance(pos, polygon.points[0]) < zone_range && IsInside(pos, polygon.points)) {
+                return &polygon.color_sub;
+            }
+        }
+    }
+    return nullptr;
+}
+
 void CustomRenderer::DrawCustomMarkers(IDirect3DDevice9* device)
 {
     if (!Minimap::ShouldMarkersDrawOnMap()) {
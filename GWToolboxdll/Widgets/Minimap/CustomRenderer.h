@@ -3,6 +3,7 @@
 #include <GWCA/GameContainers/GamePos.h>
 
 #include <Widgets/Minimap/VBuffer.h>
+#include <Widgets/Minimap/ZoneGrid.h>
 
 namespace GW::Constants {
     enum class MapID : uint32_t;
@@ -131,6 +132,10 @@ public:
     [[nodiscard]] const std::vector<CustomPolygon>& GetPolys() const { return polygons; }
     [[nodiscard]] const std::vector<CustomMarker>& GetMarkers() const { return markers; }
 
+    // Colour of the last marker, or failing that the last polygon, on this map that contains pos and recolours hostiles;
+    // markers override polygons. nullptr if there is none.
+    const Color* GetZoneColor(const GW::GamePos& pos);
+
 private:
     void Initialize(IDirect3DDevice9* device) override;
 
@@ -161,4 +166,16 @@ private:
     std::vector<CustomLine*> lines{};
     std::vector<CustomMarker> markers{};
     std::vector<CustomPolygon> polygons{};
+
+    // Polygons then markers that can recolour hostiles on zone_map, so GetZoneColor only tests the ones near a position.
+    // Grid ids index zones; later zones take priority.
+    struct Zone {
+        bool is_marker;
+        uint32_t index;
+    };
+    std::vector<Zone> zones{};
+    ZoneGrid zone_grid{};
+    GW::Constants::MapID zone_map{};
+    bool zones_dirty = true;
+    void BuildZoneIndex(GW::Constants::MapID map_id);
 };
@@ -6,15 +6,85 @@
 #include <GWCA/Managers/MapMgr.h>
 
 #include <Widgets/Minimap/D3DVertex.h>
+#include <Utils/PmapMesh.h>
 #include <Widgets/Minimap/PmapRenderer.h>
 
+#include <Modules/Resources.h>
 #include <ImGuiAddons.h>
 
+namespace {
+    // Meshes for the last few maps, so going back and forth between an outpost and an explorable doesn't rebuild them
+    constexpr size_t MESH_CACHE_SIZE = 4;
+
+    struct MeshKey {
+        uint32_t map_id;
+        size_t trapezoid_count;
+        bool outline_only;
+
+        bool operator==(const MeshKey&) const = default;
+    };
+
+    struct CachedMesh {
+        MeshKey key;
+        std::shared_ptr<const PmapMesh::Mesh> mesh; // nullptr while being built
+    };
+
+    std::mutex mesh_cache_mutex;
+    std::deque<CachedMesh> mesh_cache; // most recently used at the back
+
+    std::vector<PmapMesh::Trapezoid> CopyTrapezoids(const GW::PathingMapArray& path_map)
+    {
+        std::vector<PmapMesh::Trapezoid> trapezoids;
+        for (uint32_t plane = 0; plane < path_map.size(); plane++) {
+            const auto& pmap = path_map[plane];
+            for (size_t j = 0; j < pmap.trapezoid_count; ++j) {
+                const auto& trap = pmap.trapezoids[j];
+                trapezoids.push_back({trap.XTL, trap.XTR, trap.YT, trap.XBL, trap.XBR, trap.YB, plane});
+            }
+        }
+        return trapezoids;
+    }
+
+    // Returns the cached mesh, or nullptr if it isn't ready yet. Starts building it if this is the first request.
+    std::shared_ptr<const PmapMesh::Mesh> GetMesh(const MeshKey& key, const GW::PathingMapArray& path_map)
+    {
+        {
+            std::lock_guard lock(mesh_cache_mutex);
+            const auto found = std::ranges::find(mesh_cache, key, &CachedMesh::key);
+            if (found != mesh_cache.end()) {
+                auto cached = std::move(*found);
+                mesh_cache.erase(found);
+                mesh_cache.push_back(std::move(cached));
+                return mesh_cache.back().mesh;
+            }
+            if (mesh_cache.size() >= MESH_CACHE_SIZE) {
+                mesh_cache.pop_front();
+            }
+            mesh_cache.push_back({key, nullptr});
+        }
+
+        // Copy the corners now; the game's pathing map is only safe to read on this thread
+        auto trapezoids = CopyTrapezoids(path_map);
+        Resources::EnqueueWorkerTask([key, trapezoids = std::move(trapezoids)]() mutable {
+            auto mesh = std::make_shared<const PmapMesh::Mesh>(PmapMesh::Build(std::move(trapezoids), key.outline_only));
+            Log::Log("Pathing map %u: %zu trapezoids merged into %zu, %zu vertices\n",
+                     key.map_id, mesh->source_trapezoids, mesh->merged_trapezoids, mesh->vertices.size());
+            std::lock_guard lock(mesh_cache_mutex);
+            const auto found = std::ranges::find(mesh_cache, key, &CachedMesh::key);
+            if (found != mesh_cache.end()) {
+                found->mesh = std::move(mesh);
+            }
+        });
+        return nullptr;
+    }
+}
+
 void PmapRenderer::LoadSettings(const ToolboxIni* ini, const char* section)
 {
     color_map = Colors::Load(ini, section, "color_map", 0xFF999999);
     color_mapshadow = Colors::Load(ini, section, "color_mapshadow", 0xFF120808);
     color_mapbackground = Colors::Load(ini, section, "color_mapbackground", 0x00000000);
+    map_outline_only = ini->GetBoolValue(section, VAR_NAME(map_outline_only), map_outline_only);
     Invalidate();
 }
 
@@ -23,6 +93,7 @@ void PmapRenderer::SaveSettings(ToolboxIni* ini, const char* section) const
     Colors::Save(ini, section, "color_map", color_map);
     Colors::Save(ini, section, "color_mapshadow", color_mapshadow);
     Colors::Save(ini, section, "color_mapbackground", color_mapbackground);
+    ini->SetBoolValue(section, VAR_NAME(map_outline_only), map_outline_only);
 }
 
 void PmapRenderer::DrawSettings()
@@ -44,12 +115,36 @@ void PmapRenderer::DrawSettings()
     if (Colors::DrawSettingHueWheel("Background", &color_mapbackground)) {
         Invalidate();
     }
+    if (ImGui::Checkbox("Only draw map outline", &map_outline_only)) {
+        Invalidate();
+    }
+    if (GW::Map::GetIsMapLoaded() && ImGui::Button("Dump pathing map")) {
+        const auto map_id = static_cast<uint32_t>(GW::Map::GetMapID());
+        const auto path = Resources::GetPath(L"pmap", std::format(L"{}.pmap", map_id));
+        Resources::EnsureFolderExists(Resources::GetPath(L"pmap"));
+        if (PmapMesh::WriteTrapezoids(path, CopyTrapezoids(*GW::Map::GetPathingMap()))) {
+            Log::Info("Pathing map written to %s", path.string().c_str());
+        }
+        else {
+            Log::Error("Failed to write pathing map");
+        }
+    }
+    ImGui::ShowHelp("Saves the trapezoids of the current map's pathing map, e.g. for the tests/ benchmarks");
 }
 
-void PmapRenderer::Initialize(IDirect3DDevice9* device)
+void PmapRenderer::Invalidate()
 {
-    //#define WIREFRAME_MODE
+    VBuffer::Invalidate();
+    if (index_buffer) {
+        index_buffer->Release();
+    }
+    index_buffer = nullptr;
+    prim_count_ = vert_count_ = 0;
+    shadow_uploaded_ = false;
+}
 
+void PmapRenderer::Initialize(IDirect3DDevice9* device)
+{
     GW::PathingMapArray* path_map;
     if (GW::Map::GetIsMapLoaded()) {
         path_map = GW::Map::GetPathingMap();
@@ -60,7 +155,6 @@ void PmapRenderer::Initialize(IDirect3DDevice9* device)
     }
     const bool shadow_show = (color_mapshadow & IM_COL32_A_MASK) > 0;
 
-    // get the number of trapezoids, need it to allocate the vertex buffer
     trapez_count_ = 0;
     for (const GW::PathingMap& map : *path_map) {
         trapez_count_ += map.trapezoid_count;
@@ -69,104 +163,62 @@ void PmapRenderer::Initialize(IDirect3DDevice9* device)
         return;
     }
 
-#ifdef WIREFRAME_MODE
-
-    total_tri_count_ = tri_count_ = trapez_count_ * 4;
-    if (shadow_show) total_tri_count_ = tri_count_ * 2;
-
-    vert_count_ = tri_count_ * 2;
-    total_vert_count_ = total_tri_count_ * 2;
-
-#else
-
-    total_tri_count_ = tri_count_ = trapez_count_ * 2;
-    if (shadow_show) {
-        total_tri_count_ = tri_count_ * 2;
+    const auto mesh = GetMesh({static_cast<uint32_t>(GW::Map::GetMapID()), trapez_count_, map_outline_only}, *path_map);
+    if (!mesh) {
+        initialized = false;
+        return; // still building; try again next frame
+    }
+    if (mesh->indices.empty()) {
+        return;
     }
 
-    vert_count_ = tri_count_ * 3;
-    total_vert_count_ = total_tri_count_ * 3;
-
-#endif
-
-    D3DVertex* vertices = nullptr;
+    type = mesh->lines ? D3DPT_LINELIST : D3DPT_TRIANGLELIST;
+    vert_count_ = mesh->vertices.size();
+    prim_count_ = mesh->PrimitiveCount();
+    const size_t total_vert_count = vert_count_ * (shadow_show ? 2 : 1);
 
     // allocate new vertex buffer
     if (buffer) {
         buffer->Release();
+        buffer = nullptr;
     }
-    device->CreateVertexBuffer(sizeof(D3DVertex) * total_vert_count_, D3DUSAGE_WRITEONLY,
-                               D3DFVF_CUSTOMVERTEX, D3DPOOL_MANAGED, &buffer, nullptr);
-    buffer->Lock(0, sizeof(D3DVertex) * total_vert_count_,
-                 reinterpret_cast<void**>(&vertices), D3DLOCK_DISCARD);
-
-    D3DVertex* vertices_begin = vertices;
-
-#ifdef WIREFRAME_MODE
-    type = D3DPT_LINELIST;
-
-    // populate vertex buffer
-    for (autok = 0; k < (shadow_show ? 2 : 1); ++k) {
-        for (size_t i = 0; i < path_map.size(); i++) {
-            GW::PathingMap pmap = path_map[i];
-            for (size_t j = 0; j < pmap.trapezoid_count; ++j) {
-                GW::PathingTrapezoid& trap = pmap.trapezoids[j];
-                vertices[0].x = trap.XTL; vertices[0].y = trap.YT;
-                vertices[1].x = trap.XTR; vertices[1].y = trap.YT;
-
-                vertices[2].x = trap.XTR; vertices[2].y = trap.YT;
-                vertices[3].x = trap.XBR; vertices[3].y = trap.YB;
-
-                vertices[4].x = trap.XBR; vertices[4].y = trap.YB;
-                vertices[5].x = trap.XBL; vertices[5].y = trap.YB;
-
-                vertices[6].x = trap.XBL; vertices[6].y = trap.YB;
-                vertices[7].x = trap.XTL; vertices[7].y = trap.YT;
-
-                vertices += 8;
-            }
-        }
+    if (device->CreateVertexBuffer(sizeof(D3DVertex) * total_vert_count, D3DUSAGE_WRITEONLY,
+                                   D3DFVF_CUSTOMVERTEX, D3DPOOL_MANAGED, &buffer, nullptr) != D3D_OK) {
+        return;
     }
-#else
-    type = D3DPT_TRIANGLELIST;
-
-    // populate vertex buffer
+    D3DVertex* vertices = nullptr;
+    buffer->Lock(0, sizeof(D3DVertex) * total_vert_count, reinterpret_cast<void**>(&vertices), D3DLOCK_DISCARD);
     for (auto k = 0; k < (shadow_show ? 2 : 1); ++k) {
-        for (const GW::PathingMap& pmap : *path_map) {
-            for (size_t j = 0; j < pmap.trapezoid_count; ++j) {
-                GW::PathingTrapezoid& trap = pmap.trapezoids[j];
-
-                vertices[0].x = trap.XTL;
-                vertices[0].y = trap.YT;
-                vertices[1].x = trap.XTR;
-                vertices[1].y = trap.YT;
-                vertices[2].x = trap.XBL;
-                vertices[2].y = trap.YB;
-
-                vertices[3].x = trap.XBL;
-                vertices[3].y = trap.YB;
-                vertices[4].x = trap.XTR;
-                vertices[4].y = trap.YT;
-                vertices[5].x = trap.XBR;
-                vertices[5].y = trap.YB;
-                vertices += 6;
-            }
+        const Color color = shadow_show && k == 0 ? color_mapshadow : color_map;
+        for (const auto& v : mesh->vertices) {
+            *vertices++ = {v.x, v.y, 0.0f, color};
         }
     }
-#endif
+    buffer->Unlock();
 
-    vertices = vertices_begin;
-    for (auto i = 0u; i < total_vert_count_; i++) {
-        vertices[i].z = 0.0f;
-        if (shadow_show && i < vert_count_) {
-            vertices[i].color = color_mapshadow;
-        }
-        else {
-            vertices[i].color = color_map;
-        }
+    // 16 bit indices where they fit
+    const bool index32 = vert_count_ > 0xffff;
+    const size_t index_size = index32 ? sizeof(uint32_t) : sizeof(uint16_t);
+    if (index_buffer) {
+        index_buffer->Release();
+        index_buffer = nullptr;
     }
-
-    buffer->Unlock();
+    if (device->CreateIndexBuffer(index_size * mesh->indices.size(), D3DUSAGE_WRITEONLY,
+                                  index32 ? D3DFMT_INDEX32 : D3DFMT_INDEX16, D3DPOOL_MANAGED, &index_buffer, nullptr) != D3D_OK) {
+        return;
+    }
+    void* indices = nullptr;
+    index_buffer->Lock(0, index_size * mesh->indices.size(), &indices, D3DLOCK_DISCARD);
+    if (index32) {
+        memcpy(indices, mesh->indices.data(), index_size * mesh->indices.size());
+    }
+    else {
+        std::ranges::transform(mesh->indices, static_cast<uint16_t*>(indices), [](const uint32_t i) {
+            return static_cast<uint16_t>(i);
+        });
+    }
+    index_buffer->Unlock();
+    shadow_uploaded_ = shadow_show;
 }
 
 void PmapRenderer::Render(IDirect3DDevice9* device)
@@ -175,8 +227,17 @@ void PmapRenderer::Render(IDirect3DDevice9* device)
         initialized = true;
         Initialize(device);
     }
+    if (!(buffer && index_buffer && prim_count_)) {
+        return;
+    }
+
+    device->SetFVF(D3DFVF_CUSTOMVERTEX);
+    device->SetStreamSource(0, buffer, 0, sizeof(D3DVertex));
+    device->SetIndices(index_buffer);
 
-    if ((color_mapshadow & IM_COL32_A_MASK) > 0) {
+    const auto num_verts = static_cast<UINT>(vert_count_);
+    const auto prim_count = static_cast<UINT>(prim_count_);
+    if (shadow_uploaded_) {
         D3DMATRIX oldview;
         device->GetTransform(D3DTS_VIEW, &oldview);
         const auto oldMatrix = XMLoadFloat4x4(reinterpret_cast<const DirectX::XMFLOAT4X4*>(&oldview));
@@ -184,17 +245,14 @@ void PmapRenderer::Render(IDirect3DDevice9* device)
         const auto newview = oldMatrix * translate;
         device->SetTransform(D3DTS_VIEW, reinterpret_cast<const D3DMATRIX*>(&newview));
 
-        device->SetFVF(D3DFVF_CUSTOMVERTEX);
-        device->SetStreamSource(0, buffer, 0, sizeof(D3DVertex));
-        device->DrawPrimitive(type, 0, tri_count_);
+        device->DrawIndexedPrimitive(type, 0, 0, num_verts, 0, prim_count);
 
         device->SetTransform(D3DTS_VIEW, &oldview);
 
-        device->DrawPrimitive(type, vert_count_, tri_count_);
+        device->DrawIndexedPrimitive(type, static_cast<INT>(num_verts), 0, num_verts, 0, prim_count);
     }
     else {
-        device->SetFVF(D3DFVF_CUSTOMVERTEX);
-        device->SetStreamSource(0, buffer, 0, sizeof(D3DVertex));
-        device->DrawPrimitive(type, 0, tri_count_);
+        device->DrawIndexedPrimitive(type, 0, 0, num_verts, 0, prim_count);
     }
+    device->SetIndices(nullptr);
 }
@@ -5,9 +5,10 @@
 
 class PmapRenderer : public VBuffer {
 public:
-    // Triangle 1: (XTL, YT) (XTR, YT), (XBL, YB)
-    // Triangle 2: (XBL, YB), (XTR, YT), (XBR, YB)
+    // Geometry comes from PmapMesh, built on a worker thread and cached per map.
+    // The vertex buffer holds the shadow copy first, then the map; both share one index buffer.
     void Render(IDirect3DDevice9* device) override;
+    void Invalidate() override;
 
     void DrawSettings();
     void LoadSettings(const ToolboxIni* ini, const char* section);
@@ -21,10 +22,11 @@ private:
     Color color_map = 0;
     Color color_mapshadow = 0;
     Color color_mapbackground = 0;
+    bool map_outline_only = false;
 
+    IDirect3DIndexBuffer9* index_buffer = nullptr;
     size_t trapez_count_ = 0;
-    size_t tri_count_ = 0;       // of just 1 batch (map)
-    size_t total_tri_count_ = 0; // including shadow
-    size_t vert_count_ = 0;
-    size_t total_vert_count_ = 0; // including shadow
+    size_t prim_count_ = 0; // of just 1 batch (map)
+    size_t vert_count_ = 0; // of just 1 batch (map)
+    bool shadow_uploaded_ = false;
 };
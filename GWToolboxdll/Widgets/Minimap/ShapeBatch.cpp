@@ -0,0 +1,131 @@
+#include "stdafx.h"
+
+#include <Widgets/Minimap/ShapeBatch.h>
+
+using namespace DirectX;
+
+uint32_t ShapeBatch::AddShape(const std::vector<ShapeVertex>& triangle_list)
+{
+    Template shape;
+
+    // Unique vertices, grouped by modifier so each modifier's colour can be written to a contiguous range
+    std::vector<ShapeVertex> unique;
+    const auto find_unique = [&unique](const ShapeVertex& v) {
+        return std::ranges::find_if(unique, [&v](const ShapeVertex& u) {
+            return u.x == v.x && u.y == v.y && u.modifier == v.modifier;
+        });
+    };
+    for (const auto& v : triangle_list) {
+        if (find_unique(v) == unique.end()) {
+            unique.push_back(v);
+        }
+    }
+    std::ranges::stable_sort(unique, {}, &ShapeVertex::modifier);
+    ASSERT(unique.size() <= 0xffff);
+    shape.vertex_count = static_cast<uint16_t>(unique.size());
+
+    for (uint8_t m = 0; m <= ModifierCount; m++) {
+        const auto first = std::ranges::find_if(unique, [m](const ShapeVertex& v) {
+            return v.modifier >= m;
+        });
+        shape.modifier_begin[m] = static_cast<uint16_t>(first - unique.begin());
+    }
+
+    shape.indices.reserve(triangle_list.size());
+    for (const auto& v : triangle_list) {
+        shape.indices.push_back(static_cast<uint16_t>(find_unique(v) - unique.begin()));
+    }
+
+    const size_t blocks = (unique.size() + 3) / 4;
+    shape.xs.resize(blocks, XMVectorZero());
+    shape.ys.resize(blocks, XMVectorZero());
+    for (size_t block = 0; block < blocks; block++) {
+        float x[4] = {};
+        float y[4] = {};
+        for (size_t lane = 0; lane < 4 && block * 4 + lane < unique.size(); lane++) {
+            x[lane] = unique[block * 4 + lane].x;
+            y[lane] = unique[block * 4 + lane].y;
+        }
+        shape.xs[block] = XMVectorSet(x[0], x[1], x[2], x[3]);
+        shape.ys[block] = XMVectorSet(y[0], y[1], y[2], y[3]);
+    }
+
+    max_shape_vertices = std::max<size_t>(max_shape_vertices, shape.vertex_count);
+    max_shape_indices = std::max(max_shape_indices, shape.indices.size());
+    templates.push_back(std::move(shape));
+    return static_cast<uint32_t>(templates.size() - 1);
+}
+
+void ShapeBatch::Clear()
+{
+    instance_shape.clear();
+    instance_x.clear();
+    instance_y.clear();
+    instance_cos.clear();
+    instance_sin.clear();
+    instance_size.clear();
+    instance_colors.clear();
+}
+
+void ShapeBatch::Add(const uint32_t shape, const float x, const float y, const float rotation_cos, const float rotation_sin, const float size, const ModifierColors& colors)
+{
+    ASSERT(shape < templates.size());
+    instance_shape.push_back(shape);
+    instance_x.push_back(x);
+    instance_y.push_back(y);
+    instance_cos.push_back(rotation_cos);
+    instance_sin.push_back(rotation_sin);
+    instance_size.push_back(size);
+    instance_colors.push_back(colors);
+}
+
+size_t ShapeBatch::Emit(const size_t first_instance, Vertex* vertices, const size_t max_vertices, uint16_t* indices, const size_t max_indices,
+                        size_t& out_vertex_count, size_t& out_index_count) const
+{
+    out_vertex_count = 0;
+    out_index_count = 0;
+    XMFLOAT4A xs;
+    XMFLOAT4A ys;
+    size_t i = first_instance;
+    for (; i < instance_shape.size(); i++) {
+        const auto& shape = templates[instance_shape[i]];
+        if (out_vertex_count + shape.vertex_count > max_vertices
+            || out_index_count + shape.indices.size() > max_indices
+            || out_vertex_count + shape.vertex_count > 0x10000) {
+            break;
+        }
+
+        // x' = (x * cos - y * sin) * size + pos.x, y' = (x * sin + y * cos) * size + pos.y
+        const XMVECTOR c = XMVectorReplicate(instance_cos[i] * instance_size[i]);
+        const XMVECTOR s = XMVectorReplicate(instance_sin[i] * instance_size[i]);
+        const XMVECTOR px = XMVectorReplicate(instance_x[i]);
+        const XMVECTOR py = XMVectorReplicate(instance_y[i]);
+        Vertex* out = vertices + out_vertex_count;
+        for (size_t block = 0; block < shape.xs.size(); block++) {
+            XMStoreFloat4A(&xs, XMVectorMultiplyAdd(shape.xs[block], c, XMVectorNegativeMultiplySubtract(shape.ys[block], s, px)));
+            XMStoreFloat4A(&ys, XMVectorMultiplyAdd(shape.xs[block], s, XMVectorMultiplyAdd(shape.ys[block], c, py)));
+            const float lanes_x[4] = {xs.x, xs.y, xs.z, xs.w};
+            const float lanes_y[4] = {ys.x, ys.y, ys.z, ys.w};
+            const size_t first = block * 4;
+            const size_t count = std::min<size_t>(4, shape.vertex_count - first);
+            for (size_t lane = 0; lane < count; lane++) {
+                out[first + lane] = {lanes_x[lane], lanes_y[lane], 0.f, 0};
+            }
+        }
+        const auto& colors = instance_colors[i];
+        for (uint8_t m = 0; m < ModifierCount; m++) {
+            for (uint16_t v = shape.modifier_begin[m]; v < shape.modifier_begin[m + 1]; v++) {
+                out[v].color = colors[m];
+            }
+        }
+
+        const auto base = static_cast<uint16_t>(out_vertex_count);
+        uint16_t* out_indices = indices + out_index_count;
+        for (size_t j = 0; j < shape.indices.size(); j++) {
+            out_indices[j] = static_cast<uint16_t>(base + shape.indices[j]);
+        }
+        out_vertex_count += shape.vertex_count;
+        out_index_count += shape.indices.size();
+    }
+    return i - first_instance;
+}
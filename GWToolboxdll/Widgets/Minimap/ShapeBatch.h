@@ -0,0 +1,67 @@
+#pragma once
+
+// Builds the vertices and indices for many copies of a few small shapes (the minimap's agent markers), without
+// depending on the renderer. Shapes are stored once as indexed templates with their vertices grouped by colour modifier,
+// instances are queued as separate arrays of position/rotation/size/colours, and Emit transforms each template four
+// vertices at a time.
+class ShapeBatch {
+public:
+    enum Modifier : uint8_t {
+        None,
+        Dark,
+        Light,
+        CircleCenter,
+        ModifierCount
+    };
+
+    struct ShapeVertex {
+        float x, y;
+        Modifier modifier;
+    };
+
+    // Same layout as D3DVertex
+    struct Vertex {
+        float x, y, z;
+        uint32_t color;
+    };
+
+    // Colour of the vertices with each modifier
+    using ModifierColors = std::array<uint32_t, ModifierCount>;
+
+    // Takes a triangle list; vertices repeated between triangles are only stored once. Returns the shape id.
+    uint32_t AddShape(const std::vector<ShapeVertex>& triangle_list);
+    [[nodiscard]] size_t MaxShapeVertices() const { return max_shape_vertices; }
+    [[nodiscard]] size_t MaxShapeIndices() const { return max_shape_indices; }
+
+    void Clear();
+    void Add(uint32_t shape, float x, float y, float rotation_cos, float rotation_sin, float size, const ModifierColors& colors);
+    [[nodiscard]] size_t InstanceCount() const { return instance_shape.size(); }
+
+    // Writes whole instances from first_instance on, in the order they were added, until the buffers are full.
+    // Indices are relative to the start of vertices. Returns the number of instances written.
+    size_t Emit(size_t first_instance, Vertex* vertices, size_t max_vertices, uint16_t* indices, size_t max_indices,
+                size_t& out_vertex_count, size_t& out_index_count) const;
+
+private:
+    struct Template {
+        // Vertex positions in blocks of 4, padded with zeroes
+        std::vector<DirectX::XMVECTOR> xs;
+        std::vector<DirectX::XMVECTOR> ys;
+        uint16_t vertex_count = 0;
+        // Vertices are sorted by modifier; those with modifier m are [modifier_begin[m], modifier_begin[m + 1])
+        std::array<uint16_t, ModifierCount + 1> modifier_begin{};
+        std::vector<uint16_t> indices;
+    };
+
+    std::vector<Template> templates;
+    size_t max_shape_vertices = 0;
+    size_t max_shape_indices = 0;
+
+    std::vector<uint32_t> instance_shape;
+    std::vector<float> instance_x;
+    std::vector<float> instance_y;
+    std::vector<float> instance_cos;
+    std::vector<float> instance_sin;
+    std::vector<float> instance_size;
+    std::vector<ModifierColors> instance_colors;
+};
@@ -0,0 +1,80 @@
+#include "stdafx.h"
+
+#include <Widgets/Minimap/ZoneGrid.h>
+
+void ZoneGrid::Clear()
+{
+    cells_x = cells_y = 0;
+    cell_offsets.clear();
+    cell_items.clear();
+}
+
+uint32_t ZoneGrid::CellX(const float x) const
+{
+    const float cell = (x - origin_x) * inv_cell_size;
+    return static_cast<uint32_t>(std::clamp(cell, 0.f, static_cast<float>(cells_x - 1)));
+}
+
+uint32_t ZoneGrid::CellY(const float y) const
+{
+    const float cell = (y - origin_y) * inv_cell_size;
+    return static_cast<uint32_t>(std::clamp(cell, 0.f, static_cast<float>(cells_y - 1)));
+}
+
+void ZoneGrid::Build(const std::vector<Box>& boxes)
+{
+    Clear();
+    if (boxes.empty()) {
+        return;
+    }
+    Box bounds = boxes[0];
+    for (const auto& box : boxes) {
+        bounds.min_x = std::min(bounds.min_x, box.min_x);
+        bounds.min_y = std::min(bounds.min_y, box.min_y);
+        bounds.max_x = std::max(bounds.max_x, box.max_x);
+        bounds.max_y = std::max(bounds.max_y, box.max_y);
+    }
+    const float extent = std::max(bounds.max_x - bounds.min_x, bounds.max_y - bounds.min_y);
+    const float cell_size = std::max(min_cell_size, extent / static_cast<float>(max_cells_per_axis));
+    origin_x = bounds.min_x;
+    origin_y = bounds.min_y;
+    inv_cell_size = 1.f / cell_size;
+    cells_x = std::clamp(static_cast<uint32_t>((bounds.max_x - bounds.min_x) * inv_cell_size) + 1, 1u, max_cells_per_axis);
+    cells_y = std::clamp(static_cast<uint32_t>((bounds.max_y - bounds.min_y) * inv_cell_size) + 1, 1u, max_cells_per_axis);
+
+    // Count, then fill; boxes are visited in id order so every cell's list ends up sorted
+    cell_offsets.assign(static_cast<size_t>(cells_x) * cells_y + 1, 0);
+    const auto for_each_cell = [this](const Box& box, const auto& fn) {
+        const auto x0 = CellX(box.min_x), x1 = CellX(box.max_x);
+        const auto y0 = CellY(box.min_y), y1 = CellY(box.max_y);
+        for (auto y = y0; y <= y1; y++) {
+            for (auto x = x0; x <= x1; x++) {
+                fn(static_cast<size_t>(y) * cells_x + x);
+            }
+        }
+    };
+    for (const auto& box : boxes) {
+        for_each_cell(box, [this](const size_t cell) {
+            cell_offsets[cell + 1]++;
+        });
+    }
+    for (size_t i = 1; i < cell_offsets.size(); i++) {
+        cell_offsets[i] += cell_offsets[i - 1];
+    }
+    cell_items.resize(cell_offsets.back());
+    std::vector<uint32_t> fill(cell_offsets.begin(), cell_offsets.end() - 1);
+    for (uint32_t id = 0; id < boxes.size(); id++) {
+        for_each_cell(boxes[id], [&](const size_t cell) {
+            cell_items[fill[cell]++] = id;
+        });
+    }
+}
+
+std::span<const uint32_t> ZoneGrid::Candidates(const float x, const float y) const
+{
+    if (cell_items.empty()) {
+        return {};
+    }
+    const size_t cell = static_cast<size_t>(CellY(y)) * cells_x + CellX(x);
+    return {cell_items.data() + cell_offsets[cell], cell_items.data() + cell_offsets[cell + 1]};
+}
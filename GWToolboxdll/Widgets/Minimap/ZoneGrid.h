@@ -0,0 +1,36 @@
+#pragma once
+
+#include <span>
+
+// Uniform grid over a set of axis aligned boxes, for finding which of many areas could contain a point
+// without testing all of them. Box ids are their index in the vector passed to Build.
+class ZoneGrid {
+public:
+    struct Box {
+        float min_x, min_y, max_x, max_y;
+    };
+
+    void Clear();
+    void Build(const std::vector<Box>& boxes);
+    [[nodiscard]] bool Empty() const { return cell_items.empty(); }
+
+    // Ids of the boxes overlapping the grid cell that holds (x, y), in ascending order; the caller still has to test them
+    [[nodiscard]] std::span<const uint32_t> Candidates(float x, float y) const;
+
+private:
+    // Cells are at least this big in game units, and there are at most max_cells_per_axis of them along each axis
+    static constexpr float min_cell_size = 250.f;
+    static constexpr uint32_t max_cells_per_axis = 128;
+
+    float origin_x = 0.f;
+    float origin_y = 0.f;
+    float inv_cell_size = 0.f;
+    uint32_t cells_x = 0;
+    uint32_t cells_y = 0;
+    // Ids in cell c are cell_items[cell_offsets[c]] to cell_items[cell_offsets[c + 1]]
+    std::vector<uint32_t> cell_offsets;
+    std::vector<uint32_t> cell_items;
+
+    [[nodiscard]] uint32_t CellX(float x) const;
+    [[nodiscard]] uint32_t CellY(float y) const;
+};
@@ -28,6 +28,11 @@ namespace {
     std::vector<TBHotkey*> hotkeys; // list of hotkeys
     // Subset of hotkeys that are valid to current character/map combo
     std::vector<TBHotkey*> valid_hotkeys;
+    // valid_hotkeys bucketed by every key in their combo, most specific (most keys) first. [0] = key down, [1] = key up
+    std::array<std::array<std::vector<TBHotkey*>, 256>, 2> dispatch_table;
+    // Hotkeys triggered since the last key up, so that holding a key doesn't repeat them. Cleared from WndProc and
+    // added to from Update, so guarded by pending_mutex like the pending queue.
+    std::vector<TBHotkey*> pressed_hotkeys;
 
     KeysHeldBitset keys_currently_held;
     KeysHeldBitset wndproc_keys_held;
@@ -111,6 +116,36 @@ namespace {
             && IsFrameCreated(GW::UI::GetFrameByLabel(L"Skillbar"));
     }
 
+    // Rebuilt whenever valid_hotkeys or a key combo changes, so key handling doesn't have to scan every hotkey
+    void RebuildDispatchTable()
+    {
+        for (auto& by_key : dispatch_table) {
+            for (auto& bucket : by_key) {
+                bucket.clear();
+            }
+        }
+        for (auto* hk : valid_hotkeys) {
+            auto& by_key = dispatch_table[hk->trigger_on_key_up ? 1 : 0];
+            for (size_t key = 0; key < by_key.size(); key++) {
+                if (hk->key_combo.test(key)) {
+                    by_key[key].push_back(hk);
+                }
+            }
+        }
+        for (auto& by_key : dispatch_table) {
+            for (auto& bucket : by_key) {
+                std::ranges::stable_sort(bucket, std::greater{}, [](const TBHotkey* hk) {
+                    return hk->key_combo.count();
+                });
+            }
+        }
+        // Forget any that have been deleted
+        std::lock_guard lock(pending_mutex);
+        std::erase_if(pressed_hotkeys, [](const TBHotkey* hk) {
+            return std::ranges::find(hotkeys, hk) == hotkeys.end();
+        });
+    }
+
     // Repopulates applicable_hotkeys based on current character/map context.
     // Used because its not necessary to check these vars on every keystroke, only when they change
     bool CheckSetValidHotkeys()
@@ -170,6 +205,7 @@ namespace {
             }
             by_group[hotkey->group].push_back(hotkey);
         }
+        RebuildDispatchTable();
 
         return true;
     }
@@ -289,6 +325,7 @@ namespace {
             keys_being_assigned->key_combo = keys_selected;
             ImGui::CloseCurrentPopup();
             TBHotkey::hotkeys_changed = true;
+            RebuildDispatchTable();
         }
         ImGui::EndPopup();
     }
@@ -332,6 +369,8 @@ void HotkeysWindow::Terminate()
         delete hotkey;
     }
     hotkeys.clear();
+    valid_hotkeys.clear();
+    RebuildDispatchTable();
     for (auto& label : HotkeyGWKey::control_labels | std::views::values) {
         delete label;
         label = nullptr;
@@ -597,6 +636,8 @@ void HotkeysWindow::LoadSettings(ToolboxIni* ini)
         delete hotkey;
     }
     hotkeys.clear();
+    valid_hotkeys.clear();
+    RebuildDispatchTable();
 
     // then load again
     ToolboxIni::TNamesDepend entries;
@@ -651,40 +692,36 @@ bool HotkeysWindow::WndProc(const UINT Message, const WPARAM wParam, LPARAM)
         wndproc_keys_held.reset();
         return false;
     }
-    auto check_triggers = [](bool is_key_up, uint32_t keyData) {
-        std::vector<TBHotkey*> matching_hotkeys;
-        size_t max_modifier_count = 0;
-
-        // Step 1: Find all hotkeys that match the currently pressed keys
-        for (TBHotkey* hk : valid_hotkeys) {
-            if (is_key_up) hk->pressed = false;
-
-            // A hotkey is considered "matching" if:
-            // - It hasn't already been triggered (`hk->pressed == false`)
-            // - It should trigger on key-up (if we're processing a key-up event)
-            // - All its required keys are currently held (`hk->key_combo & wndproc_keys_held == hk->key_combo`)
-            // - The key that was just pressed/released is part of this hotkey (`hk->key_combo.test(keyData)`)
-            if (!hk->pressed && hk->trigger_on_key_up == is_key_up && (hk->key_combo & wndproc_keys_held) == hk->key_combo && hk->key_combo.test(keyData)) {
-                // Count how many keys (modifiers + main key) are required for this hotkey
-                size_t modifier_count = hk->key_combo.count();
-                matching_hotkeys.push_back(hk);
-
-                // Track the highest number of required keys (most specific hotkey)
-                max_modifier_count = std::max(max_modifier_count, modifier_count);
+    auto check_triggers = [](const bool is_key_up, const uint32_t keyData) {
+        // pressed flags are set from Update
+        std::lock_guard lock(pending_mutex);
+        if (is_key_up) {
+            for (TBHotkey* hk : pressed_hotkeys) {
+                hk->pressed = false;
             }
+            pressed_hotkeys.clear();
         }
 
         bool triggered = false;
+        size_t matched_key_count = 0;
+
+        // Only hotkeys that include the key that was just pressed/released are in this bucket, most specific first.
+        // A hotkey matches if it hasn't already been triggered and all of its keys are currently held;
+        // only the most specific matches are triggered.
+        for (TBHotkey* hk : dispatch_table[is_key_up ? 1 : 0][keyData]) {
+            const size_t key_count = hk->key_combo.count();
+            if (key_count < matched_key_count) {
+                break;
+            }
+            if (hk->pressed || (hk->key_combo & wndproc_keys_held) != hk->key_combo) {
+                continue;
+            }
+            matched_key_count = key_count;
+            PushPendingHotkey(hk);
 
-        // Step 2: Trigger only the most specific hotkeys
-        for (TBHotkey* hk : matching_hotkeys) {
-            if (hk->key_combo.count() == max_modifier_count) {
-                PushPendingHotkey(hk);
-
-                // If this hotkey is set to block Guild Wars input, mark it as triggered
-                if (!is_key_up && hk->block_gw) {
-                    triggered = true;
-                }
+            // If this hotkey is set to block Guild Wars input, mark it as triggered
+            if (!is_key_up && hk->block_gw) {
+                triggered = true;
             }
         }
 
@@ -729,9 +766,11 @@ void HotkeysWindow::Update(const float)
         if (map_change_triggered) {
             map_change_triggered = false;
             while (PopPendingHotkey()) {} // Clear any pending hotkeys from the last map
+            std::lock_guard lock(pending_mutex);
             for (auto hk : hotkeys) {
                 hk->pressed = false;
             }
+            pressed_hotkeys.clear();
         }
         return;
     }
@@ -745,7 +784,13 @@ void HotkeysWindow::Update(const float)
         }
     }
     while (const auto hk = PopPendingHotkey()) {
-        hk->pressed = true;
+        {
+            std::lock_guard lock(pending_mutex);
+            if (!hk->pressed) {
+                pressed_hotkeys.push_back(hk);
+            }
+            hk->pressed = true;
+        }
         current_hotkey = hk;
         hk->Toggle();
         current_hotkey = nullptr;
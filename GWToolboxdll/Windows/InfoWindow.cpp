@@ -581,12 +581,15 @@ namespace {
         GW::Hook::EnterHook();
         const auto out = CreateTexture_Ret(file_name, flags);
         uint32_t file_id = FileHashToFileId(file_name);
-        if (textures_created_by_file_id.find(file_id) == textures_created_by_file_id.end()) {
+        // The game can create textures off the render thread; the texture module and these lists belong to it
+        Resources::EnqueueDxTask([file_id](IDirect3DDevice9*) {
+            if (!CreateTexture_Func || textures_created_by_file_id.contains(file_id))
+                return;
             const auto f = GwDatTextureModule::LoadTextureFromFileId(file_id);
             textures_created.push_back(f);
             textures_created_by_file_id[file_id] = f;
             texture_file_ids[f] = file_id;
-        }
+        });
         GW::Hook::LeaveHook();
         return out;
     }
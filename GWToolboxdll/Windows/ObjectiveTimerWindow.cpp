@@ -44,6 +44,11 @@ namespace {
     bool save_to_disk = true;
     bool show_past_runs = false;
 
+    // Splits read by worker tasks for runs expanded in Draw, by utc_start; nullopt if the read failed.
+    // Picked up by ObjectiveSet::LoadSplits on the render thread.
+    std::mutex loaded_splits_mutex;
+    std::unordered_map<uint32_t, std::optional<ObjectiveRunDB::Run>> loaded_splits;
+
     //@Cleanup: These IDs should be wchar_t[]'s e.g. L"\x8101\x273F" and the doa event should be a wchar_t comparison instead of something bespoke.
     enum DoA_ObjId : uint32_t {
         Foundry = 0x273F,
@@ -192,6 +197,7 @@ void ObjectiveTimerWindow::Terminate() {
         run_loader.join();
     }
     ClearObjectiveSets();
+    ObjectiveRunDB::Close();
 }
 void ObjectiveTimerWindow::Initialize()
 {
@@ -978,61 +984,82 @@ void ObjectiveTimerWindow::SaveSettings(ToolboxIni* ini)
     SaveRuns();
 }
 
+bool ObjectiveTimerWindow::OpenRunDB()
+{
+    if (ObjectiveRunDB::IsOpen()) {
+        return true;
+    }
+    Resources::EnsureFolderExists(Resources::GetPath(L"runs"));
+    bool created = false;
+    if (!ObjectiveRunDB::Open(Resources::GetPath(L"runs", L"objective_runs.db"), created)) {
+        Log::Error("Failed to open objective timer run database");
+        return false;
+    }
+    if (created) {
+        ImportJsonRuns();
+    }
+    return true;
+}
+
+void ObjectiveTimerWindow::ImportJsonRuns()
+{
+    WIN32_FIND_DATAW FindFileData;
+    const std::wstring file_match = Resources::GetPath(L"runs", L"ObjectiveTimerRuns_*.json");
+    std::set<std::wstring> obj_timer_files;
+    HANDLE hFind = FindFirstFileW(file_match.c_str(), &FindFileData);
+    if (hFind != INVALID_HANDLE_VALUE) {
+        obj_timer_files.insert(FindFileData.cFileName);
+        while (FindNextFileW(hFind, &FindFileData) != 0) {
+            obj_timer_files.insert(FindFileData.cFileName);
+        }
+    }
+    FindClose(hFind);
+
+    size_t imported = 0;
+    for (const auto& obj_timer_file : obj_timer_files) {
+        try {
+            std::ifstream file(Resources::GetPath(L"runs", obj_timer_file));
+            if (!file.is_open()) {
+                continue;
+            }
+            nlohmann::json os_json_arr;
+            file >> os_json_arr;
+            for (auto json_it = os_json_arr.begin(); json_it != os_json_arr.end(); ++json_it) {
+                ObjectiveSet* os = ObjectiveSet::FromJson(json_it.value());
+                if (!ObjectiveRunDB::Contains(os->system_time) && ObjectiveRunDB::Append(os->ToRun())) {
+                    imported++;
+                }
+                delete os;
+            }
+        } catch (const std::exception&) {
+            Log::Error("Failed to import ObjectiveSets from json");
+        }
+    }
+    Log::Log("Imported %zu objective timer runs from %zu json files\n", imported, obj_timer_files.size());
+}
+
 void ObjectiveTimerWindow::LoadRuns()
 {
     if (!save_to_disk) {
         return;
     }
-    // Because this does a load of file reads and JSON decoding, its on a separate thread; it could delay rendering by
-    // seconds
+    // Opening the run database (and importing old JSON runs the first time) is done on a separate thread; it could
+    // delay rendering. Only run headers are loaded here; splits are read when a run is expanded.
     if (run_loader.joinable()) {
         run_loader.join();
     }
     loading = true;
     run_loader = std::thread([] {
         ObjectiveTimerWindow& instance = Instance();
-        // ClearObjectiveSets();
-        Resources::EnsureFolderExists(Resources::GetPath(L"runs"));
-        WIN32_FIND_DATAW FindFileData;
-        size_t max_objectives_in_memory = 200;
-        std::wstring file_match = Resources::GetPath(L"runs", L"ObjectiveTimerRuns_*.json");
-        std::wstring filename;
-        std::set<std::wstring> obj_timer_files;
-        HANDLE hFind = FindFirstFileW(file_match.c_str(), &FindFileData);
-        if (hFind != INVALID_HANDLE_VALUE) {
-            obj_timer_files.insert(FindFileData.cFileName);
-            while (FindNextFileW(hFind, &FindFileData) != 0) {
-                obj_timer_files.insert(FindFileData.cFileName);
-            }
-        }
-        FindClose(hFind);
-
-        // Output the list of names found
-        for (auto it = obj_timer_files.rbegin();
-             it != obj_timer_files.rend() && instance.objective_sets.size() < max_objectives_in_memory; ++it) {
-            try {
-                std::ifstream file;
-                std::wstring fn = Resources::GetPath(L"runs", *it);
-                file.open(fn);
-                if (file.is_open()) {
-                    nlohmann::json os_json_arr;
-                    file >> os_json_arr;
-                    for (auto json_it = os_json_arr.begin(); json_it != os_json_arr.end();
-                         ++json_it) {
-                        ObjectiveSet* os = ObjectiveSet::FromJson(json_it.value());
-                        if (instance.objective_sets.contains(os->system_time)) {
-                            delete os;
-                            continue; // Don't load in a run that already exists
-                        }
-                        os->StopObjectives();
-                        os->need_to_collapse = true;
-                        os->from_disk = true;
-                        instance.objective_sets.emplace(os->system_time, os);
-                    }
-                    file.close();
+        constexpr size_t max_objectives_in_memory = 200;
+        if (OpenRunDB()) {
+            std::vector<ObjectiveRunDB::RunInfo> run_infos;
+            ObjectiveRunDB::ListRuns(0, max_objectives_in_memory, run_infos);
+            for (const auto& info : run_infos) {
+                if (instance.objective_sets.contains(info.utc_start)) {
+                    continue; // Don't load in a run that already exists
                 }
-            } catch (const std::exception&) {
-                Log::Error("Failed to load ObjectiveSets from json");
+                instance.objective_sets.emplace(info.utc_start, ObjectiveSet::FromRunInfo(info));
             }
         }
         instance.loading = false;
@@ -1050,36 +1077,21 @@ void ObjectiveTimerWindow::SaveRuns()
     loading = true;
     run_loader = std::thread([] {
         ObjectiveTimerWindow& instance = Instance();
-        Resources::EnsureFolderExists(Resources::GetPath(L"runs"));
-        std::map<std::wstring, std::vector<ObjectiveSet*>> objective_sets_by_file;
-        wchar_t filename[36];
-        for (auto& os : instance.objective_sets) {
-            if (os.second->from_disk) {
-                continue; // No need to re-save a run.
-            }
-            time_t tt = os.second->system_time;
-            const tm* structtime = gmtime(&tt);
-            if (!structtime) {
-                continue;
-            }
-            swprintf(filename, 36, L"ObjectiveTimerRuns_%02d-%02d-%02d.json", structtime->tm_year + 1900,
-                     structtime->tm_mon + 1, structtime->tm_mday);
-            objective_sets_by_file[filename].push_back(os.second);
-        }
-        for (auto& it : objective_sets_by_file) {
-            try {
-                std::ofstream file;
-                file.open(Resources::GetPath(L"runs", it.first));
-                if (file.is_open()) {
-                    nlohmann::json os_json_arr;
-                    for (const auto os : it.second) {
-                        os_json_arr.push_back(os->ToJson());
-                    }
-                    file << os_json_arr << std::endl;
-                    file.close();
+        if (OpenRunDB()) {
+            for (const auto os : instance.objective_sets | std::views::values) {
+                if (os->from_disk) {
+                    continue; // No need to re-save a run.
+                }
+                if (os->db_saved && !os->db_saved_active) {
+                    continue; // Already saved once it was finished
+                }
+                const bool active = os->active;
+                if (!ObjectiveRunDB::Append(os->ToRun())) {
+                    Log::Error("Failed to save ObjectiveSets to disk");
+                    break;
                 }
-            } catch (const std::exception&) {
-                Log::Error("Failed to save ObjectiveSets to json");
+                os->db_saved = true;
+                os->db_saved_active = active;
             }
         }
         runs_dirty = false;
@@ -1118,13 +1130,19 @@ ObjectiveTimerWindow::Objective* ObjectiveTimerWindow::Objective::AddStartEvent(
     const EventType et, const uint32_t id1, const uint32_t id2)
 {
     start_events.emplace_back<Event>({et, id1, id2});
+    if (parent) {
+        parent->dispatch_dirty = true;
+    }
     return this;
 }
 
 ObjectiveTimerWindow::Objective* ObjectiveTimerWindow::Objective::AddStartEvent(
     const EventType et, const uint32_t count, const wchar_t* msg)
 {
-    start_events.emplace_back<Event>({et, count, (uint32_t)msg});
+    start_events.emplace_back<Event>({et, count, reinterpret_cast<uintptr_t>(msg)});
+    if (parent) {
+        parent->dispatch_dirty = true;
+    }
     return this;
 }
 
@@ -1132,13 +1150,19 @@ ObjectiveTimerWindow::Objective* ObjectiveTimerWindow::Objective::AddEndEvent(
     const EventType et, const uint32_t id1, const uint32_t id2)
 {
     end_events.emplace_back<Event>({et, id1, id2});
+    if (parent) {
+        parent->dispatch_dirty = true;
+    }
     return this;
 }
 
 ObjectiveTimerWindow::Objective* ObjectiveTimerWindow::Objective::AddEndEvent(
     const EventType et, const uint32_t count, const wchar_t* msg)
 {
-    end_events.emplace_back<Event>({et, count, (uint32_t)msg});
+    end_events.emplace_back<Event>({et, count, reinterpret_cast<uintptr_t>(msg)});
+    if (parent) {
+        parent->dispatch_dirty = true;
+    }
     return this;
 }
 
@@ -1292,9 +1316,34 @@ void ObjectiveTimerWindow::Objective::Draw()
     }
     if (show_end_column) {
         ImGui::SameLine(offset);
+        // Live ahead/behind personal best for the run in progress
+        const bool compare_to_best = parent && parent->active && status == Status::Completed && LoadPersonalBest();
+        if (compare_to_best) {
+            ImGui::PushStyleColor(ImGuiCol_Text, done <= personal_best.best ? ImVec4(0.0f, 1.0f, 0.0f, 1.0f) : ImVec4(1.0f, 0.4f, 0.4f, 1.0f));
+        }
         ImGui::Text(GetEndTimeStr());
+        if (compare_to_best) {
+            ImGui::PopStyleColor();
+        }
         if (ImGui::IsItemHovered()) {
-            ImGui::SetTooltip("End");
+            if (LoadPersonalBest()) {
+                char best_buf[16];
+                char median_buf[16];
+                PrintTime(best_buf, sizeof(best_buf), personal_best.best, show_decimal);
+                PrintTime(median_buf, sizeof(median_buf), personal_best.median, show_decimal);
+                if (status == Status::Completed) {
+                    char delta_buf[16];
+                    const bool ahead = done <= personal_best.best;
+                    PrintTime(delta_buf, sizeof(delta_buf), ahead ? personal_best.best - done : done - personal_best.best, show_decimal);
+                    ImGui::SetTooltip("End\nBest: %s (%c%s)\nMedian: %s (%u runs)", best_buf, ahead ? '-' : '+', delta_buf, median_buf, personal_best.samples);
+                }
+                else {
+                    ImGui::SetTooltip("End\nBest: %s\nMedian: %s (%u runs)", best_buf, median_buf, personal_best.samples);
+                }
+            }
+            else {
+                ImGui::SetTooltip("End");
+            }
         }
         offset += ts_width + style.ItemSpacing.x;
     }
@@ -1321,90 +1370,27 @@ void ObjectiveTimerWindow::ObjectiveSet::Update() const
     }
 }
 
-void ObjectiveTimerWindow::ObjectiveSet::Event(const EventType type, const uint32_t id1, const uint32_t id2)
+void ObjectiveTimerWindow::ObjectiveSet::BuildDispatchTable()
 {
-    auto Match = [&](const Objective::Event& event) -> bool {
-        if (type != event.type) {
-            return false;
-        }
-        switch (type) {
-            // for these, use id2 as a wchar_t*
-            case EventType::ServerMessage:
-            case EventType::DisplayDialogue: {
-                const wchar_t* msg1 = (wchar_t*)id2;
-                const wchar_t* msg2 = (wchar_t*)event.id2;
-                if (msg1 == nullptr) {
-                    return false;
-                }
-                if (msg2 == nullptr) {
-                    return false;
-                }
-                for (auto i = 0u; i < id1 && i < event.id1; i++) {
-                    if (msg2[i] != 0 && msg1[i] != msg2[i]) {
-                        return false;
-                    }
-                }
-                return true;
-            }
-
-            default:
-                if (id1 != 0 && id1 != event.id1) {
-                    return false;
-                }
-                if (id2 != 0 && id2 != event.id2) {
-                    return false;
-                }
-                return true;
-        }
-    };
-
-    bool just_set_something_done = false;
-
-    for (size_t i = 0; i < objectives.size(); i++) {
-        Objective& obj = *objectives[i];
-        if (obj.IsDone()) {
-            continue; // nothing to check
-        }
-
-        if (!obj.IsStarted()) {
-            for (auto& event : obj.start_events) {
-                if (Match(event)) {
-                    obj.SetStarted();
-                    size_t to_set_done_from = i - obj.starting_completes_n_previous_objectives;
-                    if (obj.starting_completes_n_previous_objectives == -1) {
-                        to_set_done_from = 0;
-                    }
-                    for (size_t j = to_set_done_from; j < i; ++j) {
-                        Objective* other = objectives[j];
-                        if (!other->IsDone()) {
-                            other->SetDone();
-                        }
-                    }
-                    break;
-                }
-            }
-        }
-
-        for (const Objective::Event& event : obj.end_events) {
-            if (Match(event)) {
-                obj.SetDone();
-                size_t to_set_done_from = i - obj.starting_completes_n_previous_objectives;
-                if (obj.starting_completes_n_previous_objectives == -1) {
-                    to_set_done_from = 0;
-                }
-                for (size_t j = to_set_done_from; j < i; ++j) {
-                    Objective& other = *objectives[j];
-                    if (!other.IsDone()) {
-                        other.SetDone();
-                    }
-                }
-                just_set_something_done = true;
-                break;
+    dispatch_table.Clear();
+    for (uint32_t i = 0; i < objectives.size(); i++) {
+        for (const auto* events : {&objectives[i]->start_events, &objectives[i]->end_events}) {
+            for (const auto& event : *events) {
+                dispatch_table.Add(i, event);
             }
         }
     }
+    dispatch_dirty = false;
+}
 
-    if (just_set_something_done) {
+void ObjectiveTimerWindow::ObjectiveSet::Event(const EventType type, const uint32_t id1, const uint32_t id2)
+{
+    if (dispatch_dirty) {
+        BuildDispatchTable();
+    }
+    // Narrow down to the objectives that have an event which could match; Match still has the final say
+    dispatch_table.Candidates(type, id1, id2, event_candidates);
+    if (ObjectiveEvents::Apply<Objective>(objectives, event_candidates, type, id1, id2)) {
         CheckSetDone();
     }
 }
@@ -1478,6 +1464,76 @@ nlohmann::json ObjectiveTimerWindow::ObjectiveSet::ToJson()
     return json;
 }
 
+ObjectiveTimerWindow::ObjectiveSet* ObjectiveTimerWindow::ObjectiveSet::FromRunInfo(const ObjectiveRunDB::RunInfo& info)
+{
+    const auto os = new ObjectiveSet;
+    os->active = false;
+    os->system_time = info.utc_start;
+    os->name = info.name;
+    os->duration = info.duration;
+    os->failed = (info.flags & ObjectiveRunDB::RunFlag_Failed) != 0;
+    os->from_disk = true;
+    os->need_to_collapse = true;
+    os->splits_loaded = false;
+    return os;
+}
+
+void ObjectiveTimerWindow::ObjectiveSet::LoadSplits()
+{
+    if (splits_loaded) {
+        return;
+    }
+    if (!splits_requested) {
+        // Reading from disk could stall the frame; the run is filled in once the worker is done
+        splits_requested = true;
+        const uint32_t utc_start = system_time;
+        Resources::EnqueueWorkerTask([utc_start] {
+            ObjectiveRunDB::Run run;
+            const bool ok = ObjectiveRunDB::ReadRun(utc_start, run);
+            std::lock_guard lock(loaded_splits_mutex);
+            loaded_splits[utc_start] = ok ? std::optional(std::move(run)) : std::nullopt;
+        });
+        return;
+    }
+    std::optional<ObjectiveRunDB::Run> run;
+    {
+        std::lock_guard lock(loaded_splits_mutex);
+        const auto found = loaded_splits.find(system_time);
+        if (found == loaded_splits.end()) {
+            return;
+        }
+        run = std::move(found->second);
+        loaded_splits.erase(found);
+    }
+    splits_loaded = true;
+    if (!run) {
+        return;
+    }
+    run_start_time_point = run->instance_start;
+    for (const auto& split : run->splits) {
+        Objective* obj = Objective::FromSplit(split);
+        obj->parent = this;
+        objectives.push_back(obj);
+    }
+    dispatch_dirty = true;
+    StopObjectives();
+}
+
+ObjectiveRunDB::Run ObjectiveTimerWindow::ObjectiveSet::ToRun()
+{
+    ObjectiveRunDB::Run run;
+    run.utc_start = system_time;
+    run.instance_start = run_start_time_point;
+    run.duration = GetDuration();
+    run.flags = static_cast<uint8_t>((failed ? ObjectiveRunDB::RunFlag_Failed : 0) | (active ? 0 : ObjectiveRunDB::RunFlag_Finished));
+    run.name = name;
+    run.splits.reserve(objectives.size());
+    for (auto* obj : objectives) {
+        run.splits.push_back(obj->ToSplit());
+    }
+    return run;
+}
+
 nlohmann::json ObjectiveTimerWindow::Objective::ToJson()
 {
     nlohmann::json json;
@@ -1490,6 +1546,31 @@ nlohmann::json ObjectiveTimerWindow::Objective::ToJson()
     return json;
 }
 
+ObjectiveRunDB::Split ObjectiveTimerWindow::Objective::ToSplit()
+{
+    return {start, done, GetDuration(), static_cast<uint8_t>(status), static_cast<uint8_t>(indent), name};
+}
+
+ObjectiveTimerWindow::Objective* ObjectiveTimerWindow::Objective::FromSplit(const ObjectiveRunDB::Split& split)
+{
+    const auto obj = new Objective(split.name.c_str());
+    obj->status = static_cast<Status>(split.status);
+    obj->start = split.start;
+    obj->done = split.done;
+    obj->indent = split.indent;
+    obj->duration = split.duration;
+    return obj;
+}
+
+bool ObjectiveTimerWindow::Objective::LoadPersonalBest()
+{
+    if (!personal_best_checked && parent) {
+        personal_best_checked = true;
+        ObjectiveRunDB::GetSplitStats(parent->name, name, personal_best);
+    }
+    return personal_best.samples > 0;
+}
+
 ObjectiveTimerWindow::Objective* ObjectiveTimerWindow::Objective::FromJson(const nlohmann::json& json)
 {
     const auto name = json.at("name").get<std::string>();
@@ -1574,6 +1655,12 @@ bool ObjectiveTimerWindow::ObjectiveSet::Draw()
         return false;
     }
     if (!is_collapsed) {
+        if (!need_to_collapse) {
+            LoadSplits();
+        }
+        if (splits_requested && !splits_loaded) {
+            ImGui::TextDisabled("Loading...");
+        }
         ImGui::PushID(static_cast<int>(ui_id));
         for (Objective* objective : objectives) {
             objective->Draw();
@@ -5,6 +5,8 @@
 #include <GWCA/Packets/StoC.h>
 
 #include <ToolboxWindow.h>
+#include <Utils/ObjectiveEvents.h>
+#include <Utils/ObjectiveRunDB.h>
 #include <vector>
 
 /*
@@ -43,6 +45,10 @@ public:
     void SaveRuns();
 
 private:
+    // Opens runs/objective_runs.db, importing the old per-day JSON files the first time. Called from run_loader.
+    static bool OpenRunDB();
+    static void ImportJsonRuns();
+
     std::thread run_loader;
     bool loading = false;
 
@@ -53,36 +59,7 @@ private:
     // Checks that we've received all of the packets needed to start an objective set, then triggers necessary events
     void CheckIsMapLoaded();
 
-    // TODO: many of those are not hooked up
-    enum class EventType {
-        ServerMessage,
-        // id1=msg length, id2=pointer to msg
-
-        // dialog from owner. Can be in chat or middle of screen.
-        DisplayDialogue,
-        // id1=msg length, id2=pointer to msg
-
-        InstanceLoadInfo,
-        // id1 is mapid
-        InstanceEnd,
-        // id1 is mapid we're leaving. Use as "end of instance".
-        DoorOpen,
-        // id=object_id
-        DoorClose,
-        // id=object_id
-        ObjectiveStarted,
-        // id=objective_id
-        ObjectiveDone,
-        // id=objective_id
-
-        AgentUpdateAllegiance,
-        // id1 = agent model id, id2 = allegiance_bits
-        DoACompleteZone,
-        // id1 = second wchar of message (doa "id")
-        CountdownStart,
-        // id1 = mapid
-        DungeonReward
-    };
+    using EventType = ObjectiveEvents::EventType;
 
     class ObjectiveSet;
 
@@ -94,11 +71,7 @@ private:
 
         ObjectiveSet* parent{};
 
-        struct Event {
-            EventType type;
-            uint32_t id1 = 0;
-            uint32_t id2 = 0;
-        };
+        using Event = ObjectiveEvents::Event;
 
         std::vector<Event> start_events{};
         std::vector<Event> end_events{};
@@ -131,7 +104,11 @@ private:
         Objective* SetDone();
         Objective* AddChild(Objective* child);
         static Objective* FromJson(const nlohmann::json& json);
+        static Objective* FromSplit(const ObjectiveRunDB::Split& split);
         nlohmann::json ToJson();
+        ObjectiveRunDB::Split ToSplit();
+        // Best/median done time for this objective in previous runs of the same objective set
+        bool LoadPersonalBest();
 
         [[nodiscard]] bool IsStarted() const;
         [[nodiscard]] bool IsDone() const;
@@ -143,6 +120,8 @@ private:
         char cached_start[16] = "";
         char cached_duration[16] = "";
         DWORD duration = 0;
+        ObjectiveRunDB::SplitStats personal_best{};
+        bool personal_best_checked = false;
     };
 
     class ObjectiveSet {
@@ -163,6 +142,14 @@ private:
         bool failed = false;
         bool from_disk = false;
         bool need_to_collapse = false;
+        // Runs from disk only have their header until expanded
+        bool splits_loaded = true;
+        bool splits_requested = false;
+        // Saved to the run database, and whether it was still in progress at the time
+        bool db_saved = false;
+        bool db_saved_active = false;
+        // Set when objectives or their events change; the event dispatch table is rebuilt on the next Event()
+        bool dispatch_dirty = true;
         std::string name;
 
         std::vector<Objective*> objectives{};
@@ -172,6 +159,7 @@ private:
             obj->starting_completes_n_previous_objectives = starting_completes_num_previous;
             obj->parent = this;
             objectives.push_back(obj);
+            dispatch_dirty = true;
             return objectives.back();
         }
 
@@ -197,7 +185,10 @@ private:
         bool Draw(); // returns false when should be deleted
         void StopObjectives();
         static ObjectiveSet* FromJson(const nlohmann::json& json);
+        static ObjectiveSet* FromRunInfo(const ObjectiveRunDB::RunInfo& info);
+        void LoadSplits();
         nlohmann::json ToJson();
+        ObjectiveRunDB::Run ToRun();
         void Update() const;
         void GetStartTime(tm* timeinfo) const;
 
@@ -207,6 +198,10 @@ private:
         static unsigned int cur_ui_id;
         char cached_start[16] = {0};
         char cached_time[16] = {0};
+
+        ObjectiveEvents::DispatchTable dispatch_table;
+        std::vector<uint32_t> event_candidates;
+        void BuildDispatchTable();
     };
 
     std::map<DWORD, ObjectiveSet*> objective_sets{};
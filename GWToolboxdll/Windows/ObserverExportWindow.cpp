@@ -72,7 +72,7 @@ nlohmann::json ObserverExportWindow::ToJSON_V_0_1()
                     json_agent["secondary"] = agent->secondary;
                     json_agent["profession"] = agent->profession;
                     json_agent["stats"] = shared_stats_to_json(agent->stats);
-                    for (const auto skill_id : agent->stats.skill_ids_used) {
+                    for (const auto skill_id : agent->stats.skills_used.Keys()) {
                         // parties -> party -> agents -> agent -> skills
                         ObserverModule::ObservableSkill* skill = ObserverModule::Instance().GetObservableSkillById(skill_id);
                         if (!skill) {
@@ -306,88 +306,48 @@ nlohmann::json ObserverExportWindow::ToJSON_V_1_0()
         // attacks
 
         // attacks dealt (by agent)
-        for (auto& [target_id, action] : agent->stats.attacks_dealt_to_agents) {
-            std::string target_id_s = std::to_string(target_id);
-            if (!action) {
-                json["agents"]["by_id"][agent_id_s]["stats"]["attacks_dealt_to_agents"][target_id_s] = nlohmann::json::value_t::null;
-                continue;
-            }
-            json["agents"]["by_id"][agent_id_s]["stats"]["attacks_dealt_to_agents"][target_id_s] = action_to_json(*action);
+        for (const auto& [target_id, action] : std::views::zip(agent->stats.attacks_dealt_to_agents.Keys(), agent->stats.attacks_dealt_to_agents.Values())) {
+            json["agents"]["by_id"][agent_id_s]["stats"]["attacks_dealt_to_agents"][std::to_string(target_id)] = action_to_json(action);
         }
 
         // attacks received (by agent)
-        for (auto& [caster_id, action] : agent->stats.attacks_received_from_agents) {
-            std::string caster_id_s = std::to_string(caster_id);
-            if (!action) {
-                json["agents"]["by_id"][agent_id_s]["stats"]["attacks_received_from_agents"][caster_id_s] = nlohmann::json::value_t::null;
-                continue;
-            }
-            json["agents"]["by_id"][agent_id_s]["stats"]["attacks_received_from_agents"][caster_id_s] = action_to_json(*action);
+        for (const auto& [caster_id, action] : std::views::zip(agent->stats.attacks_received_from_agents.Keys(), agent->stats.attacks_received_from_agents.Values())) {
+            json["agents"]["by_id"][agent_id_s]["stats"]["attacks_received_from_agents"][std::to_string(caster_id)] = action_to_json(action);
         }
 
         // skills
 
         // skills used
-        json["agents"]["by_id"][agent_id_s]["stats"]["skill_ids_used"] = agent->stats.skill_ids_used;
-        for (auto skill_id : agent->stats.skill_ids_used) {
-            std::string skill_id_s = std::to_string(std::to_underlying(skill_id));
-            const auto it_skill = agent->stats.skills_used.find(skill_id);
-            if (it_skill == agent->stats.skills_used.end()) {
-                json["agents"]["by_id"][agent_id_s]["stats"]["skills_used"][skill_id_s] = nlohmann::json::value_t::null;
-                continue;
-            }
-            json["agents"]["by_id"][agent_id_s]["stats"]["skills_used"][skill_id_s] = action_to_json(*it_skill->second);
-            json["agents"]["by_id"][agent_id_s]["stats"]["skills_used"][skill_id_s]["skill_id"] = it_skill->second->skill_id;
+        json["agents"]["by_id"][agent_id_s]["stats"]["skill_ids_used"] = agent->stats.skills_used.Keys();
+        for (const auto& skill : agent->stats.skills_used.Values()) {
+            std::string skill_id_s = std::to_string(std::to_underlying(skill.skill_id));
+            json["agents"]["by_id"][agent_id_s]["stats"]["skills_used"][skill_id_s] = action_to_json(skill);
+            json["agents"]["by_id"][agent_id_s]["stats"]["skills_used"][skill_id_s]["skill_id"] = skill.skill_id;
         }
 
         // skills received
-        json["agents"]["by_id"][agent_id_s]["stats"]["skill_ids_received"] = agent->stats.skill_ids_received;
-        for (auto skill_id : agent->stats.skill_ids_received) {
-            std::string skill_id_s = std::to_string(std::to_underlying(skill_id));
-            const auto it_skill = agent->stats.skills_received.find(skill_id);
-            if (it_skill == agent->stats.skills_received.end()) {
-                json["agents"]["by_id"][agent_id_s]["stats"]["skills_received"][skill_id_s] = nlohmann::json::value_t::null;
-                continue;
-            }
-            json["agents"]["by_id"][agent_id_s]["stats"]["skills_received"][skill_id_s] = action_to_json(*it_skill->second);
-            json["agents"]["by_id"][agent_id_s]["stats"]["skills_received"][skill_id_s]["skill_id"] = it_skill->second->skill_id;
+        json["agents"]["by_id"][agent_id_s]["stats"]["skill_ids_received"] = agent->stats.skills_received.Keys();
+        for (const auto& skill : agent->stats.skills_received.Values()) {
+            std::string skill_id_s = std::to_string(std::to_underlying(skill.skill_id));
+            json["agents"]["by_id"][agent_id_s]["stats"]["skills_received"][skill_id_s] = action_to_json(skill);
+            json["agents"]["by_id"][agent_id_s]["stats"]["skills_received"][skill_id_s]["skill_id"] = skill.skill_id;
         }
 
         // skills used (by agent)
-        for (auto& [target_id, agent_skill_ids] : agent->stats.skill_ids_used_on_agents) {
+        for (const auto& [target_id, skills] : std::views::zip(agent->stats.skills_used_on_agents.Keys(), agent->stats.skills_used_on_agents.Values())) {
             std::string target_id_s = std::to_string(target_id);
-            auto it_target = agent->stats.skills_used_on_agents.find(target_id);
-            if (it_target == agent->stats.skills_used_on_agents.end()) {
-                json["agents"]["by_id"][agent_id_s]["stats"]["skills_used_on_agents"][target_id_s] = nlohmann::json::value_t::null;
-                continue;
-            }
-            for (auto skill_id : agent_skill_ids) {
-                std::string skill_id_s = std::to_string(std::to_underlying(skill_id));
-                auto it_skill = it_target->second.find(skill_id);
-                if (it_skill == it_target->second.end()) {
-                    json["agents"]["by_id"][agent_id_s]["stats"]["skills_used_on_agents"][target_id_s][skill_id_s] = nlohmann::json::value_t::null;
-                    continue;
-                }
-                json["agents"]["by_id"][agent_id_s]["stats"]["skills_used_on_agents"][target_id_s][skill_id_s] = action_to_json(*it_skill->second);
+            for (const auto& skill : skills.Values()) {
+                std::string skill_id_s = std::to_string(std::to_underlying(skill.skill_id));
+                json["agents"]["by_id"][agent_id_s]["stats"]["skills_used_on_agents"][target_id_s][skill_id_s] = action_to_json(skill);
             }
         }
 
         // skills received (by agent)
-        for (auto& [caster_id, agent_skill_ids] : agent->stats.skill_ids_received_from_agents) {
+        for (const auto& [caster_id, skills] : std::views::zip(agent->stats.skills_received_from_agents.Keys(), agent->stats.skills_received_from_agents.Values())) {
             std::string caster_id_s = std::to_string(caster_id);
-            auto it_target = agent->stats.skills_received_from_agents.find(caster_id);
-            if (it_target == agent->stats.skills_received_from_agents.end()) {
-                json["agents"]["by_id"][agent_id_s]["stats"]["skills_received_from_agents"][caster_id_s] = nlohmann::json::value_t::null;
-                continue;
-            }
-            for (auto skill_id : agent_skill_ids) {
-                std::string skill_id_s = std::to_string(std::to_underlying(skill_id));
-                auto it_skill = it_target->second.find(skill_id);
-                if (it_skill == it_target->second.end()) {
-                    json["agents"]["by_id"][agent_id_s]["stats"]["skills_received_from_agents"][caster_id_s][skill_id_s] = nlohmann::json::value_t::null;
-                    continue;
-                }
-                json["agents"]["by_id"][agent_id_s]["stats"]["skills_received_from_agents"][caster_id_s][skill_id_s] = action_to_json(*it_skill->second);
+            for (const auto& skill : skills.Values()) {
+                std::string skill_id_s = std::to_string(std::to_underlying(skill.skill_id));
+                json["agents"]["by_id"][agent_id_s]["stats"]["skills_received_from_agents"][caster_id_s][skill_id_s] = action_to_json(skill);
             }
         }
     }
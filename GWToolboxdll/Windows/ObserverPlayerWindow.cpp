@@ -138,21 +138,16 @@ void ObserverPlayerWindow::DrawAction(const std::string& name, const ObserverMod
 }
 
 // Draw the skills of a player
-void ObserverPlayerWindow::DrawSkills(const std::unordered_map<GW::Constants::SkillID, ObserverModule::ObservedSkill*>& skills,
-                                      const std::vector<GW::Constants::SkillID>& skill_ids) const
+void ObserverPlayerWindow::DrawSkills(const ObserverModule::ObservedSkillTable& skills) const
 {
     auto i = 0u;
-    for (auto skill_id : skill_ids) {
+    for (const auto& usages : skills.Values()) {
         i += 1;
-        ObserverModule::ObservableSkill* skill = ObserverModule::Instance().GetObservableSkillById(skill_id);
+        ObserverModule::ObservableSkill* skill = ObserverModule::Instance().GetObservableSkillById(usages.skill_id);
         if (!skill) {
             continue;
         }
-        auto it_usages = skills.find(skill_id);
-        if (it_usages == skills.end()) {
-            continue;
-        }
-        DrawAction(("# " + std::to_string(i) + ". " + skill->Name()).c_str(), it_usages->second);
+        DrawAction(("# " + std::to_string(i) + ". " + skill->Name()).c_str(), &usages);
     }
 }
 
@@ -193,7 +188,7 @@ void ObserverPlayerWindow::Draw(IDirect3DDevice9*)
             ImGui::Text("Skills:");
             DrawHeaders();
             ImGui::Separator();
-            DrawSkills(tracking->stats.skills_used, tracking->stats.skill_ids_used);
+            DrawSkills(tracking->stats.skills_used);
         }
 
         if (show_comparison && compared && !(!show_skills_used_on_self && tracking && compared->agent_id == tracking->agent_id)) {
@@ -202,11 +197,8 @@ void ObserverPlayerWindow::Draw(IDirect3DDevice9*)
             ImGui::Text(("Skills used on: "s + compared->DisplayName()).c_str());
             DrawHeaders();
             ImGui::Separator();
-            const auto it_used_on_agent_skills = tracking->stats.skills_used_on_agents.find(compared->agent_id);
-            const auto it_used_on_agent_skill_ids = tracking->stats.skill_ids_used_on_agents.find(compared->agent_id);
-            if (it_used_on_agent_skills != tracking->stats.skills_used_on_agents.end() &&
-                it_used_on_agent_skill_ids != tracking->stats.skill_ids_used_on_agents.end()) {
-                DrawSkills(it_used_on_agent_skills->second, it_used_on_agent_skill_ids->second);
+            if (const auto used_on_agent = tracking->stats.skills_used_on_agents.Find(compared->ordinal)) {
+                DrawSkills(*used_on_agent);
             }
         }
     }
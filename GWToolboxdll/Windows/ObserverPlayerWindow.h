@@ -24,8 +24,7 @@ public:
     void DrawHeaders() const;
     void DrawAction(const std::string& name, const ObserverModule::ObservedAction* action) const;
 
-    void DrawSkills(const std::unordered_map<GW::Constants::SkillID, ObserverModule::ObservedSkill*>& skills,
-                    const std::vector<GW::Constants::SkillID>& skill_ids) const;
+    void DrawSkills(const ObserverModule::ObservedSkillTable& skills) const;
 
     [[nodiscard]] const char* Name() const override { return "Observer Player"; }
     [[nodiscard]] const char* Icon() const override { return ICON_FA_EYE; }
@@ -14,9 +14,11 @@
 #include <GWCA/Managers/UIMgr.h>
 #include <GWCA/Managers/MapMgr.h>
 #include <GWCA/Managers/GameThreadMgr.h>
+#include <GWCA/Managers/MemoryMgr.h>
 
 #include <Logger.h>
 #include <Utils/GuiUtils.h>
+#include <Utils/PacketCapture.h>
 
 #include <Modules/Resources.h>
 #include <Windows/PacketLoggerWindow.h>
@@ -157,6 +159,12 @@ namespace {
     bool blocked_packets[packet_max] = {false};
     GW::HookEntry hook_entry;
 
+    // Raw packets are written here instead of being printed while capture is on
+    bool capture_to_file = false;
+    PacketCapture::Writer capture;
+    // Anything bigger than this is a bad field walk rather than a real packet
+    constexpr size_t max_capture_size = 0x4000;
+
     void printchar(const wchar_t c)
     {
         if (c >= L' ' && c <= L'~') {
@@ -518,6 +526,114 @@ namespace {
         }
     }
 
+    // Number of bytes PrintNestedField would consume for this packet, without printing anything
+    size_t GetNestedFieldSize(const uint32_t* fields, const uint32_t n_fields, const uint32_t repeat, const uint8_t* bytes)
+    {
+        const uint8_t* start = bytes;
+        for (uint32_t rep = 0; rep < repeat && static_cast<size_t>(bytes - start) < max_capture_size; rep++) {
+            for (auto i = 0u; i < n_fields; i++) {
+                const uint32_t field = fields[i];
+                const uint32_t type = field >> 0 & 0xF;
+                const uint32_t size = field >> 4 & 0xF;
+                const uint32_t count = field >> 8 & 0xFFFF;
+                const FieldType field_type = GetField(type, size, count);
+
+                if (field_type == FieldType::NestedStruct) {
+                    uint32_t struct_count;
+                    memcpy(&struct_count, bytes, sizeof(struct_count));
+                    bytes += sizeof(struct_count);
+                    bytes += GetNestedFieldSize(fields + i + 1, n_fields - (i + 1), struct_count, bytes);
+                    break;
+                }
+                switch (field_type) {
+                    case FieldType::AgentId:
+                    case FieldType::Float:
+                    case FieldType::Byte:
+                    case FieldType::Word:
+                    case FieldType::Dword:
+                        bytes += 4;
+                        break;
+                    case FieldType::Vect2:
+                        bytes += 8;
+                        break;
+                    case FieldType::Vect3:
+                        bytes += 12;
+                        break;
+                    case FieldType::Blob:
+                    case FieldType::Array8:
+                        bytes += count;
+                        break;
+                    case FieldType::String16:
+                        bytes += count * 2;
+                        break;
+                    case FieldType::Array16:
+                        bytes += 4 + count * 2;
+                        break;
+                    case FieldType::Array32:
+                        bytes += 4 + count * 4;
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+        return static_cast<size_t>(bytes - start);
+    }
+
+    void StopCapture()
+    {
+        if (!capture.IsOpen()) {
+            return;
+        }
+        const auto dropped = capture.DroppedCount();
+        capture.Close();
+        if (dropped) {
+            Log::Warning("Packet capture dropped %u packets", dropped);
+        }
+    }
+
+    bool StartCapture()
+    {
+        StopCapture();
+        InitStoC();
+        if (!game_server_handler.m_buffer) {
+            Log::Error("Packet handlers not ready yet");
+            return false;
+        }
+        const auto folder = Resources::GetPath(L"packet_logs");
+        if (!Resources::EnsureFolderExists(folder)) {
+            Log::Error("Failed to create packet_logs folder");
+            return false;
+        }
+        std::vector<PacketCapture::FieldTable> field_tables;
+        field_tables.reserve(game_server_handler.size());
+        for (const auto& handler : game_server_handler) {
+            field_tables.emplace_back(handler.fields, handler.fields + handler.field_count);
+        }
+        PacketCapture::FileHeader header;
+        header.gw_version = GW::MemoryMgr::GetGWVersion();
+        header.handler_count = static_cast<uint32_t>(field_tables.size());
+        header.started_at = static_cast<uint64_t>(time(nullptr));
+        const auto now = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+        const auto path = folder / std::format(L"{:%Y%m%d_%H%M%S}.gwpcap", now);
+        if (!capture.Open(path, header, field_tables)) {
+            Log::ErrorW(L"Failed to open packet capture %s", path.wstring().c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // Cheap enough to run in the packet hook; no formatting, just a walk of the field table and a memcpy
+    void CapturePacket(const StoCHandler& handler, const GW::Packet::StoC::PacketBase* packet)
+    {
+        const auto packet_raw = reinterpret_cast<const uint8_t*>(packet);
+        const size_t size = sizeof(uint32_t) + GetNestedFieldSize(handler.fields + 1, handler.field_count - 1, 1, packet_raw + sizeof(uint32_t));
+        PacketCapture::Record record;
+        GetSystemTimeAsFileTime(reinterpret_cast<FILETIME*>(&record.local_time));
+        record.instance_time = GW::Map::GetInstanceTime();
+        record.size = static_cast<uint32_t>(std::min(size, max_capture_size));
+        capture.Append(record, packet_raw);
+    }
 }
 
 
@@ -553,6 +669,10 @@ void PacketLoggerWindow::PacketHandler(GW::HookStatus* status, GW::Packet::StoC:
     }
 
     const StoCHandler handler = game_server_handler.at(packet->header);
+    if (capture.IsOpen()) {
+        CapturePacket(handler, packet);
+        return;
+    }
     auto packet_raw = reinterpret_cast<uint8_t*>(packet);
 
     uint8_t** bytes = &packet_raw;
@@ -581,11 +701,15 @@ std::string PacketLoggerWindow::PrefixTimestamp(std::string message) const
     if (timestamp_type == TimestampType_None) {
         return message;
     }
+    SYSTEMTIME time;
+    GetLocalTime(&time);
+    return PrefixTimestamp(std::move(message), time, GW::Map::GetInstanceTime());
+}
 
+std::string PacketLoggerWindow::PrefixTimestamp(std::string message, const SYSTEMTIME& time, const uint32_t instance_time) const
+{
     switch (timestamp_type) {
         case TimestampType_Local: {
-            SYSTEMTIME time;
-            GetLocalTime(&time);
             bool prependColon = false;
             char t[4];
             std::string time_s = "[";
@@ -620,7 +744,7 @@ std::string PacketLoggerWindow::PrefixTimestamp(std::string message) const
             return time_s + "] " + message;
         }
         case TimestampType_Instance: {
-            auto ms = std::chrono::milliseconds(GW::Map::GetInstanceTime());
+            auto ms = std::chrono::milliseconds(instance_time);
             auto secs = std::chrono::duration_cast<std::chrono::seconds>(ms);
             ms -= std::chrono::duration_cast<std::chrono::milliseconds>(secs);
             auto mins = std::chrono::duration_cast<std::chrono::minutes>(secs);
@@ -661,6 +785,47 @@ std::string PacketLoggerWindow::PrefixTimestamp(std::string message) const
     }
 }
 
+void PacketLoggerWindow::PrintCaptureFile(const std::filesystem::path& path) const
+{
+    PacketCapture::FileHeader header;
+    std::vector<PacketCapture::FieldTable> field_tables;
+    std::vector<uint8_t> buffer;
+    std::vector<const PacketCapture::Record*> records;
+    if (!PacketCapture::Read(path, header, field_tables, buffer, records)) {
+        Log::ErrorW(L"Failed to read packet capture %s", path.wstring().c_str());
+        return;
+    }
+    if (header.gw_version != GW::MemoryMgr::GetGWVersion()) {
+        Log::Warning("Packet capture was recorded on Gw.exe build %u", header.gw_version);
+    }
+    // Padded copy so a bad field walk can't read past the end of the record
+    std::vector<uint8_t> packet_bytes;
+    for (const auto record : records) {
+        if (record->size < sizeof(uint32_t)) {
+            continue;
+        }
+        packet_bytes.assign(PacketCapture::Packet(record), PacketCapture::Packet(record) + record->size);
+        packet_bytes.resize(record->size + max_capture_size);
+        uint8_t* packet_raw = packet_bytes.data();
+        uint32_t packet_header;
+        Serialize<uint32_t>(&packet_raw, &packet_header);
+
+        FILETIME utc_time;
+        memcpy(&utc_time, &record->local_time, sizeof(utc_time));
+        SYSTEMTIME utc_system_time, local_time;
+        FileTimeToSystemTime(&utc_time, &utc_system_time);
+        SystemTimeToTzSpecificLocalTime(nullptr, &utc_system_time, &local_time);
+
+        printf(PrefixTimestamp("StoC packet(%u 0x%X) {\n", local_time, record->instance_time).c_str(), packet_header, packet_header);
+        if (log_packet_content && packet_header < field_tables.size() && !field_tables[packet_header].empty()) {
+            auto& fields = field_tables[packet_header];
+            PrintNestedField(fields.data() + 1, static_cast<uint32_t>(fields.size() - 1), 1, &packet_raw, 4);
+            printf("} endpacket(%u 0x%X)\n", packet_header, packet_header);
+        }
+    }
+    Log::InfoW(L"Printed %zu packets from %s", records.size(), path.filename().wstring().c_str());
+}
+
 void PacketLoggerWindow::AddMessageLog(const wchar_t* encoded)
 {
     const std::wstring encoded_ws(encoded);
@@ -723,6 +888,29 @@ void PacketLoggerWindow::Draw(IDirect3DDevice9*)
     }
     ImGui::ShowHelp("Log outgoing and incoming packet contents in debug console");
     ImGui::SameLine();
+    if (ImGui::Checkbox("Capture to file", &capture_to_file)) {
+        if (capture_to_file) {
+            capture_to_file = StartCapture();
+        }
+        else {
+            StopCapture();
+        }
+    }
+    ImGui::ShowHelp("While packet logging is enabled, write raw StoC packets to the packet_logs folder instead of printing them.\n"
+                    "Much cheaper than printing to the console; use 'Print capture file' to decode it afterwards.");
+    if (capture.IsOpen()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%.1f KB, %u dropped", static_cast<float>(capture.BytesWritten()) / 1024.f, capture.DroppedCount());
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Print capture file...")) {
+        Resources::OpenFileDialog([](const char* path) {
+            if (path) {
+                Instance().PrintCaptureFile(TextUtils::StringToWString(path));
+            }
+        }, "gwpcap", Resources::GetPath(L"packet_logs").string().c_str());
+    }
+    ImGui::ShowHelp("Decode a packet capture to the debug console.\nPacket contents are only printed if 'Log Packet Content' is ticked.");
     ImGui::Checkbox("Log Packet Content", &log_packet_content);
     ImGui::SameLine();
     ImGui::Checkbox("Auto ignore incoming packets", &auto_ignore_packets);
@@ -932,6 +1120,7 @@ void PacketLoggerWindow::Disable()
     logger_enabled = false;
 }
 void PacketLoggerWindow::Terminate() {
+    StopCapture();
     ClearMessageLog();
 }
 void PacketLoggerWindow::Enable()
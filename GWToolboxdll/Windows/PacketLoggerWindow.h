@@ -36,6 +36,9 @@ public:
     void CtoSHandler(const GW::HookStatus* status, void* packet) const;
     static std::string PadLeft(std::string input, uint8_t count, char c);
     std::string PrefixTimestamp(std::string message) const;
+    std::string PrefixTimestamp(std::string message, const SYSTEMTIME& time, uint32_t instance_time) const;
+    // Decode a file written by "Capture to file" to the debug console, using the field tables stored in the file
+    void PrintCaptureFile(const std::filesystem::path& path) const;
 
 private:
     enum TimestampType : int {
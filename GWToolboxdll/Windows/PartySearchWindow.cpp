@@ -31,14 +31,7 @@
 #include <GWToolbox.h>
 #include <Utils/TextUtils.h>
 
-// Every connection cost 30 seconds.
-// You have 2 tries.
-// After that, you can try every 30 seconds.
-static constexpr uint32_t COST_PER_CONNECTION_MS = 30 * 1000;
-static constexpr uint32_t COST_PER_CONNECTION_MAX_MS = 60 * 1000;
-using easywsclient::WebSocket;
-using nlohmann::json;
-using json_vec = std::vector<json>;
+using WebSocketFeeds::Status;
 
 static constexpr char ws_host[] = "wss://lfg.gwtoolbox.com";
 static constexpr char https_host[] = "https://lfg.gwtoolbox.com";
@@ -251,18 +244,6 @@ void PartySearchWindow::Initialize()
     party_advertisements.reserve(100);
     messages = CircularBuffer<Message>(100);
 
-    should_stop = false;
-    worker = std::thread([this] {
-        while (!should_stop) {
-            if (thread_jobs.empty()) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            }
-            else {
-                thread_jobs.front()();
-                thread_jobs.pop();
-            }
-        }
-    });
     // local messages
     GW::StoC::RegisterPostPacketCallback(&OnMessageLocal_Entry, GAME_SMSG_PARTY_SEARCH_REMOVE, OnRegionPartyUpdated);
     GW::StoC::RegisterPostPacketCallback(&OnMessageLocal_Entry, GAME_SMSG_PARTY_SEARCH_SIZE, OnRegionPartyUpdated);
@@ -467,35 +448,20 @@ void PartySearchWindow::OnRegionPartyUpdated(GW::HookStatus*, GW::Packet::StoC::
 void PartySearchWindow::SignalTerminate()
 {
     ToolboxWindow::SignalTerminate();
-    should_stop = true;
-    if (worker.joinable()) {
-        worker.join();
-    }
-    DeleteWebSocket(ws_window);
-    ws_window = nullptr;
-    if (wsaData.wVersion) {
-        WSACleanup();
-        wsaData = { 0 };
-    }
+    lfg_feed.Close();
 }
 
 void PartySearchWindow::Update(const float)
 {
-    if (ws_window && ws_window->getReadyState() == WebSocket::CLOSED) {
-        delete ws_window;
-        ws_window = nullptr;
-    }
-    if (ws_window && ws_window->getReadyState() != WebSocket::CLOSED) {
-        ws_window->poll();
-    }
     constexpr bool maintain_socket = false; // (visible && !collapsed) || (print_game_chat && GW::UI::GetCheckboxPreference(GW::UI::CheckboxPreference_ChannelTrade) == 0);
     if constexpr (maintain_socket) {
-        AsyncWindowConnect();
+        lfg_feed.Connect(ws_host);
     }
-    if (ws_window && ws_window->getReadyState() == WebSocket::OPEN) {
-        ws_window->close();
-        messages.clear();
-        window_rate_limiter = RateLimiter(); // Deliberately closed; reset rate limiter.
+    else {
+        if (lfg_feed.GetStatus() == Status::Open) {
+            messages.clear();
+        }
+        lfg_feed.Disconnect();
     }
     fetch();
     if (refresh_parties && clock() > refresh_parties) {
@@ -512,40 +478,15 @@ void PartySearchWindow::Update(const float)
     }
 }
 
-bool PartySearchWindow::parse_json_message(const json& js, Message* msg)
-{
-    if (js == json::value_t::discarded) {
-        return false;
-    }
-    if (!(js.contains("s") && js["s"].is_string())
-        || !(js.contains("m") && js["m"].is_string())
-        || !(js.contains("t") && js["t"].is_number_unsigned())) {
-        return false;
-    }
-    msg->name = js["s"].get<std::string>();
-    msg->message = js["m"].get<std::string>();
-    msg->name = js["s"].get<std::string>();
-    msg->timestamp = static_cast<uint32_t>(js["t"].get<uint64_t>() / 1000); // Messy?
-    return true;
-}
-
 void PartySearchWindow::fetch()
 {
-    if (!ws_window || ws_window->getReadyState() != WebSocket::OPEN) {
-        return;
-    }
-
-    ws_window->dispatch([this](const std::string& data) {
-        const json& res = json::parse(data.c_str(), nullptr, false);
-        if (res == json::value_t::discarded) {
-            Log::Log("ERROR: Failed to parse res JSON from response in ws_window->dispatch\n");
-            return;
+    WebSocketFeeds::Event event;
+    while (lfg_feed.Poll(event)) {
+        if (event.type != WebSocketFeeds::Event::Type::Message) {
+            continue;
         }
         // Add to message feed
-        Message msg;
-        if (!parse_json_message(res, &msg)) {
-            return; // Not valid message object
-        }
+        auto& msg = event.messages[0];
         messages.add(msg);
 
         // Check alerts
@@ -559,7 +500,7 @@ void PartySearchWindow::fetch()
             swprintf(buffer, 512, L"<a=1>%s</a>: <c=#f96677><quote>%s", name_ws.c_str(), msg_ws.c_str());
             WriteChat(GW::Chat::Channel::CHANNEL_TRADE, buffer);
         }
-    });
+    }
 }
 
 bool PartySearchWindow::IsLfpAlert(std::string& message) const
@@ -620,7 +561,7 @@ void PartySearchWindow::Draw(IDirect3DDevice9*)
     /* Main trade chat area */
 
     /* Connection checks */
-    /*if (!ws_window && !ws_window_connecting) {
+    /*if (lfg_feed.GetStatus() == Status::Disconnected) {
         char buf[255];
         snprintf(buf, 255, "The connection to %s has timed out.", ws_host);
         ImGui::SetCursorPosX((ImGui::GetWindowWidth() - ImGui::CalcTextSize(buf).x) / 2);
@@ -628,10 +569,10 @@ void PartySearchWindow::Draw(IDirect3DDevice9*)
         ImGui::Text(buf);
         ImGui::SetCursorPosX((ImGui::GetWindowWidth() - ImGui::CalcTextSize("Click to reconnect").x) / 2);
         if (ImGui::Button("Click to reconnect")) {
-            AsyncWindowConnect(true);
+            lfg_feed.Reconnect();
         }
         display_messages = false;
-    } else if (ws_window_connecting || (ws_window && ws_window->getReadyState() == WebSocket::CONNECTING)) {
+    } else if (lfg_feed.GetStatus() == Status::Connecting) {
         ImGui::SetCursorPosX((ImGui::GetWindowWidth() - ImGui::CalcTextSize("Connecting...").x) / 2);
         ImGui::SetCursorPosY(ImGui::GetWindowHeight() / 2);
         ImGui::Text("Connecting...");
@@ -814,42 +755,3 @@ void PartySearchWindow::ParseBuffer(const char* text, std::vector<std::string>&
         words.push_back(word);
     }
 }
-
-void PartySearchWindow::AsyncWindowConnect(const bool force)
-{
-    if (ws_window) {
-        return;
-    }
-    if (ws_window_connecting) {
-        return;
-    }
-    if (!force && !window_rate_limiter.AddTime(COST_PER_CONNECTION_MS, COST_PER_CONNECTION_MAX_MS)) {
-        return;
-    }
-    int res;
-    if (!wsaData.wVersion && (res = WSAStartup(MAKEWORD(2, 2), &wsaData)) != 0) {
-        printf("Failed to call WSAStartup: %d\n", res);
-        return;
-    }
-    ws_window_connecting = true;
-    thread_jobs.push([this] {
-        if ((ws_window = WebSocket::from_url(ws_host)) == nullptr) {
-            printf("Couldn't connect to the host '%s'", ws_host);
-        }
-        ws_window_connecting = false;
-    });
-}
-
-void PartySearchWindow::DeleteWebSocket(WebSocket* ws)
-{
-    if (!ws) {
-        return;
-    }
-    if (ws->getReadyState() == WebSocket::OPEN) {
-        ws->close();
-    }
-    while (ws->getReadyState() != WebSocket::CLOSED) {
-        ws->poll();
-    }
-    delete ws;
-}
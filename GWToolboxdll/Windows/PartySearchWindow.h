@@ -2,7 +2,7 @@
 
 #include <CircurlarBuffer.h>
 #include <ToolboxWindow.h>
-#include <Utils/RateLimiter.h>
+#include <Utils/WebSocketFeeds.h>
 
 class PartySearchWindow : public ToolboxWindow {
 public:
@@ -37,11 +37,7 @@ public:
     void DrawSettingsInternal() override;
 
 private:
-    struct Message {
-        uint32_t timestamp = 0;
-        std::string name;
-        std::string message;
-    };
+    using Message = WebSocketFeeds::ChatMessage;
 
     struct TBParty {
         TBParty()
@@ -75,8 +71,6 @@ private:
 
     std::unordered_map<std::wstring, TBParty*> party_advertisements{};
 
-    WSAData wsaData = {0};
-
     bool show_alert_window = false;
     std::recursive_mutex party_mutex;
 
@@ -92,11 +86,6 @@ private:
     char search_buffer[256] = {0};
     std::vector<std::string> alert_words{};
     std::vector<std::string> searched_words{};
-    // tasks to be done async by the worker thread
-    std::queue<std::function<void()>> thread_jobs{};
-    bool should_stop = false;
-    std::thread worker;
-    bool ws_window_connecting = false;
 
     clock_t refresh_parties = 0;
     bool display_party_types[6] = {true, true, true, false, true, true};
@@ -104,8 +93,7 @@ private:
     bool ignore_party_types[6] = {false, false, false, false, false, false};
     uint32_t max_party_size = 0;
 
-    easywsclient::WebSocket* ws_window = nullptr;
-    RateLimiter window_rate_limiter;
+    WebSocketFeeds::Feed lfg_feed;
 
     CircularBuffer<Message> messages;
 
@@ -115,11 +103,9 @@ private:
     void ClearParties();
     void FillParties();
     void DrawAlertsWindowContent(bool ownwindow);
-    void AsyncWindowConnect(bool force = false);
+    // Drains events handed over by the feed thread
     void fetch();
-    static bool parse_json_message(const nlohmann::json& js, Message* msg);
     static void ParseBuffer(const char* text, std::vector<std::string>& words);
-    static void DeleteWebSocket(easywsclient::WebSocket* ws);
     bool IsLfpAlert(std::string& message) const;
     static void OnRegionPartyUpdated(GW::HookStatus*, GW::Packet::StoC::PacketBase* packet);
 };
@@ -24,18 +24,14 @@
 #include <Windows/TradeWindow.h>
 #include <GWToolbox.h>
 #include <Utils/TextUtils.h>
+#include <Utils/TradeHistory.h>
+#include <Utils/WebSocketFeeds.h>
 
 namespace {
     GW::HookEntry ChatCmd_HookEntry;
-    // Every connection cost 30 seconds.
-    // You have 2 tries.
-    // After that, you can try every 30 seconds.
-    constexpr uint32_t COST_PER_CONNECTION_MS = 30 * 1000;
-    constexpr uint32_t COST_PER_CONNECTION_MAX_MS = 60 * 1000;
     static const char* months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
-    using easywsclient::WebSocket;
     using nlohmann::json;
-    using json_vec = std::vector<json>;
+    using WebSocketFeeds::Status;
 
     constexpr char ws_host_kmd[] = "wss://kamadan.gwtoolbox.com";
     constexpr char https_host_kmd[] = "https://kamadan.gwtoolbox.com";
@@ -48,18 +44,12 @@ namespace {
         return buff ? buff->begin() : nullptr;
     }
 
-    struct Message {
-        uint32_t timestamp = 0;
-        std::string name;
-        std::string message;
-    };
+    using Message = WebSocketFeeds::ChatMessage;
 
     GW::HookEntry OnPartySearch_Entry;
     GW::PartySearch player_party_search = { 0 };
     char player_party_search_text[64] = { 0 };
 
-    WSAData wsaData = { 0 };
-
     bool is_kamadan_chat = true;
     bool refresh_footer = false;
 
@@ -94,52 +84,56 @@ namespace {
 
     CircularBuffer<Message> messages;
 
-    bool ws_window_connecting = false;
-
-    easywsclient::WebSocket* ws_window = nullptr;
-
-    RateLimiter window_rate_limiter;
+    // Connection, reconnect backoff and JSON parsing all happen on the shared feed thread
+    WebSocketFeeds::Feed trade_feed;
 
     bool external_trade_message = false;
 
-    void search(const std::string& query, const bool print_results_in_chat = false)
+    TradeHistory::Channel CurrentChannel()
     {
-        pending_query_string = query.empty() ? " " : query;
-        print_search_results = print_results_in_chat;
-        pending_query_sent = 0;
+        return is_kamadan_chat ? TradeHistory::Channel::Kamadan : TradeHistory::Channel::Ascalon;
     }
 
-    bool parse_json_message(const json& js, Message* msg)
+    void PrintSearchResult(const Message& msg)
     {
-        if (js == json::value_t::discarded) {
-            return false;
-        }
-        if (!(js.contains("s") && js["s"].is_string())) {
-            return false;
+        std::wstring name_ws = TextUtils::StringToWString(msg.name);
+        std::wstring msg_ws = TextUtils::StringToWString(msg.message);
+        time_t ts = msg.timestamp;
+        tm* local_tm = localtime(&ts);
+        if (local_tm) {
+            wchar_t buf[512];
+            swprintf(buf, 512, L"<a=1>%s</a> @ %S %d, %02d:%02d: <c=#f96677><quote>%s", name_ws.c_str(), months[local_tm->tm_mon], local_tm->tm_mday, local_tm->tm_hour, local_tm->tm_min, msg_ws.c_str());
+            WriteChat(GW::Chat::Channel::CHANNEL_TRADE, buf,nullptr,true);
         }
-        msg->name = js["s"].get<std::string>();
-        if (!(js.contains("m") && js["m"].is_string())) {
-            return false;
-        }
-        msg->message = js["m"].get<std::string>();
-        if (!js.contains("t")) {
-            return false;
-        }
-        unsigned long long timestamp_ull = 0ull;
-        if (js["t"].is_string()) {
-            const auto str = js["t"].get<std::string>();
-            timestamp_ull = strtoull(str.c_str(), nullptr, 10);
+    }
+
+    // Answer from the local history straight away; the server's reply replaces this when (if) it arrives
+    void SearchLocalHistory(const std::string& query, const bool print_results_in_chat)
+    {
+        std::vector<TradeHistory::Entry> results;
+        if (!TradeHistory::Search(CurrentChannel(), query, 100, results)) {
+            return;
         }
-        else if (js["t"].is_number_unsigned()) {
-            timestamp_ull = js["t"].get<uint64_t>();
+        messages.clear();
+        for (auto it = results.rbegin(); it != results.rend(); ++it) {
+            messages.add({it->timestamp, std::move(it->name), std::move(it->message)});
         }
-        if (timestamp_ull == 0ull) {
-            return false;
+        if (print_results_in_chat && trade_feed.GetStatus() != WebSocketFeeds::Status::Open) {
+            // Offline; don't wait for the server
+            for (size_t i = 0; i < results.size() && i < 12; i++) {
+                PrintSearchResult(messages[messages.size() - 1 - i]);
+            }
+            print_search_results = false;
         }
-        msg->timestamp = static_cast<uint32_t>(timestamp_ull / 1000); // Messy?
-        return true;
     }
 
+    void search(const std::string& query, const bool print_results_in_chat = false)
+    {
+        pending_query_string = query.empty() ? " " : query;
+        print_search_results = print_results_in_chat;
+        pending_query_sent = 0;
+        SearchLocalHistory(query, print_results_in_chat);
+    }
 
     void CHAT_CMD_FUNC(CmdPricecheck)
     {
@@ -231,19 +225,8 @@ void TradeWindow::Initialize()
     ToolboxWindow::Initialize();
 
     messages = CircularBuffer<Message>(100);
+    TradeHistory::Load(Resources::GetPath(L"trade_history.bin"));
 
-    should_stop = false;
-    worker = new std::thread([this] {
-        while (!should_stop) {
-            if (thread_jobs.empty()) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            }
-            else {
-                thread_jobs.front()();
-                thread_jobs.pop();
-            }
-        }
-    });
     GW::Chat::CreateCommand(&ChatCmd_HookEntry, L"pc", CmdPricecheck);
     // local messages
     GW::StoC::RegisterPostPacketCallback(&OnPartySearch_Entry, GAME_SMSG_PARTY_SEARCH_ADVERTISEMENT, [](GW::HookStatus*, void* pak) {
@@ -274,19 +257,8 @@ void TradeWindow::Initialize()
 void TradeWindow::Terminate()
 {
     ToolboxWindow::Terminate();
-    should_stop = true;
-    if (worker) {
-        ASSERT(worker->joinable());
-        worker->join();
-        delete worker;
-        worker = nullptr;
-    }
-    DeleteWebSocket(ws_window);
-    ws_window = nullptr;
-    if (wsaData.wVersion) {
-        WSACleanup();
-        wsaData = { 0 };
-    }
+    trade_feed.Close();
+    TradeHistory::Terminate();
     GW::Chat::DeleteCommand(&ChatCmd_HookEntry);
     GW::UI::RemoveUIMessageCallback(&OnUIMessage_Entry);
 }
@@ -318,139 +290,103 @@ bool TradeWindow::GetInAscalonAE1(const bool check_district)
 
 void TradeWindow::Update(const float)
 {
-    if (ws_window && ws_window->getReadyState() == WebSocket::CLOSED) {
-        delete ws_window;
-        ws_window = nullptr;
-    }
-    if (ws_window && ws_window->getReadyState() != WebSocket::CLOSED) {
-        ws_window->poll();
-    }
     const bool search_pending = !pending_query_string.empty();
     const bool maintain_socket = (visible && !collapsed) || ((print_game_chat || print_game_chat_asc) && GetPreference(GW::UI::FlagPreference::ChannelTrade) == 0) || search_pending;
-    if (maintain_socket && !ws_window) {
-        AsyncWindowConnect();
+    if (maintain_socket) {
+        trade_feed.Connect(is_kamadan_chat ? ws_host_kmd : ws_host_asc);
     }
-    if (!maintain_socket && ws_window && ws_window->getReadyState() == WebSocket::OPEN) {
-        ws_window->close();
-        messages.clear();
-        window_rate_limiter = RateLimiter(); // Deliberately closed; reset rate limiter.
+    else {
+        if (trade_feed.GetStatus() == Status::Open) {
+            messages.clear();
+        }
+        trade_feed.Disconnect();
     }
     fetch();
 }
 
 void TradeWindow::fetch()
 {
-    if (!ws_window || ws_window->getReadyState() != WebSocket::OPEN) {
-        return;
-    }
     const bool search_pending = !pending_query_sent && !pending_query_string.empty();
-    if (search_pending) {
+    if (search_pending && trade_feed.GetStatus() == Status::Open) {
         //strcpy(search_buffer, pending_query_string.c_str());
-        // Fill searched_words; query to lower to ease on-the-fly search in ::fetch
+        // Fill searched_words; query to lower to ease on-the-fly search on the feed thread
         ParseBuffer(search_buffer, searched_words);
+        trade_feed.SetSearchTerms(searched_words);
 
         // Send request
         json request;
         request["query"] = pending_query_string;
         pending_query_sent = clock();
-        ws_window->send(request.dump());
+        trade_feed.Send(request.dump());
     }
 
-    ws_window->dispatch([this](const std::string& data) {
-        const json& res = json::parse(data.c_str(), nullptr, false);
-        if (res == json::value_t::discarded) {
-            Log::Log("ERROR: Failed to parse res JSON from response in ws_window->dispatch\n");
-            return;
-        }
-        if (res.find("query") != res.end() && res["query"].is_string()) {
-            auto query_string = res["query"].get<std::string>();
-            if (query_string != pending_query_string) {
-                return; // Different query has been made since this search.
-            }
-            pending_query_string.clear();
-            if (!(res.contains("num_results") && res["num_results"].is_number_unsigned())) {
-                Log::Log("ERROR: Failed to parse search results in TradeWindow::fetch\n");
-                print_search_results = false;
-                return;
-            }
-            size_t num_results = res["num_results"].get<size_t>();
-            if (print_search_results && !num_results) {
-                Log::Warning("No results found for %s", query_string.c_str());
-                print_search_results = false;
-                return;
-            }
-            if (!(res.contains("results") && res["results"].is_array())) {
-                Log::Log("ERROR: Failed to parse search results in TradeWindow::fetch\n");
-                print_search_results = false;
-                return;
-            }
-            auto results = res["results"].get<json_vec>();
-            messages.clear();
-            if (print_search_results && !results.size()) {
-                Log::Warning("No results found for %s", query_string.c_str());
-                print_search_results = false;
-                return;
-            }
-            size_t results_size = results.size();
-            for (size_t i = results_size - 1; i < results_size; i--) {
-                Message msg;
-                if (!parse_json_message(results[i], &msg)) {
-                    continue;
-                }
-                messages.add(msg);
-                if (print_search_results && i < 12) {
-                    std::wstring name_ws = TextUtils::StringToWString(msg.name);
-                    std::wstring msg_ws = TextUtils::StringToWString(msg.message);
-                    time_t ts = msg.timestamp;
-                    tm* local_tm = localtime(&ts);
-                    if (local_tm) {
-                        wchar_t buf[512];
-                        swprintf(buf, 512, L"<a=1>%s</a> @ %S %d, %02d:%02d: <c=#f96677><quote>%s", name_ws.c_str(), months[local_tm->tm_mon], local_tm->tm_mday, local_tm->tm_hour, local_tm->tm_min, msg_ws.c_str());
-                        WriteChat(GW::Chat::Channel::CHANNEL_TRADE, buf,nullptr,true);
-                    }
+    WebSocketFeeds::Event event;
+    while (trade_feed.Poll(event)) {
+        switch (event.type) {
+            case WebSocketFeeds::Event::Type::Connected:
+                pending_query_sent = 0; // Resend anything that was in flight on the old connection
+                if (messages.size() == 0 && pending_query_string.empty()) {
+                    search(""); // Initial draw, gets latest N messages
                 }
-            }
-            print_search_results = false;
-            return;
-        }
-        // Add to message feed
-        Message msg;
-        if (!parse_json_message(res, &msg)) {
-            return; // Not valid message object
-        }
-        bool add_to_window = searched_words.empty();
-        if (!add_to_window) {
-            // Currently showing a search term in-window. Only add if it matches all words.
-            add_to_window = true;
-            std::string input(msg.message);
-            std::ranges::transform(input, input.begin(),
-                                   [](const char c) -> char {
-                                       return static_cast<char>(tolower(c));
-                                   });
-            for (auto& term : searched_words) {
-                if (input.find(term) != std::string::npos) {
-                    continue; // Searched word no found; drop out
-                }
-                add_to_window = false;
                 break;
-            }
+            case WebSocketFeeds::Event::Type::Disconnected:
+                break;
+            case WebSocketFeeds::Event::Type::SearchResults:
+                OnSearchResults(event);
+                break;
+            case WebSocketFeeds::Event::Type::Message:
+                OnLiveMessage(event.messages[0], event.matches_search);
+                break;
         }
-        if (add_to_window) {
-            messages.add(msg);
+    }
+}
+
+void TradeWindow::OnSearchResults(const WebSocketFeeds::Event& event)
+{
+    if (event.query != pending_query_string) {
+        return; // Different query has been made since this search.
+    }
+    pending_query_string.clear();
+    messages.clear();
+    if (event.messages.empty()) {
+        if (print_search_results) {
+            Log::Warning("No results found for %s", event.query.c_str());
         }
+        print_search_results = false;
+        return;
+    }
+    const size_t results_size = event.messages.size();
+    for (size_t i = results_size - 1; i < results_size; i--) {
+        const Message& msg = event.messages[i];
+        messages.add(msg);
+        TradeHistory::Add(CurrentChannel(), msg.timestamp, msg.name, msg.message);
+        if (print_search_results && i < 12) {
+            PrintSearchResult(msg);
+        }
+    }
+    print_search_results = false;
+}
+
+void TradeWindow::OnLiveMessage(const WebSocketFeeds::ChatMessage& msg, const bool matches_search)
+{
+    TradeHistory::Add(CurrentChannel(), msg.timestamp, msg.name, msg.message);
+    // Currently showing a search term in-window; the feed thread has already checked it against all words.
+    if (matches_search) {
+        messages.add(msg);
+    }
 
-        // Check alerts
-        // do not display trade chat while in kamadan AE district 1 or Pre-Searing Ascalon AE district 1
-        bool print_message = ((is_kamadan_chat && print_game_chat && !GetInKamadanAE1()) || (!is_kamadan_chat && print_game_chat_asc && !GetInAscalonAE1())) && IsTradeAlert(msg.message);
+    // Check alerts
+    // do not display trade chat while in kamadan AE district 1 or Pre-Searing Ascalon AE district 1
+    std::string message = msg.message;
+    bool print_message = ((is_kamadan_chat && print_game_chat && !GetInKamadanAE1()) || (!is_kamadan_chat && print_game_chat_asc && !GetInAscalonAE1())) && IsTradeAlert(message);
 
-        if (print_message) {
-            std::wstring name_ws = TextUtils::StringToWString(msg.name);
-            std::wstring msg_ws = std::format(L"<c=#f96677><quote>{}",TextUtils::StringToWString(msg.message));
-            external_trade_message = true;
-            WriteChat(GW::Chat::Channel::CHANNEL_TRADE, msg_ws.c_str(),name_ws.c_str());
-            external_trade_message = false;
-        }
-    });
+    if (print_message) {
+        std::wstring name_ws = TextUtils::StringToWString(msg.name);
+        std::wstring msg_ws = std::format(L"<c=#f96677><quote>{}",TextUtils::StringToWString(msg.message));
+        external_trade_message = true;
+        WriteChat(GW::Chat::Channel::CHANNEL_TRADE, msg_ws.c_str(),name_ws.c_str());
+        external_trade_message = false;
+    }
 }
 
 void TradeWindow::FindPlayerPartySearch(GW::HookStatus*, void*)
@@ -584,7 +520,8 @@ void TradeWindow::Draw(IDirect3DDevice9*)
     /* Main trade chat area */
     ImGui::BeginChild("trade_scroll", ImVec2(0, -20.0f - ImGui::GetStyle().ItemInnerSpacing.y));
     /* Connection checks */
-    if (!ws_window && !ws_window_connecting) {
+    const auto feed_status = trade_feed.GetStatus();
+    if (feed_status == Status::Disconnected) {
         char buf[255];
         snprintf(buf, 255, "The connection to %s has timed out.", is_kamadan_chat ? ws_host_kmd : ws_host_asc);
         ImGui::SetCursorPosX((ImGui::GetWindowWidth() - ImGui::CalcTextSize(buf).x) / 2);
@@ -592,10 +529,10 @@ void TradeWindow::Draw(IDirect3DDevice9*)
         ImGui::Text(buf);
         ImGui::SetCursorPosX((ImGui::GetWindowWidth() - ImGui::CalcTextSize("Click to reconnect").x) / 2);
         if (ImGui::Button("Click to reconnect")) {
-            AsyncWindowConnect(true);
+            trade_feed.Reconnect();
         }
     }
-    else if (ws_window_connecting || (ws_window && ws_window->getReadyState() == WebSocket::CONNECTING)) {
+    else if (feed_status == Status::Connecting) {
         ImGui::SetCursorPosX((ImGui::GetWindowWidth() - ImGui::CalcTextSize("Connecting...").x) / 2);
         ImGui::SetCursorPosY(ImGui::GetWindowHeight() / 2);
         ImGui::Text("Connecting...");
@@ -802,53 +739,10 @@ void TradeWindow::ParseBuffer(std::fstream stream, std::vector<std::string>& wor
     }
 }
 
-void TradeWindow::AsyncWindowConnect(const bool force)
-{
-    if (ws_window) {
-        return;
-    }
-    if (ws_window_connecting) {
-        return;
-    }
-    if (!force && !window_rate_limiter.AddTime(COST_PER_CONNECTION_MS, COST_PER_CONNECTION_MAX_MS)) {
-        return;
-    }
-    int res;
-    if (!wsaData.wVersion && (res = WSAStartup(MAKEWORD(2, 2), &wsaData)) != 0) {
-        printf("Failed to call WSAStartup: %d\n", res);
-        return;
-    }
-    ws_window_connecting = true;
-    thread_jobs.push([this] {
-        if ((ws_window = WebSocket::from_url(is_kamadan_chat ? ws_host_kmd : ws_host_asc)) == nullptr) {
-            printf("Couldn't connect to the host '%s'", is_kamadan_chat ? ws_host_kmd : ws_host_asc);
-        }
-        ws_window_connecting = false;
-        if (messages.size() == 0 && pending_query_string.empty()) {
-            search(""); // Initial draw, gets latest N messages
-        }
-    });
-}
-
-void TradeWindow::DeleteWebSocket(WebSocket* ws)
-{
-    if (!ws) {
-        return;
-    }
-    if (ws->getReadyState() == WebSocket::OPEN) {
-        ws->close();
-    }
-    while (ws->getReadyState() != WebSocket::CLOSED) {
-        ws->poll();
-    }
-    delete ws;
-}
-
 void TradeWindow::SwitchSockets()
 {
     refresh_footer = true;
-    DeleteWebSocket(ws_window);
-    ws_window = nullptr;
     messages.clear();
-    AsyncWindowConnect(true);
+    pending_query_sent = 0;
+    // Next Update() hands the new host to the feed thread, which drops the old socket and connects straight away
 }
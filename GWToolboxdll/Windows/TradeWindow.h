@@ -6,7 +6,11 @@
 
 #include <CircurlarBuffer.h>
 #include <ToolboxWindow.h>
-#include <Utils/RateLimiter.h>
+
+namespace WebSocketFeeds {
+    struct ChatMessage;
+    struct Event;
+}
 
 class TradeWindow : public ToolboxWindow {
     TradeWindow() : ToolboxWindow() { show_menubutton = can_show_in_main_window; }
@@ -45,20 +49,13 @@ private:
     static bool GetInKamadanAE1(bool check_district = true);
     static bool GetInAscalonAE1(bool check_district = true);
 
-    // Since we are connecting in an other thread, the following attributes/methods avoid spamming connection requests
-    void AsyncWindowConnect(bool force = false);
-
-
+    // Drains events handed over by the feed thread
     void fetch();
-
-    // tasks to be done async by the worker thread
-    std::queue<std::function<void()>> thread_jobs{};
-    bool should_stop = false;
-    std::thread* worker = nullptr;
+    void OnSearchResults(const WebSocketFeeds::Event& event);
+    void OnLiveMessage(const WebSocketFeeds::ChatMessage& msg, bool matches_search);
 
     static void ParseBuffer(const char* text, std::vector<std::string>& words);
     static void ParseBuffer(std::fstream stream, std::vector<std::string>& words);
 
-    static void DeleteWebSocket(easywsclient::WebSocket* ws);
     void SwitchSockets();
 };
@@ -26,6 +26,7 @@
 #include <Windows/TravelWindow.h>
 #include <Windows/TravelWindowConstants.h>
 #include <Utils/TextUtils.h>
+#include <Utils/MapSearchIndex.h>
 #include <GWCA/Managers/QuestMgr.h>
 
 namespace {
@@ -110,6 +111,15 @@ namespace {
     std::vector<SearchableArea*> searchable_outposts{};
 
     FetchedMapNames fetched_searchable_outposts = FetchedMapNames::Pending;
+    // Set when the search language changes; the lists are rebuilt once neither is still decoding
+    bool refetch_searchable_areas = false;
+
+    // Ranked lookups over the names above, built once they've all decoded. Replaced whole, so /tp and the search box can
+    // read them from other threads while a rebuild is in progress.
+    std::atomic<std::shared_ptr<const MapSearchIndex>> outpost_search_index;
+    std::atomic<std::shared_ptr<const MapSearchIndex>> explorable_search_index;
+
+    char travel_search_text[64] = "";
 
     TravelWindow& Instance()
     {
@@ -308,78 +318,34 @@ namespace {
             return true;
         }
 
-        // Helper function
-        auto FindMatchingMap = [](const char* compare, const char* const* map_names, const GW::Constants::MapID* map_ids, const size_t map_count) -> GW::Constants::MapID {
-            const char* bestMatchMapName = nullptr;
-            auto bestMatchMapID = GW::Constants::MapID::None;
-
-            const auto searchStringLength = compare ? strlen(compare) : 0;
-            if (!searchStringLength) {
-                return bestMatchMapID;
-            }
-            for (size_t i = 0; i < map_count; i++) {
-                const auto thisMapLength = strlen(map_names[i]);
-                if (searchStringLength > thisMapLength) {
-                    continue; // String entered by user is longer than this outpost name.
-                }
-                if (strncmp(map_names[i], compare, searchStringLength) != 0) {
-                    continue; // No match
-                }
-                if (thisMapLength == searchStringLength) {
-                    return map_ids[i]; // Exact match, break.
-                }
-                if (!bestMatchMapName || strcmp(map_names[i], bestMatchMapName) < 0) {
-                    bestMatchMapID = map_ids[i];
-                    bestMatchMapName = map_names[i];
-                }
-            }
-            return bestMatchMapID;
-        };
-        // Helper function
-        auto FindMatchingMapVec = [](const char* compare, std::vector<SearchableArea*>& maps) -> GW::Constants::MapID {
-            const char* bestMatchMapName = nullptr;
-            auto bestMatchMapID = GW::Constants::MapID::None;
-
-            const auto searchStringLength = compare ? strlen(compare) : 0;
-            if (!searchStringLength) {
-                return bestMatchMapID;
-            }
-            for (auto it : maps) {
-                auto& map = *it;
-                if (!map.Name())
-                    continue;
-                const auto thisMapLength = strlen(map.Name());
-                if (searchStringLength > thisMapLength) {
-                    continue; // String entered by user is longer than this outpost name.
-                }
-                if (strncmp(map.Name(), compare, searchStringLength) != 0) {
-                    continue; // No match
-                }
-                if (thisMapLength == searchStringLength) {
-                    return map.map_id; // Exact match, break.
-                }
-                if (!bestMatchMapName || strcmp(map.Name(), bestMatchMapName) < 0) {
-                    bestMatchMapID = map.map_id;
-                    bestMatchMapName = map.Name();
-                }
-            }
-            return bestMatchMapID;
+        // Travelling somewhere unintended is worse than asking again, so weak fuzzy matches count as no match here.
+        // The search box still lists them.
+        const auto confident = [](const MapSearchIndex::Result& result) {
+            return result.score >= MapSearchIndex::SCORE_FUZZY_CONFIDENT ? result : MapSearchIndex::Result{};
         };
         auto best_match_map_id = GW::Constants::MapID::None;
         if (ImInPresearing()) {
-            best_match_map_id = FindMatchingMap(compare.c_str(), presearing_map_names.data(), presearing_map_ids.data(), presearing_map_ids.size());
+            static MapSearchIndex presearing_search_index;
+            if (presearing_search_index.Empty()) {
+                for (size_t i = 0; i < presearing_map_ids.size(); i++) {
+                    presearing_search_index.Add(std::to_underlying(presearing_map_ids[i]), presearing_map_names[i]);
+                }
+                presearing_search_index.Build();
+            }
+            best_match_map_id = static_cast<GW::Constants::MapID>(confident(presearing_search_index.Best(compare)).id);
         }
         else {
-            if (best_match_map_id == GW::Constants::MapID::None && fetched_searchable_outposts == FetchedMapNames::Ready) {
-                // find explorable area matching this, and then find nearest unlocked outpost.
-                best_match_map_id = FindMatchingMapVec(compare.c_str(), searchable_outposts);
+            // Prefer outposts, unless an explorable area is a clearly better match
+            const auto outposts = outpost_search_index.load();
+            const auto explorables = explorable_search_index.load();
+            const auto outpost_match = outposts ? confident(outposts->Best(compare)) : MapSearchIndex::Result{};
+            const auto explorable_match = explorables ? confident(explorables->Best(compare)) : MapSearchIndex::Result{};
+            if (outpost_match.score && outpost_match.score >= explorable_match.score) {
+                best_match_map_id = static_cast<GW::Constants::MapID>(outpost_match.id);
             }
-            if (best_match_map_id == GW::Constants::MapID::None && fetched_searchable_explorable_areas == FetchedMapNames::Ready) {
+            else if (explorable_match.score) {
                 // find explorable area matching this, and then find nearest unlocked outpost.
-                best_match_map_id = FindMatchingMapVec(compare.c_str(), searchable_explorable_areas);
-                if (best_match_map_id != GW::Constants::MapID::None) {
-                    best_match_map_id = TravelWindow::GetNearestOutpost(best_match_map_id);
-                }
+                best_match_map_id = TravelWindow::GetNearestOutpost(static_cast<GW::Constants::MapID>(explorable_match.id));
             }
         }
 
@@ -595,6 +561,17 @@ namespace {
         });
         return true;
     }
+
+    void BuildSearchIndex(std::atomic<std::shared_ptr<const MapSearchIndex>>& published, const std::vector<SearchableArea*>& vec)
+    {
+        const auto index = std::make_shared<MapSearchIndex>();
+        for (const auto area : vec) {
+            if (const auto name = area->Name())
+                index->Add(std::to_underlying(area->map_id), name);
+        }
+        index->Build();
+        published.store(index);
+    }
 }
 
 void TravelWindow::Initialize()
@@ -620,6 +597,8 @@ void TravelWindow::Terminate()
         delete s;
     }
     searchable_explorable_areas.clear();
+    outpost_search_index.store(nullptr);
+    explorable_search_index.store(nullptr);
     GW::UI::RemoveUIMessageCallback(&OnUIMessage_HookEntry);
 }
 
@@ -671,6 +650,37 @@ void TravelWindow::Draw(IDirect3DDevice9*)
         }
         else {
             ImGui::PushItemWidth(-1.0f);
+            // Ranked as you type; enter travels to the top result
+            const bool search_submitted = ImGui::InputTextWithHint("###travel_search", "Search outposts...", travel_search_text, _countof(travel_search_text), ImGuiInputTextFlags_EnterReturnsTrue);
+            const auto outposts = outpost_search_index.load();
+            if (*travel_search_text && outposts) {
+                static std::string last_search;
+                static const MapSearchIndex* last_index = nullptr;
+                static std::array<MapSearchIndex::Result, 8> search_results;
+                static size_t search_result_count = 0;
+                const auto query = SanitiseForSearch(TextUtils::StringToWString(travel_search_text));
+                if (query != last_search || outposts.get() != last_index) {
+                    search_result_count = outposts->Search(query, search_results);
+                    last_search = query;
+                    last_index = outposts.get();
+                }
+                auto travel_to = GW::Constants::MapID::None;
+                if (search_submitted && search_result_count) {
+                    travel_to = static_cast<GW::Constants::MapID>(search_results[0].id);
+                }
+                for (size_t i = 0; i < search_result_count; i++) {
+                    const auto map_id = static_cast<GW::Constants::MapID>(search_results[i].id);
+                    ImGui::PushID(static_cast<int>(i));
+                    if (ImGui::Selectable(GetMapName(map_id))) {
+                        travel_to = map_id;
+                    }
+                    ImGui::PopID();
+                }
+                if (travel_to != GW::Constants::MapID::None) {
+                    *travel_search_text = 0;
+                    Travel(travel_to, district, district_number);
+                }
+            }
             static int travelto_index = -1;
             if (ImGui::MyCombo("###travelto", "Travel To...", &travelto_index, outpost_name_array_getter, nullptr, searchable_outposts.size())) {
                 const auto map_id = IndexToOutpostID(travelto_index);
@@ -797,6 +807,15 @@ void TravelWindow::Update(const float)
         ScrollToOutpost(scroll_to_outpost_id); // We're in the process of scrolling to an outpost
     }
 
+    // Names still decoding can't be deleted, so a language change waits for both lists to finish first
+    if (refetch_searchable_areas
+        && fetched_searchable_explorable_areas != FetchedMapNames::Decoding
+        && fetched_searchable_outposts != FetchedMapNames::Decoding) {
+        fetched_searchable_explorable_areas = FetchedMapNames::Pending;
+        fetched_searchable_outposts = FetchedMapNames::Pending;
+        refetch_searchable_areas = false;
+    }
+
     // Dynamically generate a list of all explorable areas that the game has rather than storing another massive const array.
     switch (fetched_searchable_explorable_areas) {
         case FetchedMapNames::Pending: {
@@ -808,6 +827,7 @@ void TravelWindow::Update(const float)
         break;
         case FetchedMapNames::Decoding: {
             if (CheckSearchableAreasDecoded(searchable_explorable_areas)) {
+                BuildSearchIndex(explorable_search_index, searchable_explorable_areas);
                 fetched_searchable_explorable_areas = FetchedMapNames::Ready;
             }
         }
@@ -825,6 +845,7 @@ void TravelWindow::Update(const float)
         break;
         case FetchedMapNames::Decoding: {
             if (CheckSearchableAreasDecoded(searchable_outposts)) {
+                BuildSearchIndex(outpost_search_index, searchable_outposts);
                 fetched_searchable_outposts = FetchedMapNames::Ready;
             }
         }
@@ -1041,7 +1062,10 @@ void TravelWindow::DrawSettingsInternal()
     ImGui::ShowHelp("Will collapse the travel window when clicking on a travel destination");
     ImGui::Checkbox("Automatically retry if the district is full", &retry_map_travel);
     ImGui::ShowHelp("Use /tp stop to stop retrying.");
-    ImGui::Checkbox("Use English map names", &search_in_english);
+    if (ImGui::Checkbox("Use English map names", &search_in_english)) {
+        // Decode the names again in the new language and rebuild the search indexes; see Update
+        refetch_searchable_areas = true;
+    }
     ImGui::ShowHelp("If this is unchecked, the /tp command will use the localized map names based on your current language.");
 }
 
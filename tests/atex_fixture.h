@@ -0,0 +1,201 @@
+#pragma once
+
+#include <Utils/AtexDecoder.h>
+
+// Builds ATEX files for AtexDecoder: the header, the packing flags and run bit stream, then the raw block words.
+// Also the game's mirroring pass for 256x256 DXT3 textures, transcribed from Unused/GWDatBrowser/AtexAsm.cpp.
+namespace AtexFixture {
+    inline uint32_t Load(const uint8_t* p)
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline void Store(uint8_t* p, const uint32_t v)
+    {
+        memcpy(p, &v, sizeof(v));
+    }
+
+    inline void Append(std::vector<uint8_t>& out, const uint32_t v)
+    {
+        out.resize(out.size() + 4);
+        Store(out.data() + out.size() - 4, v);
+    }
+
+    // MSB first into little endian words, the way AtexDecoder's BitReader reads them
+    class BitWriter {
+    public:
+        void Write(const uint32_t value, const uint32_t n)
+        {
+            for (uint32_t i = n; i-- > 0;) {
+                if (used == 32) {
+                    words.push_back(0);
+                    used = 0;
+                }
+                words.back() |= (value >> i & 1) << (31 - used);
+                used++;
+            }
+        }
+
+        // A run of one block
+        void RunOfOne() { Write(1, 1); }
+
+        std::vector<uint32_t> words;
+
+    private:
+        uint32_t used = 32;
+    };
+
+    // "ATEX", "DXT" + subformat, the size, then the packed data
+    inline std::vector<uint8_t> MakeAtex(const char subformat, const uint16_t width, const uint16_t height, const uint32_t compression,
+                                         const std::vector<uint32_t>& bit_words, const std::vector<uint8_t>& raw)
+    {
+        std::vector<uint8_t> out;
+        Append(out, 'A' | 'T' << 8 | 'E' << 16 | 'X' << 24);
+        Append(out, 'D' | 'X' << 8 | 'T' << 16 | static_cast<uint32_t>(subformat) << 24);
+        Append(out, width | static_cast<uint32_t>(height) << 16);
+        // The raw words start right after the last word the runs took bits from
+        Append(out, static_cast<uint32_t>(8 + bit_words.size() * 4 + raw.size()));
+        Append(out, compression);
+        for (const auto word : bit_words) {
+            Append(out, word);
+        }
+        out.insert(out.end(), raw.begin(), raw.end());
+        return out;
+    }
+
+    inline bool IsMirrored(const uint32_t x, const uint32_t y)
+    {
+        return (1u << (x & 31) & 0xC0000003) || (1u << (y & 31) & 0xC0000003);
+    }
+
+    // Register by register copy of the mirroring loop in AtexSubCode7 (loc_6101D1 to loc_610377) over count 16 byte
+    // DXT3 blocks, 64 to a row. The two dead test/jz pairs at loc_61021A and loc_610242 are left out.
+    inline void AsmMirror(uint8_t* base, const uint32_t count)
+    {
+        uint32_t eax, ebx, ecx, edx, esi, edi;
+        uint32_t local_4;             // [ebp-0x4]
+        uint8_t* local_8 = base;      // [ebp-0x8], the block being written
+        uint32_t local_c = 0;         // [ebp-0xC], its index
+        edx = 0;
+        do {
+            eax = edx;
+            esi = edx;
+            eax &= 0x3F;
+            edi = 1;
+            ecx = eax;
+            ebx = 1;
+            ecx &= 0x1F;
+            esi >>= 6;
+            edi <<= ecx;
+            ecx = esi;
+            ecx &= 0x1F;
+            ebx <<= ecx;
+            edi &= 0xC0000003;
+            ebx &= 0xC0000003;
+            if (edi || ebx) {
+                if (edi) {
+                    eax ^= 3;
+                }
+                local_4 = eax;
+                if (ebx) {
+                    esi ^= 3;
+                }
+                // loc_61026A
+                edx = local_4;
+                esi <<= 6;
+                esi += edx;
+                esi <<= 4;
+                const uint8_t* src = base + esi;
+                edx = Load(src + 8);
+                eax = Load(src);
+                ecx = Load(src + 4);
+                local_4 = edx;
+                edx = Load(src + 12);
+                if (edi) {
+                    ecx = eax;
+                    esi = eax;
+                    ecx >>= 8;
+                    ecx &= 0x0F000F0;
+                    esi &= 0x0F000F00;
+                    ecx |= esi;
+                    esi = eax;
+                    esi &= 0xFFFF000F;
+                    eax &= 0x0F000F0;
+                    esi <<= 8;
+                    esi |= eax;
+                    ecx >>= 4;
+                    esi <<= 4;
+                    ecx |= esi;
+                    eax = ecx;
+                    ecx >>= 8;
+                    esi = eax;
+                    ecx &= 0x0F000F0;
+                    esi &= 0x0F000F00;
+                    edi = eax;
+                    ecx |= esi;
+                    esi = eax;
+                    esi &= 0xFFFF000F;
+                    edi &= 0x0F000F0;
+                    esi <<= 8;
+                    esi |= edi;
+                    edi = edx;
+                    ecx >>= 4;
+                    esi <<= 4;
+                    ecx |= esi;
+                    esi = edx;
+                    esi &= 0xFF030303;
+                    edi &= 0x0C0C0C0C;
+                    esi <<= 4;
+                    esi |= edi;
+                    edi = edx;
+                    edi >>= 4;
+                    edi &= 0x0C0C0C0C;
+                    edx &= 0x30303030;
+                    edi |= edx;
+                    esi <<= 2;
+                    edi >>= 2;
+                    esi |= edi;
+                    edx = esi;
+                }
+                // loc_610323
+                if (ebx) {
+                    esi = eax;
+                    eax = ecx;
+                    eax >>= 16;
+                    ecx <<= 16;
+                    eax |= ecx;
+                    ecx = esi;
+                    ecx >>= 16;
+                    esi <<= 16;
+                    ecx |= esi;
+                    esi = edx;
+                    edi = edx;
+                    esi &= 0xFF0000;
+                    edi >>= 16;
+                    esi |= edi;
+                    edi = edx;
+                    edi <<= 16;
+                    edx &= 0xFF00;
+                    edi |= edx;
+                    esi >>= 8;
+                    edi <<= 8;
+                    esi |= edi;
+                    edx = esi;
+                }
+                // loc_610363
+                Store(local_8, eax);
+                eax = local_4;
+                Store(local_8 + 12, edx);
+                edx = local_c;
+                Store(local_8 + 4, ecx);
+                Store(local_8 + 8, eax);
+            }
+            // loc_610377
+            edx++;
+            local_8 += 16;
+            local_c = edx;
+        } while (edx < count);
+    }
+}
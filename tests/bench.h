@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Minimal benchmark helpers. Pass --quick to run a few iterations only (used by ctest to make sure benchmarks still run).
+namespace Bench {
+    inline bool quick = false;
+
+    inline void Init(const int argc, char** argv)
+    {
+        for (int i = 1; i < argc; i++) {
+            if (strcmp(argv[i], "--quick") == 0) {
+                quick = true;
+            }
+        }
+    }
+
+    inline size_t Iterations(const size_t full)
+    {
+        return quick ? 1 : full;
+    }
+
+    // Runs fn() iterations times and prints the time per iteration. Returns nanoseconds per iteration.
+    template <typename Fn>
+    double Run(const char* name, size_t iterations, Fn&& fn)
+    {
+        iterations = Iterations(iterations);
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            fn();
+        }
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        const double per_iteration = elapsed / static_cast<double>(iterations);
+        std::printf("%-48s %14.0f ns/iter (%zu iterations)\n", name, per_iteration, iterations);
+        return per_iteration;
+    }
+
+    // Keeps the compiler from discarding a result
+    template <typename T>
+    void DoNotOptimize(const T& value)
+    {
+#if defined(__GNUC__)
+        asm volatile("" : : "g"(&value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+}
@@ -0,0 +1,81 @@
+// Matching sent chat commands against a few hundred aliases: the scan OnSendChat used to do (lower case the message for
+// every alias and compare), against AliasIndex::Find. Also the cost of rebuilding the index after an edit.
+// Usage: bench_alias_index [--quick]
+
+#include "stdafx.h"
+
+#include <Utils/AliasIndex.h>
+
+#include "bench.h"
+
+namespace {
+    constexpr size_t ALIAS_COUNT = 400;
+
+    // The loop AliasIndex replaced
+    size_t FindByScan(const std::vector<std::wstring>& names, const wchar_t* message)
+    {
+        size_t found = 0;
+        for (const auto& name : names) {
+            std::wstring lower = message;
+            for (auto& c : lower) {
+                c = static_cast<wchar_t>(towlower(c));
+            }
+            found += lower == name;
+        }
+        return found;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    Bench::Init(argc, argv);
+    std::mt19937 rng(1);
+    std::vector<std::wstring> names;
+    for (size_t i = 0; i < ALIAS_COUNT; i++) {
+        std::wstring name;
+        const size_t len = 2 + rng() % 10;
+        for (size_t j = 0; j < len; j++) {
+            name.push_back(static_cast<wchar_t>(L'a' + rng() % 26));
+        }
+        names.push_back(name);
+    }
+    std::vector<const wchar_t*> pointers;
+    for (const auto& name : names) {
+        pointers.push_back(name.c_str());
+    }
+
+    // Most commands sent aren't aliases: "/tp gh", "/resign", etc.
+    std::vector<std::wstring> messages;
+    for (size_t i = 0; i < 1000; i++) {
+        if (i % 4 == 0) {
+            auto message = names[rng() % names.size()];
+            message[0] = static_cast<wchar_t>(towupper(message[0]));
+            messages.push_back(message);
+        }
+        else {
+            messages.push_back(L"tp gh " + std::to_wstring(i));
+        }
+    }
+
+    std::printf("%zu aliases, %zu messages\n", names.size(), messages.size());
+    AliasIndex index;
+    Bench::Run("  AliasIndex::Build", 1000, [&] {
+        index.Build(pointers);
+    });
+
+    size_t scan_found = 0;
+    size_t index_found = 0;
+    Bench::Run("  scan every alias", 20, [&] {
+        for (const auto& message : messages) {
+            scan_found += FindByScan(names, message.c_str());
+        }
+    });
+    Bench::Run("  AliasIndex::Find", 20000, [&] {
+        for (const auto& message : messages) {
+            index_found += index.Find(message.c_str()).size();
+        }
+    });
+    Bench::DoNotOptimize(scan_found);
+    Bench::DoNotOptimize(index_found);
+    return 0;
+}
@@ -0,0 +1,94 @@
+// ATEX decoding throughput: block expansion with and without SSE2 for each format, and whole files through Decode,
+// mirrored 256x256 DXT3 and a DXT5 with alpha runs.
+// Usage: bench_atex_decoder [--quick]
+
+#include "stdafx.h"
+
+#include <Utils/AtexDecoder.h>
+
+#include "atex_fixture.h"
+#include "bench.h"
+
+namespace {
+    std::vector<uint8_t> RandomBytes(const size_t size, std::mt19937& rng)
+    {
+        std::vector<uint8_t> bytes(size);
+        for (auto& b : bytes) {
+            b = static_cast<uint8_t>(rng());
+        }
+        return bytes;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    Bench::Init(argc, argv);
+    std::mt19937 rng(1);
+
+    constexpr uint32_t size = 1024;
+    std::vector<uint32_t> pixels(size * size);
+    for (const auto& [format, name] : {std::pair{AtexDecoder::Format::DXT1, "DXT1"}, {AtexDecoder::Format::DXT3, "DXT3"},
+                                       {AtexDecoder::Format::DXT5, "DXT5"}}) {
+        const size_t block_size = format == AtexDecoder::Format::DXT1 ? 8 : 16;
+        const auto blocks = RandomBytes(size * size / 16 * block_size, rng);
+        std::printf("%s %ux%u\n", name, size, size);
+        Bench::Run("  scalar", 50, [&] {
+            AtexDecoder::DecompressBlocksScalar(format, blocks.data(), size, size, pixels.data());
+            Bench::DoNotOptimize(pixels);
+        });
+        Bench::Run("  sse2", 50, [&] {
+            AtexDecoder::DecompressBlocks(format, blocks.data(), size, size, pixels.data());
+            Bench::DoNotOptimize(pixels);
+        });
+    }
+
+    // Skill icons and the like: 256x256 DXT3 with the right half and bottom half mirrored
+    std::vector<uint8_t> raw;
+    for (uint32_t i = 0; i < 64 * 64; i++) {
+        if (!AtexFixture::IsMirrored(i & 63, i >> 6)) {
+            const auto block = RandomBytes(16, rng);
+            raw.insert(raw.end(), block.begin(), block.end());
+        }
+    }
+    const auto mirrored = AtexFixture::MakeAtex('3', 256, 256, 0x10, {}, raw);
+    AtexDecoder::Image image;
+    std::printf("256x256 DXT3, mirrored\n");
+    Bench::Run("  decode, keep compressed", 500, [&] {
+        AtexDecoder::Decode(mirrored.data(), mirrored.size(), image, true);
+        Bench::DoNotOptimize(image);
+    });
+    Bench::Run("  decode to A8R8G8B8", 500, [&] {
+        AtexDecoder::Decode(mirrored.data(), mirrored.size(), image);
+        Bench::DoNotOptimize(image);
+    });
+
+    // Half the blocks in runs of transparent alpha, the rest raw
+    constexpr uint32_t block_count = size * size / 16;
+    AtexFixture::BitWriter bits;
+    bits.Write(0x80, 8);
+    raw.clear();
+    uint32_t raw_alphas = 0;
+    for (uint32_t i = 0; i < block_count; i++) {
+        bits.RunOfOne();
+        const bool transparent = i / 32 % 2 == 0;
+        bits.Write(transparent, 1);
+        if (transparent) {
+            bits.Write(0, 1);
+        }
+        else {
+            raw_alphas++;
+        }
+    }
+    raw = RandomBytes(raw_alphas * 8 + block_count * 8, rng);
+    const auto runs = AtexFixture::MakeAtex('5', size, size, 4, bits.words, raw);
+    std::printf("%ux%u DXT5, alpha runs\n", size, size);
+    Bench::Run("  decode, keep compressed", 50, [&] {
+        AtexDecoder::Decode(runs.data(), runs.size(), image, true);
+        Bench::DoNotOptimize(image);
+    });
+    Bench::Run("  decode to A8R8G8B8", 50, [&] {
+        AtexDecoder::Decode(runs.data(), runs.size(), image);
+        Bench::DoNotOptimize(image);
+    });
+    return 0;
+}
@@ -0,0 +1,96 @@
+// FFNA chunk lookups over a corpus of synthetic model files: walking the chunk list per lookup, as ArenaNetFile did,
+// against indexing once with FfnaView, and reading a file into an ArenaNetFile with and without copying the blob.
+// Usage: bench_ffna_view [--quick]
+
+#include "stdafx.h"
+
+#include <Modules/GwDatTextureModule.h>
+#include <Utils/ArenaNetFileParser.h>
+
+#include "bench.h"
+#include "ffna_fixture.h"
+
+namespace {
+    using ArenaNetFileParser::ChunkType;
+
+    // The old lookup: from the start of the file every time
+    const uint8_t* Walk(const std::vector<uint8_t>& bytes, const uint32_t chunk_id)
+    {
+        for (size_t offset = 5; offset + 8 <= bytes.size();) {
+            uint32_t id, size;
+            memcpy(&id, &bytes[offset], 4);
+            memcpy(&size, &bytes[offset + 4], 4);
+            if (size > bytes.size() - offset - 8)
+                return nullptr;
+            if (id == chunk_id)
+                return &bytes[offset];
+            offset += 8 + size;
+        }
+        return nullptr;
+    }
+
+    // What a model lookup asks for: texture names, then a few chunks the file doesn't have
+    constexpr ChunkType lookups[] = {ChunkType::FILENAMES_FA5, ChunkType::FILENAMES_FA6, ChunkType::ATEXFILE, ChunkType::FILENAMES_BBC};
+}
+
+int main(const int argc, char** argv)
+{
+    Bench::Init(argc, argv);
+    std::mt19937 rng(1);
+
+    for (const size_t chunk_count : {size_t{4}, size_t{16}, size_t{64}}) {
+        std::vector<std::vector<uint8_t>> corpus;
+        for (size_t i = 0; i < 1000; i++) {
+            corpus.push_back(FfnaFixture::MakeModel(rng, chunk_count));
+        }
+        std::vector<ArenaNetFileParser::FfnaView> views;
+        for (const auto& file : corpus) {
+            views.emplace_back(file);
+        }
+        std::printf("1000 files of %zu chunks, %zu lookups each\n", chunk_count, std::size(lookups));
+        Bench::Run("  walk per lookup", 200, [&] {
+            for (const auto& file : corpus) {
+                for (const auto chunk_type : lookups) {
+                    Bench::DoNotOptimize(Walk(file, chunk_type));
+                }
+            }
+        });
+        Bench::Run("  index, then look up", 200, [&] {
+            for (const auto& file : corpus) {
+                const ArenaNetFileParser::FfnaView view(file);
+                for (const auto chunk_type : lookups) {
+                    Bench::DoNotOptimize(view.FindChunk(chunk_type));
+                }
+            }
+        });
+        Bench::Run("  look up in an index kept around", 200, [&] {
+            for (const auto& view : views) {
+                for (const auto chunk_type : lookups) {
+                    Bench::DoNotOptimize(view.FindChunk(chunk_type));
+                }
+            }
+        });
+    }
+
+    // Reading: the blob shared with the dat reader, against a copy into the asset as readFromDat used to make
+    auto& files = GwDatTextureModule::Files();
+    for (uint32_t file_id = 1; file_id <= 100; file_id++) {
+        files[file_id] = std::make_shared<const std::vector<uint8_t>>(FfnaFixture::MakeModel(rng, 16));
+    }
+    std::printf("100 files read into an ArenaNetFile\n");
+    Bench::Run("  copy of the blob", 2000, [&] {
+        for (uint32_t file_id = 1; file_id <= 100; file_id++) {
+            auto copy = *GwDatTextureModule::ReadDatFile(file_id);
+            ArenaNetFileParser::ArenaNetFile asset(copy);
+            Bench::DoNotOptimize(asset);
+        }
+    });
+    Bench::Run("  shared blob", 2000, [&] {
+        for (uint32_t file_id = 1; file_id <= 100; file_id++) {
+            ArenaNetFileParser::ArenaNetFile asset;
+            asset.readFromDat(file_id);
+            Bench::DoNotOptimize(asset);
+        }
+    });
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Gw.dat reading on a synthetic dat: decompression alone, serial reads, ReadMany on the worker pool at several thread
+// counts, and many small batches on the pool against starting threads for each batch as ReadMany used to.
+// Usage: bench_gwdat [--quick]
+
+#include "stdafx.h"
+
+#include <Utils/GwDat.h>
+
+#include "bench.h"
+#include "gwdat_fixture.h"
+
+namespace {
+    // The old ReadMany: fresh threads for every call
+    void ReadManyFreshThreads(GwDat::DatFile& dat, const std::span<const uint32_t> file_ids, const std::function<void(uint32_t, GwDat::Blob)>& callback)
+    {
+        const size_t num_threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), file_ids.size());
+        std::atomic<size_t> next = 0;
+        std::vector<std::jthread> threads;
+        for (size_t i = 0; i < num_threads; i++) {
+            threads.emplace_back([&] {
+                for (size_t index = next++; index < file_ids.size(); index = next++) {
+                    callback(file_ids[index], dat.Read(file_ids[index]));
+                }
+            });
+        }
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    Bench::Init(argc, argv);
+    std::mt19937 rng(1);
+    const size_t file_count = Bench::quick ? 100 : 1500;
+
+    GwDatFixture::DatBuilder builder;
+    std::vector<uint32_t> ids;
+    size_t total_bytes = 0;
+    for (uint32_t i = 0; i < file_count; i++) {
+        const auto contents = GwDatFixture::MakeContents(1024 + rng() % (64 * 1024), rng);
+        total_bytes += contents.size();
+        ids.push_back(0x10000 + i * 7);
+        builder.Add(ids.back(), contents);
+    }
+    builder.WriteMft();
+    const auto path = std::filesystem::temp_directory_path() / "gwtoolbox_bench.dat";
+    std::filesystem::remove(path);
+    builder.Save(path);
+    std::printf("%zu files, %.1f MB unpacked, %.1f MB dat\n", file_count, total_bytes / 1e6, builder.Bytes().size() / 1e6);
+
+    GwDat::DatFile dat;
+    if (!dat.Open(path)) {
+        return 1;
+    }
+    dat.SetCacheBudget(0);
+    std::atomic<size_t> read_bytes = 0;
+    const auto count_bytes = [&](uint32_t, const GwDat::Blob& blob) {
+        read_bytes += blob ? blob->size() : 0;
+    };
+
+    const auto one = GwDatFixture::MakeContents(256 * 1024, rng);
+    const auto packed = GwDatFixture::Compress(one);
+    std::vector<uint8_t> out;
+    Bench::Run("decompress 256 KB", 200, [&] {
+        GwDat::Decompress(packed.data(), packed.size(), out);
+        Bench::DoNotOptimize(out);
+    });
+
+    Bench::Run("read every file, one by one", 5, [&] {
+        for (const uint32_t id : ids) {
+            Bench::DoNotOptimize(dat.Read(id));
+        }
+    });
+    for (const size_t threads : {1, 2, 4, 0}) {
+        char name[64];
+        snprintf(name, sizeof(name), "ReadMany every file, %zu threads", threads ? threads : size_t{std::max(1u, std::thread::hardware_concurrency())});
+        Bench::Run(name, 5, [&] {
+            dat.ReadMany(ids, count_bytes, threads);
+        });
+    }
+
+    // Pre-warming a window's worth of icons at a time
+    constexpr size_t batch = 8;
+    Bench::Run("ReadMany batches of 8, pool", 5, [&] {
+        for (size_t i = 0; i + batch <= ids.size(); i += batch) {
+            dat.ReadMany(std::span(ids).subspan(i, batch), count_bytes);
+        }
+    });
+    Bench::Run("ReadMany batches of 8, fresh threads", 5, [&] {
+        for (size_t i = 0; i + batch <= ids.size(); i += batch) {
+            ReadManyFreshThreads(dat, std::span(ids).subspan(i, batch), count_bytes);
+        }
+    });
+
+    dat.SetCacheBudget(size_t{1} << 30);
+    dat.ReadMany(ids, count_bytes);
+    Bench::Run("read every file, cached", 20, [&] {
+        for (const uint32_t id : ids) {
+            Bench::DoNotOptimize(dat.Read(id));
+        }
+    });
+    Bench::DoNotOptimize(read_bytes);
+    dat.Close();
+    std::filesystem::remove(path);
+    return 0;
+}
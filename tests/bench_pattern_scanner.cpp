@@ -0,0 +1,54 @@
+// Launcher signature lookups: PatternScanner (all patterns in one pass, anchored on their rarest byte) against one
+// linear scan per pattern, on a Gw.exe sized image.
+// Usage: bench_pattern_scanner [--quick]
+
+#include "stdafx.h"
+
+#include <PatternScanner.h>
+
+#include "bench.h"
+#include "pattern_scan_fixture.h"
+
+int main(const int argc, char** argv)
+{
+    Bench::Init(argc, argv);
+    const size_t image_size = Bench::quick ? 2 * 1024 * 1024 : 30 * 1024 * 1024;
+    auto image = PatternScanFixture::MakeImage(image_size, 1);
+    // Without PE headers the scanner doesn't cache, so every iteration scans
+    image[0] = 0;
+
+    for (const size_t pattern_count : {2u, 200u}) {
+        const auto patterns = PatternScanFixture::MakePatterns(image, Bench::quick ? std::min<size_t>(pattern_count, 20) : pattern_count, 2);
+        std::printf("%zu MB image, %zu patterns\n", image_size >> 20, patterns.size());
+
+        Bench::Run("  linear scan per pattern", 1, [&] {
+            for (const auto& pattern : patterns) {
+                uintptr_t rva = 0;
+                Bench::DoNotOptimize(PatternScanFixture::LinearFind(image, pattern, &rva));
+                Bench::DoNotOptimize(rva);
+            }
+        });
+        PatternScanner scanner(image);
+        Bench::Run("  PatternScanner::FindPatternsRva", 5, [&] {
+            auto scan = PatternScanFixture::ScanPatterns(patterns);
+            Bench::DoNotOptimize(scanner.FindPatternsRva(scan));
+            Bench::DoNotOptimize(scan);
+        });
+
+        // Second launch of the same build: every address comes from the cache and is only checked.
+        // Patterns that aren't in the image would be scanned for again, so they are left out.
+        auto with_headers = image;
+        PatternScanFixture::WriteHeaders(with_headers, {});
+        PatternScanner cached(std::move(with_headers));
+        auto warm = PatternScanFixture::ScanPatterns(patterns);
+        cached.FindPatternsRva(warm);
+        std::vector<ScanPattern> found;
+        std::ranges::copy_if(warm, std::back_inserter(found), &ScanPattern::found);
+        Bench::Run("  FindPatternsRva from the cache", 1000, [&] {
+            auto scan = found;
+            Bench::DoNotOptimize(cached.FindPatternsRva(scan));
+            Bench::DoNotOptimize(scan);
+        });
+    }
+    return 0;
+}
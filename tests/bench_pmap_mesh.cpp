@@ -0,0 +1,65 @@
+// Builds the minimap pathing mesh from trapezoid dumps ("Dump pathing map" in the minimap settings writes them to
+// <toolbox folder>/pmap/<map id>.pmap), or from a synthetic map if none are given.
+// Usage: bench_pmap_mesh [--quick] [file.pmap...]
+
+#include "stdafx.h"
+
+#include <Utils/PmapMesh.h>
+
+#include "bench.h"
+#include "pmap_fixture.h"
+
+namespace {
+    void BenchMap(const std::string& name, const std::vector<PmapMesh::Trapezoid>& trapezoids)
+    {
+        std::printf("%s: %zu trapezoids\n", name.c_str(), trapezoids.size());
+        Bench::Run("  Simplify", 20, [&] {
+            auto copy = trapezoids;
+            PmapMesh::Simplify(copy);
+            Bench::DoNotOptimize(copy);
+        });
+        PmapMesh::Mesh filled;
+        Bench::Run("  Build filled", 20, [&] {
+            filled = PmapMesh::Build(trapezoids, false);
+            Bench::DoNotOptimize(filled);
+        });
+        PmapMesh::Mesh outline;
+        Bench::Run("  Build outline", 20, [&] {
+            outline = PmapMesh::Build(trapezoids, true);
+            Bench::DoNotOptimize(outline);
+        });
+        std::printf("  filled: %zu trapezoids merged into %zu, %zu vertices, %zu triangles (%zu before)\n",
+                    filled.source_trapezoids, filled.merged_trapezoids, filled.vertices.size(), filled.PrimitiveCount(),
+                    filled.source_trapezoids * 2);
+        std::printf("  outline: %zu vertices, %zu lines (%zu before)\n", outline.vertices.size(), outline.PrimitiveCount(),
+                    outline.source_trapezoids * 4);
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    Bench::Init(argc, argv);
+    bool any_file = false;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] == '-') {
+            continue;
+        }
+        any_file = true;
+        std::vector<PmapMesh::Trapezoid> trapezoids;
+        if (!PmapMesh::ReadTrapezoids(argv[i], trapezoids)) {
+            std::fprintf(stderr, "Failed to read %s\n", argv[i]);
+            return 1;
+        }
+        BenchMap(argv[i], trapezoids);
+    }
+    if (!any_file) {
+        const uint32_t size = Bench::quick ? 32 : 160;
+        const auto grid = PmapFixture::MakeGrid(size, size, 1);
+        auto trapezoids = PmapFixture::MakeTrapezoids(grid, 1, 0);
+        // A second plane on top, like bridges over a map
+        const auto upper = PmapFixture::MakeTrapezoids(PmapFixture::MakeGrid(size / 4, size, 2), 2, 1);
+        trapezoids.insert(trapezoids.end(), upper.begin(), upper.end());
+        BenchMap("synthetic", trapezoids);
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+// Price lookups for every sell quote in a trader_quotes payload: the string-keyed map with a scan over every identifier
+// for runes, which PriceIndex replaced, against PriceIndex::Find. Also the cost of parsing the payload.
+// Usage: bench_price_index [--quick] [trader_quotes.json]
+// Without a path it uses data/trader_quotes_sample.json; a response saved from kamadan.gwtoolbox.com/trader_quotes works
+// the same way.
+
+#include "stdafx.h"
+
+#include <nlohmann/json.hpp>
+
+#include <Utils/PriceIndex.h>
+
+#include "bench.h"
+
+namespace {
+    struct Query {
+        uint32_t model_id;
+        uint32_t mod;
+    };
+
+    std::string ReadFile(const char* path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    }
+
+    // The lookup PriceIndex replaced: materials by their model id string, runes by scanning every identifier for the
+    // model id prefix and the mod word
+    uint32_t FindByScan(const std::unordered_map<std::string, uint32_t>& prices, const Query& query)
+    {
+        if (!query.mod) {
+            const auto found = prices.find(std::to_string(query.model_id));
+            return found != prices.end() ? found->second : 0;
+        }
+        char mod_to_find[9];
+        snprintf(mod_to_find, sizeof(mod_to_find), "%08X", query.mod);
+        const auto model_id_to_find = std::to_string(query.model_id);
+        for (const auto& [identifier, price] : prices) {
+            if (identifier.starts_with(model_id_to_find) && identifier.contains(mod_to_find))
+                return price;
+        }
+        return 0;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    Bench::Init(argc, argv);
+    const char* path = "data/trader_quotes_sample.json";
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-')
+            path = argv[i];
+    }
+    const auto payload = ReadFile(path);
+    const auto json = nlohmann::json::parse(payload, nullptr, false);
+    if (json.is_discarded() || !json.contains("sell")) {
+        std::fprintf(stderr, "%s isn't a trader_quotes response\n", path);
+        return 1;
+    }
+
+    // Every quote, asked for the way GetPriceByItem asks: materials by model id, runes by the word after 25B80000 that
+    // names them, plus as many misses
+    std::unordered_map<std::string, uint32_t> prices;
+    std::vector<Query> queries;
+    for (const auto& [identifier, quote] : json["sell"].items()) {
+        if (!quote.contains("p") || !quote["p"].is_number_unsigned())
+            continue;
+        prices[identifier] = quote["p"].get<uint32_t>();
+        const auto dash = identifier.find('-');
+        Query query = {};
+        if (!PriceIndex::ParseModelId(std::string_view(identifier).substr(0, dash), query.model_id))
+            continue;
+        if (dash != std::string::npos) {
+            const size_t word = identifier.size() >= dash + 17 ? dash + 9 : dash + 1;
+            if (identifier.size() < word + 8)
+                continue;
+            query.mod = static_cast<uint32_t>(std::stoul(identifier.substr(word, 8), nullptr, 16));
+        }
+        queries.push_back(query);
+        queries.push_back({query.model_id + 1, query.mod ^ 0x5A5A});
+    }
+
+    std::printf("%s: %zu sell quotes, %zu lookups\n", path, prices.size(), queries.size());
+    std::shared_ptr<const PriceIndex> index;
+    Bench::Run("  parse into PriceIndex", 200, [&] {
+        index = PriceIndex::Parse(payload);
+        Bench::DoNotOptimize(index);
+    });
+    if (!index) {
+        std::fprintf(stderr, "no prices in %s\n", path);
+        return 1;
+    }
+
+    uint64_t scan_total = 0;
+    uint64_t index_total = 0;
+    Bench::Run("  string map and scan", 200, [&] {
+        for (const auto& query : queries) {
+            scan_total += FindByScan(prices, query);
+        }
+    });
+    Bench::Run("  PriceIndex::Find", 200, [&] {
+        for (const auto& query : queries) {
+            index_total += index->Find(query.model_id, query.mod);
+        }
+    });
+    Bench::DoNotOptimize(scan_total);
+    Bench::DoNotOptimize(index_total);
+    return 0;
+}
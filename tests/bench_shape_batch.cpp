@@ -0,0 +1,56 @@
+// Minimap agent markers: ShapeBatch (indexed templates, four vertices at a time) against the per-vertex path it replaced.
+// Usage: bench_shape_batch [--quick]
+
+#include "stdafx.h"
+
+#include <Widgets/Minimap/ShapeBatch.h>
+
+#include "bench.h"
+#include "shape_batch_fixture.h"
+
+int main(const int argc, char** argv)
+{
+    Bench::Init(argc, argv);
+    using namespace ShapeBatchFixture;
+
+    const auto shapes = AgentShapes();
+    ShapeBatch batch;
+    std::vector<uint32_t> ids;
+    for (const auto& shape : shapes) {
+        ids.push_back(batch.AddShape(shape));
+    }
+
+    for (const size_t agent_count : {100u, 512u, 2000u}) {
+        const auto instances = MakeInstances(agent_count, shapes.size(), 1);
+        std::printf("%zu agents\n", agent_count);
+
+        std::vector<ShapeBatch::Vertex> reference(agent_count * batch.MaxShapeIndices());
+        size_t reference_count = 0;
+        Bench::Run("  per-vertex triangle lists", 2000, [&] {
+            reference_count = EmitReference(shapes, instances, reference.data());
+            Bench::DoNotOptimize(reference);
+        });
+
+        // Enqueue (colours worked out once per agent) and Emit, as AgentRenderer does each frame
+        std::vector<ShapeBatch::Vertex> vertices(agent_count * batch.MaxShapeVertices());
+        std::vector<uint16_t> indices(agent_count * batch.MaxShapeIndices());
+        size_t vertex_count = 0;
+        size_t index_count = 0;
+        Bench::Run("  ShapeBatch Add + Emit", 2000, [&] {
+            batch.Clear();
+            for (const auto& instance : instances) {
+                batch.Add(ids[instance.shape], instance.x, instance.y, instance.cos, instance.sin, instance.size, ColorsFor(instance));
+            }
+            for (size_t drawn = 0; drawn < batch.InstanceCount();) {
+                const size_t emitted = batch.Emit(drawn, vertices.data(), vertices.size(), indices.data(), indices.size(), vertex_count, index_count);
+                if (!emitted) {
+                    break;
+                }
+                drawn += emitted;
+            }
+            Bench::DoNotOptimize(vertices);
+        });
+        std::printf("  vertices written: %zu per-vertex, %zu batched (+%zu indices)\n", reference_count, vertex_count, index_count);
+    }
+    return 0;
+}
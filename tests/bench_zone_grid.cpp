@@ -0,0 +1,44 @@
+// Hostile recolouring lookups: ZoneGrid against testing every polygon and marker, with thousands of zones.
+// Usage: bench_zone_grid [--quick]
+
+#include "stdafx.h"
+
+#include <Widgets/Minimap/ZoneGrid.h>
+
+#include "bench.h"
+#include "zone_fixture.h"
+
+int main(const int argc, char** argv)
+{
+    Bench::Init(argc, argv);
+    // About the number of hostiles in a busy explorable
+    constexpr size_t agent_count = 256;
+
+    for (const auto& [polygon_count, marker_count] : {std::pair<size_t, size_t>{100, 20}, {2000, 300}, {10000, 1000}}) {
+        const auto zones = ZoneFixture::MakeZones(polygon_count, marker_count, 40000.f, 1);
+        std::mt19937 rng(2);
+        std::uniform_real_distribution<float> coord(-20000.f, 20000.f);
+        std::vector<ZoneFixture::Point> agents(agent_count);
+        for (auto& agent : agents) {
+            agent = {coord(rng), coord(rng)};
+        }
+        std::printf("%zu polygons, %zu markers, %zu agents\n", polygon_count, marker_count, agent_count);
+
+        Bench::Run("  linear, per frame", 50, [&] {
+            for (const auto& agent : agents) {
+                Bench::DoNotOptimize(ZoneFixture::LinearLookup(zones, agent));
+            }
+        });
+        Bench::Run("  build grid", 50, [&] {
+            const ZoneFixture::GridLookup lookup(zones);
+            Bench::DoNotOptimize(lookup);
+        });
+        const ZoneFixture::GridLookup lookup(zones);
+        Bench::Run("  grid, per frame", 50, [&] {
+            for (const auto& agent : agents) {
+                Bench::DoNotOptimize(lookup.Lookup(agent));
+            }
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <BlockUpdate.h>
+
+#include <nlohmann/json.hpp>
+
+#include "sha256.h"
+
+// Two synthetic builds of GWToolboxdll.dll: the installed one and a new release with some functions recompiled (bytes
+// changed in place), code inserted (everything after it shifted) and the file grown at the end.
+namespace BlockUpdateFixture {
+    constexpr size_t block_size = 64 * 1024;
+
+    inline std::string MakeDll(const size_t size, const uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::string dll(size, '\0');
+        for (auto& c : dll) {
+            c = static_cast<char>(rng());
+        }
+        return dll;
+    }
+
+    // edits scattered changes of up to 2 KiB, one insertion if shift, and grow bytes appended
+    inline std::string NextRelease(std::string dll, const size_t edits, const bool shift, const size_t grow, const uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        for (size_t i = 0; i < edits; i++) {
+            const size_t length = 1 + rng() % 2048;
+            const size_t at = rng() % (dll.size() - length);
+            for (size_t j = 0; j < length; j++) {
+                dll[at + j] = static_cast<char>(rng());
+            }
+        }
+        if (shift) {
+            dll.insert(dll.size() * 3 / 4, std::string(777, '\x90'));
+        }
+        dll += MakeDll(grow, seed + 1);
+        return dll;
+    }
+
+    // What CI publishes with a release
+    inline std::string ManifestJson(const std::string& dll)
+    {
+        nlohmann::json json;
+        std::string hash;
+        json["size"] = dll.size();
+        json["block_size"] = block_size;
+        Sha256::Hex(dll.data(), dll.size(), hash);
+        json["sha256"] = hash;
+        auto& blocks = json["blocks"] = nlohmann::json::array();
+        for (size_t offset = 0; offset < dll.size(); offset += block_size) {
+            Sha256::Hex(dll.data() + offset, std::min(block_size, dll.size() - offset), hash);
+            blocks.push_back(hash);
+        }
+        return json.dump();
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal test helpers: CHECK records a failure and carries on, main returns TestResult().
+namespace Test {
+    inline int failures = 0;
+
+    inline int TestResult()
+    {
+        if (failures) {
+            std::fprintf(stderr, "%d check(s) failed\n", failures);
+            return 1;
+        }
+        return 0;
+    }
+}
+
+#define CHECK(expr)                                                                          \
+    do {                                                                                     \
+        if (!(expr)) {                                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expr);    \
+            Test::failures++;                                                                \
+        }                                                                                    \
+    } while (0)
+
+#define CHECK_EQ(a, b) CHECK((a) == (b))
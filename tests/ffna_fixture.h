@@ -0,0 +1,68 @@
+#pragma once
+
+#include <Utils/ArenaNetFileParser.h>
+
+// Builds FFNA files for FfnaView: the "ffna" signature and type byte, then chunks of id, size and data.
+namespace FfnaFixture {
+    using ArenaNetFileParser::ChunkType;
+
+    struct Chunk {
+        uint32_t chunk_id = 0;
+        std::vector<uint8_t> data;
+    };
+
+    inline void Append(std::vector<uint8_t>& out, const uint32_t v)
+    {
+        out.resize(out.size() + 4);
+        memcpy(out.data() + out.size() - 4, &v, sizeof(v));
+    }
+
+    inline std::vector<uint8_t> MakeFfna(const uint8_t type, const std::vector<Chunk>& chunks)
+    {
+        std::vector<uint8_t> out = {'f', 'f', 'n', 'a', type};
+        for (const auto& chunk : chunks) {
+            Append(out, chunk.chunk_id);
+            Append(out, static_cast<uint32_t>(chunk.data.size()));
+            out.insert(out.end(), chunk.data.begin(), chunk.data.end());
+        }
+        return out;
+    }
+
+    // A FILENAMES_* chunk: unk, the count, then the names; SOUND_FILES_1 has the names only
+    inline Chunk FileNames(const ChunkType chunk_type, const std::vector<uint32_t>& file_ids, const uint32_t stated_count = ~0u)
+    {
+        Chunk chunk = {chunk_type, {}};
+        if (chunk_type != ChunkType::SOUND_FILES_1) {
+            Append(chunk.data, 0);
+            Append(chunk.data, stated_count != ~0u ? stated_count : static_cast<uint32_t>(file_ids.size()));
+        }
+        for (const auto file_id : file_ids) {
+            ArenaNetFileParser::FileName name = {};
+            ArenaNetFileParser::FileIdToFileHash(file_id, name.filename);
+            const auto bytes = reinterpret_cast<const uint8_t*>(&name);
+            chunk.data.insert(chunk.data.end(), bytes, bytes + sizeof(name));
+        }
+        return chunk;
+    }
+
+    inline Chunk RandomChunk(const uint32_t chunk_id, const size_t size, std::mt19937& rng)
+    {
+        Chunk chunk = {chunk_id, std::vector<uint8_t>(size)};
+        for (auto& b : chunk.data) {
+            b = static_cast<uint8_t>(rng());
+        }
+        return chunk;
+    }
+
+    // A model file the way the game lays them out: a dozen or so chunks of other types and one list of file names
+    inline std::vector<uint8_t> MakeModel(std::mt19937& rng, const size_t chunk_count = 16)
+    {
+        std::vector<Chunk> chunks;
+        for (size_t i = 0; i + 1 < chunk_count; i++) {
+            chunks.push_back(RandomChunk(0x2000 + static_cast<uint32_t>(rng() % 0x100), 16 + rng() % 2048, rng));
+        }
+        chunks.push_back(FileNames(ChunkType::FILENAMES_FA5, {0x1234, 0x5678}));
+        std::ranges::shuffle(chunks, rng);
+        return MakeFfna(2, chunks);
+    }
+}
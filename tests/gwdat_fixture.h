@@ -0,0 +1,446 @@
+#pragma once
+
+#include <Utils/GwDat.h>
+
+// Synthetic Gw.dat files: a compressor for the game's Huffman/LZ format (greedy matching, one pair of trees per block),
+// and a writer for the header, the MFT and the file id table that can add files and move them afterwards, the way the
+// game updates the dat while it runs.
+namespace GwDatFixture {
+    // Format tables, as GwDat.cpp decodes them
+    constexpr std::pair<uint32_t, uint32_t> CODE_LENGTH_CODES[] = {
+        {0xA0000000, 0x02}, {0x60000000, 0x06}, {0x40000000, 0x0A}, {0x20000000, 0x12}, {0x12000000, 0x19},
+        {0x0C000000, 0x1F}, {0x07000000, 0x29}, {0x03000000, 0x39}, {0x01600000, 0x46}, {0x00F00000, 0x4D},
+        {0x00C00000, 0x53}, {0x00B00000, 0x57}, {0x00A00000, 0x5F}, {0x00000000, 0xFF}
+    };
+    constexpr uint8_t CODE_LENGTH_SYMBOLS[256] = {
+        0x08, 0x09, 0x0A, 0x00, 0x07, 0x0B, 0x0C, 0x06, 0x29, 0x2A, 0xE0, 0x04, 0x05, 0x20, 0x28, 0x2B,
+        0x2C, 0x40, 0x4A, 0x03, 0x0D, 0x25, 0x26, 0x27, 0x48, 0x49, 0x24, 0x47, 0x4B, 0x4C, 0x69, 0x6A,
+        0x23, 0x46, 0x60, 0x63, 0x67, 0x68, 0x88, 0x89, 0xA0, 0xE8, 0x01, 0x02, 0x2D, 0x43, 0x44, 0x45,
+        0x65, 0x66, 0x80, 0x87, 0x8A, 0xA8, 0xA9, 0xC0, 0xC9, 0xE9, 0x0E, 0x4D, 0x64, 0x6B, 0x6C, 0x84,
+        0x85, 0x8B, 0xA4, 0xA5, 0xAA, 0xC8, 0xE5, 0x83, 0x86, 0xA6, 0xA7, 0xC7, 0xCA, 0xE7, 0x22, 0x2E,
+        0x8C, 0xC4, 0xE4, 0xE6, 0x4E, 0x6D, 0xC6, 0xEC, 0x0F, 0x10, 0x11, 0x8D, 0xAB, 0xAC, 0xCC, 0xEA,
+        0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x21, 0x2F,
+        0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,
+        0x41, 0x42, 0x4F, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x5C,
+        0x5D, 0x5E, 0x5F, 0x61, 0x62, 0x6E, 0x6F, 0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78,
+        0x79, 0x7A, 0x7B, 0x7C, 0x7D, 0x7E, 0x7F, 0x81, 0x82, 0x8E, 0x8F, 0x90, 0x91, 0x92, 0x93, 0x94,
+        0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0x9B, 0x9C, 0x9D, 0x9E, 0x9F, 0xA1, 0xA2, 0xA3, 0xAD, 0xAE,
+        0xAF, 0xB0, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xBB, 0xBC, 0xBD, 0xBE,
+        0xBF, 0xC1, 0xC2, 0xC3, 0xC5, 0xCB, 0xCD, 0xCE, 0xCF, 0xD0, 0xD1, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6,
+        0xD7, 0xD8, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE, 0xDF, 0xE1, 0xE2, 0xE3, 0xEB, 0xED, 0xEE, 0xEF,
+        0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF
+    };
+    constexpr uint8_t LENGTH_BASE[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 14, 16, 20, 24, 28, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 255};
+    constexpr uint8_t LENGTH_BITS[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    constexpr uint16_t DISTANCE_BASE[] = {
+        0, 1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096, 6144, 8192, 12288, 16384, 24576
+    };
+    constexpr uint8_t DISTANCE_BITS[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    constexpr uint32_t LITERAL_SYMBOLS = 0x100 + _countof(LENGTH_BASE);
+    constexpr uint32_t DISTANCE_SYMBOLS = _countof(DISTANCE_BASE);
+    constexpr uint32_t MAX_DISTANCE = 24576 + (1 << 13); // Back references go up to this many bytes back
+
+    inline void Append(std::vector<uint8_t>& out, const void* data, const size_t size)
+    {
+        const auto bytes = static_cast<const uint8_t*>(data);
+        out.insert(out.end(), bytes, bytes + size);
+    }
+
+    template <typename T>
+    void Put(std::vector<uint8_t>& out, const size_t offset, const T value)
+    {
+        memcpy(out.data() + offset, &value, sizeof(value));
+    }
+
+    // MSB-first into little endian words
+    class BitWriter {
+    public:
+        void Write(const uint32_t value, const uint32_t n)
+        {
+            for (uint32_t i = n; i-- > 0;) {
+                current = current << 1 | (value >> i & 1);
+                if (++used == 32) {
+                    words.push_back(current);
+                    current = used = 0;
+                }
+            }
+        }
+
+        std::vector<uint32_t> Finish()
+        {
+            if (used) {
+                words.push_back(current << (32 - used));
+                current = used = 0;
+            }
+            return std::move(words);
+        }
+
+    private:
+        std::vector<uint32_t> words;
+        uint32_t current = 0;
+        uint32_t used = 0;
+    };
+
+    // The n bit code that decodes to CODE_LENGTH_SYMBOLS[index]
+    inline std::pair<uint32_t, uint32_t> CodeLengthCode(const uint32_t index)
+    {
+        for (size_t i = 0; i < _countof(CODE_LENGTH_CODES); i++) {
+            const uint32_t n = static_cast<uint32_t>(i) + 3;
+            const auto [first, last_index] = CODE_LENGTH_CODES[i];
+            const uint64_t upper = i ? CODE_LENGTH_CODES[i - 1].first : 1ull << 32;
+            const auto codes = static_cast<uint32_t>((upper - first) >> (32 - n));
+            if (index <= last_index && last_index - index < codes) {
+                return {(first >> (32 - n)) + (last_index - index), n};
+            }
+        }
+        ASSERT(false);
+        return {};
+    }
+
+    // Huffman code lengths for freqs, at most max_length bits. Unused symbols get 0; at least two symbols get a code.
+    inline std::vector<uint8_t> CodeLengths(std::vector<uint64_t> freqs, const uint32_t max_length = 20)
+    {
+        size_t used = std::ranges::count_if(freqs, [](const uint64_t f) {
+            return f != 0;
+        });
+        for (size_t i = 0; used < 2; i++) {
+            if (!freqs[i]) {
+                freqs[i] = 1;
+                used++;
+            }
+        }
+        std::vector<uint8_t> lengths(freqs.size());
+        while (true) {
+            struct Node {
+                uint64_t freq;
+                int left, right;
+            };
+            std::vector<Node> nodes;
+            using Item = std::pair<uint64_t, int>;
+            std::priority_queue<Item, std::vector<Item>, std::greater<>> queue;
+            for (size_t i = 0; i < freqs.size(); i++) {
+                if (freqs[i]) {
+                    nodes.push_back({freqs[i], -1 - static_cast<int>(i), 0});
+                    queue.emplace(freqs[i], static_cast<int>(nodes.size() - 1));
+                }
+            }
+            while (queue.size() > 1) {
+                const auto [fa, a] = queue.top();
+                queue.pop();
+                const auto [fb, b] = queue.top();
+                queue.pop();
+                nodes.push_back({fa + fb, a, b});
+                queue.emplace(fa + fb, static_cast<int>(nodes.size() - 1));
+            }
+            uint32_t longest = 0;
+            std::vector<std::pair<int, uint32_t>> stack = {{queue.top().second, 0}};
+            while (!stack.empty()) {
+                const auto [node, depth] = stack.back();
+                stack.pop_back();
+                if (nodes[node].left < 0) {
+                    lengths[-1 - nodes[node].left] = static_cast<uint8_t>(depth);
+                    longest = std::max(longest, depth);
+                }
+                else {
+                    stack.emplace_back(nodes[node].left, depth + 1);
+                    stack.emplace_back(nodes[node].right, depth + 1);
+                }
+            }
+            if (longest <= max_length) {
+                return lengths;
+            }
+            for (auto& f : freqs) {
+                f = f ? (f + 1) / 2 : 0;
+            }
+        }
+    }
+
+    // Codes as the decoder assigns them: by length, then symbol, counting down from all ones
+    inline std::vector<uint32_t> CanonicalCodes(const std::vector<uint8_t>& lengths)
+    {
+        std::vector<uint32_t> codes(lengths.size());
+        uint32_t code = 0;
+        for (uint32_t length = 0; length <= 31; length++, code = code * 2 + 1) {
+            for (size_t symbol = 0; symbol < lengths.size(); symbol++) {
+                if (length && lengths[symbol] == length) {
+                    codes[symbol] = code--;
+                }
+            }
+        }
+        return codes;
+    }
+
+    inline void WriteTree(BitWriter& out, std::vector<uint8_t> lengths)
+    {
+        while (lengths.size() > 2 && !lengths.back()) {
+            lengths.pop_back();
+        }
+        out.Write(static_cast<uint32_t>(lengths.size()), 16);
+        // From the last symbol down, in runs of up to 8 equal lengths
+        for (int symbol = static_cast<int>(lengths.size()) - 1; symbol >= 0;) {
+            int run = 1;
+            while (run < 8 && symbol - run >= 0 && lengths[symbol - run] == lengths[symbol]) {
+                run++;
+            }
+            const auto value = static_cast<uint8_t>(lengths[symbol] | (run - 1) << 5);
+            const auto index = static_cast<uint32_t>(std::ranges::find(CODE_LENGTH_SYMBOLS, value) - std::begin(CODE_LENGTH_SYMBOLS));
+            const auto [code, n] = CodeLengthCode(index);
+            out.Write(code, n);
+            symbol -= run;
+        }
+    }
+
+    template <size_t N>
+    uint32_t Bucket(const auto (&base)[N], const uint32_t value)
+    {
+        uint32_t i = 0;
+        while (i + 1 < N && base[i + 1] <= value) {
+            i++;
+        }
+        return i;
+    }
+
+    struct Token {
+        uint32_t literal_or_length; // Byte, or 0x100 + match length
+        uint32_t distance;
+    };
+
+    // Compressed dat entry for data. Blocks hold block_symbols symbols (a multiple of 4096, up to 65536); each gets
+    // its own trees.
+    inline std::vector<uint8_t> Compress(const std::vector<uint8_t>& data, const uint32_t min_length = 3, const uint32_t block_symbols = 65536)
+    {
+        ASSERT(min_length >= 1 && min_length <= 16 && block_symbols % 4096 == 0 && block_symbols && block_symbols <= 65536);
+        const uint32_t max_length = min_length + 255;
+
+        // Greedy matching over hash chains of min_length bytes
+        std::vector<Token> tokens;
+        std::vector<int> head(1 << 16, -1);
+        std::vector<int> prev(data.size(), -1);
+        const auto hash = [&](const size_t pos) {
+            uint32_t h = 0;
+            for (uint32_t i = 0; i < min_length; i++) {
+                h = h * 0x9E3779B1 + data[pos + i];
+            }
+            return h >> 16;
+        };
+        const auto insert = [&](const size_t pos) {
+            if (pos + min_length <= data.size()) {
+                const uint32_t h = hash(pos);
+                prev[pos] = head[h];
+                head[h] = static_cast<int>(pos);
+            }
+        };
+        for (size_t pos = 0; pos < data.size();) {
+            uint32_t best_length = 0;
+            uint32_t best_distance = 0;
+            if (pos + min_length <= data.size()) {
+                int chain = 32;
+                for (int candidate = head[hash(pos)]; candidate >= 0 && chain-- && pos - candidate <= MAX_DISTANCE; candidate = prev[candidate]) {
+                    uint32_t length = 0;
+                    while (length < max_length && pos + length < data.size() && data[candidate + length] == data[pos + length]) {
+                        length++;
+                    }
+                    if (length > best_length) {
+                        best_length = length;
+                        best_distance = static_cast<uint32_t>(pos - candidate);
+                    }
+                }
+            }
+            if (best_length >= min_length) {
+                tokens.push_back({0x100 + best_length - min_length, best_distance - 1});
+                for (size_t end = pos + best_length; pos < end; pos++) {
+                    insert(pos);
+                }
+            }
+            else {
+                tokens.push_back({data[pos], 0});
+                insert(pos++);
+            }
+        }
+
+        BitWriter out;
+        out.Write(0, 4);
+        out.Write(min_length - 1, 4);
+        for (size_t first = 0; first < tokens.size() || first == 0; first += block_symbols) {
+            const size_t last = std::min(tokens.size(), first + block_symbols);
+            std::vector<uint64_t> literal_freqs(LITERAL_SYMBOLS);
+            std::vector<uint64_t> distance_freqs(DISTANCE_SYMBOLS);
+            for (size_t i = first; i < last; i++) {
+                const auto& token = tokens[i];
+                if (token.literal_or_length < 0x100) {
+                    literal_freqs[token.literal_or_length]++;
+                    continue;
+                }
+                literal_freqs[0x100 + Bucket(LENGTH_BASE, token.literal_or_length - 0x100)]++;
+                distance_freqs[Bucket(DISTANCE_BASE, token.distance)]++;
+            }
+            const auto literal_lengths = CodeLengths(literal_freqs);
+            const auto distance_lengths = CodeLengths(distance_freqs);
+            const auto literal_codes = CanonicalCodes(literal_lengths);
+            const auto distance_codes = CanonicalCodes(distance_lengths);
+            WriteTree(out, literal_lengths);
+            WriteTree(out, distance_lengths);
+            out.Write(static_cast<uint32_t>((std::max<size_t>(last - first, 1) + 4095) / 4096 - 1), 4);
+            for (size_t i = first; i < last; i++) {
+                const auto& token = tokens[i];
+                if (token.literal_or_length < 0x100) {
+                    out.Write(literal_codes[token.literal_or_length], literal_lengths[token.literal_or_length]);
+                    continue;
+                }
+                const uint32_t length = token.literal_or_length - 0x100;
+                const uint32_t length_symbol = Bucket(LENGTH_BASE, length);
+                out.Write(literal_codes[0x100 + length_symbol], literal_lengths[0x100 + length_symbol]);
+                out.Write(length - LENGTH_BASE[length_symbol], LENGTH_BITS[length_symbol]);
+                const uint32_t distance_symbol = Bucket(DISTANCE_BASE, token.distance);
+                out.Write(distance_codes[distance_symbol], distance_lengths[distance_symbol]);
+                out.Write(token.distance - DISTANCE_BASE[distance_symbol], DISTANCE_BITS[distance_symbol]);
+            }
+        }
+        const auto words = out.Finish();
+        std::vector<uint8_t> bytes;
+        Append(bytes, words.data(), words.size() * 4);
+        const auto size = static_cast<uint32_t>(data.size());
+        Append(bytes, &size, 4);
+        return bytes;
+    }
+
+    // Contents for a synthetic file: runs, repeats and text-like bytes, so it compresses about as well as game assets
+    inline std::vector<uint8_t> MakeContents(const size_t size, std::mt19937& rng)
+    {
+        std::vector<uint8_t> out;
+        out.reserve(size);
+        while (out.size() < size) {
+            switch (rng() % 4) {
+                case 0:
+                    out.insert(out.end(), 1 + rng() % 64, static_cast<uint8_t>(rng()));
+                    break;
+                case 1:
+                    if (out.size() > 16) {
+                        const size_t back = 1 + rng() % std::min<size_t>(out.size(), MAX_DISTANCE);
+                        const size_t length = 3 + rng() % 200;
+                        for (size_t i = 0; i < length; i++) {
+                            out.push_back(out[out.size() - back]);
+                        }
+                    }
+                    break;
+                case 2:
+                    for (size_t i = 1 + rng() % 32; i; i--) {
+                        out.push_back(static_cast<uint8_t>('a' + std::min<uint32_t>(rng() % 32, rng() % 32)));
+                    }
+                    break;
+                default:
+                    for (size_t i = 1 + rng() % 16; i; i--) {
+                        out.push_back(static_cast<uint8_t>(rng()));
+                    }
+                    break;
+            }
+        }
+        out.resize(size);
+        return out;
+    }
+
+    // A Gw.dat being written: file data goes at the end, and the MFT and file id table are written out by WriteMft
+    class DatBuilder {
+    public:
+        static constexpr size_t HEADER_SIZE = 0x20;
+        static constexpr size_t RECORD_SIZE = 24;
+        static constexpr uint32_t FIRST_FILE_RECORD = 16;
+
+        DatBuilder()
+            : bytes(HEADER_SIZE),
+              records(FIRST_FILE_RECORD)
+        {
+            memcpy(bytes.data(), "3AN\x1A", 4);
+            Put<uint32_t>(bytes, 4, HEADER_SIZE);
+            Put<uint32_t>(bytes, 8, 512);
+        }
+
+        void Add(const uint32_t file_id, const std::vector<uint8_t>& contents, const bool compress = true)
+        {
+            ids.emplace_back(file_id, static_cast<uint32_t>(records.size()));
+            records.push_back(Store(contents, compress));
+        }
+
+        // Writes the file again at the end and points its record there, as the game does when it updates a file
+        void Replace(const uint32_t file_id, const std::vector<uint8_t>& contents, const bool compress = true)
+        {
+            const auto found = std::ranges::find(ids, file_id, &std::pair<uint32_t, uint32_t>::first);
+            ASSERT(found != ids.end());
+            records[found->second] = Store(contents, compress);
+        }
+
+        // Rewrites the MFT where it is (only if no records were added since), or writes the file id table and the MFT
+        // at the end and points the header at them
+        void WriteMft(const bool in_place = false)
+        {
+            if (in_place) {
+                ASSERT(mft_offset && mft_size == records.size() * RECORD_SIZE);
+                WriteRecords(static_cast<size_t>(mft_offset));
+                return;
+            }
+            std::vector<uint8_t> table;
+            for (const auto& [file_id, record] : ids) {
+                Append(table, &file_id, 4);
+                Append(table, &record, 4);
+            }
+            records[1] = {bytes.size(), static_cast<uint32_t>(table.size()), 0, 0};
+            Append(bytes, table.data(), table.size());
+            mft_offset = bytes.size();
+            mft_size = static_cast<uint32_t>(records.size() * RECORD_SIZE);
+            bytes.resize(bytes.size() + mft_size);
+            WriteRecords(static_cast<size_t>(mft_offset));
+            Put<uint64_t>(bytes, 0x10, mft_offset);
+            Put<uint32_t>(bytes, 0x18, mft_size);
+        }
+
+        [[nodiscard]] const std::vector<uint8_t>& Bytes() const { return bytes; }
+
+        // Overwrites the file in place without truncating it first, like the game writing to its open dat
+        void Save(const std::filesystem::path& path) const
+        {
+            if (!std::filesystem::exists(path)) {
+                std::ofstream(path, std::ios::binary).close();
+            }
+            std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+            file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        }
+
+    private:
+        struct Record {
+            uint64_t offset = 0;
+            uint32_t size = 0;
+            uint16_t compression = 0;
+            uint16_t flags = 0;
+        };
+
+        Record Store(const std::vector<uint8_t>& contents, const bool compress)
+        {
+            const auto stored = compress ? Compress(contents) : contents;
+            const Record record = {bytes.size(), static_cast<uint32_t>(stored.size()), static_cast<uint16_t>(compress ? 8 : 0), 3};
+            Append(bytes, stored.data(), stored.size());
+            bytes.resize((bytes.size() + 15) / 16 * 16); // Some slack between files, as sectors leave
+            return record;
+        }
+
+        void WriteRecords(const size_t at)
+        {
+            memset(bytes.data() + at, 0, records.size() * RECORD_SIZE);
+            memcpy(bytes.data() + at, "Mft\x1A", 4);
+            Put<uint32_t>(bytes, at + 0xC, static_cast<uint32_t>(records.size()));
+            for (size_t i = 1; i < records.size(); i++) {
+                const size_t p = at + i * RECORD_SIZE;
+                Put(bytes, p, records[i].offset);
+                Put(bytes, p + 8, records[i].size);
+                Put(bytes, p + 12, records[i].compression);
+                Put(bytes, p + 14, records[i].flags);
+            }
+        }
+
+        std::vector<uint8_t> bytes;
+        std::vector<Record> records;
+        std::vector<std::pair<uint32_t, uint32_t>> ids; // File id, record
+        uint64_t mft_offset = 0;
+        uint32_t mft_size = 0;
+    };
+}
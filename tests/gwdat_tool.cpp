@@ -0,0 +1,107 @@
+// Command line access to a Gw.dat through GwDat, for bulk work outside the game.
+// Usage:
+//   gwdat_tool list <dat>                         file id, stored size, offset and compression of every file
+//   gwdat_tool extract <dat> <file id> <out>      one file, decompressed
+//   gwdat_tool dump <dat> <dir> [threads]         every file into <dir>/<file id>.bin, on the reader's worker threads
+//   gwdat_tool fixture <dat> [files]              writes a synthetic dat to try the others on
+
+#include "stdafx.h"
+
+#include <Utils/GwDat.h>
+
+#include "gwdat_fixture.h"
+
+namespace {
+    int Usage()
+    {
+        std::fprintf(stderr, "usage: gwdat_tool list <dat> | extract <dat> <file id> <out> | dump <dat> <dir> [threads] | fixture <dat> [files]\n");
+        return 2;
+    }
+
+    bool WriteFile(const std::filesystem::path& path, const std::vector<uint8_t>& bytes)
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        return static_cast<bool>(out);
+    }
+
+    int List(GwDat::DatFile& dat)
+    {
+        for (const auto& entry : dat.Entries()) {
+            std::printf("%10u %10u %14llu %s\n", entry.file_id, entry.size, static_cast<unsigned long long>(entry.offset), entry.compression ? "packed" : "raw");
+        }
+        return 0;
+    }
+
+    int Extract(GwDat::DatFile& dat, const uint32_t file_id, const std::filesystem::path& out)
+    {
+        const auto blob = dat.Read(file_id);
+        if (!blob) {
+            std::fprintf(stderr, "file %u not found or unreadable\n", file_id);
+            return 1;
+        }
+        return WriteFile(out, *blob) ? 0 : 1;
+    }
+
+    int Dump(GwDat::DatFile& dat, const std::filesystem::path& dir, const size_t threads)
+    {
+        std::filesystem::create_directories(dir);
+        std::vector<uint32_t> ids;
+        for (const auto& entry : dat.Entries()) {
+            ids.push_back(entry.file_id);
+        }
+        dat.SetCacheBudget(0);
+        std::atomic<size_t> bytes = 0;
+        std::atomic<size_t> failed = 0;
+        const auto start = std::chrono::steady_clock::now();
+        dat.ReadMany(ids, [&](const uint32_t file_id, const GwDat::Blob& blob) {
+            if (!blob || !WriteFile(dir / (std::to_string(file_id) + ".bin"), *blob)) {
+                failed++;
+                return;
+            }
+            bytes += blob->size();
+        }, threads);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%zu files, %.1f MB in %.2f s (%.0f MB/s), %zu failed\n", ids.size() - failed, bytes / 1e6, seconds, bytes / 1e6 / seconds, failed.load());
+        return failed ? 1 : 0;
+    }
+
+    int Fixture(const std::filesystem::path& path, const size_t count)
+    {
+        std::mt19937 rng(1);
+        GwDatFixture::DatBuilder builder;
+        for (uint32_t i = 0; i < count; i++) {
+            builder.Add(0x10000 + i, GwDatFixture::MakeContents(1024 + rng() % (64 * 1024), rng), rng() % 4 != 0);
+        }
+        builder.WriteMft();
+        std::filesystem::remove(path);
+        builder.Save(path);
+        return 0;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    if (argc < 3) {
+        return Usage();
+    }
+    const std::string_view command = argv[1];
+    if (command == "fixture") {
+        return Fixture(argv[2], argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1000);
+    }
+    GwDat::DatFile dat;
+    if (!dat.Open(argv[2])) {
+        std::fprintf(stderr, "can't read %s\n", argv[2]);
+        return 1;
+    }
+    if (command == "list") {
+        return List(dat);
+    }
+    if (command == "extract" && argc == 5) {
+        return Extract(dat, std::strtoul(argv[3], nullptr, 0), argv[4]);
+    }
+    if (command == "dump" && argc >= 4) {
+        return Dump(dat, argv[3], argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 0);
+    }
+    return Usage();
+}
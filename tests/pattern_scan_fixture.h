@@ -0,0 +1,104 @@
+#pragma once
+
+#include <PatternScanner.h>
+
+// Synthetic module images for PatternScanner: PE headers, then code-like bytes (0x00, 0xCC and common opcodes far more
+// frequent than the rest) with patterns cut out of the image itself, so they occur, and often more than once.
+namespace PatternScanFixture {
+    struct Pattern {
+        std::string bytes;
+        std::string mask;
+        int offset = 0;
+
+        [[nodiscard]] ScanPattern Scan() const { return {bytes.data(), mask.c_str(), offset}; }
+    };
+
+    struct ModuleBuild {
+        uint32_t timestamp = 0x5F000000;
+        uint32_t checksum = 0x0012ABCD;
+    };
+
+    template <typename T>
+    void WriteAt(std::vector<uint8_t>& image, const size_t offset, const T value)
+    {
+        memcpy(image.data() + offset, &value, sizeof(value));
+    }
+
+    // Fills in the IMAGE_DOS_HEADER and IMAGE_NT_HEADERS32 fields PatternScanner identifies a build by
+    inline void WriteHeaders(std::vector<uint8_t>& image, const ModuleBuild& build)
+    {
+        std::fill_n(image.begin(), 0x200, uint8_t{0});
+        WriteAt<uint16_t>(image, 0, 0x5A4D);
+        WriteAt<int32_t>(image, 0x3C, 0x80);
+        WriteAt<uint32_t>(image, 0x80, 0x00004550);
+        WriteAt<uint32_t>(image, 0x80 + 0x08, build.timestamp);
+        WriteAt<uint32_t>(image, 0x80 + 0x50, static_cast<uint32_t>(image.size()));
+        WriteAt<uint32_t>(image, 0x80 + 0x58, build.checksum);
+    }
+
+    inline std::vector<uint8_t> MakeImage(const size_t size, const uint32_t seed, const ModuleBuild& build = {})
+    {
+        std::mt19937 rng(seed);
+        constexpr uint8_t common[] = {0x00, 0xCC, 0x8B, 0x89, 0x55, 0xEC, 0xE8, 0x83, 0xC4, 0x5D, 0xC3, 0x6A, 0xFF, 0x50, 0x51};
+        std::vector<uint8_t> image(size);
+        for (auto& byte : image) {
+            byte = rng() % 3 ? common[rng() % std::size(common)] : static_cast<uint8_t>(rng());
+        }
+        WriteHeaders(image, build);
+        return image;
+    }
+
+    // count patterns of 6 to 24 bytes copied from the image, about one in ten with wildcards, one in twenty altered so
+    // it most likely doesn't occur at all
+    inline std::vector<Pattern> MakePatterns(const std::vector<uint8_t>& image, const size_t count, const uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::vector<Pattern> patterns(count);
+        for (auto& pattern : patterns) {
+            const size_t length = 6 + rng() % 19;
+            const size_t at = 0x200 + rng() % (image.size() - 0x200 - length);
+            pattern.bytes.assign(reinterpret_cast<const char*>(image.data() + at), length);
+            pattern.mask.assign(length, 'x');
+            if (rng() % 10 == 0) {
+                for (size_t i = 0; i < length / 4; i++) {
+                    pattern.mask[rng() % length] = '?';
+                }
+            }
+            if (rng() % 20 == 0) {
+                pattern.bytes[length / 2] = static_cast<char>(pattern.bytes[length / 2] ^ 0x5A);
+                pattern.bytes[length - 1] = static_cast<char>(pattern.bytes[length - 1] ^ 0xA5);
+            }
+            pattern.offset = static_cast<int>(rng() % 64) - 32;
+        }
+        return patterns;
+    }
+
+    // The loop ProcessScanner::FindPatternRva used before patterns were resolved together, bounded to the image
+    inline bool LinearFind(const std::vector<uint8_t>& image, const Pattern& pattern, uintptr_t* rva)
+    {
+        const size_t length = pattern.mask.size();
+        const auto upattern = reinterpret_cast<const uint8_t*>(pattern.bytes.data());
+        for (size_t i = 0; i + length <= image.size(); i++) {
+            size_t j;
+            for (j = 0; j < length; j++) {
+                if (pattern.mask[j] == 'x' && image[i + j] != upattern[j]) {
+                    break;
+                }
+            }
+            if (j == length) {
+                *rva = i + pattern.offset;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline std::vector<ScanPattern> ScanPatterns(const std::vector<Pattern>& patterns)
+    {
+        std::vector<ScanPattern> scan;
+        for (const auto& pattern : patterns) {
+            scan.push_back(pattern.Scan());
+        }
+        return scan;
+    }
+}
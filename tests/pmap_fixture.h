@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Utils/PmapMesh.h>
+
+// Synthetic pathing maps: a grid of walkable/blocked cells, each row of walkable cells cut into trapezoids at random
+// cell boundaries, some of them split again halfway up, and everything sheared so the sides are slanted. Neighbours
+// therefore share sides without always sharing corners, the way trapezoids from the game do.
+namespace PmapFixture {
+    struct Grid {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        float cell = 100.f;
+        float shear = 0.37f; // x += shear * y
+        std::vector<uint8_t> walkable;
+
+        [[nodiscard]] bool Walkable(const int x, const int y) const
+        {
+            return x >= 0 && y >= 0 && x < static_cast<int>(width) && y < static_cast<int>(height) && walkable[y * width + x];
+        }
+    };
+
+    inline Grid MakeGrid(const uint32_t width, const uint32_t height, const uint32_t seed, const float walkable_ratio = 0.7f)
+    {
+        Grid grid;
+        grid.width = width;
+        grid.height = height;
+        grid.walkable.resize(width * height);
+        std::mt19937 rng(seed);
+        std::bernoulli_distribution walkable(walkable_ratio);
+        for (auto& cell : grid.walkable) {
+            cell = walkable(rng);
+        }
+        // Repeat some rows so there are stacked trapezoids to merge
+        for (uint32_t y = 1; y < height; y++) {
+            if (rng() % 3 == 0) {
+                std::copy_n(grid.walkable.begin() + (y - 1) * width, width, grid.walkable.begin() + y * width);
+            }
+        }
+        return grid;
+    }
+
+    inline std::vector<PmapMesh::Trapezoid> MakeTrapezoids(const Grid& grid, const uint32_t seed, const uint32_t plane = 0)
+    {
+        std::mt19937 rng(seed);
+        std::vector<PmapMesh::Trapezoid> trapezoids;
+        const auto add = [&](const float x0, const float x1, const float y0, const float y1) {
+            trapezoids.push_back({
+                x0 + grid.shear * y1, x1 + grid.shear * y1, y1,
+                x0 + grid.shear * y0, x1 + grid.shear * y0, y0, plane
+            });
+        };
+        for (uint32_t y = 0; y < grid.height; y++) {
+            uint32_t x = 0;
+            while (x < grid.width) {
+                if (!grid.Walkable(x, y)) {
+                    x++;
+                    continue;
+                }
+                uint32_t end = x;
+                while (end < grid.width && grid.Walkable(end, y)) {
+                    end++;
+                }
+                // Cut the run into pieces
+                uint32_t from = x;
+                while (from < end) {
+                    const uint32_t to = rng() % 2 ? end : from + 1 + rng() % (end - from);
+                    const float x0 = static_cast<float>(from) * grid.cell;
+                    const float x1 = static_cast<float>(to) * grid.cell;
+                    const float y0 = static_cast<float>(y) * grid.cell;
+                    const float y1 = static_cast<float>(y + 1) * grid.cell;
+                    if (rng() % 4 == 0) {
+                        const float mid = (y0 + y1) / 2;
+                        add(x0, x1, y0, mid);
+                        add(x0, x1, mid, y1);
+                    }
+                    else {
+                        add(x0, x1, y0, y1);
+                    }
+                    from = to;
+                }
+                x = end;
+            }
+        }
+        std::ranges::shuffle(trapezoids, rng);
+        return trapezoids;
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Widgets/Minimap/ShapeBatch.h>
+
+// The agent marker shapes AgentRenderer adds to its ShapeBatch, and the per-vertex path it used before ShapeBatch
+// (every triangle list vertex rotated, scaled and coloured through a switch on its modifier) as a reference.
+namespace ShapeBatchFixture {
+    using ShapeVertex = ShapeBatch::ShapeVertex;
+
+    inline std::vector<std::vector<ShapeVertex>> AgentShapes()
+    {
+        using enum ShapeBatch::Modifier;
+        std::vector<std::vector<ShapeVertex>> shapes;
+        const ShapeVertex o = {0.f, 0.f, Light};
+        const std::vector<std::pair<float, float>> tear = {
+            {1.8f, 0.f}, {0.7f, 0.7f}, {0.f, 1.f}, {-0.7f, 0.7f}, {-1.f, 0.f}, {-0.7f, -0.7f}, {0.f, -1.f}, {0.7f, -0.7f}
+        };
+        auto& tear_list = shapes.emplace_back();
+        for (size_t i = 0; i < tear.size(); i++) {
+            const auto& [x1, y1] = tear[i];
+            const auto& [x2, y2] = tear[(i + 1) % tear.size()];
+            tear_list.insert(tear_list.end(), {{x1, y1, Dark}, {x2, y2, Dark}, o});
+        }
+        constexpr int num_triangles = 32;
+        for (const auto& [edge, center] : {std::pair{Dark, Light}, std::pair{None, CircleCenter}}) {
+            auto& circle = shapes.emplace_back();
+            for (int i = 0; i < num_triangles; ++i) {
+                const float angle1 = 2 * (i + 0) * DirectX::XM_PI / num_triangles;
+                const float angle2 = 2 * (i + 1) * DirectX::XM_PI / num_triangles;
+                circle.insert(circle.end(), {{std::cos(angle1), std::sin(angle1), edge}, {std::cos(angle2), std::sin(angle2), edge}, {0.f, 0.f, center}});
+            }
+        }
+        auto& quad = shapes.emplace_back();
+        const std::pair<float, float> corners[] = {{1.f, -1.f}, {1.f, 1.f}, {-1.f, 1.f}, {-1.f, -1.f}};
+        for (size_t i = 0; i < 4; i++) {
+            quad.insert(quad.end(), {{corners[i].first, corners[i].second, Dark}, {corners[(i + 1) % 4].first, corners[(i + 1) % 4].second, Dark}, o});
+        }
+        return shapes;
+    }
+
+    // Colors::Add/Sub: per channel, clamped
+    inline uint32_t Combine(const uint32_t c1, const uint32_t c2, const int sign)
+    {
+        uint32_t result = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            const int channel = std::clamp(static_cast<int>(c1 >> shift & 0xff) + sign * static_cast<int>(c2 >> shift & 0xff), 0, 0xff);
+            result |= static_cast<uint32_t>(channel) << shift;
+        }
+        return result;
+    }
+
+    struct Instance {
+        uint32_t shape;
+        float x, y, cos, sin, size;
+        uint32_t color, modifier;
+    };
+
+    inline std::vector<Instance> MakeInstances(const size_t count, const size_t shape_count, const uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(-5000.f, 5000.f);
+        std::uniform_real_distribution<float> angle(0.f, 2 * DirectX::XM_PI);
+        std::vector<Instance> instances(count);
+        for (auto& instance : instances) {
+            const float a = angle(rng);
+            instance = {static_cast<uint32_t>(rng() % shape_count), position(rng), position(rng), std::cos(a), std::sin(a),
+                        50.f + static_cast<float>(rng() % 100), static_cast<uint32_t>(rng()) | 0xff000000u, 0x00303030};
+        }
+        return instances;
+    }
+
+    inline ShapeBatch::ModifierColors ColorsFor(const Instance& instance)
+    {
+        return {instance.color, Combine(instance.color, instance.modifier, -1), Combine(instance.color, instance.modifier, 1),
+                Combine(instance.color, 50u << 24, -1)};
+    }
+
+    // The old path: un-indexed triangle lists, one vertex at a time
+    inline size_t EmitReference(const std::vector<std::vector<ShapeVertex>>& shapes, const std::vector<Instance>& instances,
+                                ShapeBatch::Vertex* vertices)
+    {
+        size_t count = 0;
+        for (const auto& instance : instances) {
+            for (const auto& v : shapes[instance.shape]) {
+                auto& out = vertices[count++];
+                out.x = (v.x * instance.cos - v.y * instance.sin) * instance.size + instance.x;
+                out.y = (v.x * instance.sin + v.y * instance.cos) * instance.size + instance.y;
+                out.z = 0.f;
+                switch (v.modifier) {
+                    case ShapeBatch::Dark:
+                        out.color = Combine(instance.color, instance.modifier, -1);
+                        break;
+                    case ShapeBatch::Light:
+                        out.color = Combine(instance.color, instance.modifier, 1);
+                        break;
+                    case ShapeBatch::CircleCenter:
+                        out.color = Combine(instance.color, 50u << 24, -1);
+                        break;
+                    default:
+                        out.color = instance.color;
+                        break;
+                }
+            }
+        }
+        return count;
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+// Stand-in for GWToolboxdll/Logger.h: the file log goes to stderr
+namespace Log {
+    inline void Log(const char* msg, ...)
+    {
+        va_list args;
+        va_start(args, msg);
+        vfprintf(stderr, msg, args);
+        va_end(args);
+        if (msg[0] && msg[strlen(msg) - 1] != '\n') {
+            fputc('\n', stderr);
+        }
+    }
+}
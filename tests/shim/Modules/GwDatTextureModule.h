@@ -0,0 +1,22 @@
+#pragma once
+
+#include <Utils/GwDat.h>
+
+// Stand-in for GWToolboxdll/Modules/GwDatTextureModule.h: ArenaNetFileParser reads files through it. The dat is
+// whatever the test puts in Files(); there are no game file handles to fall back to.
+class GwDatTextureModule {
+public:
+    static std::map<uint32_t, GwDat::Blob>& Files()
+    {
+        static std::map<uint32_t, GwDat::Blob> files;
+        return files;
+    }
+
+    static bool ReadDatFile(const wchar_t*, std::vector<uint8_t>*) { return false; }
+
+    static GwDat::Blob ReadDatFile(const uint32_t file_id)
+    {
+        const auto found = Files().find(file_id);
+        return found != Files().end() ? found->second : nullptr;
+    }
+};
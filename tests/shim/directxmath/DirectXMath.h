@@ -0,0 +1,60 @@
+#pragma once
+
+// The few DirectXMath types and functions ShapeBatch uses, for building tests/ where DirectXMath isn't installed.
+// Same semantics as the real header, on SSE where available.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define GWTOOLBOX_XM_SSE
+#endif
+
+namespace DirectX {
+    constexpr float XM_PI = 3.141592654f;
+
+#ifdef GWTOOLBOX_XM_SSE
+    using XMVECTOR = __m128;
+#else
+    struct XMVECTOR {
+        float f[4];
+    };
+#endif
+
+    struct alignas(16) XMFLOAT4A {
+        float x, y, z, w;
+    };
+
+#ifdef GWTOOLBOX_XM_SSE
+    inline XMVECTOR XMVectorZero() { return _mm_setzero_ps(); }
+    inline XMVECTOR XMVectorSet(const float x, const float y, const float z, const float w) { return _mm_set_ps(w, z, y, x); }
+    inline XMVECTOR XMVectorReplicate(const float value) { return _mm_set_ps1(value); }
+    // v1 * v2 + v3
+    inline XMVECTOR XMVectorMultiplyAdd(const XMVECTOR v1, const XMVECTOR v2, const XMVECTOR v3) { return _mm_add_ps(_mm_mul_ps(v1, v2), v3); }
+    // v3 - v1 * v2
+    inline XMVECTOR XMVectorNegativeMultiplySubtract(const XMVECTOR v1, const XMVECTOR v2, const XMVECTOR v3) { return _mm_sub_ps(v3, _mm_mul_ps(v1, v2)); }
+    inline void XMStoreFloat4A(XMFLOAT4A* destination, const XMVECTOR v) { _mm_store_ps(&destination->x, v); }
+#else
+    inline XMVECTOR XMVectorZero() { return {}; }
+    inline XMVECTOR XMVectorSet(const float x, const float y, const float z, const float w) { return {{x, y, z, w}}; }
+    inline XMVECTOR XMVectorReplicate(const float value) { return {{value, value, value, value}}; }
+
+    inline XMVECTOR XMVectorMultiplyAdd(const XMVECTOR v1, const XMVECTOR v2, const XMVECTOR v3)
+    {
+        XMVECTOR result;
+        for (int i = 0; i < 4; i++) {
+            result.f[i] = v1.f[i] * v2.f[i] + v3.f[i];
+        }
+        return result;
+    }
+
+    inline XMVECTOR XMVectorNegativeMultiplySubtract(const XMVECTOR v1, const XMVECTOR v2, const XMVECTOR v3)
+    {
+        XMVECTOR result;
+        for (int i = 0; i < 4; i++) {
+            result.f[i] = v3.f[i] - v1.f[i] * v2.f[i];
+        }
+        return result;
+    }
+
+    inline void XMStoreFloat4A(XMFLOAT4A* destination, const XMVECTOR v) { *destination = {v.f[0], v.f[1], v.f[2], v.f[3]}; }
+#endif
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+// Stand-in for GWToolboxdll/stdafx.h in the tests project: the standard headers the portable Utils sources rely on,
+// without the Windows, GWCA and ImGui parts. DirectXMath comes from shim/directxmath if it isn't installed; Logger.h is
+// the shim's own.
+
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <cwchar>
+#include <cwctype>
+
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <random>
+#include <ranges>
+#include <set>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include <Logger.h>
+
+#ifndef _MSC_VER
+#define _countof(arr) (sizeof(arr) / sizeof((arr)[0]))
+#endif
+
+#ifndef ASSERT
+#define ASSERT(expr) ((void)(!!(expr) || (std::fprintf(stderr, "Assertion failed: %s (%s:%d)\n", #expr, __FILE__, __LINE__), std::abort(), 0)))
+#endif
@@ -0,0 +1,110 @@
+// AliasIndex against a linear scan over the same names: exact matches only, the message's case ignored, aliases that
+// share a name in list order, and unnamed aliases left out.
+
+#include "stdafx.h"
+
+#include <Utils/AliasIndex.h>
+
+#include "check.h"
+
+namespace {
+    std::vector<const wchar_t*> Pointers(const std::vector<std::wstring>& names)
+    {
+        std::vector<const wchar_t*> out;
+        for (const auto& name : names) {
+            out.push_back(name.c_str());
+        }
+        return out;
+    }
+
+    // What OnSendChat did before the index: compare the lower cased message with every alias
+    std::vector<uint32_t> FindByScan(const std::vector<std::wstring>& names, const std::wstring& message)
+    {
+        std::wstring lower = message;
+        for (auto& c : lower) {
+            c = static_cast<wchar_t>(towlower(c));
+        }
+        std::vector<uint32_t> out;
+        for (uint32_t i = 0; i < names.size(); i++) {
+            if (!names[i].empty() && names[i] == lower)
+                out.push_back(i);
+        }
+        return out;
+    }
+
+    bool Matches(const AliasIndex& index, const std::vector<std::wstring>& names, const std::wstring& message)
+    {
+        const auto found = index.Find(message.c_str());
+        return std::ranges::equal(found, FindByScan(names, message));
+    }
+
+    void TestBasics()
+    {
+        AliasIndex index;
+        CHECK(index.Find(L"ff").empty()); // Never built
+
+        const std::vector<std::wstring> names = {L"ff", L"gh", L"", L"armor", L"ff", L"gh2", L"Upper"};
+        index.Build(Pointers(names));
+        CHECK(std::ranges::equal(index.Find(L"ff"), std::vector<uint32_t>{0, 4}));
+        CHECK(std::ranges::equal(index.Find(L"FF"), std::vector<uint32_t>{0, 4}));
+        CHECK(std::ranges::equal(index.Find(L"gh"), std::vector<uint32_t>{1}));
+        CHECK(std::ranges::equal(index.Find(L"armor"), std::vector<uint32_t>{3}));
+        CHECK(index.Find(L"g").empty());
+        CHECK(index.Find(L"gh ").empty());
+        CHECK(index.Find(L"").empty());
+        CHECK(index.Find(nullptr).empty());
+        // Names aren't lower cased, messages are
+        CHECK(index.Find(L"Upper").empty());
+
+        // The index keeps its own copy of the names
+        std::vector<std::wstring> edited = {L"resign"};
+        index.Build(Pointers(edited));
+        edited[0] = L"x";
+        CHECK(std::ranges::equal(index.Find(L"resign"), std::vector<uint32_t>{0}));
+        CHECK(index.Find(L"ff").empty());
+
+        index.Build({});
+        CHECK(index.Find(L"resign").empty());
+    }
+
+    void TestRandomAliases()
+    {
+        std::mt19937 rng(1);
+        for (const size_t count : {1u, 7u, 64u, 300u, 2000u}) {
+            // Short names from a small alphabet, so there are plenty of shared names and near misses
+            std::vector<std::wstring> names(count);
+            for (auto& name : names) {
+                const size_t len = rng() % 5;
+                for (size_t i = 0; i < len; i++) {
+                    name.push_back(static_cast<wchar_t>(L'a' + rng() % 4));
+                }
+            }
+            AliasIndex index;
+            index.Build(Pointers(names));
+            for (const auto& name : names) {
+                CHECK(Matches(index, names, name));
+                auto upper = name;
+                for (auto& c : upper) {
+                    c = static_cast<wchar_t>(towupper(c));
+                }
+                CHECK(Matches(index, names, upper));
+                CHECK(Matches(index, names, name + L"b"));
+            }
+            for (uint32_t i = 0; i < 200; i++) {
+                std::wstring message;
+                const size_t len = 1 + rng() % 6;
+                for (size_t j = 0; j < len; j++) {
+                    message.push_back(static_cast<wchar_t>(L'a' + rng() % 5));
+                }
+                CHECK(Matches(index, names, message));
+            }
+        }
+    }
+}
+
+int main()
+{
+    TestBasics();
+    TestRandomAliases();
+    return Test::TestResult();
+}
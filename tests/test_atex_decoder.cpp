@@ -0,0 +1,225 @@
+// AtexDecoder on ATEX files built by the test: the mirroring of 256x256 DXT3 textures against a transcription of the
+// game's code, the packed runs, raw blocks, truncated input, and the SSE2 block expansion against the scalar one.
+
+#include "stdafx.h"
+
+#include <Utils/AtexDecoder.h>
+
+#include "atex_fixture.h"
+#include "check.h"
+
+namespace {
+    using AtexDecoder::Format;
+    using AtexFixture::BitWriter;
+
+    std::vector<uint8_t> RandomBytes(const size_t size, std::mt19937& rng)
+    {
+        std::vector<uint8_t> bytes(size);
+        for (auto& b : bytes) {
+            b = static_cast<uint8_t>(rng());
+        }
+        return bytes;
+    }
+
+    void TestMirroredMatchesGame()
+    {
+        std::mt19937 rng(1);
+        constexpr uint32_t block_count = 64 * 64;
+        std::vector<uint32_t> stored;
+        for (uint32_t i = 0; i < block_count; i++) {
+            if (!AtexFixture::IsMirrored(i & 63, i >> 6)) {
+                stored.push_back(i);
+            }
+        }
+        // Raw words for the stored blocks: all the alphas, then colours, then indices
+        const auto alphas = RandomBytes(stored.size() * 8, rng);
+        const auto colors = RandomBytes(stored.size() * 4, rng);
+        const auto indices = RandomBytes(stored.size() * 4, rng);
+        std::vector<uint8_t> raw = alphas;
+        raw.insert(raw.end(), colors.begin(), colors.end());
+        raw.insert(raw.end(), indices.begin(), indices.end());
+
+        std::vector<uint8_t> expected(block_count * 16, 0);
+        for (size_t k = 0; k < stored.size(); k++) {
+            uint8_t* block = expected.data() + stored[k] * 16;
+            memcpy(block, alphas.data() + k * 8, 8);
+            memcpy(block + 8, colors.data() + k * 4, 4);
+            memcpy(block + 12, indices.data() + k * 4, 4);
+        }
+        AtexFixture::AsmMirror(expected.data(), block_count);
+
+        const auto atex = AtexFixture::MakeAtex('3', 256, 256, 0x10, {}, raw);
+        AtexDecoder::Image image;
+        CHECK(AtexDecoder::Decode(atex.data(), atex.size(), image, true));
+        CHECK(image.format == Format::DXT3);
+        CHECK(image.data == expected);
+
+        // Only 256x256 DXT3 is mirrored; the same flag elsewhere is ignored and every block is read
+        const auto small = AtexFixture::MakeAtex('3', 128, 128, 0x10, {}, RandomBytes(32 * 32 * 16, rng));
+        CHECK(AtexDecoder::Decode(small.data(), small.size(), image, true));
+    }
+
+    void TestRawBlocks()
+    {
+        std::mt19937 rng(2);
+        for (const char subformat : {'1', '3', '5'}) {
+            const size_t block_count = 8 * 4;
+            const bool has_alpha = subformat != '1';
+            const auto alphas = RandomBytes(has_alpha ? block_count * 8 : 0, rng);
+            const auto colors = RandomBytes(block_count * 4, rng);
+            const auto indices = RandomBytes(block_count * 4, rng);
+            std::vector<uint8_t> raw = alphas;
+            raw.insert(raw.end(), colors.begin(), colors.end());
+            raw.insert(raw.end(), indices.begin(), indices.end());
+            const auto atex = AtexFixture::MakeAtex(subformat, 32, 16, 0, {}, raw);
+
+            AtexDecoder::Image image;
+            CHECK(AtexDecoder::Decode(atex.data(), atex.size(), image, true));
+            CHECK_EQ(image.Pitch() * image.Rows(), image.data.size());
+            const size_t block_size = has_alpha ? 16 : 8;
+            for (size_t i = 0; i < block_count; i++) {
+                const uint8_t* block = image.data.data() + i * block_size;
+                if (has_alpha) {
+                    CHECK(memcmp(block, alphas.data() + i * 8, 8) == 0);
+                }
+                CHECK(memcmp(block + block_size - 8, colors.data() + i * 4, 4) == 0);
+                CHECK(memcmp(block + block_size - 4, indices.data() + i * 4, 4) == 0);
+            }
+
+            // A word short
+            const std::vector<uint8_t> truncated(atex.begin(), atex.end() - 4);
+            CHECK(!AtexDecoder::Decode(truncated.data(), truncated.size(), image, true));
+        }
+    }
+
+    // 16x16 DXT1: transparent runs on every fourth block, solid colour on the ones after them, the rest raw
+    void TestDxt1Runs()
+    {
+        constexpr uint32_t color = 0x848242; // exactly representable in 565
+        BitWriter bits;
+        for (uint32_t i = 0; i < 16; i++) {
+            bits.RunOfOne();
+            bits.Write(i % 4 == 0, 1);
+        }
+        bits.Write(color, 24);
+        for (uint32_t i = 0; i < 16; i++) {
+            if (i % 4) {
+                bits.RunOfOne();
+                bits.Write(i % 4 == 1, 1);
+            }
+        }
+        std::vector<uint8_t> raw;
+        for (uint32_t i = 0; i < 8; i++) {
+            AtexFixture::Append(raw, 0x001F07E0); // colour0 pure green, colour1 pure blue
+        }
+        for (uint32_t i = 0; i < 8; i++) {
+            AtexFixture::Append(raw, 0); // every pixel colour0
+        }
+        const auto atex = AtexFixture::MakeAtex('1', 16, 16, 1 | 8, bits.words, raw);
+
+        AtexDecoder::Image image;
+        CHECK(AtexDecoder::Decode(atex.data(), atex.size(), image));
+        CHECK(image.format == Format::A8R8G8B8);
+        const auto pixels = reinterpret_cast<const uint32_t*>(image.data.data());
+        for (uint32_t i = 0; i < 16; i++) {
+            const uint32_t expected = i % 4 == 0 ? 0 : i % 4 == 1 ? 0xFF000000 | color : 0xFF00FF00;
+            const uint32_t x = i % 4 * 4;
+            const uint32_t y = i / 4 * 4;
+            for (uint32_t p = 0; p < 16; p++) {
+                CHECK_EQ(pixels[(y + p / 4) * 16 + x + p % 4], expected);
+            }
+        }
+    }
+
+    // 8x8 DXT5 and DXT3 with runs of transparent and constant alpha, the rest raw
+    void TestAlphaRuns()
+    {
+        for (const char subformat : {'5', '3'}) {
+            const bool dxt5 = subformat == '5';
+            const uint32_t alpha = dxt5 ? 0x80 : 0x9;
+            BitWriter bits;
+            bits.Write(alpha, dxt5 ? 8 : 4);
+            for (uint32_t i = 0; i < 4; i++) {
+                bits.RunOfOne();
+                // Block 0 transparent, block 1 constant, the others raw
+                if (i < 2) {
+                    bits.Write(1, 1);
+                    bits.Write(i, 1);
+                }
+                else {
+                    bits.Write(0, 1);
+                }
+            }
+            std::vector<uint8_t> raw;
+            for (uint32_t i = 0; i < 2; i++) {
+                // DXT5: both endpoints 0xFF, indices 0; DXT3: every alpha 0xF
+                AtexFixture::Append(raw, 0xFFFFFFFF & (dxt5 ? 0x0000FFFF : 0xFFFFFFFF));
+                AtexFixture::Append(raw, dxt5 ? 0 : 0xFFFFFFFF);
+            }
+            for (uint32_t i = 0; i < 4; i++) {
+                AtexFixture::Append(raw, 0xF800F800); // red
+            }
+            for (uint32_t i = 0; i < 4; i++) {
+                AtexFixture::Append(raw, 0);
+            }
+            const auto atex = AtexFixture::MakeAtex(subformat, 8, 8, dxt5 ? 4 : 2, bits.words, raw);
+
+            AtexDecoder::Image image;
+            CHECK(AtexDecoder::Decode(atex.data(), atex.size(), image));
+            const auto pixels = reinterpret_cast<const uint32_t*>(image.data.data());
+            const uint32_t constant = dxt5 ? alpha : alpha * 0x11;
+            for (uint32_t i = 0; i < 4; i++) {
+                const uint32_t expected_alpha = i == 0 ? 0 : i == 1 ? constant : 0xFF;
+                for (uint32_t p = 0; p < 16; p++) {
+                    const uint32_t pixel = pixels[(i / 2 * 4 + p / 4) * 8 + i % 2 * 4 + p % 4];
+                    CHECK_EQ(pixel >> 24, expected_alpha);
+                    CHECK_EQ(pixel & 0xFFFFFF, 0xFF0000u);
+                }
+            }
+        }
+    }
+
+    void TestSimdMatchesScalar()
+    {
+        std::mt19937 rng(3);
+        constexpr uint32_t width = 64;
+        constexpr uint32_t height = 32;
+        for (const auto format : {Format::DXT1, Format::DXT3, Format::DXT5}) {
+            const size_t block_size = format == Format::DXT1 ? 8 : 16;
+            auto blocks = RandomBytes(width * height / 16 * block_size, rng);
+            // Make sure both DXT1 colour modes and both DXT5 alpha modes come up
+            for (size_t i = 0; i < blocks.size(); i += block_size * 2) {
+                std::swap(blocks[i + block_size - 8], blocks[i + block_size - 6]);
+                std::swap(blocks[i], blocks[i + 1]);
+            }
+            std::vector<uint32_t> simd(width * height);
+            std::vector<uint32_t> scalar(width * height);
+            AtexDecoder::DecompressBlocks(format, blocks.data(), width, height, simd.data());
+            AtexDecoder::DecompressBlocksScalar(format, blocks.data(), width, height, scalar.data());
+            CHECK(simd == scalar);
+        }
+    }
+
+    void TestRejects()
+    {
+        AtexDecoder::Image image;
+        auto atex = AtexFixture::MakeAtex('1', 16, 16, 0, {}, std::vector<uint8_t>(16 * 8));
+        CHECK(AtexDecoder::CanDecode(atex.data(), atex.size()));
+        atex[7] = 'Z'; // unknown subformat
+        CHECK(!AtexDecoder::CanDecode(atex.data(), atex.size()));
+        const auto odd = AtexFixture::MakeAtex('1', 10, 16, 0, {}, std::vector<uint8_t>(16 * 8));
+        CHECK(!AtexDecoder::Decode(odd.data(), odd.size(), image));
+        CHECK(!AtexDecoder::CanDecode(atex.data(), 12));
+    }
+}
+
+int main()
+{
+    TestMirroredMatchesGame();
+    TestRawBlocks();
+    TestDxt1Runs();
+    TestAlphaRuns();
+    TestSimdMatchesScalar();
+    TestRejects();
+    return Test::TestResult();
+}
@@ -0,0 +1,228 @@
+// The block update end to end over HTTP: a local server with a new release of the dll and its manifest, an installed
+// older build, and the ranged requests the launcher sends (same Range header, all in flight at once through libcurl).
+// Checks the reassembled file against the manifest, the request count, and that a server ignoring Range is caught.
+
+#include "stdafx.h"
+
+#include <BlockUpdate.h>
+
+#include <arpa/inet.h>
+#include <curl/curl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "block_update_fixture.h"
+#include "check.h"
+
+namespace {
+    // Serves GET /GWToolboxdll.dll (with single "Range: bytes=first-last" support) and /GWToolboxdll.manifest.json
+    class StaticServer {
+    public:
+        StaticServer(std::string dll, std::string manifest, const bool honour_range)
+            : dll(std::move(dll))
+            , manifest(std::move(manifest))
+            , honour_range(honour_range)
+        {
+            listener = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t length = sizeof(address);
+            CHECK(bind(listener, reinterpret_cast<sockaddr*>(&address), length) == 0);
+            CHECK(listen(listener, 64) == 0);
+            CHECK(getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) == 0);
+            port = ntohs(address.sin_port);
+            accept_thread = std::thread([this] { AcceptLoop(); });
+        }
+
+        ~StaticServer()
+        {
+            shutdown(listener, SHUT_RDWR);
+            close(listener);
+            accept_thread.join();
+            for (auto& connection : connections) {
+                connection.join();
+            }
+        }
+
+        [[nodiscard]] std::string Url(const char* file) const { return "http://127.0.0.1:" + std::to_string(port) + "/" + file; }
+
+        std::atomic<size_t> dll_requests = 0;
+        std::atomic<size_t> dll_bytes_sent = 0;
+
+    private:
+        void AcceptLoop()
+        {
+            for (;;) {
+                const int client = accept(listener, nullptr, nullptr);
+                if (client < 0) {
+                    return;
+                }
+                connections.emplace_back([this, client] { Serve(client); });
+            }
+        }
+
+        void Serve(const int client)
+        {
+            std::string request;
+            char buffer[4096];
+            while (request.find("\r\n\r\n") == std::string::npos) {
+                const auto received = recv(client, buffer, sizeof(buffer), 0);
+                if (received <= 0) {
+                    close(client);
+                    return;
+                }
+                request.append(buffer, static_cast<size_t>(received));
+            }
+            const std::string path = request.substr(4, request.find(' ', 4) - 4);
+            std::string status = "200 OK";
+            std::string body;
+            if (path == "/GWToolboxdll.manifest.json") {
+                body = manifest;
+            }
+            else if (path == "/GWToolboxdll.dll") {
+                dll_requests++;
+                body = dll;
+                size_t first, last;
+                const auto range = request.find("\r\nRange: bytes=");
+                if (honour_range && range != std::string::npos && sscanf(request.c_str() + range, "\r\nRange: bytes=%zu-%zu", &first, &last) == 2) {
+                    if (first <= last && last < dll.size()) {
+                        status = "206 Partial Content";
+                        body = dll.substr(first, last - first + 1);
+                    }
+                    else {
+                        status = "416 Range Not Satisfiable";
+                        body.clear();
+                    }
+                }
+                dll_bytes_sent += body.size();
+            }
+            else {
+                status = "404 Not Found";
+            }
+            const std::string response = "HTTP/1.1 " + status + "\r\nContent-Length: " + std::to_string(body.size())
+                                         + "\r\nConnection: close\r\n\r\n" + body;
+            for (size_t sent = 0; sent < response.size();) {
+                const auto n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+                if (n <= 0) {
+                    break;
+                }
+                sent += static_cast<size_t>(n);
+            }
+            close(client);
+        }
+
+        std::string dll;
+        std::string manifest;
+        bool honour_range;
+        int listener = -1;
+        uint16_t port = 0;
+        std::thread accept_thread;
+        std::vector<std::thread> connections;
+    };
+
+    size_t Append(const char* data, const size_t size, const size_t count, void* out)
+    {
+        static_cast<std::string*>(out)->append(data, size * count);
+        return size * count;
+    }
+
+    struct Transfer {
+        CURL* handle = nullptr;
+        curl_slist* headers = nullptr;
+        std::string content;
+    };
+
+    // Fetches every URL (with its optional header) at once, like RunBlockRequests
+    std::vector<std::string> FetchAll(const std::vector<std::pair<std::string, std::string>>& requests)
+    {
+        CURLM* multi = curl_multi_init();
+        std::vector<Transfer> transfers(requests.size());
+        for (size_t i = 0; i < requests.size(); i++) {
+            auto& transfer = transfers[i];
+            transfer.handle = curl_easy_init();
+            curl_easy_setopt(transfer.handle, CURLOPT_URL, requests[i].first.c_str());
+            curl_easy_setopt(transfer.handle, CURLOPT_WRITEFUNCTION, &Append);
+            curl_easy_setopt(transfer.handle, CURLOPT_WRITEDATA, &transfer.content);
+            if (!requests[i].second.empty()) {
+                transfer.headers = curl_slist_append(nullptr, requests[i].second.c_str());
+                curl_easy_setopt(transfer.handle, CURLOPT_HTTPHEADER, transfer.headers);
+            }
+            curl_multi_add_handle(multi, transfer.handle);
+        }
+        int running = 1;
+        while (running) {
+            curl_multi_perform(multi, &running);
+            curl_multi_poll(multi, nullptr, 0, 100, nullptr);
+        }
+        std::vector<std::string> contents;
+        for (auto& transfer : transfers) {
+            long status = 0;
+            curl_easy_getinfo(transfer.handle, CURLINFO_RESPONSE_CODE, &status);
+            CHECK(status == 200 || status == 206);
+            curl_multi_remove_handle(multi, transfer.handle);
+            curl_easy_cleanup(transfer.handle);
+            curl_slist_free_all(transfer.headers);
+            contents.push_back(std::move(transfer.content));
+        }
+        curl_multi_cleanup(multi);
+        return contents;
+    }
+
+    // DownloadWindow::DownloadAllFiles from the manifest on: true if the reassembled dll matches it
+    bool UpdateFrom(StaticServer& server, const std::string& installed, std::string& output)
+    {
+        const auto manifest_json = FetchAll({{server.Url("GWToolboxdll.manifest.json"), {}}});
+        BlockUpdate::Manifest manifest;
+        if (!BlockUpdate::ParseManifest(manifest_json[0], &manifest)) {
+            return false;
+        }
+        const auto ranges = BlockUpdate::Plan(manifest, installed, output, &Sha256::Hex);
+        CHECK(ranges.size() <= BlockUpdate::MAX_RANGES);
+        std::vector<std::pair<std::string, std::string>> requests;
+        for (const auto& range : ranges) {
+            requests.emplace_back(server.Url("GWToolboxdll.dll"), BlockUpdate::RangeHeader(range));
+        }
+        const auto contents = FetchAll(requests);
+        for (size_t i = 0; i < ranges.size(); i++) {
+            if (!BlockUpdate::Apply(ranges[i], contents[i], output)) {
+                return false;
+            }
+        }
+        std::string hash;
+        return Sha256::Hex(output.data(), output.size(), hash) && hash == manifest.sha256;
+    }
+
+    void TestRangedUpdate()
+    {
+        const auto installed = BlockUpdateFixture::MakeDll(4 * 1024 * 1024 + 321, 1);
+        const auto release = BlockUpdateFixture::NextRelease(installed, 25, true, 70000, 2);
+        StaticServer server(release, BlockUpdateFixture::ManifestJson(release), true);
+        std::string output;
+        CHECK(UpdateFrom(server, installed, output));
+        CHECK(output == release);
+        CHECK(server.dll_requests > 1);
+        CHECK(server.dll_requests <= BlockUpdate::MAX_RANGES);
+        CHECK(server.dll_bytes_sent < release.size());
+    }
+
+    void TestServerIgnoringRange()
+    {
+        // Sends the whole file for every request: each range comes back the wrong length, so the launcher falls back
+        const auto installed = BlockUpdateFixture::MakeDll(1024 * 1024, 3);
+        const auto release = BlockUpdateFixture::NextRelease(installed, 5, false, 0, 4);
+        StaticServer server(release, BlockUpdateFixture::ManifestJson(release), false);
+        std::string output;
+        CHECK(!UpdateFrom(server, installed, output));
+    }
+}
+
+int main()
+{
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    TestRangedUpdate();
+    TestServerIgnoringRange();
+    curl_global_cleanup();
+    return Test::TestResult();
+}
@@ -0,0 +1,123 @@
+// Planning a block update between two synthetic builds of the dll: the reused blocks plus the planned ranges have to
+// rebuild the new dll exactly, in at most BlockUpdate::MAX_RANGES requests.
+
+#include "stdafx.h"
+
+#include <BlockUpdate.h>
+
+#include "block_update_fixture.h"
+#include "check.h"
+
+namespace {
+    using BlockUpdate::Range;
+
+    BlockUpdate::Manifest Manifest(const std::string& dll)
+    {
+        BlockUpdate::Manifest manifest;
+        CHECK(BlockUpdate::ParseManifest(BlockUpdateFixture::ManifestJson(dll), &manifest));
+        return manifest;
+    }
+
+    // Plans the update from local to remote, fills in the ranges from remote and returns how many bytes that took
+    size_t Update(const std::string& local, const std::string& remote)
+    {
+        const auto manifest = Manifest(remote);
+        std::string output;
+        const auto ranges = BlockUpdate::Plan(manifest, local, output, &Sha256::Hex);
+        CHECK(ranges.size() <= BlockUpdate::MAX_RANGES);
+        CHECK_EQ(output.size(), remote.size());
+
+        size_t downloaded = 0;
+        size_t end = 0;
+        for (const auto& range : ranges) {
+            CHECK(range.length > 0);
+            CHECK(range.offset >= end); // in order, not overlapping
+            CHECK(range.offset % BlockUpdateFixture::block_size == 0);
+            end = range.offset + range.length;
+            CHECK(end <= remote.size());
+            CHECK(BlockUpdate::Apply(range, remote.substr(range.offset, range.length), output));
+            downloaded += range.length;
+        }
+        CHECK(output == remote);
+        std::string hash;
+        Sha256::Hex(output.data(), output.size(), hash);
+        CHECK_EQ(hash, manifest.sha256);
+        return downloaded;
+    }
+
+    void TestSha256()
+    {
+        std::string hash;
+        Sha256::Hex("abc", 3, hash);
+        CHECK_EQ(hash, std::string("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+        Sha256::Hex("", 0, hash);
+        CHECK_EQ(hash, std::string("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+    }
+
+    void TestParseManifest()
+    {
+        const auto dll = BlockUpdateFixture::MakeDll(200000, 1);
+        BlockUpdate::Manifest manifest;
+        CHECK(BlockUpdate::ParseManifest(BlockUpdateFixture::ManifestJson(dll), &manifest));
+        CHECK_EQ(manifest.size, dll.size());
+        CHECK_EQ(manifest.blocks.size(), 4u);
+
+        auto json = nlohmann::json::parse(BlockUpdateFixture::ManifestJson(dll));
+        json["blocks"].erase(json["blocks"].size() - 1);
+        CHECK(!BlockUpdate::ParseManifest(json.dump(), &manifest));
+        json = nlohmann::json::parse(BlockUpdateFixture::ManifestJson(dll));
+        json["block_size"] = 0;
+        CHECK(!BlockUpdate::ParseManifest(json.dump(), &manifest));
+        CHECK(!BlockUpdate::ParseManifest("{\"size\": 1", &manifest));
+        CHECK(!BlockUpdate::ParseManifest("[]", &manifest));
+    }
+
+    void TestReleases()
+    {
+        const auto installed = BlockUpdateFixture::MakeDll(3 * 1024 * 1024 + 12345, 2);
+
+        // Same file: nothing to download
+        CHECK_EQ(Update(installed, installed), 0u);
+
+        // A few recompiled functions: only their blocks
+        const auto small = BlockUpdateFixture::NextRelease(installed, 3, false, 0, 3);
+        CHECK(Update(installed, small) <= 6 * BlockUpdateFixture::block_size);
+
+        // Code inserted: the blocks after it no longer line up, but the ones before it are still reused
+        const auto shifted = BlockUpdateFixture::NextRelease(installed, 2, true, 5000, 4);
+        CHECK(Update(installed, shifted) < shifted.size() / 2);
+
+        // Changes all over the file still fit in MAX_RANGES requests, at the cost of some unchanged blocks
+        for (uint32_t seed = 5; seed < 15; seed++) {
+            const auto scattered = BlockUpdateFixture::NextRelease(installed, 40 + seed * 3, seed % 2, seed * 1000, seed);
+            CHECK(Update(installed, scattered) < scattered.size());
+        }
+
+        // Nothing in common, or no local dll at all: everything, split over the requests
+        CHECK_EQ(Update(BlockUpdateFixture::MakeDll(1000000, 20), installed), installed.size());
+        CHECK_EQ(Update({}, installed), installed.size());
+    }
+
+    void TestRangeHeaderAndApply()
+    {
+        CHECK_EQ(BlockUpdate::RangeHeader({65536, 65536}), std::string("Range: bytes=65536-131071"));
+        CHECK_EQ(BlockUpdate::RangeHeader({0, 1}), std::string("Range: bytes=0-0"));
+
+        std::string output(100, '\0');
+        CHECK(BlockUpdate::Apply({90, 10}, std::string(10, 'x'), output));
+        CHECK(output.ends_with(std::string(10, 'x')));
+        // A server that ignored the range and sent the whole file
+        CHECK(!BlockUpdate::Apply({0, 10}, std::string(100, 'y'), output));
+        CHECK(!BlockUpdate::Apply({95, 10}, std::string(10, 'y'), output));
+        CHECK(output.find('y') == std::string::npos);
+    }
+}
+
+int main()
+{
+    TestSha256();
+    TestParseManifest();
+    TestReleases();
+    TestRangeHeaderAndApply();
+    return Test::TestResult();
+}
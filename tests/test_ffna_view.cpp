@@ -0,0 +1,225 @@
+// FfnaView on built and damaged FFNA files: chunk lookups against a plain walk of the chunk list, bounds on everything
+// it hands out, and ArenaNetFile reading through the view without copying the dat blob.
+
+#include "stdafx.h"
+
+#include <Modules/GwDatTextureModule.h>
+#include <Utils/ArenaNetFileParser.h>
+
+#include "check.h"
+#include "ffna_fixture.h"
+
+namespace {
+    using ArenaNetFileParser::ChunkType;
+    using ArenaNetFileParser::FfnaView;
+    using FfnaFixture::MakeFfna;
+
+    std::vector<uint8_t> Bytes(const char* s)
+    {
+        return {s, s + strlen(s)};
+    }
+
+    // The first chunk with chunk_id, walking the list the way the game does and stopping at the first that doesn't fit
+    std::optional<std::pair<size_t, size_t>> WalkTo(const std::span<const uint8_t> bytes, const uint32_t chunk_id)
+    {
+        if (bytes.size() < 5 || memcmp(bytes.data(), "ffna", 4) != 0)
+            return std::nullopt;
+        for (size_t offset = 5; offset + 8 <= bytes.size();) {
+            uint32_t id, size;
+            memcpy(&id, &bytes[offset], 4);
+            memcpy(&size, &bytes[offset + 4], 4);
+            if (size > bytes.size() - offset - 8)
+                return std::nullopt;
+            if (id == chunk_id)
+                return std::pair{offset + 8, size_t{size}};
+            offset += 8 + size;
+        }
+        return std::nullopt;
+    }
+
+    bool Inside(const std::span<const uint8_t> bytes, const void* p, const size_t size)
+    {
+        const auto begin = reinterpret_cast<uintptr_t>(bytes.data());
+        const auto at = reinterpret_cast<uintptr_t>(p);
+        return at >= begin && at + size <= begin + bytes.size();
+    }
+
+    // Every lookup agrees with the walk and stays inside the buffer
+    void CheckAgainstWalk(const std::span<const uint8_t> bytes, const std::vector<uint32_t>& chunk_ids)
+    {
+        const FfnaView view(bytes);
+        for (const auto chunk_id : chunk_ids) {
+            const auto chunk_type = static_cast<ChunkType>(chunk_id);
+            const auto expected = WalkTo(bytes, chunk_id);
+            const auto data = view.ChunkData(chunk_type);
+            const auto chunk = view.FindChunk(chunk_type);
+            if (!expected) {
+                CHECK(data.empty() && !chunk);
+                continue;
+            }
+            CHECK(chunk && reinterpret_cast<const uint8_t*>(chunk) == bytes.data() + expected->first - 8);
+            CHECK(data.data() == bytes.data() + expected->first && data.size() == expected->second);
+            const auto names = view.FileNames(chunk_type);
+            CHECK(names.empty() || Inside(bytes, names.data(), names.size_bytes()));
+            const auto geometry = view.Geometry();
+            CHECK(!geometry || Inside(bytes, geometry, sizeof(*geometry)));
+        }
+    }
+
+    void TestLookups()
+    {
+        std::mt19937 rng(1);
+        const auto atex = Bytes("ATEX first");
+        const auto file = MakeFfna(2, {
+            FfnaFixture::RandomChunk(ChunkType::GEOMETRY, 4, rng), // Too small for its header
+            {ChunkType::ATEXFILE, atex},
+            FfnaFixture::FileNames(ChunkType::FILENAMES_FA5, {0x1234, 0x5678, 0xABCDE}),
+            {ChunkType::ATEXFILE, Bytes("ATEX second")},
+            FfnaFixture::FileNames(ChunkType::SOUND_FILES_1, {0x42}),
+            {ChunkType::FILENAMES_FA6, {}},
+        });
+        const FfnaView view(file);
+        CHECK(view.isValid());
+        CHECK_EQ(view.getFFNAType(), 2u);
+
+        // The first chunk of an id wins, as in the game's walk
+        const auto found = view.Atex();
+        CHECK(std::ranges::equal(found, atex));
+        CHECK(view.FindChunk(ChunkType::ATEXFILE)->chunk_size == atex.size());
+        CHECK(!view.FindChunk(ChunkType::FILENAMES_BBC) && view.ChunkData(ChunkType::FILENAMES_BBC).empty());
+        CHECK(!view.Geometry());
+
+        const auto names = view.FileNames(ChunkType::FILENAMES_FA5);
+        CHECK_EQ(names.size(), 3u);
+        CHECK_EQ(ArenaNetFileParser::FileHashToFileId(names[2].filename), 0xABCDEu);
+        const auto sounds = view.FileNames(ChunkType::SOUND_FILES_1);
+        CHECK(sounds.size() == 1 && ArenaNetFileParser::FileHashToFileId(sounds[0].filename) == 0x42);
+        CHECK(view.FileNames(ChunkType::FILENAMES_FA6).empty());
+
+        CheckAgainstWalk(file, {ChunkType::GEOMETRY, ChunkType::ATEXFILE, ChunkType::FILENAMES_FA5, ChunkType::SOUND_FILES_1,
+                                ChunkType::FILENAMES_FA6, ChunkType::FILENAMES_BBD});
+    }
+
+    void TestDamagedFiles()
+    {
+        std::mt19937 rng(2);
+        CHECK(!FfnaView(std::span<const uint8_t>()).isValid());
+        CHECK(!FfnaView(Bytes("ffn")).isValid());
+        CHECK(!FfnaView(Bytes("ffnb\x02")).isValid());
+        CHECK(FfnaView(Bytes("ffna\x02")).isValid()); // No chunks
+        CHECK(FfnaView(Bytes("ffna\x02")).Atex().empty());
+
+        // A chunk that runs past the end: the ones before it still work
+        auto file = MakeFfna(2, {{ChunkType::ATEXFILE, Bytes("ATEX")}, FfnaFixture::RandomChunk(ChunkType::GEOMETRY, 200, rng)});
+        file.resize(file.size() - 1);
+        FfnaView view(file);
+        CHECK(!view.isValid());
+        CHECK_EQ(view.Atex().size(), 4u);
+        CHECK(!view.FindChunk(ChunkType::GEOMETRY));
+
+        // Less than a chunk header left over is padding
+        file = MakeFfna(2, {{ChunkType::ATEXFILE, Bytes("ATEX")}});
+        file.insert(file.end(), 7, 0);
+        CHECK(FfnaView(file).isValid());
+
+        // Counts past the end of the chunk are clamped
+        file = MakeFfna(2, {FfnaFixture::FileNames(ChunkType::FILENAMES_FA5, {1, 2}, 1000)});
+        CHECK_EQ(FfnaView(file).FileNames(ChunkType::FILENAMES_FA5).size(), 2u);
+        file = MakeFfna(2, {{ChunkType::FILENAMES_FA5, {1, 2, 3}}});
+        CHECK(FfnaView(file).FileNames(ChunkType::FILENAMES_FA5).empty());
+    }
+
+    void TestFuzz()
+    {
+        std::mt19937 rng(3);
+        std::vector<uint32_t> chunk_ids = {ChunkType::GEOMETRY, ChunkType::ANIMATION, ChunkType::ATEXFILE, ChunkType::FILENAMES_FA5,
+                                           ChunkType::FILENAMES_FA6, ChunkType::FILENAMES_FAD, ChunkType::FILENAMES_BBC,
+                                           ChunkType::FILENAMES_BBD, ChunkType::SOUND_FILES_1};
+        for (uint32_t i = 0; i < 3000; i++) {
+            std::vector<FfnaFixture::Chunk> chunks;
+            for (size_t n = rng() % 12; n-- > 0;) {
+                const uint32_t chunk_id = chunk_ids[rng() % chunk_ids.size()];
+                if (chunk_id != ChunkType::ATEXFILE && chunk_id != ChunkType::GEOMETRY && chunk_id != ChunkType::ANIMATION && rng() % 2) {
+                    std::vector<uint32_t> file_ids(rng() % 6);
+                    for (auto& file_id : file_ids) {
+                        file_id = 1 + rng() % 0xFFFFFF;
+                    }
+                    chunks.push_back(FfnaFixture::FileNames(static_cast<ChunkType>(chunk_id), file_ids, rng() % 4 ? ~0u : rng() % 100));
+                }
+                else {
+                    chunks.push_back(FfnaFixture::RandomChunk(chunk_id, rng() % 300, rng));
+                }
+            }
+            auto file = MakeFfna(static_cast<uint8_t>(rng()), chunks);
+            // Flip bits, often in a size field, and cut the file short
+            for (size_t flips = rng() % 4; flips-- > 0;) {
+                file[rng() % file.size()] ^= static_cast<uint8_t>(1 << rng() % 8);
+            }
+            if (rng() % 3 == 0) {
+                file.resize(rng() % (file.size() + 1));
+            }
+            // Exactly the size of the buffer, so ASan sees any read past it
+            const auto exact = std::make_unique<uint8_t[]>(file.size());
+            std::ranges::copy(file, exact.get());
+            CheckAgainstWalk({exact.get(), file.size()}, chunk_ids);
+        }
+    }
+
+    void TestArenaNetFile()
+    {
+        using ArenaNetFileParser::ArenaNetFile;
+        auto& files = GwDatTextureModule::Files();
+        const auto atex = Bytes("ATEX image");
+        const auto blob = std::make_shared<const std::vector<uint8_t>>(MakeFfna(8, {
+            {ChunkType::ATEXFILE, atex},
+            FfnaFixture::FileNames(ChunkType::SOUND_FILES_1, {0x321}),
+        }));
+        files[0x100] = blob;
+
+        // Read without a copy: the asset shares the dat's blob and the view points into it
+        ArenaNetFile asset;
+        CHECK(asset.readFromDat(0x100));
+        CHECK(asset.data == blob);
+        CHECK(asset.isValid());
+        CHECK_EQ(asset.getFFNAType(), 8u);
+        CHECK(asset.view.Atex().data() == blob->data() + 13);
+        CHECK(asset.FindChunk(ChunkType::SOUND_FILES_1));
+
+        // By file hash, as the names in other files give them
+        wchar_t file_hash[4] = {0};
+        ArenaNetFileParser::FileIdToFileHash(0x100, file_hash);
+        ArenaNetFile by_hash;
+        CHECK(by_hash.readFromDat(file_hash) && by_hash.data == blob);
+
+        // A copy keeps the blob alive, and with it the view
+        auto copy = asset;
+        asset = {};
+        files.clear();
+        CHECK(!asset.isValid() && !asset.view.isValid());
+        CHECK(std::ranges::equal(copy.view.Atex(), atex));
+
+        // Missing files leave the asset as it was
+        CHECK(!copy.readFromDat(0x100));
+        CHECK(copy.isValid());
+
+        // Bytes that aren't ffna
+        auto bytes = Bytes("atex");
+        const auto data = bytes.data();
+        ArenaNetFileParser::ATexFile texture;
+        CHECK(texture.parse(bytes));
+        CHECK(texture.bytes().data() == data); // Taken over, not copied
+        ArenaNetFile not_ffna;
+        auto atex_bytes = Bytes("atex");
+        CHECK(!not_ffna.parse(atex_bytes));
+        CHECK(!not_ffna.FindChunk(ChunkType::ATEXFILE));
+    }
+}
+
+int main()
+{
+    TestLookups();
+    TestDamagedFiles();
+    TestFuzz();
+    TestArenaNetFile();
+    return Test::TestResult();
+}
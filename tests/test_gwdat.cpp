@@ -0,0 +1,243 @@
+// GwDat on synthetic dats: the decompressor against the fixture's compressor, reads through the MFT, ReadMany on the
+// reader's worker threads, and the index following the game as it adds and moves files.
+
+#include "stdafx.h"
+
+#include <Utils/GwDat.h>
+
+#include "check.h"
+#include "gwdat_fixture.h"
+
+namespace {
+    using GwDatFixture::DatBuilder;
+
+    std::filesystem::path TempDat(const char* name)
+    {
+        const auto path = std::filesystem::temp_directory_path() / name;
+        std::filesystem::remove(path);
+        return path;
+    }
+
+    bool RoundTrips(const std::vector<uint8_t>& data, const uint32_t min_length = 3, const uint32_t block_symbols = 65536)
+    {
+        const auto packed = GwDatFixture::Compress(data, min_length, block_symbols);
+        std::vector<uint8_t> out;
+        return GwDat::Decompress(packed.data(), packed.size(), out) && out == data;
+    }
+
+    void TestDecompress()
+    {
+        std::mt19937 rng(1);
+        CHECK(RoundTrips({}));
+        CHECK(RoundTrips({42}));
+        CHECK(RoundTrips(std::vector<uint8_t>(100000, 7))); // One long overlapping match after another
+        for (uint32_t seed = 0; seed < 20; seed++) {
+            CHECK(RoundTrips(GwDatFixture::MakeContents(1 + rng() % 200000, rng), 1 + seed % 16));
+        }
+        // Several blocks, each with its own trees
+        CHECK(RoundTrips(GwDatFixture::MakeContents(300000, rng), 3, 4096));
+
+        // Random bytes: every literal in use, so the trees have codes longer than the 8 bit lookup
+        std::vector<uint8_t> noise(50000);
+        for (auto& b : noise) {
+            b = static_cast<uint8_t>(std::min(rng() % 256, rng() % 256));
+        }
+        CHECK(RoundTrips(noise));
+        // A block with long codes followed by blocks with none
+        auto mixed = noise;
+        mixed.insert(mixed.end(), 200000, 'x');
+        CHECK(RoundTrips(mixed, 3, 4096));
+    }
+
+    void TestCorruptStreams()
+    {
+        std::mt19937 rng(2);
+        const auto data = GwDatFixture::MakeContents(20000, rng);
+        const auto packed = GwDatFixture::Compress(data);
+        std::vector<uint8_t> out;
+
+        // Unpacked size past the limit
+        auto huge = packed;
+        GwDatFixture::Put<uint32_t>(huge, huge.size() - 4, 0x7FFFFFFF);
+        CHECK(!GwDat::Decompress(huge.data(), huge.size(), out));
+        CHECK(!GwDat::Decompress(packed.data(), 4, out));
+
+        // Flipped bits and cut streams either fail or give data of the stated size; they never read or write outside
+        for (uint32_t i = 0; i < 2000; i++) {
+            auto damaged = packed;
+            if (i % 2) {
+                damaged[rng() % (damaged.size() - 4)] ^= static_cast<uint8_t>(1 << rng() % 8);
+            }
+            else {
+                // Whole words, so the size stays in the last one
+                damaged.erase(damaged.begin() + rng() % (damaged.size() / 4 - 1) * 4, damaged.end() - 4);
+            }
+            if (GwDat::Decompress(damaged.data(), damaged.size(), out)) {
+                CHECK_EQ(out.size(), data.size());
+            }
+        }
+    }
+
+    struct Fixture {
+        DatBuilder dat;
+        std::map<uint32_t, std::vector<uint8_t>> files;
+    };
+
+    Fixture MakeFixture(const size_t count, const uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        Fixture fixture;
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t file_id = 0x1000 + static_cast<uint32_t>(rng() % 1000000);
+            if (fixture.files.contains(file_id)) {
+                continue;
+            }
+            auto contents = GwDatFixture::MakeContents(1 + rng() % 30000, rng);
+            fixture.dat.Add(file_id, contents, rng() % 4 != 0);
+            fixture.files[file_id] = std::move(contents);
+        }
+        fixture.dat.WriteMft();
+        return fixture;
+    }
+
+    void TestRead()
+    {
+        auto fixture = MakeFixture(200, 3);
+        const auto path = TempDat("gwtoolbox_test.dat");
+        fixture.dat.Save(path);
+
+        GwDat::DatFile dat;
+        CHECK(!dat.IsOpen());
+        CHECK(dat.Open(path));
+        CHECK(dat.IsOpen());
+        const auto entries = dat.Entries();
+        CHECK_EQ(entries.size(), fixture.files.size());
+        CHECK(std::ranges::is_sorted(entries, {}, &GwDat::Entry::file_id));
+        for (const auto& [file_id, contents] : fixture.files) {
+            const auto entry = dat.Find(file_id);
+            CHECK(entry && entry->record >= DatBuilder::FIRST_FILE_RECORD);
+            const auto blob = dat.Read(file_id);
+            CHECK(blob && *blob == contents);
+        }
+        CHECK(!dat.Find(1));
+        CHECK(!dat.Read(1));
+
+        // Cached until the budget says otherwise
+        const uint32_t some_id = fixture.files.begin()->first;
+        CHECK(dat.Read(some_id) == dat.Read(some_id));
+        dat.SetCacheBudget(0);
+        CHECK(dat.Read(some_id) != dat.Read(some_id));
+
+        dat.Close();
+        CHECK(!dat.IsOpen());
+        CHECK(!dat.Read(some_id));
+        CHECK(!dat.Open(TempDat("gwtoolbox_missing.dat")));
+        std::filesystem::remove(path);
+    }
+
+    void TestReadMany()
+    {
+        auto fixture = MakeFixture(300, 4);
+        const auto path = TempDat("gwtoolbox_test.dat");
+        fixture.dat.Save(path);
+        GwDat::DatFile dat;
+        CHECK(dat.Open(path));
+        dat.SetCacheBudget(0);
+
+        std::vector<uint32_t> ids;
+        for (const auto& file_id : fixture.files | std::views::keys) {
+            ids.push_back(file_id);
+        }
+        ids.push_back(1); // Missing; still reported
+
+        std::mutex mutex;
+        std::set<std::thread::id> all_threads;
+        for (const size_t threads : {size_t{0}, size_t{1}, size_t{3}, size_t{0}, size_t{64}}) {
+            std::map<uint32_t, size_t> seen;
+            std::set<std::thread::id> batch_threads;
+            dat.ReadMany(ids, [&](const uint32_t file_id, const GwDat::Blob& blob) {
+                std::lock_guard lock(mutex);
+                seen[file_id]++;
+                batch_threads.insert(std::this_thread::get_id());
+                if (file_id == 1) {
+                    CHECK(!blob);
+                }
+                else {
+                    CHECK(blob && *blob == fixture.files[file_id]);
+                }
+            }, threads);
+            CHECK_EQ(seen.size(), ids.size());
+            CHECK(std::ranges::all_of(seen | std::views::values, [](const size_t n) {
+                return n == 1;
+            }));
+            CHECK(!batch_threads.contains(std::this_thread::get_id()));
+            if (threads) {
+                CHECK(batch_threads.size() <= threads);
+            }
+            all_threads.insert(batch_threads.begin(), batch_threads.end());
+        }
+        // The same threads every time
+        CHECK(all_threads.size() <= std::max(1u, std::thread::hardware_concurrency()));
+        dat.ReadMany({}, [](uint32_t, const GwDat::Blob&) {
+            CHECK(false);
+        });
+        std::filesystem::remove(path);
+    }
+
+    void TestGameWritesDat()
+    {
+        auto fixture = MakeFixture(50, 5);
+        const auto path = TempDat("gwtoolbox_test.dat");
+        fixture.dat.Save(path);
+        GwDat::DatFile dat;
+        CHECK(dat.Open(path));
+        CHECK(!dat.Refresh());
+
+        // New file: appended with a new file id table and MFT
+        std::mt19937 rng(6);
+        const uint32_t new_id = 7;
+        const auto new_contents = GwDatFixture::MakeContents(5000, rng);
+        CHECK(!dat.Read(new_id));
+        fixture.dat.Add(new_id, new_contents);
+        fixture.dat.WriteMft();
+        fixture.dat.Save(path);
+        const auto added = dat.Read(new_id);
+        CHECK(added && *added == new_contents);
+        CHECK(dat.Find(new_id));
+
+        // Existing file rewritten elsewhere, its record updated in place; the header and table stay as they were.
+        // The cached copy is dropped too.
+        const uint32_t moved_id = fixture.files.begin()->first;
+        CHECK(dat.Read(moved_id) && *dat.Read(moved_id) == fixture.files[moved_id]);
+        const auto moved_contents = GwDatFixture::MakeContents(8000, rng);
+        fixture.dat.Replace(moved_id, moved_contents);
+        fixture.dat.WriteMft(true);
+        fixture.dat.Save(path);
+        CHECK(!dat.Refresh()); // Nothing Refresh looks at has changed
+        const auto moved = dat.Read(moved_id);
+        CHECK(moved && *moved == moved_contents);
+
+        // Explicit refresh after the MFT moves
+        fixture.dat.Add(8, new_contents, false);
+        fixture.dat.WriteMft();
+        fixture.dat.Save(path);
+        CHECK(dat.Refresh());
+        CHECK(dat.Find(8));
+        CHECK(!dat.Refresh());
+        for (const auto& [file_id, contents] : fixture.files) {
+            const auto blob = dat.Read(file_id);
+            CHECK(blob && *blob == (file_id == moved_id ? moved_contents : contents));
+        }
+        std::filesystem::remove(path);
+    }
+}
+
+int main()
+{
+    TestDecompress();
+    TestCorruptStreams();
+    TestRead();
+    TestReadMany();
+    TestGameWritesDat();
+    return Test::TestResult();
+}
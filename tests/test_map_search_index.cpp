@@ -0,0 +1,258 @@
+// MapSearchIndex over every map name in GWCA's MapID table: each name found by itself, results against a brute force
+// scoring of every name, and the fuzzy cutoff /tp uses letting typos through but not noise.
+
+#include "stdafx.h"
+
+#include <regex>
+
+#include <Utils/MapSearchIndex.h>
+
+#include "check.h"
+
+namespace {
+    struct MapName {
+        uint32_t id;
+        std::string name;
+    };
+
+    // "Kamadan_Jewel_of_Istan_outpost" -> "kamadan jewel of istan outpost", the way names look after SanitiseForSearch
+    std::vector<MapName> LoadMapNames()
+    {
+        std::ifstream file("../Dependencies/GWCA/include/GWCA/Constants/Maps.h");
+        static const std::regex enumerator(R"(^\s*([A-Za-z0-9_]+)\s*(?:=\s*(\d+))?\s*,)");
+        std::vector<MapName> names;
+        std::string line;
+        bool in_enum = false;
+        uint32_t next_id = 0;
+        while (std::getline(file, line)) {
+            if (!in_enum) {
+                in_enum = line.contains("enum class MapID");
+                continue;
+            }
+            if (line.contains("};"))
+                break;
+            std::smatch match;
+            if (!std::regex_search(line, match, enumerator))
+                continue;
+            const uint32_t id = match[2].matched ? static_cast<uint32_t>(std::stoul(match[2])) : next_id;
+            next_id = id + 1;
+            if (match[1] == "None" || match[1] == "Count")
+                continue;
+            std::string name;
+            for (const char c : match[1].str()) {
+                if (c != '_')
+                    name.push_back(static_cast<char>(tolower(c)));
+                else if (!name.empty() && name.back() != ' ')
+                    name.push_back(' ');
+            }
+            while (!name.empty() && name.back() == ' ') {
+                name.pop_back();
+            }
+            names.push_back({id, name});
+        }
+        return names;
+    }
+
+    std::vector<uint32_t> Trigrams(const std::string& str)
+    {
+        const auto padded = " " + str + " ";
+        std::vector<uint32_t> trigrams;
+        for (size_t i = 0; i + 3 <= padded.size(); i++) {
+            trigrams.push_back(static_cast<uint8_t>(padded[i]) << 16 | static_cast<uint8_t>(padded[i + 1]) << 8 | static_cast<uint8_t>(padded[i + 2]));
+        }
+        std::ranges::sort(trigrams);
+        trigrams.erase(std::ranges::unique(trigrams).begin(), trigrams.end());
+        return trigrams;
+    }
+
+    // Every rule in MapSearchIndex applied to one name
+    uint32_t Score(const std::string& name, const std::string& query)
+    {
+        if (query.empty())
+            return 0;
+        uint32_t score = 0;
+        if (name == query)
+            score = MapSearchIndex::SCORE_EXACT;
+        else if (name.starts_with(query))
+            score = MapSearchIndex::SCORE_NAME_PREFIX;
+        std::string initials;
+        for (size_t i = 0; i < name.size(); i++) {
+            if (name[i] == ' ' || !(i == 0 || name[i - 1] == ' '))
+                continue;
+            initials.push_back(name[i]);
+            if (i && std::string_view(name).substr(i).starts_with(query))
+                score = std::max(score, MapSearchIndex::SCORE_WORD_PREFIX);
+        }
+        if (initials.size() > 1 && initials.starts_with(query))
+            score = std::max(score, MapSearchIndex::SCORE_INITIALS_PREFIX);
+        if (query.size() >= 3) {
+            const auto query_trigrams = Trigrams(query);
+            const auto name_trigrams = Trigrams(name);
+            std::vector<uint32_t> shared;
+            std::ranges::set_intersection(query_trigrams, name_trigrams, std::back_inserter(shared));
+            if (shared.size() * 2 >= query_trigrams.size()) {
+                const auto fuzzy = (MapSearchIndex::SCORE_FUZZY_MAX - 1000) * shared.size() / query_trigrams.size() + 1000 - std::min<size_t>(name.size(), 999);
+                score = std::max(score, static_cast<uint32_t>(fuzzy));
+            }
+        }
+        return score;
+    }
+
+    struct Fixture {
+        std::vector<MapName> names;
+        MapSearchIndex index;
+        std::map<std::string, std::set<uint32_t>> ids_by_name;
+    };
+
+    const Fixture& GetFixture()
+    {
+        static const Fixture fixture = [] {
+            Fixture f;
+            f.names = LoadMapNames();
+            for (const auto& [id, name] : f.names) {
+                f.index.Add(id, name);
+                f.ids_by_name[name].insert(id);
+            }
+            f.index.Build();
+            return f;
+        }();
+        return fixture;
+    }
+
+    void TestEveryName()
+    {
+        const auto& f = GetFixture();
+        CHECK(f.names.size() > 600);
+        CHECK(f.ids_by_name.contains("kamadan jewel of istan outpost"));
+        for (const auto& [id, name] : f.names) {
+            const auto best = f.index.Best(name);
+            CHECK_EQ(best.score, MapSearchIndex::SCORE_EXACT);
+            CHECK(f.ids_by_name.at(name).contains(best.id));
+        }
+    }
+
+    // A name, cut short, with a letter changed, or noise
+    std::string RandomQuery(const std::vector<MapName>& names, std::mt19937& rng)
+    {
+        auto query = names[rng() % names.size()].name;
+        switch (rng() % 6) {
+            case 0:
+                return query.substr(0, 1 + rng() % query.size());
+            case 1: {
+                const auto space = query.find(' ', rng() % query.size());
+                return space == std::string::npos ? query : query.substr(space + 1, 1 + rng() % 12);
+            }
+            case 2: {
+                std::string initials;
+                for (size_t i = 0; i < query.size(); i++) {
+                    if (query[i] != ' ' && (i == 0 || query[i - 1] == ' '))
+                        initials.push_back(query[i]);
+                }
+                return initials.substr(0, 1 + rng() % initials.size());
+            }
+            case 3:
+                query.erase(rng() % query.size(), 1);
+                return query;
+            case 4:
+                query[rng() % query.size()] = static_cast<char>('a' + rng() % 26);
+                return query;
+            default:
+                query.clear();
+                for (size_t i = 3 + rng() % 10; i-- > 0;) {
+                    query.push_back(rng() % 6 == 0 && !query.empty() ? ' ' : static_cast<char>('a' + rng() % 26));
+                }
+                return query;
+        }
+    }
+
+    void TestAgainstBruteForce()
+    {
+        const auto& f = GetFixture();
+        // Names in the order the index breaks ties: alphabetical, then in the order added
+        std::vector<size_t> order(f.names.size());
+        std::iota(order.begin(), order.end(), size_t{0});
+        std::ranges::stable_sort(order, {}, [&f](const size_t i) -> const std::string& {
+            return f.names[i].name;
+        });
+
+        std::mt19937 rng(1);
+        std::array<MapSearchIndex::Result, 8> results;
+        for (uint32_t i = 0; i < 2000; i++) {
+            const auto query = RandomQuery(f.names, rng);
+            std::vector<MapSearchIndex::Result> expected;
+            for (const auto n : order) {
+                if (const auto score = Score(f.names[n].name, query))
+                    expected.push_back({f.names[n].id, score});
+            }
+            std::ranges::stable_sort(expected, std::greater{}, &MapSearchIndex::Result::score);
+            expected.resize(std::min(expected.size(), results.size()));
+
+            const auto count = f.index.Search(query, results);
+            CHECK_EQ(count, expected.size());
+            for (size_t j = 0; j < std::min(count, expected.size()); j++) {
+                CHECK(results[j].id == expected[j].id && results[j].score == expected[j].score);
+            }
+        }
+        CHECK_EQ(f.index.Search("", results), 0u);
+        CHECK_EQ(f.index.Best("").score, 0u);
+    }
+
+    void TestConfidentFuzzyMatches()
+    {
+        const auto& f = GetFixture();
+        const auto confident = [&f](const std::string& query) {
+            const auto best = f.index.Best(query);
+            return best.score >= MapSearchIndex::SCORE_FUZZY_CONFIDENT ? best : MapSearchIndex::Result{};
+        };
+
+        // One letter dropped, changed or swapped in a longer name usually still goes where it was meant to
+        std::mt19937 rng(2);
+        size_t typos = 0;
+        size_t resolved = 0;
+        for (const auto& [id, name] : f.names) {
+            if (name.size() < 8)
+                continue;
+            auto query = name;
+            const size_t pos = rng() % (query.size() - 1);
+            switch (rng() % 3) {
+                case 0:
+                    query.erase(pos, 1);
+                    break;
+                case 1:
+                    query[pos] = query[pos] == 'x' ? 'q' : 'x';
+                    break;
+                default:
+                    std::swap(query[pos], query[pos + 1]);
+                    break;
+            }
+            if (query == name)
+                continue;
+            typos++;
+            const auto best = confident(query);
+            resolved += best.score && f.ids_by_name.at(name).contains(best.id);
+        }
+        CHECK(resolved * 10 >= typos * 9);
+        CHECK(f.ids_by_name.at("kamadan jewel of istan outpost").contains(confident("kamadan jewel of istan outpots").id));
+
+        // Noise never does. Short strings can be legitimately close to part of a name ("nyon"), so only longer ones.
+        for (uint32_t i = 0; i < 5000; i++) {
+            std::string query;
+            for (size_t n = 6 + rng() % 9; n-- > 0;) {
+                query.push_back(static_cast<char>('a' + rng() % 26));
+            }
+            if (f.index.Best(query).score < MapSearchIndex::SCORE_INITIALS_PREFIX) {
+                CHECK(!confident(query).score);
+            }
+        }
+        CHECK(!confident("xyz city").score);
+        CHECK(!confident("hello world").score);
+    }
+}
+
+int main()
+{
+    TestEveryName();
+    TestAgainstBruteForce();
+    TestConfidentFuzzyMatches();
+    return Test::TestResult();
+}
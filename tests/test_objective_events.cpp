@@ -0,0 +1,283 @@
+// Replays event sequences through the objective dispatch table and through the linear scan it replaced (every
+// objective visited for every event), and checks both give the same split times.
+
+#include "stdafx.h"
+
+#include <Utils/ObjectiveEvents.h>
+
+#include "check.h"
+
+namespace {
+    using ObjectiveEvents::Event;
+    using ObjectiveEvents::EventType;
+
+    constexpr uint32_t TIME_UNKNOWN = std::numeric_limits<uint32_t>::max();
+
+    // Just enough of ObjectiveTimerWindow::Objective for ObjectiveEvents::Apply; times are the replay step
+    struct Objective {
+        std::vector<Event> start_events;
+        std::vector<Event> end_events;
+        int starting_completes_n_previous_objectives = 0;
+        uint32_t start = TIME_UNKNOWN;
+        uint32_t done = TIME_UNKNOWN;
+        const uint32_t* clock = nullptr;
+
+        [[nodiscard]] bool IsStarted() const { return IsDone() || start != TIME_UNKNOWN; }
+        [[nodiscard]] bool IsDone() const { return done != TIME_UNKNOWN; }
+
+        Objective* SetStarted()
+        {
+            if (!IsStarted()) {
+                start = *clock;
+            }
+            return this;
+        }
+
+        Objective* SetDone()
+        {
+            if (!IsDone()) {
+                done = *clock;
+            }
+            return this;
+        }
+    };
+
+    struct ObjectiveSet {
+        std::vector<Objective*> objectives;
+        std::vector<std::unique_ptr<Objective>> storage;
+        uint32_t clock = 0;
+        ObjectiveEvents::DispatchTable dispatch_table;
+        std::vector<uint32_t> candidates;
+
+        Objective& Add(const int completes_previous = 0)
+        {
+            storage.push_back(std::make_unique<Objective>());
+            storage.back()->starting_completes_n_previous_objectives = completes_previous;
+            storage.back()->clock = &clock;
+            objectives.push_back(storage.back().get());
+            return *objectives.back();
+        }
+
+        void BuildDispatchTable()
+        {
+            dispatch_table.Clear();
+            for (uint32_t i = 0; i < objectives.size(); i++) {
+                for (const auto* events : {&objectives[i]->start_events, &objectives[i]->end_events}) {
+                    for (const auto& event : *events) {
+                        dispatch_table.Add(i, event);
+                    }
+                }
+            }
+        }
+
+        bool Event(const bool use_table, const EventType type, const uint32_t id1, const uintptr_t id2)
+        {
+            if (use_table) {
+                dispatch_table.Candidates(type, id1, id2, candidates);
+            }
+            else {
+                candidates.resize(objectives.size());
+                std::iota(candidates.begin(), candidates.end(), 0u);
+            }
+            return ObjectiveEvents::Apply<Objective>(objectives, candidates, type, id1, id2);
+        }
+    };
+
+    // An event as it arrives from a packet; messages point into `text`
+    struct RecordedEvent {
+        EventType type;
+        uint32_t id1 = 0;
+        uint32_t id2 = 0;
+        std::wstring text;
+    };
+
+    uintptr_t Msg(const wchar_t* msg)
+    {
+        return reinterpret_cast<uintptr_t>(msg);
+    }
+
+    // Objective sets like the ones ObjectiveTimerWindow builds: door driven zones, wildcard server messages, dialogues
+    // that share their first characters, and objectives that complete all the previous ones.
+    void BuildUrgoz(ObjectiveSet& os)
+    {
+        os.Add().SetStarted();
+        for (const uint32_t door : {45420u, 11692u, 54552u, 1760u, 40330u, 60114u, 37191u, 35500u, 34278u}) {
+            os.Add(-1).start_events.push_back({EventType::DoorOpen, door});
+        }
+        auto& urgoz = os.Add(-1);
+        urgoz.start_events = {{EventType::DoorOpen, 15529}, {EventType::DoorOpen, 45631}, {EventType::DoorOpen, 53071}};
+        urgoz.end_events = {
+            {EventType::ServerMessage, 6, Msg(L"\x6C9C\x0\x0\x0\x0\x2810")},
+            {EventType::ServerMessage, 6, Msg(L"\x6C9C\x0\x0\x0\x0\x1488")}
+        };
+    }
+
+    void BuildDoA(ObjectiveSet& os)
+    {
+        enum : uint32_t { Foundry = 0x273F, Veil, Gloom, City };
+        auto& foundry = os.Add();
+        foundry.start_events = {{EventType::DoACompleteZone, Gloom}, {EventType::DoorOpen, 1001}};
+        foundry.end_events = {{EventType::DoACompleteZone, Foundry}};
+        for (uint32_t door = 1001; door < 1005; door++) {
+            auto& room = os.Add(1);
+            room.start_events = {{EventType::DoorClose, door}};
+            room.end_events = {{EventType::DoorOpen, door + 1}};
+        }
+        auto& fury = os.Add(1);
+        fury.start_events = {{EventType::DisplayDialogue, 4, Msg(L"\x8101\x273D\x98DB\xB91A")}};
+        fury.end_events = {{EventType::DoACompleteZone, Foundry}, {EventType::AgentUpdateAllegiance, 5221, 0x6E6F6E63}};
+        auto& veil = os.Add();
+        veil.start_events = {{EventType::DoACompleteZone, City}};
+        veil.end_events = {{EventType::DoACompleteZone, Veil}};
+        auto& veil_1 = os.Add(1);
+        veil_1.start_events = {{EventType::DisplayDialogue, 4, Msg(L"\x8101\x34C1\x9FA1\xED8F\x1BE4")}};
+        veil_1.end_events = {{EventType::DisplayDialogue, 1, Msg(L"\x8102")}};
+        auto& gloom = os.Add(-1);
+        gloom.start_events = {{EventType::DisplayDialogue, 4, Msg(L"\x8101\x5765\x9846\xA72B")}};
+        gloom.end_events = {{EventType::DisplayDialogue, 4, Msg(L"\x8101\x5767\xA547\xB2C2")}, {EventType::DoACompleteZone, Gloom}};
+        auto& any_dialogue = os.Add();
+        any_dialogue.start_events = {{EventType::DisplayDialogue, 3, Msg(L"\x0\x5765\x0")}};
+        any_dialogue.end_events = {{EventType::DisplayDialogue, 0, Msg(L"")}};
+    }
+
+    void BuildDungeon(ObjectiveSet& os)
+    {
+        for (uint32_t level = 0; level < 5; level++) {
+            os.Add(-1).start_events.push_back({EventType::InstanceLoadInfo, 700 + level});
+        }
+        os.objectives.front()->SetStarted();
+        os.objectives.back()->end_events.push_back({EventType::DungeonReward});
+        os.Add().end_events.push_back({EventType::ObjectiveDone, 42});
+        os.objectives.back()->start_events.push_back({EventType::ObjectiveStarted, 42});
+    }
+
+    using Builder = void (*)(ObjectiveSet&);
+
+    // The events each set listens for, plus lookalikes and noise: other doors and ids, messages sharing the first one
+    // or two characters, zero ids (which match anything) and short/empty messages.
+    std::vector<RecordedEvent> Record(const ObjectiveSet& os, std::mt19937& rng, const size_t noise)
+    {
+        std::vector<RecordedEvent> events;
+        const auto add_pattern = [&](const Event& pattern) {
+            RecordedEvent event{pattern.type, pattern.id1, static_cast<uint32_t>(pattern.id2), {}};
+            if (ObjectiveEvents::IsMessageEvent(pattern.type)) {
+                const auto msg = reinterpret_cast<const wchar_t*>(pattern.id2);
+                event.text.assign(msg, msg + pattern.id1);
+                for (auto& c : event.text) {
+                    if (!c) {
+                        c = static_cast<wchar_t>(0x100 + rng() % 0x100); // fill wildcards
+                    }
+                }
+                event.id1 = static_cast<uint32_t>(event.text.size());
+                event.id2 = 0;
+            }
+            events.push_back(event);
+        };
+        for (const auto* obj : os.objectives) {
+            for (const auto& e : obj->start_events) {
+                add_pattern(e);
+            }
+            for (const auto& e : obj->end_events) {
+                add_pattern(e);
+            }
+        }
+        const auto patterns = events;
+        for (size_t i = 0; i < noise; i++) {
+            auto event = patterns[rng() % patterns.size()];
+            switch (rng() % 6) {
+                case 0:
+                    event.id1 = rng() % 4 ? event.id1 + 1 + rng() % 3 : 0;
+                    break;
+                case 1:
+                    event.id2 = rng() % 2 ? 0 : static_cast<uint32_t>(rng());
+                    break;
+                case 2:
+                    event.type = static_cast<EventType>(rng() % static_cast<uint32_t>(EventType::Count));
+                    break;
+                case 3:
+                    if (!event.text.empty()) {
+                        event.text[rng() % event.text.size()] = static_cast<wchar_t>(0x8100 + rng() % 4);
+                    }
+                    break;
+                case 4:
+                    if (!event.text.empty()) {
+                        event.text.resize(rng() % event.text.size());
+                        event.id1 = static_cast<uint32_t>(event.text.size());
+                    }
+                    break;
+                default:
+                    break;
+            }
+            if (ObjectiveEvents::IsMessageEvent(event.type) && event.text.empty() && rng() % 2) {
+                event.text = L"\x8101";
+                event.id1 = 1;
+            }
+            if (ObjectiveEvents::IsMessageEvent(event.type)) {
+                event.id1 = std::min(event.id1, static_cast<uint32_t>(event.text.size())); // never read past the message
+            }
+            events.push_back(event);
+        }
+        std::ranges::shuffle(events, rng);
+        return events;
+    }
+
+    void Replay(const Builder build, const uint32_t seed, const size_t noise)
+    {
+        std::mt19937 rng(seed);
+        ObjectiveSet linear;
+        ObjectiveSet table;
+        build(linear);
+        build(table);
+        table.BuildDispatchTable();
+        const auto events = Record(linear, rng, noise);
+
+        for (const auto& event : events) {
+            linear.clock++;
+            table.clock++;
+            const uintptr_t id2 = ObjectiveEvents::IsMessageEvent(event.type) ? Msg(event.text.c_str()) : event.id2;
+            const bool linear_done = linear.Event(false, event.type, event.id1, id2);
+            const bool table_done = table.Event(true, event.type, event.id1, id2);
+            CHECK_EQ(linear_done, table_done);
+        }
+        for (size_t i = 0; i < linear.objectives.size(); i++) {
+            CHECK_EQ(linear.objectives[i]->start, table.objectives[i]->start);
+            CHECK_EQ(linear.objectives[i]->done, table.objectives[i]->done);
+        }
+    }
+
+    void TestCandidatesCoverMatches()
+    {
+        ObjectiveSet os;
+        BuildDoA(os);
+        os.BuildDispatchTable();
+        std::vector<uint32_t> candidates;
+        const std::wstring dialogue = L"\x8101\x5765\x9846\xA72B";
+        os.dispatch_table.Candidates(EventType::DisplayDialogue, 4, Msg(dialogue.c_str()), candidates);
+        // gloom by its first two characters, any_dialogue as its first character is a wildcard
+        CHECK_EQ(candidates, (std::vector<uint32_t>{8, 9}));
+        os.dispatch_table.Candidates(EventType::DisplayDialogue, 1, Msg(L"\x8102"), candidates);
+        CHECK(std::ranges::find(candidates, 7u) != candidates.end());
+        os.dispatch_table.Candidates(EventType::DoorOpen, 0, 0, candidates);
+        CHECK(candidates.size() > 1); // a zero id matches every door
+        os.dispatch_table.Candidates(EventType::DoorOpen, 999999, 0, candidates);
+        CHECK(candidates.empty());
+        os.dispatch_table.Candidates(EventType::ServerMessage, 4, 0, candidates);
+        CHECK(candidates.empty());
+    }
+
+    void TestReplays()
+    {
+        for (const Builder build : {&BuildUrgoz, &BuildDoA, &BuildDungeon}) {
+            for (uint32_t seed = 1; seed <= 200; seed++) {
+                Replay(build, seed, seed % 4 == 0 ? 0 : 50);
+            }
+        }
+    }
+}
+
+int main()
+{
+    TestCandidatesCoverMatches();
+    TestReplays();
+    return Test::TestResult();
+}
@@ -0,0 +1,171 @@
+// PatternScanner's per-build cache: addresses are reused for the same build of the module, checked before use so a
+// stale entry is rescanned, and dropped entirely for another build.
+
+#include "stdafx.h"
+
+#include <PatternScanner.h>
+
+#include <nlohmann/json.hpp>
+
+#include "check.h"
+#include "pattern_scan_fixture.h"
+
+namespace {
+    using PatternScanFixture::Pattern;
+
+    const auto cache_path = std::filesystem::temp_directory_path() / "gwtoolbox_test_pattern_cache.json";
+
+    nlohmann::json ReadCache()
+    {
+        std::ifstream file(cache_path);
+        return nlohmann::json::parse(file, nullptr, false);
+    }
+
+    // Resolves patterns through a fresh scanner with the cache file loaded, then saves it
+    std::vector<ScanPattern> Resolve(const std::vector<uint8_t>& image, const std::vector<Pattern>& patterns, bool* loaded = nullptr)
+    {
+        PatternScanner scanner(image);
+        const bool cache_loaded = scanner.LoadCache(cache_path);
+        if (loaded) {
+            *loaded = cache_loaded;
+        }
+        auto scan = PatternScanFixture::ScanPatterns(patterns);
+        CHECK(scanner.FindPatternsRva(scan));
+        CHECK(scanner.SaveCache());
+        return scan;
+    }
+
+    // Patterns cut from the image, with their first match as the linear scan finds it
+    std::vector<Pattern> FoundPatterns(const std::vector<uint8_t>& image, const uint32_t seed)
+    {
+        std::vector<Pattern> patterns;
+        for (auto& pattern : PatternScanFixture::MakePatterns(image, 40, seed)) {
+            uintptr_t rva;
+            if (PatternScanFixture::LinearFind(image, pattern, &rva)) {
+                patterns.push_back(std::move(pattern));
+            }
+        }
+        return patterns;
+    }
+
+    void CheckRvas(const std::vector<uint8_t>& image, const std::vector<Pattern>& patterns, const std::vector<ScanPattern>& scan)
+    {
+        for (size_t i = 0; i < patterns.size(); i++) {
+            uintptr_t expected = 0;
+            CHECK(PatternScanFixture::LinearFind(image, patterns[i], &expected));
+            CHECK(scan[i].found);
+            CHECK_EQ(scan[i].rva, expected);
+        }
+    }
+
+    void TestReuse()
+    {
+        std::filesystem::remove(cache_path);
+        const auto image = PatternScanFixture::MakeImage(64 * 1024, 1);
+        const auto patterns = FoundPatterns(image, 1);
+        bool loaded = true;
+        CheckRvas(image, patterns, Resolve(image, patterns, &loaded));
+        CHECK(!loaded);
+        const auto saved = ReadCache();
+        CHECK_EQ(saved["module"].get<std::string>(), PatternScanner(image).GetModuleId());
+        CHECK(saved["entries"].size() <= patterns.size()); // duplicates share a key
+
+        // Everything comes from the cache, so nothing is written back
+        const auto written = std::filesystem::last_write_time(cache_path) - std::chrono::hours(1);
+        std::filesystem::last_write_time(cache_path, written);
+        CheckRvas(image, patterns, Resolve(image, patterns, &loaded));
+        CHECK(loaded);
+        CHECK(std::filesystem::last_write_time(cache_path) == written);
+    }
+
+    void TestShiftedBytes()
+    {
+        // Same headers, so the same module id, but the code after them moved by a few bytes: every cached address is
+        // stale and has to be found again, and the cache updated
+        std::filesystem::remove(cache_path);
+        const auto image = PatternScanFixture::MakeImage(64 * 1024, 2);
+        const auto patterns = FoundPatterns(image, 2);
+        Resolve(image, patterns);
+
+        auto shifted = image;
+        shifted.insert(shifted.begin() + 0x200, {0x90, 0x90, 0x90});
+        shifted.resize(image.size());
+        std::vector<Pattern> still_there;
+        for (const auto& pattern : patterns) {
+            uintptr_t rva;
+            if (PatternScanFixture::LinearFind(shifted, pattern, &rva)) {
+                still_there.push_back(pattern);
+            }
+        }
+        CHECK(still_there.size() > patterns.size() / 2);
+        bool loaded = false;
+        const auto scan = Resolve(shifted, still_there, &loaded);
+        CHECK(loaded);
+        CheckRvas(shifted, still_there, scan);
+
+        // The new addresses were saved: a third run finds them all in the cache and has nothing to write
+        const auto written = std::filesystem::last_write_time(cache_path) - std::chrono::hours(1);
+        std::filesystem::last_write_time(cache_path, written);
+        CheckRvas(shifted, still_there, Resolve(shifted, still_there));
+        CHECK(std::filesystem::last_write_time(cache_path) == written);
+    }
+
+    void TestCachedAddressStillMatching()
+    {
+        // A pattern that now also occurs earlier keeps its cached address; it still matches there, which is all
+        // the cache promises
+        std::filesystem::remove(cache_path);
+        auto image = PatternScanFixture::MakeImage(64 * 1024, 3);
+        const Pattern pattern = {std::string("\x12\x34\x56\x78\x9A\xBC\xDE\xF0", 8), "xxxxxxxx", 0};
+        std::copy_n(pattern.bytes.begin(), 8, image.begin() + 0x8000);
+        CHECK_EQ(Resolve(image, {pattern})[0].rva, 0x8000u);
+        std::copy_n(pattern.bytes.begin(), 8, image.begin() + 0x1000);
+        CHECK_EQ(Resolve(image, {pattern})[0].rva, 0x8000u);
+        // Once it stops matching there, the first match is found again
+        image[0x8000] = 0;
+        CHECK_EQ(Resolve(image, {pattern})[0].rva, 0x1000u);
+    }
+
+    void TestOtherBuild()
+    {
+        std::filesystem::remove(cache_path);
+        const auto image = PatternScanFixture::MakeImage(64 * 1024, 4);
+        const auto patterns = FoundPatterns(image, 4);
+        Resolve(image, patterns);
+
+        // A new build of the game: entries are dropped, not checked
+        const auto update = PatternScanFixture::MakeImage(64 * 1024, 5, {0x60000000, 0x00AA0000});
+        const auto new_patterns = FoundPatterns(update, 5);
+        bool loaded = true;
+        CheckRvas(update, new_patterns, Resolve(update, new_patterns, &loaded));
+        CHECK(!loaded);
+        const auto saved = ReadCache();
+        CHECK_EQ(saved["module"].get<std::string>(), PatternScanner(update).GetModuleId());
+        CHECK(saved["entries"].size() <= new_patterns.size());
+    }
+
+    void TestMalformedCache()
+    {
+        {
+            std::ofstream file(cache_path, std::ios::trunc);
+            file << "{\"module\": 12, \"entries\": [";
+        }
+        const auto image = PatternScanFixture::MakeImage(64 * 1024, 6);
+        const auto patterns = FoundPatterns(image, 6);
+        bool loaded = true;
+        CheckRvas(image, patterns, Resolve(image, patterns, &loaded));
+        CHECK(!loaded);
+        CHECK(ReadCache().is_object());
+        std::filesystem::remove(cache_path);
+    }
+}
+
+int main()
+{
+    TestReuse();
+    TestShiftedBytes();
+    TestCachedAddressStillMatching();
+    TestOtherBuild();
+    TestMalformedCache();
+    return Test::TestResult();
+}
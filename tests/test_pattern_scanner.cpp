@@ -0,0 +1,89 @@
+// PatternScanner against the linear scan it replaced: every pattern resolves to the same (lowest) address, or to
+// nothing in both.
+
+#include "stdafx.h"
+
+#include <PatternScanner.h>
+
+#include "check.h"
+#include "pattern_scan_fixture.h"
+
+namespace {
+    using PatternScanFixture::Pattern;
+
+    void CheckAgainstLinear(const std::vector<uint8_t>& image, const std::vector<Pattern>& patterns)
+    {
+        PatternScanner scanner(image);
+        auto scan = PatternScanFixture::ScanPatterns(patterns);
+        bool all_expected = true;
+        const bool all_found = scanner.FindPatternsRva(scan);
+        for (size_t i = 0; i < patterns.size(); i++) {
+            uintptr_t expected_rva = 0;
+            const bool expected = PatternScanFixture::LinearFind(image, patterns[i], &expected_rva);
+            all_expected &= expected;
+            CHECK_EQ(scan[i].found, expected);
+            if (expected) {
+                CHECK_EQ(scan[i].rva, expected_rva);
+            }
+        }
+        CHECK_EQ(all_found, all_expected);
+    }
+
+    void TestRandomImages()
+    {
+        for (uint32_t seed = 1; seed <= 20; seed++) {
+            const auto image = PatternScanFixture::MakeImage(256 * 1024, seed);
+            CheckAgainstLinear(image, PatternScanFixture::MakePatterns(image, 50, seed));
+        }
+    }
+
+    void TestEdges()
+    {
+        auto image = PatternScanFixture::MakeImage(4096, 7);
+        image[4094] = 0xAB;
+        image[4095] = 0xCD;
+        std::vector<Pattern> patterns = {
+            {"\xAB\xCD", "xx", 0},                                         // last bytes of the image
+            {"\xAB\xCD\xEF", "xxx", 0},                                    // would run past the end
+            {std::string(8, '\0'), "????????", 5},                         // nothing fixed
+            {std::string(reinterpret_cast<char*>(image.data()), 16), "xxxxxxxxxxxxxxxx", 0}, // the headers
+            {std::string(5000, '\xCC'), std::string(5000, 'x'), 0},       // longer than the image
+        };
+        CheckAgainstLinear(image, patterns);
+
+        PatternScanner scanner(image);
+        auto scan = PatternScanFixture::ScanPatterns(patterns);
+        scanner.FindPatternsRva(scan);
+        CHECK(scan[0].found && scan[0].rva == 4094);
+        CHECK(!scan[1].found);
+        CHECK(scan[2].found && scan[2].rva == 5);
+        CHECK(scan[3].found && scan[3].rva == 0);
+        CHECK(!scan[4].found);
+
+        // An empty image matches nothing with a fixed byte
+        PatternScanner empty;
+        std::vector<ScanPattern> one = {patterns[0].Scan()};
+        CHECK(!empty.FindPatternsRva(one));
+        CHECK(empty.GetModuleId().empty());
+    }
+
+    void TestModuleId()
+    {
+        const auto image = PatternScanFixture::MakeImage(8192, 3, {0x11223344, 0x55667788});
+        CHECK_EQ(PatternScanner(image).GetModuleId(), std::string("11223344-00002000-55667788"));
+        auto no_headers = image;
+        no_headers[0] = 0;
+        CHECK(PatternScanner(no_headers).GetModuleId().empty());
+        auto bad_lfanew = image;
+        PatternScanFixture::WriteAt<int32_t>(bad_lfanew, 0x3C, 8000);
+        CHECK(PatternScanner(bad_lfanew).GetModuleId().empty());
+    }
+}
+
+int main()
+{
+    TestRandomImages();
+    TestEdges();
+    TestModuleId();
+    return Test::TestResult();
+}
@@ -0,0 +1,204 @@
+#include "stdafx.h"
+
+#include <Utils/PmapMesh.h>
+
+#include "check.h"
+#include "pmap_fixture.h"
+
+namespace {
+    using PmapMesh::Trapezoid;
+
+    Trapezoid Rect(const float x0, const float x1, const float y0, const float y1, const uint32_t plane = 0)
+    {
+        return {x0, x1, y1, x0, x1, y0, plane};
+    }
+
+    float Length(const PmapMesh::Mesh& mesh, const size_t i)
+    {
+        const auto& a = mesh.vertices[mesh.indices[i]];
+        const auto& b = mesh.vertices[mesh.indices[i + 1]];
+        return std::hypot(b.x - a.x, b.y - a.y);
+    }
+
+    float OutlineLength(const PmapMesh::Mesh& mesh)
+    {
+        float length = 0.f;
+        for (size_t i = 0; i < mesh.indices.size(); i += 2) {
+            length += Length(mesh, i);
+        }
+        return length;
+    }
+
+    double FilledArea(const PmapMesh::Mesh& mesh)
+    {
+        double area = 0.0;
+        for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+            const auto& a = mesh.vertices[mesh.indices[i]];
+            const auto& b = mesh.vertices[mesh.indices[i + 1]];
+            const auto& c = mesh.vertices[mesh.indices[i + 2]];
+            area += std::abs((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y)) / 2.0;
+        }
+        return area;
+    }
+
+    double TrapezoidArea(const std::vector<Trapezoid>& trapezoids)
+    {
+        double area = 0.0;
+        for (const auto& t : trapezoids) {
+            area += (std::abs(t.XTR - t.XTL) + std::abs(t.XBR - t.XBL)) / 2.0 * std::abs(t.YT - t.YB);
+        }
+        return area;
+    }
+
+    // Corners lying strictly inside another trapezoid's edge on the same plane
+    size_t CountTJunctions(const std::vector<Trapezoid>& trapezoids)
+    {
+        struct Point {
+            float x, y;
+        };
+        size_t count = 0;
+        for (const auto& edge_owner : trapezoids) {
+            const Point corners[] = {{edge_owner.XTL, edge_owner.YT}, {edge_owner.XTR, edge_owner.YT},
+                                     {edge_owner.XBR, edge_owner.YB}, {edge_owner.XBL, edge_owner.YB}};
+            for (size_t e = 0; e < 4; e++) {
+                const auto& a = corners[e];
+                const auto& b = corners[(e + 1) % 4];
+                const float length = std::hypot(b.x - a.x, b.y - a.y);
+                if (length == 0.f) {
+                    continue;
+                }
+                for (const auto& t : trapezoids) {
+                    if (t.plane != edge_owner.plane) {
+                        continue;
+                    }
+                    for (const Point p : {Point{t.XTL, t.YT}, Point{t.XTR, t.YT}, Point{t.XBL, t.YB}, Point{t.XBR, t.YB}}) {
+                        const float along = ((p.x - a.x) * (b.x - a.x) + (p.y - a.y) * (b.y - a.y)) / length;
+                        const float off = std::abs((p.x - a.x) * (b.y - a.y) - (p.y - a.y) * (b.x - a.x)) / length;
+                        if (off < 0.01f && along > 0.01f && along < length - 0.01f) {
+                            count++;
+                        }
+                    }
+                }
+            }
+        }
+        return count;
+    }
+
+    void TestSplitNeighbourIsNotAWall()
+    {
+        // One square on the left, the right column split halfway up: x = 10 is interior all the way
+        const std::vector trapezoids = {Rect(0, 10, 0, 10), Rect(10, 20, 0, 5), Rect(10, 20, 5, 10)};
+        const auto mesh = PmapMesh::Build(trapezoids, true);
+        CHECK(mesh.lines);
+        CHECK(std::abs(OutlineLength(mesh) - 60.f) < 1e-3f);
+        for (size_t i = 0; i < mesh.indices.size(); i += 2) {
+            const auto& a = mesh.vertices[mesh.indices[i]];
+            const auto& b = mesh.vertices[mesh.indices[i + 1]];
+            CHECK(!(a.x == 10.f && b.x == 10.f));
+        }
+    }
+
+    void TestPartlySharedSide()
+    {
+        // The right neighbour only covers the middle of the left square's side
+        const std::vector trapezoids = {Rect(0, 10, 0, 10), Rect(10, 20, 2, 7)};
+        const auto mesh = PmapMesh::Build(trapezoids, true);
+        // 40 for the square minus the 5 shared, plus 10 + 10 + 5 for the neighbour
+        CHECK(std::abs(OutlineLength(mesh) - 60.f) < 1e-3f);
+    }
+
+    void TestPlanesDontShareWalls()
+    {
+        const std::vector trapezoids = {Rect(0, 10, 0, 10, 0), Rect(10, 20, 0, 10, 1)};
+        CHECK(std::abs(OutlineLength(PmapMesh::Build(trapezoids, true)) - 80.f) < 1e-3f);
+    }
+
+    void TestMergeAvoidsTJunctions()
+    {
+        // Stacked squares whose right neighbour spans both: merged into one
+        std::vector trapezoids = {Rect(0, 10, 5, 10), Rect(0, 10, 0, 5), Rect(10, 20, 0, 10)};
+        PmapMesh::Simplify(trapezoids);
+        CHECK_EQ(trapezoids.size(), 2u);
+        // The right neighbour is split at the same height, so merging the left pair would leave its corner on the side
+        trapezoids = {Rect(0, 10, 5, 10), Rect(0, 10, 0, 5), Rect(10, 20, 0, 5), Rect(10, 20, 5, 10)};
+        PmapMesh::Simplify(trapezoids);
+        CHECK_EQ(trapezoids.size(), 4u);
+    }
+
+    void TestSyntheticMaps()
+    {
+        for (uint32_t seed = 1; seed <= 20; seed++) {
+            const auto grid = PmapFixture::MakeGrid(24, 24, seed);
+            auto trapezoids = PmapFixture::MakeTrapezoids(grid, seed);
+
+            // Wall length is the number of cell edges between walkable and blocked cells
+            size_t horizontal_edges = 0;
+            size_t vertical_edges = 0;
+            for (int y = 0; y <= static_cast<int>(grid.height); y++) {
+                for (int x = 0; x <= static_cast<int>(grid.width); x++) {
+                    horizontal_edges += grid.Walkable(x, y) != grid.Walkable(x, y - 1);
+                    vertical_edges += grid.Walkable(x, y) != grid.Walkable(x - 1, y);
+                }
+            }
+            const float expected = grid.cell * (static_cast<float>(horizontal_edges)
+                                                + static_cast<float>(vertical_edges) * std::hypot(1.f, grid.shear));
+            const auto outline = PmapMesh::Build(trapezoids, true);
+            CHECK(std::abs(OutlineLength(outline) - expected) < expected * 1e-4f);
+
+            // Every wall runs along a cell edge with walkable ground on one side only
+            for (size_t i = 0; i < outline.indices.size(); i += 2) {
+                const auto& a = outline.vertices[outline.indices[i]];
+                const auto& b = outline.vertices[outline.indices[i + 1]];
+                const float my = (a.y + b.y) / 2 / grid.cell;
+                const float mx = ((a.x + b.x) / 2 - grid.shear * (a.y + b.y) / 2) / grid.cell;
+                const int cx = static_cast<int>(std::floor(mx));
+                const int cy = static_cast<int>(std::floor(my));
+                if (a.y == b.y) {
+                    const int edge_y = static_cast<int>(std::lround(my));
+                    CHECK(grid.Walkable(cx, edge_y) != grid.Walkable(cx, edge_y - 1));
+                }
+                else {
+                    const int edge_x = static_cast<int>(std::lround(mx));
+                    CHECK(grid.Walkable(edge_x, cy) != grid.Walkable(edge_x - 1, cy));
+                }
+            }
+
+            const double area = TrapezoidArea(trapezoids);
+            const auto filled = PmapMesh::Build(trapezoids, false);
+            CHECK(filled.merged_trapezoids <= filled.source_trapezoids);
+            CHECK(std::abs(FilledArea(filled) - area) < area * 1e-5);
+
+            const size_t t_junctions = CountTJunctions(trapezoids);
+            auto simplified = trapezoids;
+            PmapMesh::Simplify(simplified);
+            CHECK(simplified.size() < trapezoids.size());
+            CHECK(CountTJunctions(simplified) <= t_junctions);
+            CHECK(std::abs(TrapezoidArea(simplified) - area) < area * 1e-5);
+        }
+    }
+
+    void TestDumpRoundTrip()
+    {
+        const auto trapezoids = PmapFixture::MakeTrapezoids(PmapFixture::MakeGrid(16, 16, 7), 7);
+        const auto path = std::filesystem::temp_directory_path() / "gwtoolbox_test.pmap";
+        CHECK(PmapMesh::WriteTrapezoids(path, trapezoids));
+        std::vector<Trapezoid> read;
+        CHECK(PmapMesh::ReadTrapezoids(path, read));
+        CHECK_EQ(read.size(), trapezoids.size());
+        CHECK(memcmp(read.data(), trapezoids.data(), read.size() * sizeof(Trapezoid)) == 0);
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+        CHECK(!PmapMesh::ReadTrapezoids(path, read));
+        std::filesystem::remove(path);
+    }
+}
+
+int main()
+{
+    TestSplitNeighbourIsNotAWall();
+    TestPartlySharedSide();
+    TestPlanesDontShareWalls();
+    TestMergeAvoidsTJunctions();
+    TestSyntheticMaps();
+    TestDumpRoundTrip();
+    return Test::TestResult();
+}
@@ -0,0 +1,97 @@
+// PriceIndex on the sample trader_quotes payload and on malformed ones: every sell quote found by model id, or by model
+// id and each word of its mod struct, and nothing else.
+
+#include "stdafx.h"
+
+#include <nlohmann/json.hpp>
+
+#include <Utils/PriceIndex.h>
+
+#include "check.h"
+
+namespace {
+    std::string ReadFile(const char* path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    }
+
+    void TestSample()
+    {
+        const auto payload = ReadFile("data/trader_quotes_sample.json");
+        const auto index = PriceIndex::Parse(payload);
+        CHECK(index);
+        if (!index)
+            return;
+
+        const auto json = nlohmann::json::parse(payload);
+        size_t keys = 0;
+        for (const auto& [identifier, quote] : json["sell"].items()) {
+            const auto price = quote["p"].get<uint32_t>();
+            const auto dash = identifier.find('-');
+            uint32_t model_id = 0;
+            CHECK(PriceIndex::ParseModelId(std::string_view(identifier).substr(0, dash), model_id));
+            if (dash == std::string::npos) {
+                CHECK_EQ(index->Find(model_id), price);
+                keys++;
+                continue;
+            }
+            // Runes share words like 25B80000 with each other, so only the word that names the rune has to match
+            bool found = false;
+            for (size_t i = dash + 1; i + 8 <= identifier.size(); i += 8) {
+                const auto mod = static_cast<uint32_t>(std::stoul(identifier.substr(i, 8), nullptr, 16));
+                found |= index->Find(model_id, mod) == price;
+                CHECK(index->Find(model_id, mod) != 0);
+            }
+            CHECK(found);
+            CHECK_EQ(index->Find(model_id), 0u);
+        }
+        CHECK(keys > 0 && index->size() > keys);
+        CHECK_EQ(index->Find(1), 0u);
+        CHECK_EQ(index->Find(898, 0x12345678), 0u);
+    }
+
+    void TestMalformed()
+    {
+        CHECK(!PriceIndex::Parse(""));
+        CHECK(!PriceIndex::Parse("{\"sell\":"));
+        CHECK(!PriceIndex::Parse("[]"));
+        CHECK(!PriceIndex::Parse(R"({"buy":{"921":{"p":5}}})"));
+        CHECK(!PriceIndex::Parse(R"({"sell":[]})"));
+        CHECK(!PriceIndex::Parse(R"({"sell":{}})"));
+        // Only unsigned prices under usable identifiers count
+        CHECK(!PriceIndex::Parse(R"({"sell":{"921":{"p":-5},"922":{"p":"5"},"923":5,"92x":{"p":5},"-1":{"p":5}}})"));
+
+        const auto index = PriceIndex::Parse(R"({"sell":{
+            "921":{"p":7},
+            "922":{"q":1},
+            "898-0000000024080212ABC":{"p":300},
+            "898-2408021":{"p":400},
+            "5550-25B80000XYZ00000":{"p":500}
+        }})");
+        CHECK(index);
+        if (!index)
+            return;
+        CHECK_EQ(index->Find(921), 7u);
+        CHECK_EQ(index->Find(922), 0u);
+        // Zero words and a trailing partial word are skipped; a bad word ends the mod struct
+        CHECK_EQ(index->Find(898, 0x24080212), 300u);
+        CHECK_EQ(index->Find(898, 0), 0u);
+        CHECK_EQ(index->Find(898, 0x2408021), 0u);
+        CHECK_EQ(index->Find(5550, 0x25B80000), 500u);
+        CHECK_EQ(index->size(), 3u);
+
+        uint32_t model_id = 0;
+        CHECK(PriceIndex::ParseModelId("5550", model_id) && model_id == 5550);
+        CHECK(!PriceIndex::ParseModelId("", model_id));
+        CHECK(!PriceIndex::ParseModelId("55a", model_id));
+        CHECK(!PriceIndex::ParseModelId("99999999999", model_id));
+    }
+}
+
+int main()
+{
+    TestSample();
+    TestMalformed();
+    return Test::TestResult();
+}
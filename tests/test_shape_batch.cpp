@@ -0,0 +1,99 @@
+#include "stdafx.h"
+
+#include <Widgets/Minimap/ShapeBatch.h>
+
+#include "check.h"
+#include "shape_batch_fixture.h"
+
+namespace {
+    using namespace ShapeBatchFixture;
+
+    struct Fixture {
+        ShapeBatch batch;
+        std::vector<std::vector<ShapeVertex>> shapes = AgentShapes();
+        std::vector<uint32_t> ids;
+
+        Fixture()
+        {
+            for (const auto& shape : shapes) {
+                ids.push_back(batch.AddShape(shape));
+            }
+        }
+
+        void Add(const std::vector<Instance>& instances)
+        {
+            batch.Clear();
+            for (const auto& instance : instances) {
+                batch.Add(ids[instance.shape], instance.x, instance.y, instance.cos, instance.sin, instance.size, ColorsFor(instance));
+            }
+        }
+    };
+
+    void TestTemplatesDropDuplicates()
+    {
+        Fixture f;
+        // circle: 32 around plus the centre, instead of 96 (the last edge's end may not round to the first's start)
+        CHECK(f.batch.MaxShapeVertices() >= 33u && f.batch.MaxShapeVertices() <= 34u);
+        CHECK_EQ(f.batch.MaxShapeIndices(), 96u);
+    }
+
+    // Indexed output expanded back into triangle lists matches the old per-vertex output
+    void TestMatchesReference()
+    {
+        Fixture f;
+        const auto instances = MakeInstances(300, f.shapes.size(), 1);
+        f.Add(instances);
+
+        std::vector<ShapeBatch::Vertex> reference(instances.size() * f.batch.MaxShapeIndices());
+        reference.resize(EmitReference(f.shapes, instances, reference.data()));
+
+        std::vector<ShapeBatch::Vertex> vertices(4096);
+        std::vector<uint16_t> indices(4096);
+        std::vector<ShapeBatch::Vertex> expanded;
+        size_t batches = 0;
+        for (size_t drawn = 0; drawn < f.batch.InstanceCount();) {
+            size_t vertex_count = 0;
+            size_t index_count = 0;
+            const size_t emitted = f.batch.Emit(drawn, vertices.data(), vertices.size(), indices.data(), indices.size(), vertex_count, index_count);
+            CHECK(emitted > 0);
+            if (!emitted) {
+                break;
+            }
+            for (size_t i = 0; i < index_count; i++) {
+                CHECK(indices[i] < vertex_count);
+                expanded.push_back(vertices[indices[i]]);
+            }
+            drawn += emitted;
+            batches++;
+        }
+        CHECK(batches > 1); // didn't all fit, so whole instances carried over to the next buffer
+        CHECK_EQ(expanded.size(), reference.size());
+        for (size_t i = 0; i < std::min(expanded.size(), reference.size()); i++) {
+            CHECK(std::abs(expanded[i].x - reference[i].x) < 1e-2f);
+            CHECK(std::abs(expanded[i].y - reference[i].y) < 1e-2f);
+            CHECK_EQ(expanded[i].color, reference[i].color);
+        }
+    }
+
+    void TestFullBuffer()
+    {
+        Fixture f;
+        f.Add(MakeInstances(10, f.shapes.size(), 2));
+        std::vector<ShapeBatch::Vertex> vertices(8);
+        std::vector<uint16_t> indices(8);
+        size_t vertex_count = 1;
+        size_t index_count = 1;
+        // Nothing fits, nothing written
+        CHECK_EQ(f.batch.Emit(0, vertices.data(), vertices.size(), indices.data(), indices.size(), vertex_count, index_count), 0u);
+        CHECK_EQ(vertex_count, 0u);
+        CHECK_EQ(index_count, 0u);
+    }
+}
+
+int main()
+{
+    TestTemplatesDropDuplicates();
+    TestMatchesReference();
+    TestFullBuffer();
+    return Test::TestResult();
+}
@@ -0,0 +1,76 @@
+#include "stdafx.h"
+
+#include <Widgets/Minimap/ZoneGrid.h>
+
+#include "check.h"
+#include "zone_fixture.h"
+
+namespace {
+    void TestEmpty()
+    {
+        ZoneGrid grid;
+        CHECK(grid.Empty());
+        CHECK(grid.Candidates(0.f, 0.f).empty());
+        grid.Build({});
+        CHECK(grid.Empty());
+    }
+
+    void TestCandidates()
+    {
+        // Overlapping boxes, a point sized one, and one far away so the grid has several cells
+        const std::vector<ZoneGrid::Box> boxes = {
+            {0, 0, 1000, 1000}, {500, 500, 600, 600}, {550, 550, 550, 550}, {20000, 20000, 21000, 21000}, {-100, -100, 100, 100}
+        };
+        ZoneGrid grid;
+        grid.Build(boxes);
+        CHECK(!grid.Empty());
+
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<float> coord(-5000.f, 25000.f);
+        for (int i = 0; i < 10000; i++) {
+            const float x = i == 0 ? 550.f : coord(rng);
+            const float y = i == 0 ? 550.f : coord(rng);
+            const auto candidates = grid.Candidates(x, y);
+            CHECK(std::ranges::is_sorted(candidates));
+            CHECK(std::ranges::adjacent_find(candidates) == candidates.end());
+            for (uint32_t id = 0; id < boxes.size(); id++) {
+                const auto& box = boxes[id];
+                if (x >= box.min_x && x <= box.max_x && y >= box.min_y && y <= box.max_y) {
+                    CHECK(std::ranges::find(candidates, id) != candidates.end());
+                }
+            }
+        }
+        CHECK_EQ(grid.Candidates(550.f, 550.f).size(), 3u);
+        // Far outside the bounds clamps to the edge cells
+        CHECK(std::ranges::find(grid.Candidates(1e9f, 1e9f), 3u) != grid.Candidates(1e9f, 1e9f).end());
+    }
+
+    // The grid lookup picks the same polygon or marker as testing every zone: markers over polygons, later over earlier
+    void TestMatchesLinearLookup()
+    {
+        const auto zones = ZoneFixture::MakeZones(2000, 300, 40000.f, 5);
+        const ZoneFixture::GridLookup lookup(zones);
+        std::mt19937 rng(9);
+        std::uniform_real_distribution<float> coord(-22000.f, 22000.f);
+        size_t hits = 0;
+        size_t marker_hits = 0;
+        for (int i = 0; i < 20000; i++) {
+            const ZoneFixture::Point pos = {coord(rng), coord(rng)};
+            const auto expected = ZoneFixture::LinearLookup(zones, pos);
+            CHECK(lookup.Lookup(pos) == expected);
+            hits += expected.index >= 0;
+            marker_hits += expected.is_marker;
+        }
+        // Make sure the data actually exercises both kinds of zone
+        CHECK(hits > 1000);
+        CHECK(marker_hits > 100 && marker_hits < hits);
+    }
+}
+
+int main()
+{
+    TestEmpty();
+    TestCandidates();
+    TestMatchesLinearLookup();
+    return Test::TestResult();
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <Widgets/Minimap/ZoneGrid.h>
+
+// Custom polygons and markers as CustomRenderer uses them to recolour hostiles: the lookup it did before ZoneGrid
+// (every zone tested, the last matching polygon then the last matching marker wins) and the one through the grid.
+namespace ZoneFixture {
+    constexpr float zone_range = 2500.f;
+
+    struct Point {
+        float x, y;
+    };
+
+    struct Polygon {
+        std::vector<Point> points;
+    };
+
+    struct Marker {
+        Point pos;
+        float size;
+    };
+
+    struct Zones {
+        std::vector<Polygon> polygons;
+        std::vector<Marker> markers;
+    };
+
+    // Result of a lookup: the polygon or marker whose colour applies
+    struct Hit {
+        bool is_marker = false;
+        int32_t index = -1;
+        bool operator==(const Hit&) const = default;
+    };
+
+    inline float Distance(const Point& a, const Point& b) { return std::hypot(a.x - b.x, a.y - b.y); }
+
+    // Same as CustomRenderer's IsInside
+    inline bool IsInside(const Point& pos, const std::vector<Point>& points)
+    {
+        bool b = false;
+        for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+            if ((points[i].y >= pos.y) != (points[j].y >= pos.y) &&
+                pos.x <= (points[j].x - points[i].x) * (pos.y - points[i].y) / (points[j].y - points[i].y) + points[i].x) {
+                b = !b;
+            }
+        }
+        return b;
+    }
+
+    inline bool PolygonHit(const Polygon& polygon, const Point& pos)
+    {
+        return !polygon.points.empty() && Distance(pos, polygon.points[0]) < zone_range && IsInside(pos, polygon.points);
+    }
+
+    inline bool MarkerHit(const Marker& marker, const Point& pos)
+    {
+        return Distance(pos, marker.pos) < zone_range && Distance(pos, marker.pos) <= std::abs(marker.size);
+    }
+
+    inline Hit LinearLookup(const Zones& zones, const Point& pos)
+    {
+        Hit hit;
+        for (size_t i = 0; i < zones.polygons.size(); i++) {
+            if (PolygonHit(zones.polygons[i], pos)) {
+                hit = {false, static_cast<int32_t>(i)};
+            }
+        }
+        for (size_t i = 0; i < zones.markers.size(); i++) {
+            if (MarkerHit(zones.markers[i], pos)) {
+                hit = {true, static_cast<int32_t>(i)};
+            }
+        }
+        return hit;
+    }
+
+    // CustomRenderer::BuildZoneIndex and GetZoneColor
+    class GridLookup {
+    public:
+        explicit GridLookup(const Zones& zones)
+            : zones(zones)
+        {
+            std::vector<ZoneGrid::Box> boxes;
+            for (uint32_t i = 0; i < zones.polygons.size(); i++) {
+                const auto& points = zones.polygons[i].points;
+                if (points.empty()) {
+                    continue;
+                }
+                const auto& first = points[0];
+                ZoneGrid::Box box{first.x, first.y, first.x, first.y};
+                for (const auto& point : points) {
+                    box.min_x = std::min(box.min_x, point.x);
+                    box.min_y = std::min(box.min_y, point.y);
+                    box.max_x = std::max(box.max_x, point.x);
+                    box.max_y = std::max(box.max_y, point.y);
+                }
+                box.min_x = std::max(box.min_x, first.x - zone_range);
+                box.min_y = std::max(box.min_y, first.y - zone_range);
+                box.max_x = std::min(box.max_x, first.x + zone_range);
+                box.max_y = std::min(box.max_y, first.y + zone_range);
+                ids.push_back({false, static_cast<int32_t>(i)});
+                boxes.push_back(box);
+            }
+            for (uint32_t i = 0; i < zones.markers.size(); i++) {
+                const auto& marker = zones.markers[i];
+                const float radius = std::min(std::abs(marker.size), zone_range);
+                ids.push_back({true, static_cast<int32_t>(i)});
+                boxes.push_back({marker.pos.x - radius, marker.pos.y - radius, marker.pos.x + radius, marker.pos.y + radius});
+            }
+            grid.Build(boxes);
+        }
+
+        [[nodiscard]] Hit Lookup(const Point& pos) const
+        {
+            const auto candidates = grid.Candidates(pos.x, pos.y);
+            for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+                const auto& id = ids[*it];
+                if (id.is_marker ? MarkerHit(zones.markers[id.index], pos) : PolygonHit(zones.polygons[id.index], pos)) {
+                    return id;
+                }
+            }
+            return {};
+        }
+
+        ZoneGrid grid;
+
+    private:
+        const Zones& zones;
+        std::vector<Hit> ids;
+    };
+
+    // Random polygons (some concave, some larger than zone_range) and circles over a map of the given size
+    inline Zones MakeZones(const size_t polygon_count, const size_t marker_count, const float map_size, const uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> coord(-map_size / 2, map_size / 2);
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+        Zones zones;
+        for (size_t i = 0; i < polygon_count; i++) {
+            const Point center = {coord(rng), coord(rng)};
+            const float radius = 200.f + unit(rng) * (i % 50 == 0 ? 6000.f : 1500.f);
+            const size_t corners = 3 + rng() % 8;
+            auto& polygon = zones.polygons.emplace_back();
+            for (size_t c = 0; c < corners; c++) {
+                const float angle = 2 * 3.14159265f * static_cast<float>(c) / static_cast<float>(corners);
+                const float r = radius * (0.4f + 0.6f * unit(rng));
+                polygon.points.push_back({center.x + r * std::cos(angle), center.y + r * std::sin(angle)});
+            }
+        }
+        for (size_t i = 0; i < marker_count; i++) {
+            zones.markers.push_back({{coord(rng), coord(rng)}, (unit(rng) < 0.1f ? -1.f : 1.f) * (100.f + unit(rng) * 3000.f)});
+        }
+        return zones;
+    }
+}